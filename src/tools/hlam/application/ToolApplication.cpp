@@ -32,6 +32,7 @@
 #include "ui/options/OptionsPageGameConfigurations.hpp"
 #include "ui/options/OptionsPageGeneral.hpp"
 #include "ui/options/OptionsPageRegistry.hpp"
+#include "ui/options/OptionsPageResources.hpp"
 #include "ui/options/OptionsPageStudioModel.hpp"
 #include "ui/options/OptionsPageStyle.hpp"
 
@@ -238,6 +239,7 @@ ui::EditorContext* ToolApplication::CreateEditorContext(std::unique_ptr<QSetting
 	optionsPageRegistry->AddPage(std::make_unique<ui::options::OptionsPageGameConfigurations>(gameConfigurationsSettings));
 	optionsPageRegistry->AddPage(std::make_unique<ui::options::OptionsPageStudioModel>(studioModelSettings));
 	optionsPageRegistry->AddPage(std::make_unique<ui::options::OptionsPageStyle>(styleSettings));
+	optionsPageRegistry->AddPage(std::make_unique<ui::options::OptionsPageResources>());
 
 	auto assetProviderRegistry{std::make_unique<ui::assets::AssetProviderRegistry>()};
 
@@ -0,0 +1,132 @@
+#include <chrono>
+#include <system_error>
+
+#include "assets/ResourceCache.hpp"
+
+namespace assets
+{
+std::optional<FileIdentity> FileIdentity::Get(const std::filesystem::path& fileName)
+{
+	std::error_code error;
+
+	const auto canonicalPath = std::filesystem::canonical(fileName, error);
+
+	if (error)
+	{
+		return {};
+	}
+
+	const auto size = std::filesystem::file_size(canonicalPath, error);
+
+	if (error)
+	{
+		return {};
+	}
+
+	const auto modifiedTime = std::filesystem::last_write_time(canonicalPath, error);
+
+	if (error)
+	{
+		return {};
+	}
+
+	return FileIdentity
+	{
+		canonicalPath.u8string(),
+		size,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(modifiedTime.time_since_epoch()).count()
+	};
+}
+
+ResourceCache& ResourceCache::GetInstance()
+{
+	static ResourceCache cache;
+	return cache;
+}
+
+void ResourceCache::Remove(const std::string& type, const FileIdentity& file, const std::string& variant, const void* resource)
+{
+	std::lock_guard lock{_mutex};
+
+	if (auto it = _entries.find(MakeKey(type, file, variant)); it != _entries.end())
+	{
+		if (auto existing = it->second.Resource.lock(); !existing || existing.get() == resource)
+		{
+			_entries.erase(it);
+		}
+	}
+}
+
+std::vector<ResourceInfo> ResourceCache::GetResources() const
+{
+	std::lock_guard lock{_mutex};
+
+	PruneExpired();
+
+	std::vector<ResourceInfo> resources;
+
+	resources.reserve(_entries.size());
+
+	for (const auto& [key, entry] : _entries)
+	{
+		//Don't count the reference held by this function
+		if (auto resource = entry.Resource.lock(); resource)
+		{
+			resources.push_back({entry.Type, entry.Name, resource.use_count() - 1, entry.Bytes});
+		}
+	}
+
+	return resources;
+}
+
+std::string ResourceCache::MakeKey(const std::string& type, const FileIdentity& file, const std::string& variant)
+{
+	return type + '\n' + file.Path + '\n' + std::to_string(file.Size) + '\n' + std::to_string(file.ModifiedTime) + '\n' + variant;
+}
+
+std::shared_ptr<void> ResourceCache::FindResource(const std::string& key) const
+{
+	std::lock_guard lock{_mutex};
+
+	if (auto it = _entries.find(key); it != _entries.end())
+	{
+		return it->second.Resource.lock();
+	}
+
+	return {};
+}
+
+std::shared_ptr<void> ResourceCache::AddResource(std::string&& key, const std::string& type, const std::string& name,
+	const std::shared_ptr<void>& resource, std::size_t bytes)
+{
+	std::lock_guard lock{_mutex};
+
+	PruneExpired();
+
+	auto& entry = _entries[std::move(key)];
+
+	if (auto existing = entry.Resource.lock(); existing)
+	{
+		return existing;
+	}
+
+	entry = Entry{type, name, resource, bytes};
+
+	return resource;
+}
+
+void ResourceCache::PruneExpired() const
+{
+	for (auto it = _entries.begin(); it != _entries.end();)
+	{
+		if (it->second.Resource.expired())
+		{
+			it = _entries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+}
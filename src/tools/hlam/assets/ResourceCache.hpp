@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace assets
+{
+/**
+*	@brief Identifies the contents of a file. Files with the same path, size and modification time are assumed to be identical.
+*/
+struct FileIdentity
+{
+	std::string Path;
+	std::uintmax_t Size = 0;
+	std::int64_t ModifiedTime = 0;
+
+	/**
+	*	@brief Gets the identity of a file as it is right now.
+	*	@return The identity, or an empty optional if the file does not exist or can't be accessed.
+	*/
+	static std::optional<FileIdentity> Get(const std::filesystem::path& fileName);
+};
+
+/**
+*	@brief Describes a resource in the cache.
+*/
+struct ResourceInfo
+{
+	std::string Type;
+	std::string Name;
+	long UseCount = 0;
+	std::size_t Bytes = 0;
+};
+
+/**
+*	@brief Process wide cache of resources loaded from files, used to share read-only data between assets.
+*	The cache only holds weak references, resources are freed when the last user releases them.
+*	Resources of different types loaded from the same file are told apart by their type and variant.
+*	Thread safe.
+*/
+class ResourceCache final
+{
+public:
+	ResourceCache() = default;
+	~ResourceCache() = default;
+
+	ResourceCache(const ResourceCache&) = delete;
+	ResourceCache& operator=(const ResourceCache&) = delete;
+
+	static ResourceCache& GetInstance();
+
+	/**
+	*	@param variant Distinguishes resources of the same type created from the same file with different settings
+	*	@return The resource, or null if it is not in the cache.
+	*/
+	template<typename T>
+	std::shared_ptr<T> Find(const std::string& type, const FileIdentity& file, const std::string& variant = {}) const
+	{
+		return std::static_pointer_cast<T>(FindResource(MakeKey(type, file, variant)));
+	}
+
+	/**
+	*	@brief Adds a resource. If another thread added the same resource first, that one is returned instead.
+	*	@param bytes Approximate amount of memory used by the resource, for diagnostics.
+	*/
+	template<typename T>
+	std::shared_ptr<T> Add(const std::string& type, const FileIdentity& file, const std::string& variant,
+		const std::shared_ptr<T>& resource, std::size_t bytes)
+	{
+		return std::static_pointer_cast<T>(AddResource(MakeKey(type, file, variant), type, file.Path, resource, bytes));
+	}
+
+	/**
+	*	@brief Removes a resource so it won't be shared anymore. Used before modifying a resource that has no other users.
+	*	Does nothing if a different resource is stored under the same key.
+	*/
+	void Remove(const std::string& type, const FileIdentity& file, const std::string& variant, const void* resource);
+
+	/**
+	*	@brief Gets information about all resources that are still in use.
+	*/
+	std::vector<ResourceInfo> GetResources() const;
+
+private:
+	struct Entry
+	{
+		std::string Type;
+		std::string Name;
+		std::weak_ptr<void> Resource;
+		std::size_t Bytes = 0;
+	};
+
+	static std::string MakeKey(const std::string& type, const FileIdentity& file, const std::string& variant);
+
+	std::shared_ptr<void> FindResource(const std::string& key) const;
+
+	std::shared_ptr<void> AddResource(std::string&& key, const std::string& type, const std::string& name,
+		const std::shared_ptr<void>& resource, std::size_t bytes);
+
+	/**
+	*	@brief Removes entries whose resource has been freed. The mutex must be locked.
+	*/
+	void PruneExpired() const;
+
+private:
+	mutable std::mutex _mutex;
+	mutable std::unordered_map<std::string, Entry> _entries;
+};
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <numeric>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "benchmarks/Benchmark.hpp"
+
+namespace benchmarks
+{
+namespace detail
+{
+const void* volatile Sink = nullptr;
+}
+
+static void WriteJsonString(std::ostream& stream, std::string_view text)
+{
+	stream << '"';
+
+	for (const char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			stream << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			stream << ' ';
+		}
+		else
+		{
+			stream << c;
+		}
+	}
+
+	stream << '"';
+}
+
+std::size_t GetResidentMemorySize()
+{
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.WorkingSetSize;
+#else
+	//The second value is the number of resident pages
+	FILE* file = fopen("/proc/self/statm", "r");
+
+	if (!file)
+	{
+		return 0;
+	}
+
+	unsigned long totalPages = 0;
+	unsigned long residentPages = 0;
+
+	const bool success = fscanf(file, "%lu %lu", &totalPages, &residentPages) == 2;
+
+	fclose(file);
+
+	if (!success)
+	{
+		return 0;
+	}
+
+	const long pageSize = sysconf(_SC_PAGESIZE);
+
+	return pageSize > 0 ? static_cast<std::size_t>(residentPages) * static_cast<std::size_t>(pageSize) : 0;
+#endif
+}
+
+BenchmarkRunner::BenchmarkRunner(BenchmarkSettings&& settings)
+	: _settings(std::move(settings))
+{
+}
+
+bool BenchmarkRunner::ShouldRun(std::string_view name) const
+{
+	return _settings.Filter.empty() || name.find(_settings.Filter) != std::string_view::npos;
+}
+
+void BenchmarkRunner::Record(std::string_view name, std::string_view input, std::chrono::nanoseconds time,
+	double bytesPerIteration, double itemsPerIteration)
+{
+	if (!ShouldRun(name))
+	{
+		return;
+	}
+
+	AddResult(name, input, {static_cast<double>(time.count())}, 1, bytesPerIteration, itemsPerIteration);
+}
+
+void BenchmarkRunner::RecordMemoryUse(std::string_view name, std::string_view input, std::chrono::nanoseconds time,
+	std::size_t residentMemoryBefore, std::size_t residentMemoryAfter, double bytesPerIteration)
+{
+	if (!ShouldRun(name))
+	{
+		return;
+	}
+
+	AddResult(name, input, {static_cast<double>(time.count())}, 1, bytesPerIteration, 0);
+
+	auto& result = _results.back();
+
+	result.ResidentMemoryBefore = residentMemoryBefore;
+	result.ResidentMemoryAfter = residentMemoryAfter;
+}
+
+void BenchmarkRunner::AddResult(std::string_view name, std::string_view input, std::vector<double>&& sampleTimes, std::size_t iterations,
+	double bytesPerIteration, double itemsPerIteration)
+{
+	BenchmarkResult result;
+
+	result.Name = name;
+	result.Input = input;
+	result.Iterations = iterations;
+	result.BytesPerIteration = bytesPerIteration;
+	result.ItemsPerIteration = itemsPerIteration;
+
+	if (!sampleTimes.empty())
+	{
+		std::sort(sampleTimes.begin(), sampleTimes.end());
+
+		const std::size_t middle = sampleTimes.size() / 2;
+
+		result.MeanTime = std::accumulate(sampleTimes.begin(), sampleTimes.end(), 0.0) / static_cast<double>(sampleTimes.size());
+		result.MedianTime = (sampleTimes.size() % 2) != 0 ? sampleTimes[middle] : (sampleTimes[middle - 1] + sampleTimes[middle]) / 2;
+		result.MinTime = sampleTimes.front();
+	}
+
+	_results.push_back(std::move(result));
+}
+
+void BenchmarkRunner::WriteJson(std::ostream& stream, const std::vector<std::pair<std::string, std::string>>& properties) const
+{
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+
+	stream << std::fixed << std::setprecision(1);
+
+	stream << "{\n\"context\":{";
+
+	bool first = true;
+
+	for (const auto& property : properties)
+	{
+		if (!first)
+		{
+			stream << ',';
+		}
+
+		first = false;
+
+		WriteJsonString(stream, property.first);
+		stream << ':';
+		WriteJsonString(stream, property.second);
+	}
+
+	stream << "},\n\"benchmarks\":[";
+
+	first = true;
+
+	for (const auto& result : _results)
+	{
+		if (!first)
+		{
+			stream << ',';
+		}
+
+		first = false;
+
+		stream << "\n{\"name\":";
+		WriteJsonString(stream, result.Name);
+		stream << ",\"input\":";
+		WriteJsonString(stream, result.Input);
+		stream << ",\"iterations\":" << result.Iterations
+			<< ",\"mean_ns\":" << result.MeanTime
+			<< ",\"median_ns\":" << result.MedianTime
+			<< ",\"min_ns\":" << result.MinTime;
+
+		//Throughput is based on the median so a few slow samples don't skew it
+		if (result.MedianTime > 0)
+		{
+			if (result.BytesPerIteration > 0)
+			{
+				stream << ",\"bytes_per_second\":" << (result.BytesPerIteration * 1e9 / result.MedianTime);
+			}
+
+			if (result.ItemsPerIteration > 0)
+			{
+				stream << ",\"items_per_second\":" << (result.ItemsPerIteration * 1e9 / result.MedianTime);
+			}
+		}
+
+		if (result.ResidentMemoryBefore > 0 && result.ResidentMemoryAfter > 0)
+		{
+			stream << ",\"rss_before_bytes\":" << result.ResidentMemoryBefore
+				<< ",\"rss_after_bytes\":" << result.ResidentMemoryAfter;
+		}
+
+		stream << '}';
+	}
+
+	stream << "\n]\n}\n";
+
+	stream.flags(flags);
+	stream.precision(precision);
+}
+}
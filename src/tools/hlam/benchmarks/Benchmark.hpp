@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace benchmarks
+{
+namespace detail
+{
+extern const void* volatile Sink;
+}
+
+/**
+*	@brief Prevents the compiler from optimizing away a value that is only computed to be measured.
+*/
+template<typename T>
+void DoNotOptimize(const T& value)
+{
+	detail::Sink = &value;
+}
+
+struct BenchmarkSettings
+{
+	/**
+	*	Minimum time in seconds to spend measuring each benchmark.
+	*/
+	double MinTime = 0.5;
+
+	/**
+	*	Number of samples the measuring time is divided into. Statistics are calculated over the samples.
+	*/
+	std::size_t Samples = 10;
+
+	/**
+	*	If not empty, only benchmarks whose name contains this are run.
+	*/
+	std::string Filter;
+};
+
+struct BenchmarkResult
+{
+	std::string Name;
+
+	/**
+	*	Name of the data the benchmark ran on, such as a model.
+	*/
+	std::string Input;
+
+	std::size_t Iterations = 0;
+
+	//Times are in nanoseconds per iteration
+	double MeanTime = 0;
+	double MedianTime = 0;
+	double MinTime = 0;
+
+	/**
+	*	If not 0, throughput is reported in bytes per second.
+	*/
+	double BytesPerIteration = 0;
+
+	/**
+	*	If not 0, throughput is reported in items per second.
+	*/
+	double ItemsPerIteration = 0;
+
+	/**
+	*	If not 0, memory of the process that was resident before and after the benchmark ran, in bytes.
+	*/
+	std::size_t ResidentMemoryBefore = 0;
+	std::size_t ResidentMemoryAfter = 0;
+};
+
+/**
+*	@brief Gets how much memory of this process is resident in physical memory, in bytes.
+*	@return The resident memory size, or 0 if it could not be queried
+*/
+std::size_t GetResidentMemorySize();
+
+/**
+*	@brief Runs benchmarks and collects their results.
+*	Each benchmark is run in samples of enough iterations to be measured accurately, until the minimum time has passed.
+*/
+class BenchmarkRunner final
+{
+public:
+	explicit BenchmarkRunner(BenchmarkSettings&& settings);
+
+	BenchmarkRunner(const BenchmarkRunner&) = delete;
+	BenchmarkRunner& operator=(const BenchmarkRunner&) = delete;
+
+	bool ShouldRun(std::string_view name) const;
+
+	/**
+	*	@brief Measures how long calling function takes.
+	*	@param input Name of the data the benchmark runs on
+	*/
+	template<typename Function>
+	void Run(std::string_view name, std::string_view input, Function&& function,
+		double bytesPerIteration = 0, double itemsPerIteration = 0);
+
+	/**
+	*	@brief Records a measurement that can only be taken once, such as loading a file for the first time.
+	*/
+	void Record(std::string_view name, std::string_view input, std::chrono::nanoseconds time,
+		double bytesPerIteration = 0, double itemsPerIteration = 0);
+
+	/**
+	*	@brief Records a one time measurement along with the resident memory before and after it was taken.
+	*/
+	void RecordMemoryUse(std::string_view name, std::string_view input, std::chrono::nanoseconds time,
+		std::size_t residentMemoryBefore, std::size_t residentMemoryAfter, double bytesPerIteration = 0);
+
+	const std::vector<BenchmarkResult>& GetResults() const { return _results; }
+
+	/**
+	*	@brief Writes the results as JSON, one benchmark per line so results from different builds can be diffed.
+	*	@param properties Extra properties describing the build and machine, written as strings
+	*/
+	void WriteJson(std::ostream& stream, const std::vector<std::pair<std::string, std::string>>& properties) const;
+
+private:
+	void AddResult(std::string_view name, std::string_view input, std::vector<double>&& sampleTimes, std::size_t iterations,
+		double bytesPerIteration, double itemsPerIteration);
+
+private:
+	const BenchmarkSettings _settings;
+
+	std::vector<BenchmarkResult> _results;
+};
+
+template<typename Function>
+void BenchmarkRunner::Run(std::string_view name, std::string_view input, Function&& function,
+	double bytesPerIteration, double itemsPerIteration)
+{
+	if (!ShouldRun(name))
+	{
+		return;
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	const auto timeCalls = [&](std::size_t count)
+	{
+		const auto start = Clock::now();
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			function();
+		}
+
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	};
+
+	const double sampleTime = (_settings.MinTime * 1e9) / static_cast<double>(std::max<std::size_t>(_settings.Samples, 1));
+
+	//The first calls also warm up caches
+	std::size_t callsPerSample = 1;
+
+	while (true)
+	{
+		const double time = timeCalls(callsPerSample);
+
+		if (time >= sampleTime * 0.5)
+		{
+			break;
+		}
+
+		callsPerSample = time > 0
+			? std::max(callsPerSample * 2, static_cast<std::size_t>(callsPerSample * (sampleTime / time)))
+			: callsPerSample * 10;
+	}
+
+	std::vector<double> sampleTimes;
+
+	double totalTime = 0;
+
+	//Slow benchmarks take fewer samples to keep the run time reasonable
+	const std::size_t maxSamples = std::max<std::size_t>(_settings.Samples, 3) * 4;
+
+	while (sampleTimes.size() < maxSamples)
+	{
+		const double time = timeCalls(callsPerSample);
+
+		totalTime += time;
+		sampleTimes.push_back(time / static_cast<double>(callsPerSample));
+
+		if (sampleTimes.size() >= 3 && totalTime >= _settings.MinTime * 1e9)
+		{
+			break;
+		}
+	}
+
+	const std::size_t iterations = callsPerSample * sampleTimes.size();
+
+	AddResult(name, input, std::move(sampleTimes), iterations, bytesPerIteration, itemsPerIteration);
+}
+}
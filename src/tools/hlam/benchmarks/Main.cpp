@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "benchmarks/Benchmark.hpp"
+#include "benchmarks/Suites.hpp"
+#include "benchmarks/SyntheticModel.hpp"
+
+#include "core/shared/Profiler.hpp"
+
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+#include "graphics/TextureConversion.hpp"
+
+#include "utility/MathBatch.hpp"
+
+using namespace benchmarks;
+
+namespace
+{
+struct ModelInput
+{
+	std::filesystem::path FileName;
+	std::string Name;
+};
+
+void PrintUsage()
+{
+	std::cerr << "Usage: hlam_benchmarks [options]\n"
+		"Measures model loading, animation, skinning, texture conversion and sound loading and writes the results as JSON.\n"
+		"Options:\n"
+		"  --output <file>   Write results to file instead of standard output\n"
+		"  --models <dir>    Also run on all studio models in this directory and its subdirectories\n"
+		"  --sounds <dir>    Measure loading all wave files in this directory and its subdirectories\n"
+		"  --filter <text>   Only run benchmarks whose name contains text\n"
+		"  --min-time <s>    Minimum time to spend measuring each benchmark, in seconds (default 0.5)\n"
+		"  --no-synthetic    Don't run on the generated models\n"
+		"  --profile         Record profiler zones while measuring, which adds their overhead to the results\n";
+}
+
+/**
+*	@brief Generated models cover a small and a large skeleton, so results don't depend on which real models are available.
+*	The small model has long sequences so sampling the first and last frames shows the cost of walking the run-length encoded data.
+*/
+std::vector<ModelInput> CreateSyntheticModels()
+{
+	SyntheticModelSettings small;
+
+	small.Name = "Synthetic16Bones500Frames";
+	small.Bones = 16;
+	small.Vertices = 256;
+	small.Meshes = 2;
+	//Animation offsets are 16 bit, so the large skeleton can't store this many frames
+	small.Frames = 500;
+
+	SyntheticModelSettings large;
+
+	large.Name = "Synthetic128Bones";
+
+	const auto directory = std::filesystem::temp_directory_path() / "hlam_benchmarks";
+
+	std::vector<ModelInput> models;
+
+	for (const auto& settings : {small, large})
+	{
+		models.push_back({WriteSyntheticModel(settings, directory), settings.Name});
+	}
+
+	return models;
+}
+
+/**
+*	@brief Finds all main studio model files in a directory. Models are sorted by name so results are always in the same order.
+*/
+std::vector<ModelInput> FindModels(const std::filesystem::path& directory)
+{
+	std::vector<ModelInput> models;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator{directory})
+	{
+		if (!entry.is_regular_file())
+		{
+			continue;
+		}
+
+		auto extension = entry.path().extension().u8string();
+
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+		if (extension != ".mdl" || !studiomdl::IsStudioModel(entry.path().u8string()))
+		{
+			continue;
+		}
+
+		models.push_back({entry.path(), entry.path().lexically_relative(directory).generic_u8string()});
+	}
+
+	std::sort(models.begin(), models.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.Name < rhs.Name;
+		});
+
+	return models;
+}
+
+std::string GetCurrentDate()
+{
+	const std::time_t now = std::time(nullptr);
+
+	char buffer[32]{};
+	std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+	return buffer;
+}
+
+std::vector<std::pair<std::string, std::string>> GetProperties()
+{
+	return
+	{
+		{"date", GetCurrentDate()},
+#ifdef NDEBUG
+		{"build_type", "release"},
+#else
+		{"build_type", "debug"},
+#endif
+		{"hardware_threads", std::to_string(std::thread::hardware_concurrency())},
+		{"math_batch", MathBatchImplementationToString(GetMathBatchImplementation())},
+		{"texture_conversion", graphics::TextureConversionImplementationToString(graphics::GetTextureConversionImplementation())},
+		{"profiler", Profiler::GetInstance().IsEnabled() ? "enabled" : "disabled"}
+	};
+}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkSettings settings;
+	std::filesystem::path outputFileName;
+	std::filesystem::path modelsDirectory;
+	std::filesystem::path soundsDirectory;
+	bool useSyntheticModels = true;
+	bool enableProfiler = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument{argv[i]};
+
+		const auto getValue = [&]() -> const char*
+		{
+			if ((i + 1) >= argc)
+			{
+				std::cerr << "Missing value for " << argument << '\n';
+				PrintUsage();
+				std::exit(EXIT_FAILURE);
+			}
+
+			return argv[++i];
+		};
+
+		if (argument == "--output")
+		{
+			outputFileName = std::filesystem::u8path(getValue());
+		}
+		else if (argument == "--models")
+		{
+			modelsDirectory = std::filesystem::u8path(getValue());
+		}
+		else if (argument == "--sounds")
+		{
+			soundsDirectory = std::filesystem::u8path(getValue());
+		}
+		else if (argument == "--filter")
+		{
+			settings.Filter = getValue();
+		}
+		else if (argument == "--min-time")
+		{
+			settings.MinTime = std::max(0.0, std::atof(getValue()));
+		}
+		else if (argument == "--no-synthetic")
+		{
+			useSyntheticModels = false;
+		}
+		else if (argument == "--profile")
+		{
+			enableProfiler = true;
+		}
+		else
+		{
+			PrintUsage();
+			return argument == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	//The profiler is on by default for the editor, only measure instrumented code if asked to
+	Profiler::GetInstance().SetEnabled(enableProfiler);
+
+	const auto properties = GetProperties();
+
+	BenchmarkRunner runner{std::move(settings)};
+
+	try
+	{
+		std::vector<ModelInput> models;
+
+		if (useSyntheticModels)
+		{
+			models = CreateSyntheticModels();
+		}
+
+		std::vector<std::filesystem::path> directoryFileNames;
+
+		if (!modelsDirectory.empty())
+		{
+			auto realModels = FindModels(modelsDirectory);
+
+			for (const auto& model : realModels)
+			{
+				directoryFileNames.push_back(model.FileName);
+			}
+
+			models.insert(models.end(), std::make_move_iterator(realModels.begin()), std::make_move_iterator(realModels.end()));
+		}
+
+		for (const auto& model : models)
+		{
+			std::cerr << "Running " << model.Name << '\n';
+
+			try
+			{
+				RunStudioModelBenchmarks(runner, model.FileName, model.Name);
+			}
+			catch (const studiomdl::StudioModelIsNotMainHeader&)
+			{
+				//Texture and sequence group files are loaded along with their main file
+			}
+			catch (const assets::AssetException& e)
+			{
+				std::cerr << "Skipping " << model.Name << ": " << e.what() << '\n';
+			}
+		}
+
+		//Run after the per model benchmarks so those still load each model for the first time in this process
+		if (!directoryFileNames.empty())
+		{
+			std::cerr << "Running " << modelsDirectory.u8string() << '\n';
+			RunModelDirectoryLoadBenchmarks(runner, directoryFileNames, modelsDirectory.u8string());
+		}
+
+		if (!soundsDirectory.empty())
+		{
+			std::cerr << "Running " << soundsDirectory.u8string() << '\n';
+			RunSoundBenchmarks(runner, soundsDirectory);
+		}
+
+		RunPaletteBenchmarks(runner);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: " << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	if (outputFileName.empty())
+	{
+		runner.WriteJson(std::cout, properties);
+	}
+	else
+	{
+		std::ofstream stream{outputFileName};
+
+		if (!stream)
+		{
+			std::cerr << "Could not open \"" << outputFileName.u8string() << "\" for writing\n";
+			return EXIT_FAILURE;
+		}
+
+		runner.WriteJson(stream, properties);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "benchmarks/Benchmark.hpp"
+#include "benchmarks/Suites.hpp"
+
+#include "soundsystem/WaveFile.hpp"
+
+namespace benchmarks
+{
+void RunSoundBenchmarks(BenchmarkRunner& runner, const std::filesystem::path& directory)
+{
+	std::vector<std::string> fileNames;
+	double totalSize = 0;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator{directory})
+	{
+		if (!entry.is_regular_file())
+		{
+			continue;
+		}
+
+		auto extension = entry.path().extension().u8string();
+
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+		if (extension == ".wav")
+		{
+			fileNames.push_back(entry.path().u8string());
+			totalSize += static_cast<double>(entry.file_size());
+		}
+	}
+
+	if (fileNames.empty())
+	{
+		return;
+	}
+
+	std::sort(fileNames.begin(), fileNames.end());
+
+	//Files are loaded as a batch since game directories contain thousands of short sounds
+	const std::string input{directory.filename().u8string() + " (" + std::to_string(fileNames.size()) + " files)"};
+
+	runner.Run("LoadWaveFile/Direct", input, [&]()
+		{
+			for (const auto& fileName : fileNames)
+			{
+				const auto wave = soundsystem::LoadWaveFile(fileName);
+				DoNotOptimize(wave);
+			}
+		}, totalSize, static_cast<double>(fileNames.size()));
+
+	runner.Run("LoadWaveFile/AudioFile", input, [&]()
+		{
+			for (const auto& fileName : fileNames)
+			{
+				const auto wave = soundsystem::LoadWaveFileWithAudioFile(fileName);
+				DoNotOptimize(wave);
+			}
+		}, totalSize, static_cast<double>(fileNames.size()));
+}
+}
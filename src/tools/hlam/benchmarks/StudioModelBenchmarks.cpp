@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/mat3x4.hpp>
+
+#include "benchmarks/Benchmark.hpp"
+#include "benchmarks/Suites.hpp"
+
+#include "engine/renderer/studiomodel/BoneSetup.hpp"
+
+#include "engine/shared/renderer/studiomodel/ModelRenderInfo.hpp"
+#include "engine/shared/studiomodel/DumpModelInfo.hpp"
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+#include "utility/MathBatch.hpp"
+
+using namespace studiomdl;
+
+namespace benchmarks
+{
+namespace
+{
+ModelRenderInfo CreateRenderInfo(StudioModel& model)
+{
+	ModelRenderInfo renderInfo{};
+
+	renderInfo.Scale = {1, 1, 1};
+	renderInfo.Model = &model;
+	renderInfo.Transparency = 1;
+	renderInfo.Blender[0] = renderInfo.Blender[1] = 127;
+	renderInfo.Controller[0] = renderInfo.Controller[1] = renderInfo.Controller[2] = renderInfo.Controller[3] = 127;
+
+	return renderInfo;
+}
+
+/**
+*	@brief Gets the first sequence with the given number of blends, or -1 if there is none.
+*/
+int FindSequenceWithBlends(const studiohdr_t& header, int blendCount)
+{
+	for (int i = 0; i < header.numseq; ++i)
+	{
+		if (header.GetSequence(i)->numblends == blendCount)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void RunLoadBenchmarks(BenchmarkRunner& runner, const std::filesystem::path& fileName, std::string_view input)
+{
+	const std::string utf8FileName{fileName.u8string()};
+
+	const double fileSize = static_cast<double>(std::filesystem::file_size(fileName));
+
+	const std::pair<const char*, bool> modes[] = {{"Read", false}, {"Mapped", true}};
+
+	//The operating system may still have the file cached, so this is the first load in the process, not a load from disk
+	for (const auto& [modeName, useMemoryMapping] : modes)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		auto model = LoadStudioModel(utf8FileName.c_str(), useMemoryMapping);
+
+		runner.Record(std::string{"LoadStudioModel/Cold/"} + modeName, input, std::chrono::steady_clock::now() - start, fileSize);
+
+		DoNotOptimize(model);
+	}
+
+	for (const auto& [modeName, useMemoryMapping] : modes)
+	{
+		runner.Run(std::string{"LoadStudioModel/Warm/"} + modeName, input, [&, useMemoryMapping = useMemoryMapping]()
+			{
+				auto model = LoadStudioModel(utf8FileName.c_str(), useMemoryMapping);
+				DoNotOptimize(model);
+			}, fileSize);
+	}
+}
+
+void RunAnimationBenchmarks(BenchmarkRunner& runner, StudioModel& model, std::string_view input)
+{
+	const auto header = model.GetStudioHeader();
+
+	if (header->numseq <= 0 || header->numbones <= 0)
+	{
+		return;
+	}
+
+	auto renderInfo = CreateRenderInfo(model);
+
+	auto boneSetup = std::make_unique<BoneSetup>();
+	auto pose = std::make_unique<BonePose>();
+
+	const std::pair<const char*, bool> sources[] = {{"Decoded", true}, {"RunLengthEncoded", false}};
+
+	//The last frame is the worst case for the run-length encoded data since every span before it has to be skipped
+	const std::pair<const char*, float> frames[] =
+	{
+		{"FirstFrame", 0.f},
+		{"LastFrame", static_cast<float>(std::max(0, header->GetSequence(0)->numframes - 1))}
+	};
+
+	for (const auto& [sourceName, useAnimationCache] : sources)
+	{
+		for (const auto& [frameName, frame] : frames)
+		{
+			renderInfo.Sequence = 0;
+			renderInfo.Frame = frame;
+
+			runner.Run(std::string{"CalcRotations/"} + sourceName + '/' + frameName, input,
+				[&, useAnimationCache = useAnimationCache]()
+				{
+					boneSetup->CalcSequencePose(renderInfo, 0, useAnimationCache, *pose);
+					DoNotOptimize(*pose);
+				}, 0, header->numbones);
+		}
+	}
+
+	auto boneTransforms = std::make_unique<glm::mat3x4[]>(MAXSTUDIOBONES);
+
+	//Every iteration calculates the pose from scratch, like the renderer does when its pose cache misses
+	for (const int blendCount : {1, 4, 9})
+	{
+		const int sequence = FindSequenceWithBlends(*header, blendCount);
+
+		if (sequence == -1)
+		{
+			continue;
+		}
+
+		renderInfo.Sequence = sequence;
+		renderInfo.Frame = header->GetSequence(sequence)->numframes / 2.f;
+
+		const std::string name{"SetUpBones/Blends" + std::to_string(blendCount)};
+
+		runner.Run(name + "/Decoded", input, [&]()
+			{
+				boneSetup->CalcBoneTransforms(renderInfo, boneTransforms.get());
+				DoNotOptimize(boneTransforms[0]);
+			}, 0, header->numbones);
+
+		runner.Run(name + "/RunLengthEncoded", input, [&]()
+			{
+				boneSetup->CalcBoneTransforms(renderInfo, nullptr, boneTransforms.get());
+				DoNotOptimize(boneTransforms[0]);
+			}, 0, header->numbones);
+	}
+}
+
+/**
+*	@brief Measures transforming each body part's first submodel by the bones, the part of skinning that runs on the CPU.
+*	Lighting is done by the renderer so it is not included, which keeps this program free of OpenGL.
+*/
+void RunVertexTransformBenchmarks(BenchmarkRunner& runner, StudioModel& model, std::string_view input)
+{
+	const auto header = model.GetStudioHeader();
+
+	std::vector<const mstudiomodel_t*> submodels;
+
+	int vertexCount = 0;
+	int maxVertexCount = 0;
+	int maxNormalCount = 0;
+
+	for (int i = 0; i < header->numbodyparts; ++i)
+	{
+		const auto& bodyPart = *header->GetBodypart(i);
+
+		if (bodyPart.nummodels > 0)
+		{
+			const auto submodel = reinterpret_cast<const mstudiomodel_t*>(header->GetData() + bodyPart.modelindex);
+
+			submodels.push_back(submodel);
+			vertexCount += submodel->numverts;
+			maxVertexCount = std::max(maxVertexCount, submodel->numverts);
+			maxNormalCount = std::max(maxNormalCount, submodel->numnorms);
+		}
+	}
+
+	if (vertexCount == 0 || header->numbones <= 0)
+	{
+		return;
+	}
+
+	auto renderInfo = CreateRenderInfo(model);
+
+	//Bones are calculated once and reused, only the vertices and normals are transformed every iteration
+	auto boneSetup = std::make_unique<BoneSetup>();
+	auto boneTransforms = std::make_unique<glm::mat3x4[]>(MAXSTUDIOBONES);
+
+	boneSetup->CalcBoneTransforms(renderInfo, boneTransforms.get());
+
+	std::vector<glm::vec3> vertices(maxVertexCount);
+	std::vector<glm::vec3> normals(maxNormalCount);
+
+	const auto data = reinterpret_cast<const byte*>(header);
+
+	const auto originalImplementation = GetMathBatchImplementation();
+
+	for (const auto implementation : {MathBatchImplementation::Scalar, MathBatchImplementation::SSE2, MathBatchImplementation::AVX2})
+	{
+		if (!SetMathBatchImplementation(implementation))
+		{
+			continue;
+		}
+
+		runner.Run(std::string{"TransformVertices/"} + MathBatchImplementationToString(implementation), input, [&]()
+			{
+				for (const auto submodel : submodels)
+				{
+					VectorTransformBatch(reinterpret_cast<const glm::vec3*>(data + submodel->vertindex), data + submodel->vertinfoindex,
+						boneTransforms.get(), header->numbones, vertices.data(), submodel->numverts);
+
+					VectorRotateBatch(reinterpret_cast<const glm::vec3*>(data + submodel->normindex), data + submodel->norminfoindex,
+						boneTransforms.get(), header->numbones, normals.data(), submodel->numnorms);
+				}
+
+				DoNotOptimize(vertices[0]);
+			}, 0, vertexCount);
+	}
+
+	SetMathBatchImplementation(originalImplementation);
+}
+
+void RunDumpModelInfoBenchmark(BenchmarkRunner& runner, StudioModel& model, std::string_view input)
+{
+	if (!runner.ShouldRun("DumpModelInfo"))
+	{
+		return;
+	}
+
+	const std::unique_ptr<FILE, decltype(&std::fclose)> file{std::tmpfile(), &std::fclose};
+
+	if (!file)
+	{
+		return;
+	}
+
+	runner.Run("DumpModelInfo", input, [&]()
+		{
+			std::rewind(file.get());
+			DumpModelInfo(file.get(), model);
+		});
+}
+}
+
+void RunModelDirectoryLoadBenchmarks(BenchmarkRunner& runner, const std::vector<std::filesystem::path>& fileNames, std::string_view input)
+{
+	const std::pair<const char*, bool> modes[] = {{"Read", false}, {"Mapped", true}};
+
+	for (const auto& [modeName, useMemoryMapping] : modes)
+	{
+		const std::string name{std::string{"LoadModelDirectory/"} + modeName};
+
+		if (!runner.ShouldRun(name))
+		{
+			continue;
+		}
+
+		std::vector<std::unique_ptr<StudioModel>> models;
+
+		models.reserve(fileNames.size());
+
+		double totalSize = 0;
+
+		const std::size_t residentMemoryBefore = GetResidentMemorySize();
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (const auto& fileName : fileNames)
+		{
+			try
+			{
+				models.push_back(LoadStudioModel(fileName.u8string().c_str(), useMemoryMapping));
+			}
+			catch (const assets::AssetException&)
+			{
+				//Texture and sequence group files are loaded along with their main file, models that fail to load are reported elsewhere
+				continue;
+			}
+
+			totalSize += static_cast<double>(std::filesystem::file_size(fileName));
+		}
+
+		const auto duration = std::chrono::steady_clock::now() - start;
+
+		//Measured while all models are still loaded
+		const std::size_t residentMemoryAfter = GetResidentMemorySize();
+
+		runner.RecordMemoryUse(name, input, duration, residentMemoryBefore, residentMemoryAfter, totalSize);
+
+		DoNotOptimize(models);
+	}
+}
+
+void RunStudioModelBenchmarks(BenchmarkRunner& runner, const std::filesystem::path& fileName, std::string_view input)
+{
+	RunLoadBenchmarks(runner, fileName, input);
+
+	const auto model = LoadStudioModel(fileName.u8string().c_str());
+
+	RunAnimationBenchmarks(runner, *model, input);
+	RunVertexTransformBenchmarks(runner, *model, input);
+	RunDumpModelInfoBenchmark(runner, *model, input);
+	RunModelTextureBenchmarks(runner, *model, input);
+}
+}
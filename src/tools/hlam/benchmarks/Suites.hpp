@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace studiomdl
+{
+class StudioModel;
+}
+
+namespace benchmarks
+{
+class BenchmarkRunner;
+
+/**
+*	@brief Runs all benchmarks that operate on a studio model.
+*	The model is loaded cold first, so this should be called before anything else loads it in this process.
+*	@param input Name to report the model as
+*	@exception assets::AssetException If the model could not be loaded
+*/
+void RunStudioModelBenchmarks(BenchmarkRunner& runner, const std::filesystem::path& fileName, std::string_view input);
+
+/**
+*	@brief Measures loading all models in a directory and keeping them loaded, with and without memory mapping.
+*	The process's resident memory is recorded before and after each pass so the memory use of both modes can be compared.
+*	@param fileNames Main, texture and sequence group files. Files that are not main files are skipped
+*	@param input Name to report the directory as
+*/
+void RunModelDirectoryLoadBenchmarks(BenchmarkRunner& runner, const std::vector<std::filesystem::path>& fileNames, std::string_view input);
+
+/**
+*	@brief Measures converting the model's textures to RGBA, with each conversion implementation and with multiple threads.
+*/
+void RunModelTextureBenchmarks(BenchmarkRunner& runner, studiomdl::StudioModel& model, std::string_view input);
+
+/**
+*	@brief Measures loading all wave files in a directory and its subdirectories,
+*	directly and by decoding them with AudioFile.
+*/
+void RunSoundBenchmarks(BenchmarkRunner& runner, const std::filesystem::path& directory);
+
+/**
+*	@brief Runs benchmarks that don't need a model.
+*/
+void RunPaletteBenchmarks(BenchmarkRunner& runner);
+}
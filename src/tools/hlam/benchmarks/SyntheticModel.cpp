@@ -0,0 +1,492 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
+
+#include "benchmarks/SyntheticModel.hpp"
+
+#include "graphics/Palette.hpp"
+
+#include "utility/IOUtils.hpp"
+#include "utility/mathlib.hpp"
+
+namespace benchmarks
+{
+namespace
+{
+/**
+*	@brief Scale of animated positions, in units per animation value.
+*/
+constexpr float PositionScale = 1.f / 256.f;
+
+/**
+*	@brief Scale of animated rotations, in radians per animation value.
+*/
+constexpr float RotationScale = 1.f / 8192.f;
+
+/**
+*	@brief Maximum number of frames stored in one run-length encoded span.
+*	Real models use longer spans for constant values, short spans make the decoder walk more of them.
+*/
+constexpr int MaxFramesPerSpan = 16;
+
+constexpr int FirstRotationChannel = 3;
+constexpr int ChannelCount = 6;
+
+const int BlendCounts[] = {1, 4, 9};
+
+/**
+*	@brief Appends zero initialized data to a buffer and hands out offsets to it.
+*	Pointers are invalidated by the next allocation, so data is accessed through offsets.
+*/
+class ModelBuilder final
+{
+public:
+	template<typename T>
+	int Allocate(int count = 1)
+	{
+		const std::size_t offset = (_data.size() + 3) & ~std::size_t{3};
+
+		_data.resize(offset + (sizeof(T) * count));
+
+		return static_cast<int>(offset);
+	}
+
+	template<typename T>
+	T* At(int offset)
+	{
+		return reinterpret_cast<T*>(_data.data() + offset);
+	}
+
+	std::vector<byte> Finish()
+	{
+		_data.resize((_data.size() + 3) & ~std::size_t{3});
+		At<studiohdr_t>(0)->length = static_cast<int>(_data.size());
+		return std::move(_data);
+	}
+
+private:
+	std::vector<byte> _data;
+};
+
+template<std::size_t Size>
+void CopyName(char (&destination)[Size], const std::string& name)
+{
+	std::snprintf(destination, Size, "%s", name.c_str());
+}
+
+short AnimationValue(int bone, int channel, int frame, int frameCount)
+{
+	const double angle = (frame * 2 * PI<double> / frameCount) + (bone * 0.37) + channel;
+	return static_cast<short>(std::lround(std::sin(angle) * 2048));
+}
+
+/**
+*	@brief Appends the run-length encoded values of one channel. The stream ends with an extra span
+*	holding the first frame, since interpolating the last frame reads the first value of the next span.
+*	@return Offset of the stream
+*/
+int WriteAnimationValues(ModelBuilder& builder, int bone, int channel, int frameCount)
+{
+	const int spanCount = (frameCount + MaxFramesPerSpan - 1) / MaxFramesPerSpan;
+
+	const int offset = builder.Allocate<mstudioanimvalue_t>(frameCount + spanCount + 2);
+
+	auto values = builder.At<mstudioanimvalue_t>(offset);
+
+	for (int frame = 0; frame < frameCount; frame += MaxFramesPerSpan)
+	{
+		const int count = std::min(MaxFramesPerSpan, frameCount - frame);
+
+		values->num.valid = static_cast<byte>(count);
+		values->num.total = static_cast<byte>(count);
+		++values;
+
+		for (int i = 0; i < count; ++i, ++values)
+		{
+			values->value = AnimationValue(bone, channel, frame + i, frameCount);
+		}
+	}
+
+	values[0].num.valid = 1;
+	values[0].num.total = 1;
+	values[1].value = AnimationValue(bone, channel, 0, frameCount);
+
+	return offset;
+}
+
+/**
+*	@brief Writes the animation data for a sequence with the given number of blends.
+*	Each blend uses the rotation streams of other bones so blends differ without storing more data.
+*	@return Offset of the first mstudioanim_t
+*/
+int WriteAnimations(ModelBuilder& builder, int boneCount, int blendCount, int frameCount)
+{
+	const int animIndex = builder.Allocate<mstudioanim_t>(blendCount * boneCount);
+
+	std::vector<int> streams(static_cast<std::size_t>(boneCount) * ChannelCount, 0);
+
+	for (int bone = 0; bone < boneCount; ++bone)
+	{
+		//Only the root bone moves, the others only rotate
+		const int firstChannel = bone == 0 ? 0 : FirstRotationChannel;
+
+		for (int channel = firstChannel; channel < ChannelCount; ++channel)
+		{
+			streams[(bone * ChannelCount) + channel] = WriteAnimationValues(builder, bone, channel, frameCount);
+		}
+	}
+
+	for (int blend = 0; blend < blendCount; ++blend)
+	{
+		for (int bone = 0; bone < boneCount; ++bone)
+		{
+			const int animOffset = animIndex + (((blend * boneCount) + bone) * static_cast<int>(sizeof(mstudioanim_t)));
+
+			auto anim = builder.At<mstudioanim_t>(animOffset);
+
+			for (int channel = 0; channel < ChannelCount; ++channel)
+			{
+				const int sourceBone = channel >= FirstRotationChannel ? (bone + (blend * 7)) % boneCount : bone;
+				const int stream = streams[(sourceBone * ChannelCount) + channel];
+
+				if (stream == 0)
+				{
+					continue;
+				}
+
+				const int relativeOffset = stream - animOffset;
+
+				if (relativeOffset <= 0 || relativeOffset > std::numeric_limits<unsigned short>::max())
+				{
+					throw std::invalid_argument("Animation data is too large, use fewer bones or frames");
+				}
+
+				anim->offset[channel] = static_cast<unsigned short>(relativeOffset);
+			}
+		}
+	}
+
+	return animIndex;
+}
+}
+
+std::vector<byte> CreateSyntheticModel(const SyntheticModelSettings& settings)
+{
+	if (settings.Name.empty())
+	{
+		throw std::invalid_argument("Synthetic model must have a name");
+	}
+
+	if (settings.Bones < 1 || settings.Bones > MAXSTUDIOBONES
+		|| settings.Vertices < 3 || settings.Vertices > MAXSTUDIOVERTS
+		|| settings.Meshes < 1 || settings.Meshes > MAXSTUDIOMESHES || (settings.Vertices / settings.Meshes) < 3
+		|| settings.Frames < 1 || settings.Textures < 1 || settings.TextureWidth < 1 || settings.TextureHeight < 1)
+	{
+		throw std::invalid_argument("Synthetic model settings are out of range");
+	}
+
+	ModelBuilder builder;
+
+	builder.Allocate<studiohdr_t>();
+
+	{
+		auto header = builder.At<studiohdr_t>(0);
+
+		std::memcpy(&header->id, STUDIOMDL_HDR_ID, sizeof(header->id));
+		header->version = STUDIO_VERSION;
+		CopyName(header->name, settings.Name + ".mdl");
+
+		header->eyeposition = {0, 0, 64};
+		header->min = header->bbmin = {-32, -32, 0};
+		header->max = header->bbmax = {32, 32, 72};
+	}
+
+	//Bones form a balanced tree so concatenating transforms follows realistic parent chains
+	const int boneIndex = builder.Allocate<mstudiobone_t>(settings.Bones);
+
+	for (int i = 0; i < settings.Bones; ++i)
+	{
+		auto& bone = builder.At<mstudiobone_t>(boneIndex)[i];
+
+		CopyName(bone.name, "Bone" + std::to_string(i));
+		bone.parent = i > 0 ? (i - 1) / 2 : -1;
+
+		std::fill(std::begin(bone.bonecontroller), std::end(bone.bonecontroller), -1);
+
+		bone.value[0] = 0;
+		bone.value[1] = static_cast<float>((i % 3) - 1);
+		bone.value[2] = i > 0 ? 4.f : 36.f;
+
+		for (int channel = 0; channel < ChannelCount; ++channel)
+		{
+			bone.scale[channel] = channel < FirstRotationChannel ? PositionScale : RotationScale;
+		}
+	}
+
+	builder.At<mstudiobone_t>(boneIndex)[0].bonecontroller[5] = 0;
+
+	const int boneControllerIndex = builder.Allocate<mstudiobonecontroller_t>();
+
+	{
+		auto controller = builder.At<mstudiobonecontroller_t>(boneControllerIndex);
+
+		controller->bone = 0;
+		controller->type = STUDIO_ZR;
+		controller->start = -30;
+		controller->end = 30;
+		controller->index = 0;
+	}
+
+	const int hitboxCount = (settings.Bones + 7) / 8;
+	const int hitboxIndex = builder.Allocate<mstudiobbox_t>(hitboxCount);
+
+	for (int i = 0; i < hitboxCount; ++i)
+	{
+		auto& hitbox = builder.At<mstudiobbox_t>(hitboxIndex)[i];
+
+		hitbox.bone = i * 8;
+		hitbox.group = i % 8;
+		hitbox.bbmin = {-2, -2, -2};
+		hitbox.bbmax = {2, 2, 2};
+	}
+
+	const int sequenceGroupIndex = builder.Allocate<mstudioseqgroup_t>();
+
+	CopyName(builder.At<mstudioseqgroup_t>(sequenceGroupIndex)->label, "default");
+
+	const int sequenceCount = static_cast<int>(std::size(BlendCounts));
+	const int sequenceIndex = builder.Allocate<mstudioseqdesc_t>(sequenceCount);
+
+	for (int i = 0; i < sequenceCount; ++i)
+	{
+		const int blendCount = BlendCounts[i];
+
+		const int eventIndex = builder.Allocate<mstudioevent_t>(2);
+
+		for (int j = 0; j < 2; ++j)
+		{
+			auto& event = builder.At<mstudioevent_t>(eventIndex)[j];
+
+			event.frame = (settings.Frames * j) / 2;
+			event.event = 5004;
+			CopyName(event.options, "common/null.wav");
+		}
+
+		const int animIndex = WriteAnimations(builder, settings.Bones, blendCount, settings.Frames);
+
+		auto& sequence = builder.At<mstudioseqdesc_t>(sequenceIndex)[i];
+
+		CopyName(sequence.label, "blend" + std::to_string(blendCount));
+		sequence.fps = 30;
+		sequence.flags = STUDIO_LOOPING;
+		sequence.numevents = 2;
+		sequence.eventindex = eventIndex;
+		sequence.numframes = settings.Frames;
+		sequence.bbmin = {-32, -32, 0};
+		sequence.bbmax = {32, 32, 72};
+		sequence.numblends = blendCount;
+		sequence.animindex = animIndex;
+
+		if (blendCount > 1)
+		{
+			sequence.blendtype[0] = STUDIO_XR;
+			sequence.blendstart[0] = -45;
+			sequence.blendend[0] = 45;
+			sequence.blendtype[1] = STUDIO_YR;
+			sequence.blendstart[1] = -45;
+			sequence.blendend[1] = 45;
+		}
+	}
+
+	const int textureIndex = builder.Allocate<mstudiotexture_t>(settings.Textures);
+
+	int textureDataIndex = 0;
+
+	for (int i = 0; i < settings.Textures; ++i)
+	{
+		const int pixelCount = settings.TextureWidth * settings.TextureHeight;
+
+		const int dataIndex = builder.Allocate<byte>(pixelCount + static_cast<int>(PALETTE_SIZE));
+
+		if (i == 0)
+		{
+			textureDataIndex = dataIndex;
+		}
+
+		auto pixels = builder.At<byte>(dataIndex);
+
+		for (int y = 0; y < settings.TextureHeight; ++y)
+		{
+			for (int x = 0; x < settings.TextureWidth; ++x)
+			{
+				*pixels++ = static_cast<byte>((x ^ y) + i);
+			}
+		}
+
+		for (int color = 0; color < static_cast<int>(PALETTE_ENTRIES); ++color)
+		{
+			pixels[(color * 3) + 0] = static_cast<byte>(color);
+			pixels[(color * 3) + 1] = static_cast<byte>(255 - color);
+			pixels[(color * 3) + 2] = static_cast<byte>(color * 7);
+		}
+
+		auto& texture = builder.At<mstudiotexture_t>(textureIndex)[i];
+
+		CopyName(texture.name, "texture" + std::to_string(i) + ".bmp");
+		texture.flags = i == 1 ? STUDIO_NF_CHROME : 0;
+		texture.width = settings.TextureWidth;
+		texture.height = settings.TextureHeight;
+		texture.index = dataIndex;
+	}
+
+	const int skinIndex = builder.Allocate<short>(settings.Textures);
+
+	for (int i = 0; i < settings.Textures; ++i)
+	{
+		builder.At<short>(skinIndex)[i] = static_cast<short>(i);
+	}
+
+	//One submodel with a normal for every vertex
+	const int vertexInfoIndex = builder.Allocate<byte>(settings.Vertices);
+	const int normalInfoIndex = builder.Allocate<byte>(settings.Vertices);
+	const int vertexIndex = builder.Allocate<glm::vec3>(settings.Vertices);
+	const int normalIndex = builder.Allocate<glm::vec3>(settings.Vertices);
+
+	for (int i = 0; i < settings.Vertices; ++i)
+	{
+		const byte bone = static_cast<byte>((i * settings.Bones) / settings.Vertices);
+
+		builder.At<byte>(vertexInfoIndex)[i] = bone;
+		builder.At<byte>(normalInfoIndex)[i] = bone;
+
+		const float angle = static_cast<float>(i) * 0.7f;
+
+		builder.At<glm::vec3>(vertexIndex)[i] = {std::cos(angle) * 2, std::sin(angle) * 2, static_cast<float>(i % 4)};
+		builder.At<glm::vec3>(normalIndex)[i] = {std::cos(angle), std::sin(angle), 0};
+	}
+
+	const int meshIndex = builder.Allocate<mstudiomesh_t>(settings.Meshes);
+
+	for (int i = 0; i < settings.Meshes; ++i)
+	{
+		const int firstVertex = (settings.Vertices * i) / settings.Meshes;
+		const int lastVertex = (settings.Vertices * (i + 1)) / settings.Meshes;
+
+		//Triangle strips of up to 16 vertices, each followed by 4 shorts per vertex, then a terminating 0
+		std::vector<short> commands;
+
+		for (int first = firstVertex; first < lastVertex; first += 16)
+		{
+			const int start = std::min(first, lastVertex - 3);
+			const int count = std::min(16, lastVertex - start);
+
+			commands.push_back(static_cast<short>(count));
+
+			for (int vertex = start; vertex < start + count; ++vertex)
+			{
+				commands.push_back(static_cast<short>(vertex));
+				commands.push_back(static_cast<short>(vertex));
+				commands.push_back(static_cast<short>((vertex * 5) % settings.TextureWidth));
+				commands.push_back(static_cast<short>((vertex * 3) % settings.TextureHeight));
+			}
+		}
+
+		commands.push_back(0);
+
+		const int triIndex = builder.Allocate<short>(static_cast<int>(commands.size()));
+
+		std::copy(commands.begin(), commands.end(), builder.At<short>(triIndex));
+
+		auto& mesh = builder.At<mstudiomesh_t>(meshIndex)[i];
+
+		mesh.numtris = lastVertex - firstVertex - 2;
+		mesh.triindex = triIndex;
+		mesh.skinref = i % settings.Textures;
+		mesh.numnorms = lastVertex - firstVertex;
+		mesh.normindex = normalIndex + (firstVertex * static_cast<int>(sizeof(glm::vec3)));
+	}
+
+	const int modelIndex = builder.Allocate<mstudiomodel_t>();
+
+	{
+		auto model = builder.At<mstudiomodel_t>(modelIndex);
+
+		CopyName(model->name, "body");
+		model->boundingradius = 64;
+		model->nummesh = settings.Meshes;
+		model->meshindex = meshIndex;
+		model->numverts = settings.Vertices;
+		model->vertinfoindex = vertexInfoIndex;
+		model->vertindex = vertexIndex;
+		model->numnorms = settings.Vertices;
+		model->norminfoindex = normalInfoIndex;
+		model->normindex = normalIndex;
+	}
+
+	const int bodyPartIndex = builder.Allocate<mstudiobodyparts_t>();
+
+	{
+		auto bodyPart = builder.At<mstudiobodyparts_t>(bodyPartIndex);
+
+		CopyName(bodyPart->name, "body");
+		bodyPart->nummodels = 1;
+		bodyPart->base = 1;
+		bodyPart->modelindex = modelIndex;
+	}
+
+	auto header = builder.At<studiohdr_t>(0);
+
+	header->numbones = settings.Bones;
+	header->boneindex = boneIndex;
+	header->numbonecontrollers = 1;
+	header->bonecontrollerindex = boneControllerIndex;
+	header->numhitboxes = hitboxCount;
+	header->hitboxindex = hitboxIndex;
+	header->numseq = sequenceCount;
+	header->seqindex = sequenceIndex;
+	header->numseqgroups = 1;
+	header->seqgroupindex = sequenceGroupIndex;
+	header->numtextures = settings.Textures;
+	header->textureindex = textureIndex;
+	header->texturedataindex = textureDataIndex;
+	header->numskinref = settings.Textures;
+	header->numskinfamilies = 1;
+	header->skinindex = skinIndex;
+	header->numbodyparts = 1;
+	header->bodypartindex = bodyPartIndex;
+
+	return builder.Finish();
+}
+
+std::filesystem::path WriteSyntheticModel(const SyntheticModelSettings& settings, const std::filesystem::path& directory)
+{
+	const auto data = CreateSyntheticModel(settings);
+
+	std::filesystem::create_directories(directory);
+
+	const auto fileName = directory / std::filesystem::u8path(settings.Name + ".mdl");
+
+	FILE* file = utf8_fopen(fileName.u8string().c_str(), "wb");
+
+	if (!file)
+	{
+		throw std::runtime_error("Could not open \"" + fileName.u8string() + "\" for writing");
+	}
+
+	const bool success = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+
+	std::fclose(file);
+
+	if (!success)
+	{
+		throw std::runtime_error("Error writing \"" + fileName.u8string() + "\"");
+	}
+
+	return fileName;
+}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "core/shared/Const.hpp"
+
+namespace benchmarks
+{
+/**
+*	@brief Describes a generated studio model.
+*	Sequences with 1, 4 and 9 blends are always generated, so every blending path can be measured.
+*/
+struct SyntheticModelSettings
+{
+	std::string Name;
+
+	int Bones = 128;
+	int Vertices = 2048;
+	int Meshes = 8;
+	int Frames = 30;
+	int Textures = 4;
+	int TextureWidth = 320;
+	int TextureHeight = 200;
+};
+
+/**
+*	@brief Creates the contents of a studio model file that stores its textures in the main file.
+*	The data is deterministic so results from different builds can be compared.
+*	@exception std::invalid_argument If the settings describe a model the format can't store
+*/
+std::vector<byte> CreateSyntheticModel(const SyntheticModelSettings& settings);
+
+/**
+*	@brief Creates a synthetic model and writes it to directory, named after the model.
+*	@return Path to the file
+*	@exception std::runtime_error If the file could not be written
+*/
+std::filesystem::path WriteSyntheticModel(const SyntheticModelSettings& settings, const std::filesystem::path& directory);
+}
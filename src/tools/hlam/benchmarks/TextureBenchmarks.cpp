@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "benchmarks/Benchmark.hpp"
+#include "benchmarks/Suites.hpp"
+
+#include "core/shared/JobSystem.hpp"
+
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+#include "graphics/GraphicsUtils.hpp"
+#include "graphics/Palette.hpp"
+#include "graphics/TextureConversion.hpp"
+#include "graphics/TextureLoader.hpp"
+
+using namespace studiomdl;
+
+namespace benchmarks
+{
+void RunModelTextureBenchmarks(BenchmarkRunner& runner, StudioModel& model, std::string_view input)
+{
+	const auto textureHeader = model.GetTextureHeader();
+
+	if (textureHeader->textureindex <= 0 || textureHeader->numtextures <= 0)
+	{
+		return;
+	}
+
+	const byte* const data = reinterpret_cast<const byte*>(textureHeader);
+
+	double pixelCount = 0;
+
+	for (int i = 0; i < textureHeader->numtextures; ++i)
+	{
+		const auto& texture = *textureHeader->GetTexture(i);
+		pixelCount += static_cast<double>(texture.width) * texture.height;
+	}
+
+	//Same settings the program uses by default
+	graphics::TextureLoader textureLoader;
+
+	const auto originalImplementation = graphics::GetTextureConversionImplementation();
+
+	for (const auto implementation : {
+		graphics::TextureConversionImplementation::Scalar,
+		graphics::TextureConversionImplementation::SSE2,
+		graphics::TextureConversionImplementation::AVX2})
+	{
+		if (!graphics::SetTextureConversionImplementation(implementation))
+		{
+			continue;
+		}
+
+		runner.Run(std::string{"ConvertIndexed8/"} + graphics::TextureConversionImplementationToString(implementation), input, [&]()
+			{
+				for (int i = 0; i < textureHeader->numtextures; ++i)
+				{
+					const auto& texture = *textureHeader->GetTexture(i);
+
+					const auto image = textureLoader.ConvertIndexed8(
+						texture.width, texture.height,
+						data + texture.index,
+						data + texture.index + (texture.width * texture.height),
+						(texture.flags & STUDIO_NF_MASKED) != 0);
+
+					DoNotOptimize(image);
+				}
+			}, pixelCount);
+	}
+
+	graphics::SetTextureConversionImplementation(originalImplementation);
+
+	for (const std::size_t threadCount : {1, 2, 4, 8})
+	{
+		const std::string name{"PrepareTextures/Threads" + std::to_string(threadCount)};
+
+		if (!runner.ShouldRun(name))
+		{
+			continue;
+		}
+
+		//The calling thread converts textures too, so one thread needs no job system
+		const auto jobSystem = threadCount > 1 ? std::make_unique<JobSystem>(threadCount - 1) : nullptr;
+
+		runner.Run(name, input, [&]()
+			{
+				model.PrepareTextures(textureLoader, jobSystem.get());
+			}, pixelCount);
+	}
+}
+
+void RunPaletteBenchmarks(BenchmarkRunner& runner)
+{
+	byte originalPalette[PALETTE_SIZE];
+
+	for (std::size_t i = 0; i < PALETTE_ENTRIES; ++i)
+	{
+		originalPalette[(i * 3) + 0] = static_cast<byte>(i);
+		originalPalette[(i * 3) + 1] = static_cast<byte>(i / 2);
+		originalPalette[(i * 3) + 2] = static_cast<byte>(255 - i);
+	}
+
+	byte palette[PALETTE_SIZE];
+
+	int hue = 0;
+
+	//Starts from the original palette every time, like the textures panel does when a slider moves
+	runner.Run("PaletteHueReplace", "Palette256", [&]()
+		{
+			std::copy(std::begin(originalPalette), std::end(originalPalette), palette);
+			graphics::PaletteHueReplace(palette, hue, 0, static_cast<int>(PALETTE_ENTRIES) - 1);
+			hue = (hue + 1) % 256;
+			DoNotOptimize(palette);
+		}, 0, PALETTE_ENTRIES);
+}
+}
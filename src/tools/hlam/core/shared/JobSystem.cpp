@@ -0,0 +1,366 @@
+#include <exception>
+#include <string>
+
+#include "core/shared/JobSystem.hpp"
+#include "core/shared/Logging.hpp"
+#include "core/shared/Profiler.hpp"
+
+class Job final
+{
+public:
+	explicit Job(std::function<void()>&& function)
+		: Function(std::move(function))
+	{
+	}
+
+	std::function<void()> Function;
+
+	/**
+	*	Number of dependencies that have not finished yet, plus one until the job has been fully scheduled.
+	*	The job is queued when this reaches zero.
+	*/
+	std::atomic<int> PendingDependencies{1};
+
+	/**
+	*	Guards Continuations and the transition to finished.
+	*/
+	std::mutex Mutex;
+	std::atomic<bool> Finished{false};
+	std::vector<JobHandle> Continuations;
+
+	std::exception_ptr Exception;
+};
+
+namespace
+{
+//Set on worker threads
+thread_local JobSystem* WorkerJobSystem = nullptr;
+thread_local std::size_t CurrentWorkerIndex = 0;
+
+//Set while a job is running, also when a waiting thread runs it
+thread_local JobSystem* RunningJobSystem = nullptr;
+}
+
+JobSystem::JobSystem(std::size_t threadCount)
+{
+	threadCount = std::max<std::size_t>(threadCount, 1);
+
+	_workers.reserve(threadCount);
+
+	for (std::size_t i = 0; i < threadCount; ++i)
+	{
+		_workers.emplace_back(std::make_unique<Worker>());
+	}
+
+	//Start the threads only after all workers exist, they steal from each other
+	for (std::size_t i = 0; i < threadCount; ++i)
+	{
+		_workers[i]->Thread = std::thread(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+std::size_t JobSystem::DefaultThreadCount()
+{
+	const std::size_t hardwareThreads = std::thread::hardware_concurrency();
+
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+JobSystem* JobSystem::GetCurrent()
+{
+	return RunningJobSystem;
+}
+
+JobHandle JobSystem::Schedule(std::function<void()>&& function, std::initializer_list<JobHandle> dependencies)
+{
+	auto job = std::make_shared<Job>(std::move(function));
+
+	for (const auto& dependency : dependencies)
+	{
+		if (!dependency)
+		{
+			continue;
+		}
+
+		std::lock_guard lock{dependency->Mutex};
+
+		if (!dependency->Finished)
+		{
+			++job->PendingDependencies;
+			dependency->Continuations.push_back(job);
+		}
+	}
+
+	//Remove the guard added on construction, if all dependencies have finished by now the job can run
+	if (--job->PendingDependencies == 0)
+	{
+		Enqueue(JobHandle{job});
+	}
+
+	return job;
+}
+
+bool JobSystem::IsFinished(const JobHandle& job)
+{
+	return !job || job->Finished;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	if (!job)
+	{
+		return;
+	}
+
+	//Only workers help out, other threads could otherwise pick up an unrelated job that takes much longer
+	const bool isWorker = WorkerJobSystem == this;
+
+	while (!job->Finished)
+	{
+		if (isWorker && TryRunJob())
+		{
+			continue;
+		}
+
+		std::unique_lock lock{_wakeMutex};
+
+		//No work left to help with, so the job is running on another thread or waiting on one that is
+		_finishedCondition.wait(lock, [&]
+			{
+				return job->Finished || (isWorker && _queuedJobsCount > 0);
+			});
+	}
+
+	if (job->Exception)
+	{
+		std::rethrow_exception(job->Exception);
+	}
+}
+
+void JobSystem::RunOnMainThread(std::function<void()>&& function)
+{
+	bool wasEmpty;
+	std::function<void()> wakeCallback;
+
+	{
+		std::lock_guard lock{_mainThreadMutex};
+
+		wasEmpty = _mainThreadCallbacks.empty();
+		_mainThreadCallbacks.push_back(std::move(function));
+
+		if (wasEmpty)
+		{
+			wakeCallback = _mainThreadWakeCallback;
+		}
+	}
+
+	//The previous wake up has not been handled yet, it will run this callback as well
+	if (wasEmpty && wakeCallback)
+	{
+		wakeCallback();
+	}
+}
+
+void JobSystem::RunMainThreadCallbacks()
+{
+	std::vector<std::function<void()>> callbacks;
+
+	{
+		std::lock_guard lock{_mainThreadMutex};
+		callbacks.swap(_mainThreadCallbacks);
+	}
+
+	for (auto& callback : callbacks)
+	{
+		try
+		{
+			callback();
+		}
+		catch (const std::exception& e)
+		{
+			Error("JobSystem::RunMainThreadCallbacks: Uncaught exception: %s\n", e.what());
+		}
+	}
+}
+
+void JobSystem::SetMainThreadWakeCallback(std::function<void()>&& callback)
+{
+	std::lock_guard lock{_mainThreadMutex};
+	_mainThreadWakeCallback = std::move(callback);
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard lock{_wakeMutex};
+
+		if (_stopping)
+		{
+			return;
+		}
+
+		_stopping = true;
+	}
+
+	_wakeCondition.notify_all();
+
+	for (auto& worker : _workers)
+	{
+		worker->Thread.join();
+	}
+
+	std::lock_guard lock{_mainThreadMutex};
+	_mainThreadCallbacks.clear();
+	_mainThreadWakeCallback = {};
+}
+
+void JobSystem::WorkerMain(std::size_t index)
+{
+	WorkerJobSystem = this;
+	CurrentWorkerIndex = index;
+
+	Profiler::GetInstance().SetThreadName("Worker " + std::to_string(index + 1));
+
+	while (true)
+	{
+		if (TryRunJob())
+		{
+			continue;
+		}
+
+		std::unique_lock lock{_wakeMutex};
+
+		_wakeCondition.wait(lock, [this]
+			{
+				return _queuedJobsCount > 0 || _stopping;
+			});
+
+		//Jobs scheduled before shutdown are always finished
+		if (_stopping && _queuedJobsCount == 0)
+		{
+			break;
+		}
+	}
+
+	WorkerJobSystem = nullptr;
+}
+
+void JobSystem::Enqueue(JobHandle&& job)
+{
+	{
+		std::unique_lock lock{_wakeMutex};
+
+		if (!_stopping)
+		{
+			const std::size_t index = WorkerJobSystem == this ? CurrentWorkerIndex : _nextWorker++ % _workers.size();
+
+			auto& worker = *_workers[index];
+
+			{
+				std::lock_guard workerLock{worker.Mutex};
+				worker.Jobs.push_back(std::move(job));
+			}
+
+			++_queuedJobsCount;
+
+			lock.unlock();
+
+			_wakeCondition.notify_one();
+			_finishedCondition.notify_all();
+			return;
+		}
+	}
+
+	//Workers may already have exited, so run it here
+	Execute(job);
+}
+
+bool JobSystem::TryRunJob()
+{
+	const std::size_t start = CurrentWorkerIndex;
+
+	for (std::size_t i = 0; i < _workers.size(); ++i)
+	{
+		auto& worker = *_workers[(start + i) % _workers.size()];
+
+		JobHandle job;
+
+		{
+			std::lock_guard lock{worker.Mutex};
+
+			if (worker.Jobs.empty())
+			{
+				continue;
+			}
+
+			//Newest job from our own queue since its data is most likely still in cache, oldest job when stealing
+			if (i == 0)
+			{
+				job = std::move(worker.Jobs.back());
+				worker.Jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(worker.Jobs.front());
+				worker.Jobs.pop_front();
+			}
+		}
+
+		--_queuedJobsCount;
+
+		Execute(job);
+
+		return true;
+	}
+
+	return false;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+	JobSystem* const previousJobSystem = RunningJobSystem;
+	RunningJobSystem = this;
+
+	try
+	{
+		PROFILE_ZONE("JobSystem::Job");
+		job->Function();
+	}
+	catch (...)
+	{
+		job->Exception = std::current_exception();
+	}
+
+	RunningJobSystem = previousJobSystem;
+
+	//Release anything captured by the function now instead of when the last handle goes away
+	job->Function = {};
+
+	std::vector<JobHandle> continuations;
+
+	{
+		std::lock_guard lock{job->Mutex};
+		job->Finished = true;
+		continuations.swap(job->Continuations);
+	}
+
+	{
+		//Prevents the notification from being missed by a thread that is about to wait
+		std::lock_guard lock{_wakeMutex};
+	}
+
+	_finishedCondition.notify_all();
+
+	for (auto& continuation : continuations)
+	{
+		if (--continuation->PendingDependencies == 0)
+		{
+			Enqueue(std::move(continuation));
+		}
+	}
+}
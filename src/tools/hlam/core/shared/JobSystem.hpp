@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Job;
+
+/**
+*	@brief Handle to a scheduled job. Only keeps the job's state alive, a job runs whether or not a handle is kept.
+*/
+using JobHandle = std::shared_ptr<Job>;
+
+/**
+*	@brief Runs jobs on a fixed set of worker threads.
+*	Each worker has its own queue. Jobs scheduled by a worker go into its own queue and are run newest first,
+*	workers that run out of jobs steal the oldest jobs from other workers.
+*	Workers that wait on a job run other jobs in the meantime, so jobs can wait on jobs they schedule.
+*	Other threads only block, so the main thread never ends up running an unrelated long job.
+*	Results that have to be used on the main thread are passed back using RunOnMainThread.
+*/
+class JobSystem final
+{
+public:
+	/**
+	*	@param threadCount Number of worker threads to create. Use DefaultThreadCount to use all cores.
+	*/
+	explicit JobSystem(std::size_t threadCount = DefaultThreadCount());
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/**
+	*	@brief Gets the number of worker threads needed to use all cores, leaving one for the main thread.
+	*/
+	static std::size_t DefaultThreadCount();
+
+	/**
+	*	@brief Gets the job system that is running the job on the calling thread, or null if the thread is not running a job.
+	*	Lets jobs split up their work without having to be given the job system.
+	*/
+	static JobSystem* GetCurrent();
+
+	std::size_t GetThreadCount() const { return _workers.size(); }
+
+	/**
+	*	@brief Schedules a function to run on a worker thread once all dependencies have finished.
+	*	Dependencies that throw an exception still count as finished.
+	*	Once the job system has shut down the function is run on the calling thread instead.
+	*/
+	JobHandle Schedule(std::function<void()>&& function, std::initializer_list<JobHandle> dependencies = {});
+
+	/**
+	*	@brief Schedules a function to run once job has finished.
+	*/
+	JobHandle Then(const JobHandle& job, std::function<void()>&& function)
+	{
+		return Schedule(std::move(function), {job});
+	}
+
+	static bool IsFinished(const JobHandle& job);
+
+	/**
+	*	@brief Waits until job has finished. Worker threads run other jobs in the meantime.
+	*	If the job threw an exception it is rethrown here.
+	*/
+	void Wait(const JobHandle& job);
+
+	/**
+	*	@brief Calls function(rangeBegin, rangeEnd) for consecutive ranges of at most grainSize indices covering [begin, end).
+	*	The calling thread and any workers that are free take ranges from a shared counter until none are left.
+	*	The calling thread only waits for ranges that other threads have already started,
+	*	never for workers that are busy with other jobs.
+	*	Returns once all ranges have been processed. The first exception thrown by function is rethrown here.
+	*/
+	template<typename Function>
+	void ParallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, const Function& function);
+
+	/**
+	*	@brief Queues a function to run on the main thread the next time RunMainThreadCallbacks is called.
+	*	Can be called from any thread.
+	*/
+	void RunOnMainThread(std::function<void()>&& function);
+
+	/**
+	*	@brief Runs all functions queued by RunOnMainThread. Must be called on the main thread.
+	*/
+	void RunMainThreadCallbacks();
+
+	/**
+	*	@brief Sets the function used to get the main thread to call RunMainThreadCallbacks.
+	*	Called from the thread that queues a function when there were no functions queued yet.
+	*/
+	void SetMainThreadWakeCallback(std::function<void()>&& callback);
+
+	/**
+	*	@brief Finishes all scheduled jobs and stops the worker threads.
+	*	Functions queued by RunOnMainThread that have not run yet are discarded.
+	*/
+	void Shutdown();
+
+private:
+	struct Worker
+	{
+		std::thread Thread;
+		std::mutex Mutex;
+		std::deque<JobHandle> Jobs;
+	};
+
+	void WorkerMain(std::size_t index);
+
+	/**
+	*	@brief Adds a job whose dependencies have all finished to a worker queue.
+	*/
+	void Enqueue(JobHandle&& job);
+
+	/**
+	*	@brief Takes a job from the current worker's queue, or steals one from another worker, and runs it.
+	*	Must be called on a worker thread.
+	*	@return Whether a job was run.
+	*/
+	bool TryRunJob();
+
+	void Execute(const JobHandle& job);
+
+private:
+	std::vector<std::unique_ptr<Worker>> _workers;
+
+	std::mutex _wakeMutex;
+	std::condition_variable _wakeCondition;
+	std::condition_variable _finishedCondition;
+	std::atomic<std::size_t> _queuedJobsCount{0};
+	bool _stopping = false;
+
+	std::atomic<std::size_t> _nextWorker{0};
+
+	std::mutex _mainThreadMutex;
+	std::vector<std::function<void()>> _mainThreadCallbacks;
+	std::function<void()> _mainThreadWakeCallback;
+};
+
+template<typename Function>
+void JobSystem::ParallelFor(std::size_t begin, std::size_t end, std::size_t grainSize, const Function& function)
+{
+	if (begin >= end)
+	{
+		return;
+	}
+
+	grainSize = std::max<std::size_t>(grainSize, 1);
+
+	const std::size_t rangeCount = ((end - begin) + grainSize - 1) / grainSize;
+
+	struct State
+	{
+		explicit State(std::size_t rangeCount)
+			: RemainingRanges(rangeCount)
+		{
+		}
+
+		std::atomic<std::size_t> NextRange{0};
+		std::atomic<std::size_t> RemainingRanges;
+
+		std::mutex Mutex;
+		std::condition_variable Finished;
+		std::exception_ptr Exception;
+	};
+
+	//Helper jobs that only start after all ranges are done still reference the state
+	const auto state = std::make_shared<State>(rangeCount);
+
+	//function is only used after claiming a range, and this call doesn't return until all claimed ranges are done
+	const auto runRanges = [state, rangeCount, begin, end, grainSize, &function]
+	{
+		for (std::size_t range; (range = state->NextRange++) < rangeCount;)
+		{
+			const std::size_t rangeBegin = begin + (range * grainSize);
+
+			try
+			{
+				function(rangeBegin, std::min(end, rangeBegin + grainSize));
+			}
+			catch (...)
+			{
+				std::lock_guard lock{state->Mutex};
+
+				if (!state->Exception)
+				{
+					state->Exception = std::current_exception();
+				}
+			}
+
+			if (--state->RemainingRanges == 0)
+			{
+				std::lock_guard lock{state->Mutex};
+				state->Finished.notify_all();
+			}
+		}
+	};
+
+	const std::size_t helperCount = std::min(rangeCount - 1, _workers.size());
+
+	for (std::size_t i = 0; i < helperCount; ++i)
+	{
+		Schedule(runRanges);
+	}
+
+	runRanges();
+
+	std::unique_lock lock{state->Mutex};
+
+	state->Finished.wait(lock, [&]
+		{
+			return state->RemainingRanges == 0;
+		});
+
+	if (state->Exception)
+	{
+		std::rethrow_exception(state->Exception);
+	}
+}
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#include "core/shared/Profiler.hpp"
+
+struct Profiler::ThreadBuffer
+{
+	std::uint32_t ThreadId = 0;
+
+	/**
+	*	Guarded by the profiler's thread mutex.
+	*/
+	std::string ThreadName;
+
+	/**
+	*	Only used by the owning thread.
+	*/
+	std::uint32_t Depth = 0;
+
+	/**
+	*	Total number of events written. Events are stored at WriteIndex % EventsPerThread.
+	*/
+	std::atomic<std::uint64_t> WriteIndex{0};
+
+	const std::unique_ptr<ProfileEvent[]> Events = std::make_unique<ProfileEvent[]>(EventsPerThread);
+};
+
+/**
+*	@brief Removes a thread's buffer from the profiler when the thread exits.
+*	The buffer itself is freed once GetEvents is no longer copying from it.
+*/
+struct Profiler::ThreadRegistration
+{
+	ThreadRegistration() = default;
+
+	~ThreadRegistration()
+	{
+		if (Buffer)
+		{
+			Profiler::GetInstance().RemoveThreadBuffer(*Buffer);
+		}
+	}
+
+	ThreadRegistration(const ThreadRegistration&) = delete;
+	ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+	ThreadBuffer* Buffer = nullptr;
+};
+
+static std::int64_t GetClockTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void WriteJsonString(std::ostream& stream, const char* text)
+{
+	stream << '"';
+
+	for (; *text; ++text)
+	{
+		const char c = *text;
+
+		if (c == '"' || c == '\\')
+		{
+			stream << '\\' << c;
+		}
+		else if (static_cast<unsigned char>(c) < 0x20)
+		{
+			stream << ' ';
+		}
+		else
+		{
+			stream << c;
+		}
+	}
+
+	stream << '"';
+}
+
+Profiler::Profiler()
+	: _startTime(GetClockTime())
+{
+}
+
+Profiler::~Profiler() = default;
+
+Profiler& Profiler::GetInstance()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+std::int64_t Profiler::GetTime() const
+{
+	return GetClockTime() - _startTime;
+}
+
+void Profiler::SetThreadName(std::string&& name)
+{
+	auto& buffer = GetThreadBuffer();
+
+	std::lock_guard lock{_threadsMutex};
+	buffer.ThreadName = std::move(name);
+}
+
+std::uint32_t Profiler::BeginZone()
+{
+	return GetThreadBuffer().Depth++;
+}
+
+void Profiler::EndZone(const char* name, std::int64_t start, std::uint32_t depth)
+{
+	const std::int64_t end = GetTime();
+
+	auto& buffer = GetThreadBuffer();
+
+	--buffer.Depth;
+
+	const std::uint64_t index = buffer.WriteIndex.load(std::memory_order_relaxed);
+
+	buffer.Events[index % EventsPerThread] = ProfileEvent{name, start, end, depth};
+
+	buffer.WriteIndex.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::MarkFrame()
+{
+	const std::int64_t now = GetTime();
+
+	if (_lastFrameTime >= 0)
+	{
+		const float frameTime = (now - _lastFrameTime) / 1'000'000.f;
+
+		if (_frameTimes.size() < MaxFrameTimes)
+		{
+			_frameTimes.push_back(frameTime);
+		}
+		else
+		{
+			_frameTimes[_nextFrameTime] = frameTime;
+		}
+
+		_nextFrameTime = (_nextFrameTime + 1) % MaxFrameTimes;
+	}
+
+	_lastFrameTime = now;
+}
+
+std::vector<float> Profiler::GetFrameTimes() const
+{
+	std::vector<float> frameTimes{_frameTimes};
+
+	//Once the buffer is full the next entry to be overwritten is the oldest
+	if (frameTimes.size() == MaxFrameTimes)
+	{
+		std::rotate(frameTimes.begin(), frameTimes.begin() + _nextFrameTime, frameTimes.end());
+	}
+
+	return frameTimes;
+}
+
+void Profiler::RecordCounter(const char* name, double value)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	const ProfileCounter counter{name, GetTime(), value};
+
+	if (_counters.size() < MaxCounters)
+	{
+		_counters.push_back(counter);
+	}
+	else
+	{
+		_counters[_nextCounter] = counter;
+	}
+
+	_nextCounter = (_nextCounter + 1) % MaxCounters;
+}
+
+std::vector<ProfileCounter> Profiler::GetCounters(std::int64_t since) const
+{
+	std::vector<ProfileCounter> counters{_counters};
+
+	if (counters.size() == MaxCounters)
+	{
+		std::rotate(counters.begin(), counters.begin() + _nextCounter, counters.end());
+	}
+
+	counters.erase(std::remove_if(counters.begin(), counters.end(), [&](const auto& counter)
+		{
+			return counter.Time < since;
+		}), counters.end());
+
+	return counters;
+}
+
+std::vector<ProfileThreadEvents> Profiler::GetEvents(std::int64_t since) const
+{
+	std::vector<std::shared_ptr<ThreadBuffer>> threads;
+	std::vector<ProfileThreadEvents> result;
+
+	{
+		std::lock_guard lock{_threadsMutex};
+
+		threads = _threads;
+
+		for (const auto& thread : threads)
+		{
+			result.push_back({thread->ThreadId, thread->ThreadName, {}});
+		}
+	}
+
+	for (std::size_t i = 0; i < threads.size(); ++i)
+	{
+		const auto& thread = *threads[i];
+		auto& events = result[i].Events;
+
+		const std::uint64_t end = thread.WriteIndex.load(std::memory_order_acquire);
+		const std::uint64_t begin = end > EventsPerThread ? end - EventsPerThread : 0;
+
+		events.reserve(end - begin);
+
+		for (std::uint64_t index = begin; index < end; ++index)
+		{
+			events.push_back(thread.Events[index % EventsPerThread]);
+		}
+
+		//The owning thread may have kept writing, the slot it is writing to right now is also unreliable
+		const std::uint64_t newEnd = thread.WriteIndex.load(std::memory_order_acquire) + 1;
+		const std::uint64_t firstIntact = newEnd > EventsPerThread ? newEnd - EventsPerThread : 0;
+
+		if (firstIntact > begin)
+		{
+			events.erase(events.begin(), events.begin() + std::min<std::uint64_t>(firstIntact - begin, events.size()));
+		}
+
+		events.erase(std::remove_if(events.begin(), events.end(), [&](const auto& event)
+			{
+				return event.End < since;
+			}), events.end());
+	}
+
+	return result;
+}
+
+void Profiler::WriteChromeTrace(std::ostream& stream, std::int64_t since) const
+{
+	const auto threads = GetEvents(since);
+
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+
+	//Trace timestamps are in microseconds
+	stream << std::fixed << std::setprecision(3);
+
+	stream << "{\"traceEvents\":[";
+
+	bool first = true;
+
+	for (const auto& thread : threads)
+	{
+		if (!first)
+		{
+			stream << ',';
+		}
+
+		first = false;
+
+		stream << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.ThreadId << ",\"args\":{\"name\":";
+		WriteJsonString(stream, thread.ThreadName.empty() ? "Thread" : thread.ThreadName.c_str());
+		stream << "}}";
+
+		for (const auto& event : thread.Events)
+		{
+			stream << ",\n{\"name\":";
+			WriteJsonString(stream, event.Name);
+			stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.ThreadId
+				<< ",\"ts\":" << (event.Start / 1000.0)
+				<< ",\"dur\":" << ((event.End - event.Start) / 1000.0) << '}';
+		}
+	}
+
+	//Counters are shown per process, the thread id is ignored
+	for (const auto& counter : GetCounters(since))
+	{
+		if (!first)
+		{
+			stream << ',';
+		}
+
+		first = false;
+
+		stream << "\n{\"name\":";
+		WriteJsonString(stream, counter.Name);
+		stream << ",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":" << (counter.Time / 1000.0)
+			<< ",\"args\":{\"value\":" << counter.Value << "}}";
+	}
+
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	stream.flags(flags);
+	stream.precision(precision);
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+	//Only one profiler is ever used, so the buffer doesn't need to be looked up per profiler
+	thread_local ThreadRegistration registration;
+
+	if (!registration.Buffer)
+	{
+		auto newBuffer = std::make_shared<ThreadBuffer>();
+
+		std::lock_guard lock{_threadsMutex};
+
+		newBuffer->ThreadId = _nextThreadId++;
+		_threads.push_back(newBuffer);
+
+		registration.Buffer = newBuffer.get();
+	}
+
+	return *registration.Buffer;
+}
+
+void Profiler::RemoveThreadBuffer(const ThreadBuffer& buffer)
+{
+	std::lock_guard lock{_threadsMutex};
+
+	_threads.erase(std::remove_if(_threads.begin(), _threads.end(), [&](const auto& thread)
+		{
+			return thread.get() == &buffer;
+		}), _threads.end());
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+*	@brief A timed zone as recorded by the profiler. Times are in nanoseconds since the profiler was created.
+*/
+struct ProfileEvent
+{
+	const char* Name;
+	std::int64_t Start;
+	std::int64_t End;
+
+	/**
+	*	Number of zones this one is nested in.
+	*/
+	std::uint32_t Depth;
+};
+
+/**
+*	@brief A sampled value as recorded by the profiler, such as the number of draw calls in a frame.
+*/
+struct ProfileCounter
+{
+	const char* Name;
+	std::int64_t Time;
+	double Value;
+};
+
+/**
+*	@brief Events recorded by a single thread, oldest first.
+*/
+struct ProfileThreadEvents
+{
+	std::uint32_t ThreadId;
+	std::string ThreadName;
+	std::vector<ProfileEvent> Events;
+};
+
+/**
+*	@brief Records timed zones on any thread.
+*	Each thread writes to its own ring buffer so recording needs no locks, old events are overwritten.
+*	A thread's buffer is freed when the thread exits, so events of threads that have exited are not reported.
+*	Zones are recorded using PROFILE_ZONE.
+*/
+class Profiler final
+{
+public:
+	/**
+	*	@brief Maximum number of events kept per thread.
+	*/
+	static constexpr std::size_t EventsPerThread = 1 << 15;
+
+	/**
+	*	@brief Maximum number of frame times kept.
+	*/
+	static constexpr std::size_t MaxFrameTimes = 256;
+
+	/**
+	*	@brief Maximum number of counter samples kept.
+	*/
+	static constexpr std::size_t MaxCounters = 1 << 14;
+
+private:
+	Profiler();
+
+public:
+	~Profiler();
+
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	static Profiler& GetInstance();
+
+	bool IsEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+	void SetEnabled(bool enabled)
+	{
+		_enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	*	@brief Gets the current time in nanoseconds since the profiler was created.
+	*/
+	std::int64_t GetTime() const;
+
+	/**
+	*	@brief Sets the name shown for the calling thread.
+	*/
+	void SetThreadName(std::string&& name);
+
+	/**
+	*	@brief Called when a zone is entered on the calling thread.
+	*	@return Depth of the zone.
+	*/
+	std::uint32_t BeginZone();
+
+	/**
+	*	@brief Called when a zone is left on the calling thread.
+	*/
+	void EndZone(const char* name, std::int64_t start, std::uint32_t depth);
+
+	/**
+	*	@brief Marks the start of a new frame. Must be called on the main thread.
+	*/
+	void MarkFrame();
+
+	/**
+	*	@brief Gets the time between frames in milliseconds, oldest first. Must be called on the main thread.
+	*/
+	std::vector<float> GetFrameTimes() const;
+
+	/**
+	*	@brief Records the current value of a counter. Must be called on the main thread.
+	*	The name must be a string literal, or otherwise outlive the profiler.
+	*/
+	void RecordCounter(const char* name, double value);
+
+	/**
+	*	@brief Gets all counter samples recorded at or after since, oldest first. Must be called on the main thread.
+	*/
+	std::vector<ProfileCounter> GetCounters(std::int64_t since) const;
+
+	/**
+	*	@brief Gets all events that ended at or after since, for every thread that recorded events.
+	*	Events being overwritten while they are copied are left out.
+	*/
+	std::vector<ProfileThreadEvents> GetEvents(std::int64_t since) const;
+
+	/**
+	*	@brief Writes all events that ended at or after since in Chrome's trace event format.
+	*	Counter samples are included, so this must be called on the main thread.
+	*	The result can be opened in chrome://tracing or Perfetto.
+	*/
+	void WriteChromeTrace(std::ostream& stream, std::int64_t since) const;
+
+private:
+	struct ThreadBuffer;
+	struct ThreadRegistration;
+
+	ThreadBuffer& GetThreadBuffer();
+
+	void RemoveThreadBuffer(const ThreadBuffer& buffer);
+
+private:
+	std::atomic<bool> _enabled{true};
+
+	const std::int64_t _startTime;
+
+	mutable std::mutex _threadsMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> _threads;
+	std::uint32_t _nextThreadId = 1;
+
+	std::int64_t _lastFrameTime = -1;
+	std::vector<float> _frameTimes;
+	std::size_t _nextFrameTime = 0;
+
+	std::vector<ProfileCounter> _counters;
+	std::size_t _nextCounter = 0;
+};
+
+/**
+*	@brief Records the time between construction and destruction as a zone.
+*	The name must be a string literal, or otherwise outlive the profiler.
+*/
+class ProfileZone final
+{
+public:
+	explicit ProfileZone(const char* name)
+		: _name(name)
+	{
+		auto& profiler = Profiler::GetInstance();
+
+		if (profiler.IsEnabled())
+		{
+			_depth = profiler.BeginZone();
+			_start = profiler.GetTime();
+		}
+	}
+
+	~ProfileZone()
+	{
+		if (_start >= 0)
+		{
+			Profiler::GetInstance().EndZone(_name, _start, _depth);
+		}
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* const _name;
+	std::int64_t _start = -1;
+	std::uint32_t _depth = 0;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+
+/**
+*	@brief Records the rest of the enclosing scope as a zone with the given name.
+*/
+#define PROFILE_ZONE(name) const ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__){name}
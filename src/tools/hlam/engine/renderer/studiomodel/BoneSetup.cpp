@@ -0,0 +1,486 @@
+#include <algorithm>
+
+#include "engine/shared/renderer/studiomodel/ModelRenderInfo.hpp"
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+#include "engine/renderer/studiomodel/BoneSetup.hpp"
+
+#include "utility/mathlib.hpp"
+#include "utility/MathBatch.hpp"
+
+//Double to float conversion
+#pragma warning( disable: 4244 )
+
+namespace studiomdl
+{
+/**
+*	@brief Used in place of animation data that could not be loaded. No channels are animated so all bones use their default values.
+*/
+static const mstudioanim_t BindPoseAnimations[MAXSTUDIOBONES]{};
+
+BonePose::BonePose()
+{
+	//Identity rotations so blending the padding never divides by zero
+	std::fill(std::begin(Rotations[0]), std::end(Rotations[0]), 0.f);
+	std::fill(std::begin(Rotations[1]), std::end(Rotations[1]), 0.f);
+	std::fill(std::begin(Rotations[2]), std::end(Rotations[2]), 0.f);
+	std::fill(std::begin(Rotations[3]), std::end(Rotations[3]), 1.f);
+
+	for (auto& positions : Positions)
+	{
+		std::fill(std::begin(positions), std::end(positions), 0.f);
+	}
+}
+
+void BonePose::SetBone(int bone, const glm::vec4& rotation, const glm::vec3& position)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		Rotations[i][bone] = rotation[i];
+	}
+
+	for (int i = 0; i < 3; ++i)
+	{
+		Positions[i][bone] = position[i];
+	}
+}
+
+void BlendBonePoses(BonePose& a, const BonePose& b, float s, int boneCount)
+{
+	if (s < 0) s = 0;
+	else if (s > 1.0) s = 1.0;
+
+	//Process whole registers, the padding is never used
+	const std::size_t count = BonePose::GetPaddedCount(boneCount);
+
+	float* const rotationsA[4] = {a.Rotations[0], a.Rotations[1], a.Rotations[2], a.Rotations[3]};
+	const float* const rotationsB[4] = {b.Rotations[0], b.Rotations[1], b.Rotations[2], b.Rotations[3]};
+
+	QuaternionNlerpBatchSoA(rotationsA, rotationsB, s, count);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		LerpBatch(a.Positions[i], b.Positions[i], s, count);
+	}
+}
+
+void BoneSetup::CalcBoneTransforms(const ModelRenderInfo& renderInfo, glm::mat3x4* boneTransforms)
+{
+	_renderInfo = &renderInfo;
+	_studioHeader = renderInfo.Model->GetStudioHeader();
+
+	CalcBonePoses();
+
+	QuaternionMatrixBatch(_rotations, _positions, _localTransforms, _studioHeader->numbones);
+	ConcatBoneTransformsBatch(_localTransforms, _parents, boneTransforms, _studioHeader->numbones);
+
+	_renderInfo = nullptr;
+	_studioHeader = nullptr;
+}
+
+void BoneSetup::CalcBoneTransforms(const ModelRenderInfo& renderInfo, const DecodedAnimation* decodedAnimation, glm::mat3x4* boneTransforms)
+{
+	_useAnimationCache = false;
+	_decodedAnimation = decodedAnimation;
+
+	CalcBoneTransforms(renderInfo, boneTransforms);
+
+	_useAnimationCache = true;
+	_decodedAnimation = nullptr;
+}
+
+void BoneSetup::CalcSequencePose(const ModelRenderInfo& renderInfo, int blend, bool useAnimationCache, BonePose& pose)
+{
+	_renderInfo = &renderInfo;
+	_studioHeader = renderInfo.Model->GetStudioHeader();
+	_useAnimationCache = useAnimationCache;
+
+	CalcBoneAdj();
+
+	mstudioseqdesc_t* const pseqdesc = _studioHeader->GetSequence(renderInfo.Sequence);
+
+	const mstudioanim_t* panim = renderInfo.Model->GetAnim(pseqdesc);
+
+	if (panim)
+	{
+		panim += std::clamp(blend, 0, pseqdesc->numblends - 1) * _studioHeader->numbones;
+	}
+	else
+	{
+		panim = BindPoseAnimations;
+	}
+
+	CalcRotations(pose, pseqdesc, panim, renderInfo.Frame);
+
+	_renderInfo = nullptr;
+	_studioHeader = nullptr;
+	_useAnimationCache = true;
+}
+
+void BoneSetup::CalcBonePoses()
+{
+	auto& pose1 = _poses[0];
+	auto& pose2 = _poses[1];
+	auto& pose3 = _poses[2];
+	auto& pose4 = _poses[3];
+
+	// add in programatic controllers
+	CalcBoneAdj();
+
+	mstudioseqdesc_t* const pseqdesc = _studioHeader->GetSequence(_renderInfo->Sequence);
+
+	const mstudioanim_t* panim = _renderInfo->Model->GetAnim(pseqdesc);
+
+	if (!panim)
+	{
+		//The sequence group could not be loaded
+		CalcRotations(pose1, pseqdesc, BindPoseAnimations, _renderInfo->Frame);
+	}
+	else if (pseqdesc->numblends == 9)
+	{
+		const auto f = _renderInfo->Frame;
+
+		const auto blendX = static_cast<double>(_renderInfo->Blender[0]);
+		const auto blendY = static_cast<double>(_renderInfo->Blender[1]);
+
+		const mstudioanim_t* lastanim;
+
+		double interpolantX;
+		double interpolantY;
+
+		if (blendX > 127.0)
+		{
+			interpolantX = blendX - 127.0 + blendX - 127.0;
+
+			if (blendY > 127.0)
+			{
+				interpolantY = blendY - 127.0 + blendY - 127.0;
+
+				auto panim4 = panim;
+				if (pseqdesc->numblends > 4)
+					panim4 += 4 * _studioHeader->numbones;
+				CalcRotations(pose1, pseqdesc, panim4, f);
+
+				auto panim5 = panim;
+				if (pseqdesc->numblends > 5)
+					panim5 += 5 * _studioHeader->numbones;
+				CalcRotations(pose2, pseqdesc, panim5, f);
+
+				auto panim7 = panim;
+				if (pseqdesc->numblends > 7)
+					panim7 += 7 * _studioHeader->numbones;
+				CalcRotations(pose3, pseqdesc, panim7, f);
+
+				lastanim = panim;
+				if (pseqdesc->numblends > 8)
+					lastanim += 8 * _studioHeader->numbones;
+			}
+			else
+			{
+				interpolantY = blendY + blendY;
+
+				auto panim1 = panim;
+				if (pseqdesc->numblends > 1)
+					panim1 += _studioHeader->numbones;
+				CalcRotations(pose1, pseqdesc, panim1, f);
+
+				auto panim2 = panim;
+				if (pseqdesc->numblends > 2)
+					panim2 += 2 * _studioHeader->numbones;
+				CalcRotations(pose2, pseqdesc, panim2, f);
+
+				auto panim4 = panim;
+				if (pseqdesc->numblends > 4)
+					panim4 += 4 * _studioHeader->numbones;
+				CalcRotations(pose3, pseqdesc, panim4, f);
+
+				lastanim = panim;
+				if (pseqdesc->numblends > 5)
+					lastanim += 5 * _studioHeader->numbones;
+			}
+		}
+		else
+		{
+			interpolantX = blendX + blendX;
+
+			if (blendY <= 127.0)
+			{
+				interpolantY = blendY + blendY;
+
+				CalcRotations(pose1, pseqdesc, panim, f);
+
+				auto panim1 = panim;
+				if (pseqdesc->numblends > 1)
+					panim1 += _studioHeader->numbones;
+				CalcRotations(pose2, pseqdesc, panim1, f);
+
+				auto panim3 = panim;
+				if (pseqdesc->numblends > 3)
+					panim3 += 3 * _studioHeader->numbones;
+				CalcRotations(pose3, pseqdesc, panim3, f);
+
+				lastanim = panim;
+				if (pseqdesc->numblends > 4)
+					lastanim += 4 * _studioHeader->numbones;
+			}
+			else
+			{
+				interpolantY = blendY - 127.0 + blendY - 127.0;
+
+				auto panim3 = panim;
+				if (pseqdesc->numblends > 3)
+					panim3 += 3 * _studioHeader->numbones;
+				CalcRotations(pose1, pseqdesc, panim3, f);
+
+				auto panim4 = panim;
+				if (pseqdesc->numblends > 4)
+					panim4 += 4 * _studioHeader->numbones;
+				CalcRotations(pose2, pseqdesc, panim4, f);
+
+				auto panim6 = panim;
+				if (pseqdesc->numblends > 6)
+					panim6 += 6 * _studioHeader->numbones;
+				CalcRotations(pose3, pseqdesc, panim6, f);
+
+				lastanim = panim;
+				if (pseqdesc->numblends > 7)
+					lastanim += 7 * _studioHeader->numbones;
+			}
+		}
+
+		CalcRotations(pose4, pseqdesc, lastanim, f);
+
+		const auto normalizedInterpolantX = interpolantX / 255.0;
+		BlendBonePoses(pose1, pose2, normalizedInterpolantX, _studioHeader->numbones);
+		BlendBonePoses(pose3, pose4, normalizedInterpolantX, _studioHeader->numbones);
+
+		const auto normalizedInterpolantY = interpolantY / 255.0;
+		BlendBonePoses(pose1, pose3, normalizedInterpolantY, _studioHeader->numbones);
+	}
+	else
+	{
+		CalcRotations(pose1, pseqdesc, panim, _renderInfo->Frame);
+
+		if (pseqdesc->numblends > 1)
+		{
+			panim += _studioHeader->numbones;
+			CalcRotations(pose2, pseqdesc, panim, _renderInfo->Frame);
+			float s = _renderInfo->Blender[0] / 255.0;
+
+			BlendBonePoses(pose1, pose2, s, _studioHeader->numbones);
+
+			if (pseqdesc->numblends == 4)
+			{
+				panim += _studioHeader->numbones;
+				CalcRotations(pose3, pseqdesc, panim, _renderInfo->Frame);
+
+				panim += _studioHeader->numbones;
+				CalcRotations(pose4, pseqdesc, panim, _renderInfo->Frame);
+
+				s = _renderInfo->Blender[0] / 255.0;
+				BlendBonePoses(pose3, pose4, s, _studioHeader->numbones);
+
+				s = _renderInfo->Blender[1] / 255.0;
+				BlendBonePoses(pose1, pose3, s, _studioHeader->numbones);
+			}
+		}
+	}
+
+	const mstudiobone_t* const pbones = _studioHeader->GetBones();
+
+	for (int i = 0; i < _studioHeader->numbones; i++)
+	{
+		_rotations[i] = pose1.GetRotation(i);
+		_positions[i] = pose1.GetPosition(i);
+		_parents[i] = pbones[i].parent;
+	}
+}
+
+void BoneSetup::CalcRotations(BonePose& pose, const mstudioseqdesc_t* const pseqdesc, const mstudioanim_t* panim, const float f)
+{
+	const int frame = (int)f;
+	const float s = (f - frame);
+
+	//Use the decoded animation if possible to avoid walking the run-length encoded data for every channel
+	const DecodedAnimation* decodedAnimation = nullptr;
+	int blend = 0;
+
+	if (frame >= 0 && frame < pseqdesc->numframes)
+	{
+		decodedAnimation = _useAnimationCache
+			? _renderInfo->Model->GetAnimationCache()->Get(*_renderInfo->Model, _renderInfo->Sequence)
+			: _decodedAnimation;
+
+		if (decodedAnimation)
+		{
+			const mstudioanim_t* const firstBlend = _renderInfo->Model->GetAnim(const_cast<mstudioseqdesc_t*>(pseqdesc));
+
+			if (firstBlend && panim != BindPoseAnimations)
+			{
+				blend = static_cast<int>((panim - firstBlend) / _studioHeader->numbones);
+			}
+			else
+			{
+				decodedAnimation = nullptr;
+			}
+		}
+	}
+
+	auto pbone = _studioHeader->GetBones();
+
+	const DecodedAnimValue* decoded[AnimChannelCount];
+
+	glm::vec4 q;
+	glm::vec3 pos;
+
+	for (int i = 0; i < _studioHeader->numbones; i++, pbone++, panim++)
+	{
+		if (decodedAnimation)
+		{
+			for (int j = 0; j < AnimChannelCount; ++j)
+			{
+				decoded[j] = decodedAnimation->GetChannel(blend, i, j);
+
+				if (decoded[j])
+				{
+					decoded[j] += frame;
+				}
+			}
+		}
+
+		CalcBoneQuaternion(frame, s, pbone, panim, decodedAnimation ? decoded : nullptr, q);
+		CalcBonePosition(frame, s, pbone, panim, decodedAnimation ? decoded : nullptr, pos);
+
+		pose.SetBone(i, q, pos);
+	}
+
+	if (pseqdesc->motiontype & STUDIO_X)
+		pose.Positions[0][pseqdesc->motionbone] = 0.0;
+	if (pseqdesc->motiontype & STUDIO_Y)
+		pose.Positions[1][pseqdesc->motionbone] = 0.0;
+	if (pseqdesc->motiontype & STUDIO_Z)
+		pose.Positions[2][pseqdesc->motionbone] = 0.0;
+}
+
+void BoneSetup::CalcBoneAdj()
+{
+	const auto* const pbonecontroller = _studioHeader->GetBoneControllers();
+
+	for (int j = 0; j < _studioHeader->numbonecontrollers; j++)
+	{
+		const auto i = pbonecontroller[j].index;
+
+		float value;
+
+		if (i <= 3)
+		{
+			// check for 360% wrapping
+			if (pbonecontroller[j].type & STUDIO_RLOOP)
+			{
+				value = _renderInfo->Controller[i] * (360.0 / 256.0) + pbonecontroller[j].start;
+			}
+			else
+			{
+				value = _renderInfo->Controller[i] / 255.0;
+				if (value < 0) value = 0;
+				if (value > 1.0) value = 1.0;
+				value = (1.0 - value) * pbonecontroller[j].start + value * pbonecontroller[j].end;
+			}
+			// Con_DPrintf( "%d %d %f : %f\n", m_controller[j], m_prevcontroller[j], value, dadt );
+		}
+		else
+		{
+			value = _renderInfo->Mouth / 64.0;
+			if (value > 1.0) value = 1.0;
+			value = (1.0 - value) * pbonecontroller[j].start + value * pbonecontroller[j].end;
+			// Con_DPrintf("%d %f\n", mouthopen, value );
+		}
+		switch (pbonecontroller[j].type & STUDIO_TYPES)
+		{
+		case STUDIO_XR:
+		case STUDIO_YR:
+		case STUDIO_ZR:
+			_adj[j] = value * (PI<double> / 180.0);
+			break;
+		case STUDIO_X:
+		case STUDIO_Y:
+		case STUDIO_Z:
+			_adj[j] = value;
+			break;
+		}
+	}
+}
+
+void BoneSetup::CalcBoneQuaternion(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim,
+	const DecodedAnimValue* const* decoded, glm::vec4& q)
+{
+	glm::vec3			angle1, angle2;
+
+	for (int j = 0; j < 3; j++)
+	{
+		if (panim->offset[j + 3] == 0)
+		{
+			angle2[j] = angle1[j] = pbone->value[j + 3]; // default;
+		}
+		else
+		{
+			const auto value = decoded
+				? *decoded[j + 3]
+				: DecodeRotationValue((const mstudioanimvalue_t*)((const byte*)panim + panim->offset[j + 3]), frame);
+
+			angle1[j] = value.Value1;
+			angle2[j] = value.Value2;
+
+			angle1[j] = pbone->value[j + 3] + angle1[j] * pbone->scale[j + 3];
+			angle2[j] = pbone->value[j + 3] + angle2[j] * pbone->scale[j + 3];
+		}
+
+		if (pbone->bonecontroller[j + 3] != -1)
+		{
+			angle1[j] += _adj[pbone->bonecontroller[j + 3]];
+			angle2[j] += _adj[pbone->bonecontroller[j + 3]];
+		}
+	}
+
+	if (!VectorCompare(angle1, angle2))
+	{
+		glm::vec4 q1, q2;
+
+		AngleQuaternion(angle1, q1);
+		AngleQuaternion(angle2, q2);
+		QuaternionSlerp(q1, q2, s, q);
+	}
+	else
+	{
+		AngleQuaternion(angle1, q);
+	}
+}
+
+void BoneSetup::CalcBonePosition(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim,
+	const DecodedAnimValue* const* decoded, glm::vec3& pos)
+{
+	for (int j = 0; j < 3; j++)
+	{
+		pos[j] = pbone->value[j]; // default;
+		if (panim->offset[j] != 0)
+		{
+			const auto value = decoded
+				? *decoded[j]
+				: DecodePositionValue((const mstudioanimvalue_t*)((const byte*)panim + panim->offset[j]), frame);
+
+			if (value.Interpolate)
+			{
+				pos[j] += (value.Value1 * (1.0 - s) + s * value.Value2) * pbone->scale[j];
+			}
+			else
+			{
+				pos[j] += value.Value1 * pbone->scale[j];
+			}
+		}
+		if (pbone->bonecontroller[j] != -1)
+		{
+			pos[j] += _adj[pbone->bonecontroller[j]];
+		}
+	}
+}
+}
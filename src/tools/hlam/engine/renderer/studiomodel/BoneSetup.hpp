@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x4.hpp>
+
+#include "engine/shared/studiomodel/AnimationCache.hpp"
+#include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
+
+namespace studiomdl
+{
+struct ModelRenderInfo;
+
+/**
+*	@brief Bone rotations and positions stored as one array per component so poses can be blended with SIMD.
+*	Arrays are padded to a multiple of the widest SIMD register. Padding always holds valid rotations
+*	so blending can process whole registers without producing invalid values.
+*/
+struct BonePose
+{
+	static constexpr std::size_t SIMDWidth = 8;
+	static constexpr std::size_t PaddedBoneCount = ((MAXSTUDIOBONES + SIMDWidth - 1) / SIMDWidth) * SIMDWidth;
+
+	/**
+	*	@brief Gets the number of elements to process to cover boneCount bones.
+	*/
+	static constexpr std::size_t GetPaddedCount(int boneCount)
+	{
+		return ((static_cast<std::size_t>(boneCount) + SIMDWidth - 1) / SIMDWidth) * SIMDWidth;
+	}
+
+	BonePose();
+
+	void SetBone(int bone, const glm::vec4& rotation, const glm::vec3& position);
+
+	glm::vec4 GetRotation(int bone) const
+	{
+		return {Rotations[0][bone], Rotations[1][bone], Rotations[2][bone], Rotations[3][bone]};
+	}
+
+	glm::vec3 GetPosition(int bone) const
+	{
+		return {Positions[0][bone], Positions[1][bone], Positions[2][bone]};
+	}
+
+	alignas(32) float Rotations[4][PaddedBoneCount];
+	alignas(32) float Positions[3][PaddedBoneCount];
+};
+
+/**
+*	@brief Blends pose b into pose a.
+*	Rotations use corrected normalized linear interpolation, which stays within 0.1 degrees of QuaternionSlerp.
+*	@param s Blend fraction, clamped to [0, 1]
+*/
+void BlendBonePoses(BonePose& a, const BonePose& b, float s, int boneCount);
+
+/**
+*	@brief Calculates bone transforms for a model.
+*	All intermediate data is stored in the instance, so separate instances can evaluate different entities concurrently.
+*	Note that the model's animation cache is not thread safe, so models evaluated concurrently must not share one.
+*/
+class BoneSetup final
+{
+public:
+	BoneSetup() = default;
+
+	BoneSetup(const BoneSetup&) = delete;
+	BoneSetup& operator=(const BoneSetup&) = delete;
+
+	/**
+	*	@brief Calculates the bone transforms for the given render info.
+	*	@param boneTransforms Array of at least numbones transforms
+	*/
+	void CalcBoneTransforms(const ModelRenderInfo& renderInfo, glm::mat3x4* boneTransforms);
+
+	/**
+	*	@brief Calculates the bone transforms for the given render info without using the model's animation cache.
+	*	Instances can evaluate entities that share a model concurrently this way,
+	*	as long as they don't use different sequence groups that could evict each other.
+	*	@param decodedAnimation Decoded data for the render info's sequence, or null to read the run-length encoded data
+	*/
+	void CalcBoneTransforms(const ModelRenderInfo& renderInfo, const DecodedAnimation* decodedAnimation, glm::mat3x4* boneTransforms);
+
+	/**
+	*	@brief Samples one blend of the render info's sequence at its current frame, with controllers applied but without blending.
+	*	This is the work CalcBoneTransforms does for each blend.
+	*	@param useAnimationCache Whether to use the model's decoded animation data instead of reading the run-length encoded data
+	*/
+	void CalcSequencePose(const ModelRenderInfo& renderInfo, int blend, bool useAnimationCache, BonePose& pose);
+
+private:
+	void CalcBonePoses();
+
+	void CalcRotations(BonePose& pose, const mstudioseqdesc_t* const pseqdesc, const mstudioanim_t* panim, const float f);
+
+	void CalcBoneAdj();
+	/**
+	*	@param decoded If not null, decoded channel values for this bone. Used instead of the run-length encoded data in panim.
+	*/
+	void CalcBoneQuaternion(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim,
+		const DecodedAnimValue* const* decoded, glm::vec4& q);
+	void CalcBonePosition(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim,
+		const DecodedAnimValue* const* decoded, glm::vec3& pos);
+
+private:
+	const ModelRenderInfo* _renderInfo = nullptr;
+	studiohdr_t* _studioHeader = nullptr;
+
+	bool _useAnimationCache = true;
+	const DecodedAnimation* _decodedAnimation = nullptr;
+
+	float _adj[MAXSTUDIOCONTROLLERS];		//This used to be a vec4, but it really needs to be this.
+
+	/**
+	*	Up to 4 poses are blended together, the result is stored in the first.
+	*/
+	BonePose _poses[4];
+
+	glm::vec4 _rotations[MAXSTUDIOBONES];
+	glm::vec3 _positions[MAXSTUDIOBONES];
+	glm::mat3x4 _localTransforms[MAXSTUDIOBONES];
+	int _parents[MAXSTUDIOBONES];
+};
+}
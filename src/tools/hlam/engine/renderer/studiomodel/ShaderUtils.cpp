@@ -0,0 +1,63 @@
+#include <string>
+#include <vector>
+
+#include "core/shared/Logging.hpp"
+
+#include "engine/renderer/studiomodel/ShaderUtils.hpp"
+
+namespace studiomdl
+{
+GLuint CompileShader(GLenum type, std::initializer_list<const char*> sources, const char* name)
+{
+	const std::vector<const char*> strings{sources};
+
+	const GLuint shader = glCreateShader(type);
+
+	glShaderSource(shader, static_cast<GLsizei>(strings.size()), strings.data(), nullptr);
+	glCompileShader(shader);
+
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+		std::string log(static_cast<std::size_t>(length) + 1, '\0');
+		glGetShaderInfoLog(shader, length, nullptr, log.data());
+
+		Error("%s: Error compiling %s shader:\n%s\n",
+			name, type == GL_VERTEX_SHADER ? "vertex" : "fragment", log.c_str());
+
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+bool LinkProgram(GLuint program, const char* name)
+{
+	glLinkProgram(program);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+	if (status != GL_TRUE)
+	{
+		GLint length = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+
+		std::string log(static_cast<std::size_t>(length) + 1, '\0');
+		glGetProgramInfoLog(program, length, nullptr, log.data());
+
+		Error("%s: Error linking program:\n%s\n", name, log.c_str());
+
+		glDeleteProgram(program);
+		return false;
+	}
+
+	return true;
+}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <initializer_list>
+
+#include "graphics/OpenGL.hpp"
+
+namespace studiomdl
+{
+/**
+*	@brief Compiles a shader whose source is the concatenation of the given strings.
+*	@param name Name of the owner, used in error messages
+*	@return The shader, or 0 if it could not be compiled. Errors are logged.
+*/
+GLuint CompileShader(GLenum type, std::initializer_list<const char*> sources, const char* name);
+
+/**
+*	@brief Links a program. If linking fails the program is deleted.
+*	@param name Name of the owner, used in error messages
+*	@return Whether the program was linked. Errors are logged.
+*/
+bool LinkProgram(GLuint program, const char* name);
+}
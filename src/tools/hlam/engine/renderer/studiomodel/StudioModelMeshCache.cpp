@@ -0,0 +1,194 @@
+#include <cstdint>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+#include "engine/renderer/studiomodel/StudioModelMeshCache.hpp"
+
+namespace studiomdl
+{
+CachedSubModel& StudioModelMeshCache::GetSubModel(const StudioModel& model, const mstudiomodel_t& subModel)
+{
+	if (auto it = _subModels.find(&subModel);
+		it != _subModels.end() && it->second.Model == &model && it->second.MeshesRevision == model.GetMeshesRevision())
+	{
+		return it->second;
+	}
+
+	//Detaching or editing the model invalidates its meshes, which may have moved to a different address
+	RemoveOutdatedSubModels(model);
+
+	auto& cache = _subModels[&subModel];
+
+	Build(model, subModel, cache);
+
+	return cache;
+}
+
+void StudioModelMeshCache::Clear()
+{
+	for (auto& [subModel, cache] : _subModels)
+	{
+		DeleteBuffers(cache);
+	}
+
+	_subModels.clear();
+}
+
+void StudioModelMeshCache::DeleteBuffers(CachedSubModel& cache)
+{
+	glDeleteBuffers(1, &cache.TexCoordBuffer);
+	glDeleteBuffers(1, &cache.IndexBuffer);
+	glDeleteBuffers(1, &cache.SkinningBuffer);
+	glDeleteBuffers(1, &cache.DynamicBuffer);
+}
+
+void StudioModelMeshCache::RemoveOutdatedSubModels(const StudioModel& model)
+{
+	for (auto it = _subModels.begin(); it != _subModels.end();)
+	{
+		if (it->second.Model == &model && it->second.MeshesRevision != model.GetMeshesRevision())
+		{
+			DeleteBuffers(it->second);
+			it = _subModels.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void StudioModelMeshCache::Build(const StudioModel& model, const mstudiomodel_t& subModel, CachedSubModel& cache)
+{
+	const auto header = model.GetStudioHeader();
+
+	cache.Model = &model;
+	cache.MeshesRevision = model.GetMeshesRevision();
+	cache.DynamicFrame = 0;
+	cache.Vertices.clear();
+	cache.Meshes.clear();
+
+	cache.Meshes.resize(subModel.nummesh);
+
+	std::vector<glm::vec2> texCoords;
+	std::vector<GLuint> indices;
+
+	//Tricmd vertices are unique per mesh since the mesh determines how they are lit
+	std::unordered_map<std::uint64_t, GLuint> vertexLookup;
+	std::vector<GLuint> primitive;
+
+	const auto meshes = reinterpret_cast<const mstudiomesh_t*>(header->GetData() + subModel.meshindex);
+
+	for (int j = 0; j < subModel.nummesh; ++j)
+	{
+		auto& cachedMesh = cache.Meshes[j];
+
+		cachedMesh.FirstVertex = static_cast<int>(cache.Vertices.size());
+		cachedMesh.FirstIndex = static_cast<int>(indices.size());
+
+		vertexLookup.clear();
+
+		auto ptricmds = reinterpret_cast<const short*>(header->GetData() + meshes[j].triindex);
+
+		int i;
+
+		while ((i = *(ptricmds++)) != 0)
+		{
+			const bool isFan = i < 0;
+
+			if (isFan)
+			{
+				i = -i;
+			}
+
+			cachedMesh.PolygonCount += i - 2;
+
+			primitive.clear();
+
+			for (; i > 0; --i, ptricmds += 4)
+			{
+				const std::uint64_t key =
+					(static_cast<std::uint64_t>(static_cast<std::uint16_t>(ptricmds[0])) << 48)
+					| (static_cast<std::uint64_t>(static_cast<std::uint16_t>(ptricmds[1])) << 32)
+					| (static_cast<std::uint64_t>(static_cast<std::uint16_t>(ptricmds[2])) << 16)
+					| static_cast<std::uint64_t>(static_cast<std::uint16_t>(ptricmds[3]));
+
+				auto [it, inserted] = vertexLookup.emplace(key, static_cast<GLuint>(cache.Vertices.size()));
+
+				if (inserted)
+				{
+					cache.Vertices.push_back({ptricmds[0], ptricmds[1]});
+					texCoords.emplace_back(ptricmds[2], ptricmds[3]);
+				}
+
+				primitive.push_back(it->second);
+			}
+
+			for (std::size_t v = 2; v < primitive.size(); ++v)
+			{
+				if (isFan)
+				{
+					indices.insert(indices.end(), {primitive[0], primitive[v - 1], primitive[v]});
+				}
+				//Strips alternate winding every triangle
+				else if (v % 2 == 0)
+				{
+					indices.insert(indices.end(), {primitive[v - 2], primitive[v - 1], primitive[v]});
+				}
+				else
+				{
+					indices.insert(indices.end(), {primitive[v - 1], primitive[v - 2], primitive[v]});
+				}
+			}
+		}
+
+		cachedMesh.VertexCount = static_cast<int>(cache.Vertices.size()) - cachedMesh.FirstVertex;
+		cachedMesh.IndexCount = static_cast<int>(indices.size()) - cachedMesh.FirstIndex;
+	}
+
+	if (cache.TexCoordBuffer == 0)
+	{
+		glGenBuffers(1, &cache.TexCoordBuffer);
+		glGenBuffers(1, &cache.IndexBuffer);
+		glGenBuffers(1, &cache.SkinningBuffer);
+		glGenBuffers(1, &cache.DynamicBuffer);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, cache.TexCoordBuffer);
+	glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
+
+	const auto vertices = reinterpret_cast<const glm::vec3*>(header->GetData() + subModel.vertindex);
+	const auto normals = reinterpret_cast<const glm::vec3*>(header->GetData() + subModel.normindex);
+	const auto vertexBones = header->GetData() + subModel.vertinfoindex;
+	const auto normalBones = header->GetData() + subModel.norminfoindex;
+
+	std::vector<CachedSkinningVertex> skinningVertices;
+
+	skinningVertices.reserve(cache.Vertices.size());
+
+	for (const auto& vertex : cache.Vertices)
+	{
+		skinningVertices.push_back({
+			vertices[vertex.VertexIndex],
+			normals[vertex.NormalIndex],
+			{vertexBones[vertex.VertexIndex], normalBones[vertex.NormalIndex]}});
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, cache.SkinningBuffer);
+	glBufferData(GL_ARRAY_BUFFER, skinningVertices.size() * sizeof(CachedSkinningVertex), skinningVertices.data(), GL_STATIC_DRAW);
+
+	//Allocated here, filled every frame
+	glBindBuffer(GL_ARRAY_BUFFER, cache.DynamicBuffer);
+	glBufferData(GL_ARRAY_BUFFER, cache.Vertices.size() * (sizeof(glm::vec3) + sizeof(glm::vec4) + sizeof(glm::vec2)), nullptr, GL_STREAM_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cache.IndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include "graphics/OpenGL.hpp"
+
+#include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
+
+namespace studiomdl
+{
+class StudioModel;
+
+/**
+*	@brief A unique tricmd vertex: the studio vertex and normal it references.
+*	Texture coordinates are stored in the submodel's static texture coordinate buffer.
+*/
+struct CachedMeshVertex
+{
+	short VertexIndex;
+	short NormalIndex;
+};
+
+/**
+*	@brief Static vertex data used by GPU skinning.
+*/
+struct CachedSkinningVertex
+{
+	glm::vec3 Position;
+	glm::vec3 Normal;
+
+	/**
+	*	@brief Vertex and normal bone indices. Stored as floats for compatibility with OpenGL 3.0 attribute arrays.
+	*/
+	glm::vec2 Bones;
+};
+
+/**
+*	@brief Range of a single mesh in its submodel's vertex and index buffers.
+*/
+struct CachedMesh
+{
+	int FirstVertex = 0;
+	int VertexCount = 0;
+
+	int FirstIndex = 0;
+	int IndexCount = 0;
+
+	/**
+	*	@brief Number of polygons in the original tricmds. Matches what the immediate mode renderer reports.
+	*/
+	unsigned int PolygonCount = 0;
+};
+
+/**
+*	@brief Retained mode representation of a submodel.
+*	Triangle strips and fans are converted to an indexed triangle list once.
+*	Positions, colors and chrome texture coordinates change every frame and are streamed into the dynamic buffer.
+*/
+struct CachedSubModel
+{
+	const StudioModel* Model = nullptr;
+	unsigned int MeshesRevision = 0;
+
+	std::vector<CachedMeshVertex> Vertices;
+	std::vector<CachedMesh> Meshes;
+
+	/**
+	*	@brief Unscaled texture coordinates. Scaled to the mesh's texture using the texture matrix.
+	*/
+	GLuint TexCoordBuffer = 0;
+	GLuint IndexBuffer = 0;
+
+	/**
+	*	@brief Bind pose positions, normals and bone indices for GPU skinning. Rebuilt when the mesh revision changes.
+	*/
+	GLuint SkinningBuffer = 0;
+
+	/**
+	*	@brief Positions, followed by colors, followed by chrome texture coordinates.
+	*/
+	GLuint DynamicBuffer = 0;
+
+	/**
+	*	@brief State the dynamic buffer was last uploaded with, set by the renderer.
+	*	Drawing the submodel again in the same frame, pose, skin and transparency reuses the buffer's contents.
+	*	A frame of 0 means the buffer holds nothing that can be reused.
+	*/
+	unsigned int DynamicFrame = 0;
+	unsigned int DynamicPoseId = 0;
+	const short* DynamicSkinRef = nullptr;
+	float DynamicTransparency = 0;
+};
+
+/**
+*	@brief Caches GPU buffers for studio submodels.
+*	Buffer objects are shared between contexts so no vertex array objects are used here.
+*/
+class StudioModelMeshCache final
+{
+public:
+	StudioModelMeshCache() = default;
+	~StudioModelMeshCache() = default;
+
+	StudioModelMeshCache(const StudioModelMeshCache&) = delete;
+	StudioModelMeshCache& operator=(const StudioModelMeshCache&) = delete;
+
+	/**
+	*	@brief Gets the cached data for the given submodel, building or rebuilding it if needed.
+	*	Building removes the model's entries for older mesh revisions, since those may be keyed by addresses it no longer uses.
+	*	@param model Model that owns the submodel
+	*	@param subModel Submodel to get the cached data for
+	*/
+	CachedSubModel& GetSubModel(const StudioModel& model, const mstudiomodel_t& subModel);
+
+	/**
+	*	@brief Frees all buffers. Must be called while the context that created them is current.
+	*/
+	void Clear();
+
+private:
+	void Build(const StudioModel& model, const mstudiomodel_t& subModel, CachedSubModel& cache);
+
+	static void DeleteBuffers(CachedSubModel& cache);
+
+	void RemoveOutdatedSubModels(const StudioModel& model);
+
+private:
+	std::unordered_map<const mstudiomodel_t*, CachedSubModel> _subModels;
+};
+}
@@ -0,0 +1,117 @@
+#include "core/shared/Logging.hpp"
+
+#include "engine/renderer/studiomodel/ShaderUtils.hpp"
+#include "engine/renderer/studiomodel/StudioModelPaletteShader.hpp"
+
+namespace studiomdl
+{
+const char* const PaletteLookupShaderSource = R"(
+uniform sampler2D Texture;
+uniform sampler2D Palette;
+
+uniform bool UsePalette;
+uniform bool LinearFilter;
+
+vec4 LookupTexel(ivec2 coord, ivec2 size)
+{
+	//Wrap around like GL_REPEAT
+	coord = ivec2(mod(vec2(coord), vec2(size)));
+
+	int index = int(texelFetch(Texture, coord, 0).r * 255.0 + 0.5);
+
+	return texelFetch(Palette, ivec2(index, 0), 0);
+}
+
+vec4 SampleTexture(vec2 texCoord)
+{
+	if (!UsePalette)
+	{
+		return texture(Texture, texCoord);
+	}
+
+	ivec2 size = textureSize(Texture, 0);
+
+	if (!LinearFilter)
+	{
+		return LookupTexel(ivec2(floor(texCoord * vec2(size))), size);
+	}
+
+	//Filtering has to happen after the lookup, interpolating indices would produce unrelated colors
+	vec2 position = texCoord * vec2(size) - 0.5;
+	ivec2 base = ivec2(floor(position));
+	vec2 fraction = fract(position);
+
+	vec4 topLeft = LookupTexel(base, size);
+	vec4 topRight = LookupTexel(base + ivec2(1, 0), size);
+	vec4 bottomLeft = LookupTexel(base + ivec2(0, 1), size);
+	vec4 bottomRight = LookupTexel(base + ivec2(1, 1), size);
+
+	return mix(mix(topLeft, topRight, fraction.x), mix(bottomLeft, bottomRight, fraction.x), fraction.y);
+}
+)";
+
+static const char* const PaletteFragmentShader = R"(
+void main()
+{
+	gl_FragColor = SampleTexture(gl_TexCoord[0].st) * gl_Color;
+}
+)";
+
+bool IsPaletteLookupSupported()
+{
+	return GLEW_VERSION_3_0;
+}
+
+bool StudioModelPaletteShader::Create()
+{
+	Destroy();
+
+	if (!IsPaletteLookupSupported())
+	{
+		Warning("StudioModelPaletteShader: OpenGL 3.0 is required for indexed textures\n");
+		return false;
+	}
+
+	const GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER,
+		{"#version 130\n", PaletteLookupShaderSource, PaletteFragmentShader}, "StudioModelPaletteShader");
+
+	if (fragmentShader == 0)
+	{
+		return false;
+	}
+
+	const GLuint program = glCreateProgram();
+
+	glAttachShader(program, fragmentShader);
+
+	//Flagged for deletion, freed along with the program
+	glDeleteShader(fragmentShader);
+
+	if (!LinkProgram(program, "StudioModelPaletteShader"))
+	{
+		return false;
+	}
+
+	_program = program;
+
+	UsePalette = glGetUniformLocation(_program, "UsePalette");
+	LinearFilter = glGetUniformLocation(_program, "LinearFilter");
+
+	//Samplers never change
+	glUseProgram(_program);
+	glUniform1i(glGetUniformLocation(_program, "Texture"), 0);
+	glUniform1i(glGetUniformLocation(_program, "Palette"), PaletteTextureUnit);
+	glUseProgram(0);
+
+	return true;
+}
+
+void StudioModelPaletteShader::Destroy()
+{
+	if (_program != 0)
+	{
+		glDeleteProgram(_program);
+		_program = 0;
+	}
+}
+}
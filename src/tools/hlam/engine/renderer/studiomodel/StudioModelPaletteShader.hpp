@@ -0,0 +1,54 @@
+#pragma once
+
+#include "graphics/OpenGL.hpp"
+
+namespace studiomdl
+{
+/**
+*	@brief Texture unit the palette of an indexed texture is bound to. The index texture is bound to unit 0.
+*/
+constexpr GLint PaletteTextureUnit = 2;
+
+/**
+*	@brief GLSL 1.30 source that declares the Texture, Palette, UsePalette and LinearFilter uniforms
+*	and a vec4 SampleTexture(vec2 texCoord) function that samples either a regular or an indexed texture.
+*	Does not contain a version directive so it can be included in other shaders.
+*/
+extern const char* const PaletteLookupShaderSource;
+
+/**
+*	@brief Whether indexed textures can be drawn. Does not require a current context.
+*/
+bool IsPaletteLookupSupported();
+
+/**
+*	@brief Fragment program that draws indexed textures. Vertex processing is left to the fixed function pipeline.
+*/
+class StudioModelPaletteShader final
+{
+public:
+	StudioModelPaletteShader() = default;
+	~StudioModelPaletteShader() = default;
+
+	StudioModelPaletteShader(const StudioModelPaletteShader&) = delete;
+	StudioModelPaletteShader& operator=(const StudioModelPaletteShader&) = delete;
+
+	/**
+	*	@brief Compiles and links the program.
+	*	@return Whether the program is ready for use. Errors are logged.
+	*/
+	bool Create();
+
+	void Destroy();
+
+	bool IsValid() const { return _program != 0; }
+
+	GLuint GetProgram() const { return _program; }
+
+	GLint UsePalette = -1;
+	GLint LinearFilter = -1;
+
+private:
+	GLuint _program = 0;
+};
+}
@@ -1,21 +1,62 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
 
+#include "core/shared/JobSystem.hpp"
 #include "core/shared/Logging.hpp"
+#include "core/shared/Profiler.hpp"
 
+#include "graphics/GPUTimer.hpp"
 #include "graphics/GraphicsUtils.hpp"
 
 #include "engine/shared/studiomodel/StudioModel.hpp"
 
 #include "engine/renderer/studiomodel/StudioModelRenderer.hpp"
 
+#include "utility/MathBatch.hpp"
+
 //Double to float conversion
 #pragma warning( disable: 4244 )
 
 namespace studiomdl
 {
-StudioModelRenderer::StudioModelRenderer() = default;
+/**
+*	@brief Instances evaluated by a single job at minimum, so small crowds aren't dominated by the cost of scheduling jobs.
+*/
+constexpr std::size_t MinInstancesPerThread = 16;
+
+/**
+*	@brief Per-vertex buffers shared by all renderers on a thread, since only one of them draws at a time.
+*	They grow to fit the largest submodel drawn so far, so small models don't pay for the largest supported size.
+*/
+struct VertexBuffers
+{
+	std::vector<glm::vec3> TransformedVertices;
+	std::vector<glm::vec3> TransformedNormals;
+	std::vector<glm::vec3> LightValues;
+	std::vector<glm::vec2> Chrome;
+
+	/**
+	*	Renderer that last transformed vertices. Other renderers can't reuse them even if their submodel and pose match.
+	*/
+	const StudioModelRenderer* TransformedVerticesOwner = nullptr;
+};
+
+static VertexBuffers& GetVertexBuffers()
+{
+	thread_local VertexBuffers buffers;
+	return buffers;
+}
+
+StudioModelRenderer::StudioModelRenderer(JobSystem* jobSystem, graphics::GPUTimer* gpuTimer)
+	: _jobSystem(jobSystem)
+	, _gpuTimer(gpuTimer)
+{
+}
+
 StudioModelRenderer::~StudioModelRenderer() = default;
 
 bool StudioModelRenderer::Initialize()
@@ -23,15 +64,80 @@ bool StudioModelRenderer::Initialize()
 	_modelsDrawnCount = 0;
 	_drawnPolygonsCount = 0;
 
+	//GPU skinning is optional, fall back to fixed function if it isn't supported
+	if (_skinningShader.Create())
+	{
+		glGenTextures(1, &_boneDataTexture);
+		glCountedBindTexture(GL_TEXTURE_2D, _boneDataTexture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SkinningTexelsPerBone, MAXSTUDIOBONES, 0, GL_RGBA, GL_FLOAT, nullptr);
+		glCountedBindTexture(GL_TEXTURE_2D, 0);
+
+		//Instances are drawn one at a time if this isn't supported
+		if (_instancedSkinningShader.Create(true))
+		{
+			glGenBuffers(1, &_instanceDataBuffer);
+			glGenTextures(1, &_instanceDataTexture);
+
+			glCountedBindTexture(GL_TEXTURE_BUFFER, _instanceDataTexture);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _instanceDataBuffer);
+			glCountedBindTexture(GL_TEXTURE_BUFFER, 0);
+
+			glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &_maxInstanceDataTexels);
+		}
+	}
+
+	//Without this textures are converted to RGBA and uploaded in full
+	_paletteShader.Create();
+
+	const byte placeholderColor[4]{127, 127, 127, 255};
+
+	glGenTextures(1, &_placeholderTexture);
+	glCountedBindTexture(GL_TEXTURE_2D, _placeholderTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholderColor);
+	glCountedBindTexture(GL_TEXTURE_2D, 0);
+
 	return true;
 }
 
 void StudioModelRenderer::Shutdown()
 {
+	glDeleteTexture(_boneDataTexture);
+	_skinningShader.Destroy();
+	glDeleteTexture(_instanceDataTexture);
+	glDeleteBuffers(1, &_instanceDataBuffer);
+	_instanceDataBuffer = 0;
+	_instancedSkinningShader.Destroy();
+	_paletteShader.Destroy();
+	glDeleteTexture(_placeholderTexture);
+
+	_meshCache.Clear();
+
+	_cachedPoses.clear();
+	RunFrame();
 }
 
 void StudioModelRenderer::RunFrame()
 {
+	//Models may have been edited since the last frame, so nothing is reused across frames
+	_cachedPoseCount = 0;
+	_poseCacheHits = 0;
+	_poseCacheMisses = 0;
+
+	_currentPoseId = 0;
+	_nextPoseId = 0;
+
+	_xformvertsModel = nullptr;
+	_xformvertsPoseId = 0;
+
+	//0 is reserved for buffers that hold nothing reusable
+	if (++_frameNumber == 0)
+	{
+		++_frameNumber;
+	}
 }
 
 unsigned int StudioModelRenderer::DrawModel(studiomdl::ModelRenderInfo* const renderInfo, const renderer::DrawFlags flags)
@@ -86,6 +192,11 @@ unsigned int StudioModelRenderer::DrawModel(studiomdl::ModelRenderInfo* const re
 
 	SetupLighting();
 
+	if (IsGPUSkinningEnabled())
+	{
+		UploadBoneData();
+	}
+
 	unsigned int uiDrawnPolys = 0;
 
 	const bool fixShadowZFighting = (flags & renderer::DrawFlag::FIX_SHADOW_Z_FIGHTING) != 0;
@@ -101,6 +212,7 @@ unsigned int StudioModelRenderer::DrawModel(studiomdl::ModelRenderInfo* const re
 
 				if (flags & renderer::DrawFlag::DRAW_SHADOWS)
 				{
+					const graphics::GPUPassScope shadowsPass{_gpuTimer, graphics::RenderPass::Shadows};
 					uiDrawnPolys += DrawShadows(fixShadowZFighting, false);
 				}
 			}
@@ -109,11 +221,13 @@ unsigned int StudioModelRenderer::DrawModel(studiomdl::ModelRenderInfo* const re
 
 	if (flags & renderer::DrawFlag::WIREFRAME_OVERLAY)
 	{
+		const graphics::GPUPassScope wireframeOverlayPass{_gpuTimer, graphics::RenderPass::WireframeOverlay};
+
 		//TODO: restore render mode after this?
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		glDisable(GL_TEXTURE_2D);
-		glDisable(GL_CULL_FACE);
-		glEnable(GL_DEPTH_TEST);
+		glCountedDisable(GL_TEXTURE_2D);
+		glCountedDisable(GL_CULL_FACE);
+		glCountedEnable(GL_DEPTH_TEST);
 
 		for (int i = 0; i < _studioHeader->numbodyparts; i++)
 		{
@@ -124,43 +238,195 @@ unsigned int StudioModelRenderer::DrawModel(studiomdl::ModelRenderInfo* const re
 
 				if (flags & renderer::DrawFlag::DRAW_SHADOWS)
 				{
+					const graphics::GPUPassScope shadowsPass{_gpuTimer, graphics::RenderPass::Shadows};
 					uiDrawnPolys += DrawShadows(fixShadowZFighting, true);
 				}
 			}
 		}
 	}
 
-	// draw bones
-	if (flags & renderer::DrawFlag::DRAW_BONES)
+	const renderer::DrawFlags debugOverlayFlags = renderer::DrawFlag::DRAW_BONES | renderer::DrawFlag::DRAW_ATTACHMENTS
+		| renderer::DrawFlag::DRAW_EYE_POSITION | renderer::DrawFlag::DRAW_HITBOXES | renderer::DrawFlag::DRAW_NORMALS;
+
+	if (flags & debugOverlayFlags)
 	{
-		DrawBones();
+		const graphics::GPUPassScope debugOverlaysPass{_gpuTimer, graphics::RenderPass::DebugOverlays};
+
+		// draw bones
+		if (flags & renderer::DrawFlag::DRAW_BONES)
+		{
+			DrawBones();
+		}
+
+		if (flags & renderer::DrawFlag::DRAW_ATTACHMENTS)
+		{
+			DrawAttachments();
+		}
+
+		if (flags & renderer::DrawFlag::DRAW_EYE_POSITION)
+		{
+			DrawEyePosition();
+		}
+
+		if (flags & renderer::DrawFlag::DRAW_HITBOXES)
+		{
+			DrawHitBoxes();
+		}
+
+		if (flags & renderer::DrawFlag::DRAW_NORMALS)
+		{
+			DrawNormals();
+		}
 	}
 
-	if (flags & renderer::DrawFlag::DRAW_ATTACHMENTS)
+	glPopMatrix();
+
+	_drawnPolygonsCount += uiDrawnPolys;
+
+	return uiDrawnPolys;
+}
+
+unsigned int StudioModelRenderer::DrawModelInstances(ModelRenderInfo* const renderInfos, const std::size_t count, const renderer::DrawFlags flags)
+{
+	if (count == 0)
 	{
-		DrawAttachments();
+		return 0;
 	}
 
-	if (flags & renderer::DrawFlag::DRAW_EYE_POSITION)
+	if (!renderInfos || !renderInfos[0].Model)
 	{
-		DrawEyePosition();
+		Error("StudioModelRenderer::DrawModelInstances: Called with null render info or model!\n");
+		return 0;
 	}
 
-	if (flags & renderer::DrawFlag::DRAW_HITBOXES)
+	const renderer::DrawFlags instancedFlags = renderer::DrawFlag::NODRAW | renderer::DrawFlag::WIREFRAME_OVERLAY;
+
+	if (!IsGPUSkinningEnabled() || !_instancedSkinningShader.IsValid() || (flags & ~instancedFlags) != 0)
 	{
-		DrawHitBoxes();
+		unsigned int drawnPolys = 0;
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			drawnPolys += DrawModel(&renderInfos[i], flags);
+		}
+
+		return drawnPolys;
 	}
 
-	if (flags & renderer::DrawFlag::DRAW_NORMALS)
+	_renderInfo = &renderInfos[0];
+	_studioHeader = _renderInfo->Model->GetStudioHeader();
+	_textureHeader = _renderInfo->Model->GetTextureHeader();
+
+	_modelsDrawnCount += count;
+
+	if (_studioHeader->numbodyparts == 0 || _studioHeader->numbones == 0)
 	{
-		DrawNormals();
+		return 0;
 	}
 
-	glPopMatrix();
+	//Instances that use the same skin are drawn together
+	_instanceOrder.resize(count);
+	std::iota(_instanceOrder.begin(), _instanceOrder.end(), 0);
 
-	_drawnPolygonsCount += uiDrawnPolys;
+	std::stable_sort(_instanceOrder.begin(), _instanceOrder.end(), [&](auto lhs, auto rhs)
+		{
+			return renderInfos[lhs].Skin < renderInfos[rhs].Skin;
+		});
 
-	return uiDrawnPolys;
+	EvaluateInstances(renderInfos, count);
+
+	//Same as SetupLighting, the per-bone light vectors are part of the instance data
+	_ambientlight = 32;
+	_shadelight = 192;
+
+	//Instance transforms are part of the bone transforms, so the shader only needs the view and projection
+	glm::mat4 projection;
+	glm::mat4 modelView;
+	glGetFloatv(GL_PROJECTION_MATRIX, glm::value_ptr(projection));
+	glGetFloatv(GL_MODELVIEW_MATRIX, glm::value_ptr(modelView));
+	_instanceViewProjection = projection * modelView;
+
+	const std::size_t texelsPerInstance = static_cast<std::size_t>(_studioHeader->numbones) * SkinningTexelsPerBone;
+
+	//Instances are uploaded in batches that fit in the texture buffer
+	const std::size_t instancesPerBatch = std::max<std::size_t>(1, static_cast<std::size_t>(_maxInstanceDataTexels) / texelsPerInstance);
+
+	unsigned int drawnPolys = 0;
+
+	glActiveTexture(GL_TEXTURE1);
+	glCountedBindTexture(GL_TEXTURE_BUFFER, _instanceDataTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	for (std::size_t batchStart = 0; batchStart < count; batchStart += instancesPerBatch)
+	{
+		const std::size_t batchEnd = std::min(count, batchStart + instancesPerBatch);
+
+		glBindBuffer(GL_TEXTURE_BUFFER, _instanceDataBuffer);
+		//Orphan the previous batch so the driver doesn't have to wait for pending draws
+		glBufferData(GL_TEXTURE_BUFFER, (batchEnd - batchStart) * texelsPerInstance * sizeof(glm::vec4),
+			&_instanceData[batchStart * texelsPerInstance], GL_STREAM_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		const auto drawBatch = [&, this](bool wireframe)
+		{
+			for (int i = 0; i < _studioHeader->numbodyparts; ++i)
+			{
+				SetupModel(i);
+
+				for (std::size_t groupStart = batchStart; groupStart < batchEnd;)
+				{
+					const int skin = renderInfos[_instanceOrder[groupStart]].Skin;
+
+					std::size_t groupEnd = groupStart + 1;
+
+					while (groupEnd < batchEnd && renderInfos[_instanceOrder[groupEnd]].Skin == skin)
+					{
+						++groupEnd;
+					}
+
+					_renderInfo = &renderInfos[_instanceOrder[groupStart]];
+
+					if (_renderInfo->Transparency > 0.0f)
+					{
+						drawnPolys += DrawInstances(wireframe,
+							static_cast<int>(groupStart - batchStart), static_cast<int>(groupEnd - groupStart), skin);
+					}
+
+					groupStart = groupEnd;
+				}
+			}
+		};
+
+		if (!(flags & renderer::DrawFlag::NODRAW))
+		{
+			drawBatch(false);
+		}
+
+		if (flags & renderer::DrawFlag::WIREFRAME_OVERLAY)
+		{
+			const graphics::GPUPassScope wireframeOverlayPass{_gpuTimer, graphics::RenderPass::WireframeOverlay};
+
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			glCountedDisable(GL_TEXTURE_2D);
+			glCountedDisable(GL_CULL_FACE);
+			glCountedEnable(GL_DEPTH_TEST);
+
+			drawBatch(true);
+		}
+	}
+
+	glActiveTexture(GL_TEXTURE1);
+	glCountedBindTexture(GL_TEXTURE_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	_drawnPolygonsCount += drawnPolys;
+
+	_renderInfo = nullptr;
+	_studioHeader = nullptr;
+	_textureHeader = nullptr;
+	_model = nullptr;
+
+	return drawnPolys;
 }
 
 void StudioModelRenderer::DrawSingleBone(ModelRenderInfo& renderInfo, const int iBone)
@@ -178,20 +444,20 @@ void StudioModelRenderer::DrawSingleBone(ModelRenderInfo& renderInfo, const int
 	SetUpBones();
 
 	const mstudiobone_t* const pbones = _studioHeader->GetBones();
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_DEPTH_TEST);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_DEPTH_TEST);
 
 	if (pbones[iBone].parent >= 0)
 	{
 		glPointSize(10.0f);
 		glColor3f(0, 0.7f, 1);
-		glBegin(GL_LINES);
+		glCountedBegin(GL_LINES);
 		glVertex3f(_bonetransform[pbones[iBone].parent][0][3], _bonetransform[pbones[iBone].parent][1][3], _bonetransform[pbones[iBone].parent][2][3]);
 		glVertex3f(_bonetransform[iBone][0][3], _bonetransform[iBone][1][3], _bonetransform[iBone][2][3]);
 		glEnd();
 
 		glColor3f(0, 0, 0.8f);
-		glBegin(GL_POINTS);
+		glCountedBegin(GL_POINTS);
 		if (pbones[pbones[iBone].parent].parent != -1)
 			glVertex3f(_bonetransform[pbones[iBone].parent][0][3], _bonetransform[pbones[iBone].parent][1][3], _bonetransform[pbones[iBone].parent][2][3]);
 		glVertex3f(_bonetransform[iBone][0][3], _bonetransform[iBone][1][3], _bonetransform[iBone][2][3]);
@@ -202,7 +468,7 @@ void StudioModelRenderer::DrawSingleBone(ModelRenderInfo& renderInfo, const int
 		// draw parent bone node
 		glPointSize(10.0f);
 		glColor3f(0.8f, 0, 0);
-		glBegin(GL_POINTS);
+		glCountedBegin(GL_POINTS);
 		glVertex3f(_bonetransform[iBone][0][3], _bonetransform[iBone][1][3], _bonetransform[iBone][2][3]);
 		glEnd();
 	}
@@ -228,9 +494,9 @@ void StudioModelRenderer::DrawSingleAttachment(ModelRenderInfo& renderInfo, cons
 
 	SetUpBones();
 
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_CULL_FACE);
+	glCountedDisable(GL_DEPTH_TEST);
 
 	mstudioattachment_t* pattachments = _studioHeader->GetAttachments();
 	glm::vec3 v[4];
@@ -238,7 +504,7 @@ void StudioModelRenderer::DrawSingleAttachment(ModelRenderInfo& renderInfo, cons
 	VectorTransform(pattachments[iAttachment].vectors[0], _bonetransform[pattachments[iAttachment].bone], v[1]);
 	VectorTransform(pattachments[iAttachment].vectors[1], _bonetransform[pattachments[iAttachment].bone], v[2]);
 	VectorTransform(pattachments[iAttachment].vectors[2], _bonetransform[pattachments[iAttachment].bone], v[3]);
-	glBegin(GL_LINES);
+	glCountedBegin(GL_LINES);
 	glColor3f(0, 1, 1);
 	glVertex3fv(glm::value_ptr(v[0]));
 	glColor3f(1, 1, 1);
@@ -255,7 +521,7 @@ void StudioModelRenderer::DrawSingleAttachment(ModelRenderInfo& renderInfo, cons
 
 	glPointSize(10);
 	glColor3f(0, 1, 0);
-	glBegin(GL_POINTS);
+	glCountedBegin(GL_POINTS);
 	glVertex3fv(glm::value_ptr(v[0]));
 	glEnd();
 	glPointSize(1);
@@ -279,18 +545,18 @@ void StudioModelRenderer::DrawSingleHitbox(ModelRenderInfo& renderInfo, const in
 
 	SetUpBones();
 
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_CULL_FACE);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_CULL_FACE);
 	if (_renderInfo->Transparency < 1.0f)
-		glDisable(GL_DEPTH_TEST);
+		glCountedDisable(GL_DEPTH_TEST);
 	else
-		glEnable(GL_DEPTH_TEST);
+		glCountedEnable(GL_DEPTH_TEST);
 
 	glColor4f(1, 0, 0, 0.5f);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glCountedEnable(GL_BLEND);
+	glCountedBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	mstudiobbox_t* hitbox = _studioHeader->GetHitBox(hitboxIndex);
 	glm::vec3 v[8], v2[8];
@@ -346,11 +612,35 @@ void StudioModelRenderer::DrawSingleHitbox(ModelRenderInfo& renderInfo, const in
 	_renderInfo = nullptr;
 }
 
+void StudioModelRenderer::SkinModel(ModelRenderInfo& renderInfo)
+{
+	_renderInfo = &renderInfo;
+	_studioHeader = _renderInfo->Model->GetStudioHeader();
+	_textureHeader = _renderInfo->Model->GetTextureHeader();
+
+	//Chrome vectors are cached per model drawn
+	++_modelsDrawnCount;
+
+	SetUpBones();
+
+	SetupLighting();
+
+	for (int i = 0; i < _studioHeader->numbodyparts; i++)
+	{
+		SetupModel(i);
+
+		_xformvertsModel = nullptr;
+
+		TransformVertices();
+		LightVertices();
+	}
+}
+
 void StudioModelRenderer::DrawBones()
 {
 	const mstudiobone_t* const pbones = _studioHeader->GetBones();
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_DEPTH_TEST);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_DEPTH_TEST);
 
 	for (int i = 0; i < _studioHeader->numbones; i++)
 	{
@@ -358,13 +648,13 @@ void StudioModelRenderer::DrawBones()
 		{
 			glPointSize(3.0f);
 			glColor3f(1, 0.7f, 0);
-			glBegin(GL_LINES);
+			glCountedBegin(GL_LINES);
 			glVertex3f(_bonetransform[pbones[i].parent][0][3], _bonetransform[pbones[i].parent][1][3], _bonetransform[pbones[i].parent][2][3]);
 			glVertex3f(_bonetransform[i][0][3], _bonetransform[i][1][3], _bonetransform[i][2][3]);
 			glEnd();
 
 			glColor3f(0, 0, 0.8f);
-			glBegin(GL_POINTS);
+			glCountedBegin(GL_POINTS);
 			if (pbones[pbones[i].parent].parent != -1)
 				glVertex3f(_bonetransform[pbones[i].parent][0][3], _bonetransform[pbones[i].parent][1][3], _bonetransform[pbones[i].parent][2][3]);
 			glVertex3f(_bonetransform[i][0][3], _bonetransform[i][1][3], _bonetransform[i][2][3]);
@@ -375,7 +665,7 @@ void StudioModelRenderer::DrawBones()
 			// draw parent bone node
 			glPointSize(5.0f);
 			glColor3f(0.8f, 0, 0);
-			glBegin(GL_POINTS);
+			glCountedBegin(GL_POINTS);
 			glVertex3f(_bonetransform[i][0][3], _bonetransform[i][1][3], _bonetransform[i][2][3]);
 			glEnd();
 		}
@@ -386,9 +676,9 @@ void StudioModelRenderer::DrawBones()
 
 void StudioModelRenderer::DrawAttachments()
 {
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_CULL_FACE);
+	glCountedDisable(GL_DEPTH_TEST);
 
 	for (int i = 0; i < _studioHeader->numattachments; i++)
 	{
@@ -398,7 +688,7 @@ void StudioModelRenderer::DrawAttachments()
 		VectorTransform(pattachments[i].vectors[0], _bonetransform[pattachments[i].bone], v[1]);
 		VectorTransform(pattachments[i].vectors[1], _bonetransform[pattachments[i].bone], v[2]);
 		VectorTransform(pattachments[i].vectors[2], _bonetransform[pattachments[i].bone], v[3]);
-		glBegin(GL_LINES);
+		glCountedBegin(GL_LINES);
 		glColor3f(1, 0, 0);
 		glVertex3fv(glm::value_ptr(v[0]));
 		glColor3f(1, 1, 1);
@@ -415,7 +705,7 @@ void StudioModelRenderer::DrawAttachments()
 
 		glPointSize(5);
 		glColor3f(0, 1, 0);
-		glBegin(GL_POINTS);
+		glCountedBegin(GL_POINTS);
 		glVertex3fv(glm::value_ptr(v[0]));
 		glEnd();
 		glPointSize(1);
@@ -424,13 +714,13 @@ void StudioModelRenderer::DrawAttachments()
 
 void StudioModelRenderer::DrawEyePosition()
 {
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_CULL_FACE);
+	glCountedDisable(GL_DEPTH_TEST);
 
 	glPointSize(7);
 	glColor3f(1, 0, 1);
-	glBegin(GL_POINTS);
+	glCountedBegin(GL_POINTS);
 	glVertex3fv(glm::value_ptr(_studioHeader->eyeposition));
 	glEnd();
 	glPointSize(1);
@@ -438,18 +728,18 @@ void StudioModelRenderer::DrawEyePosition()
 
 void StudioModelRenderer::DrawHitBoxes()
 {
-	glDisable(GL_TEXTURE_2D);
-	glDisable(GL_CULL_FACE);
+	glCountedDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_CULL_FACE);
 	if (_renderInfo->Transparency < 1.0f)
-		glDisable(GL_DEPTH_TEST);
+		glCountedDisable(GL_DEPTH_TEST);
 	else
-		glEnable(GL_DEPTH_TEST);
+		glCountedEnable(GL_DEPTH_TEST);
 
 	glColor4f(1, 0, 0, 0.5f);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glCountedEnable(GL_BLEND);
+	glCountedBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	for (int i = 0; i < _studioHeader->numhitboxes; i++)
 	{
@@ -506,32 +796,24 @@ void StudioModelRenderer::DrawHitBoxes()
 
 void StudioModelRenderer::DrawNormals()
 {
-	glDisable(GL_TEXTURE_2D);
+	glCountedDisable(GL_TEXTURE_2D);
 
 	glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-	glBegin(GL_LINES);
+	glCountedBegin(GL_LINES);
 
 	for (int iBodyPart = 0; iBodyPart < _studioHeader->numbodyparts; ++iBodyPart)
 	{
 		SetupModel(iBodyPart);
 
-		auto pvertbone = (const byte*)(_studioHeader->GetData() + _model->vertinfoindex);
 		auto pnormbone = (const byte*)(_studioHeader->GetData() + _model->norminfoindex);
 
 		auto pMeshes = (const mstudiomesh_t*)(_studioHeader->GetData() + _model->meshindex);
 
-		auto pstudioverts = (const glm::vec3*)(_studioHeader->GetData() + _model->vertindex);
 		auto pstudionorms = (const glm::vec3*)(_studioHeader->GetData() + _model->normindex);
 
-		for (int i = 0; i < _model->numverts; i++)
-		{
-			VectorTransform(pstudioverts[i], _bonetransform[pvertbone[i]], _xformverts[i]);
-		}
+		TransformVertices();
 
-		for (int i = 0; i < _model->numnorms; i++)
-		{
-			VectorRotate(pstudionorms[i], _bonetransform[pnormbone[i]], _xformnorms[i]);
-		}
+		VectorRotateBatch(pstudionorms, pnormbone, _bonetransform, _studioHeader->numbones, _xformnorms, _model->numnorms);
 
 		for (int j = 0; j < _model->nummesh; j++)
 		{
@@ -565,454 +847,364 @@ void StudioModelRenderer::DrawNormals()
 
 void StudioModelRenderer::SetUpBones()
 {
-	static glm::vec3 pos[MAXSTUDIOBONES];
-	static glm::vec4 q[MAXSTUDIOBONES];
-
-	static glm::vec3 pos2[MAXSTUDIOBONES];
-	static glm::vec4 q2[MAXSTUDIOBONES];
-	static glm::vec3 pos3[MAXSTUDIOBONES];
-	static glm::vec4 q3[MAXSTUDIOBONES];
-	static glm::vec3 pos4[MAXSTUDIOBONES];
-	static glm::vec4 q4[MAXSTUDIOBONES];
+	PROFILE_ZONE("StudioModelRenderer::SetUpBones");
 
 	if (_renderInfo->Sequence >= _studioHeader->numseq)
 	{
 		_renderInfo->Sequence = 0;
 	}
 
-	mstudioseqdesc_t* const pseqdesc = _studioHeader->GetSequence(_renderInfo->Sequence);
-
-	const mstudioanim_t* panim = _renderInfo->Model->GetAnim(pseqdesc);
-
-	if (pseqdesc->numblends == 9)
+	const BonePoseKey key
 	{
-		const auto f = _renderInfo->Frame;
-
-		const auto blendX = static_cast<double>(_renderInfo->Blender[0]);
-		const auto blendY = static_cast<double>(_renderInfo->Blender[1]);
-
-		const mstudioanim_t* lastanim;
-
-		double interpolantX;
-		double interpolantY;
+		_renderInfo->Model,
+		_renderInfo->Sequence,
+		_renderInfo->Frame,
+		{_renderInfo->Blender[0], _renderInfo->Blender[1]},
+		{_renderInfo->Controller[0], _renderInfo->Controller[1], _renderInfo->Controller[2], _renderInfo->Controller[3]},
+		_renderInfo->Mouth
+	};
+
+	for (std::size_t i = 0; i < _cachedPoseCount; ++i)
+	{
+		const auto& pose = *_cachedPoses[i];
 
-		if (blendX > 127.0)
+		if (pose.Key == key)
 		{
-			interpolantX = blendX - 127.0 + blendX - 127.0;
+			++_poseCacheHits;
 
-			if (blendY > 127.0)
+			if (_currentPoseId != pose.PoseId)
 			{
-				interpolantY = blendY - 127.0 + blendY - 127.0;
-
-				auto panim4 = panim;
-				if (pseqdesc->numblends > 4)
-					panim4 += 4 * _studioHeader->numbones;
-				CalcRotations(pos, q, pseqdesc, panim4, f);
-
-				auto panim5 = panim;
-				if (pseqdesc->numblends > 5)
-					panim5 += 5 * _studioHeader->numbones;
-				CalcRotations(pos2, q2, pseqdesc, panim5, f);
-
-				auto panim7 = panim;
-				if (pseqdesc->numblends > 7)
-					panim7 += 7 * _studioHeader->numbones;
-				CalcRotations(pos3, q3, pseqdesc, panim7, f);
-
-				lastanim = panim;
-				if (pseqdesc->numblends > 8)
-					lastanim += 8 * _studioHeader->numbones;
-			}
-			else
-			{
-				interpolantY = blendY + blendY;
-
-				auto panim1 = panim;
-				if (pseqdesc->numblends > 1)
-					panim1 += _studioHeader->numbones;
-				CalcRotations(pos, q, pseqdesc, panim1, f);
-
-				auto panim2 = panim;
-				if (pseqdesc->numblends > 2)
-					panim2 += 2 * _studioHeader->numbones;
-				CalcRotations(pos2, q2, pseqdesc, panim2, f);
-
-				auto panim4 = panim;
-				if (pseqdesc->numblends > 4)
-					panim4 += 4 * _studioHeader->numbones;
-				CalcRotations(pos3, q3, pseqdesc, panim4, f);
-
-				lastanim = panim;
-				if (pseqdesc->numblends > 5)
-					lastanim += 5 * _studioHeader->numbones;
+				std::copy_n(pose.BoneTransforms, _studioHeader->numbones, _bonetransform);
+				_currentPoseId = pose.PoseId;
 			}
+
+			return;
 		}
-		else
-		{
-			interpolantX = blendX + blendX;
+	}
 
-			if (blendY <= 127.0)
-			{
-				interpolantY = blendY + blendY;
+	++_poseCacheMisses;
 
-				CalcRotations(pos, q, pseqdesc, panim, f);
+	CalcBones();
 
-				auto panim1 = panim;
-				if (pseqdesc->numblends > 1)
-					panim1 += _studioHeader->numbones;
-				CalcRotations(pos2, q2, pseqdesc, panim1, f);
+	if (_cachedPoseCount == _cachedPoses.size())
+	{
+		_cachedPoses.emplace_back(std::make_unique<CachedBonePose>());
+	}
 
-				auto panim3 = panim;
-				if (pseqdesc->numblends > 3)
-					panim3 += 3 * _studioHeader->numbones;
-				CalcRotations(pos3, q3, pseqdesc, panim3, f);
+	auto& pose = *_cachedPoses[_cachedPoseCount++];
 
-				lastanim = panim;
-				if (pseqdesc->numblends > 4)
-					lastanim += 4 * _studioHeader->numbones;
-			}
-			else
-			{
-				interpolantY = blendY - 127.0 + blendY - 127.0;
-
-				auto panim3 = panim;
-				if (pseqdesc->numblends > 3)
-					panim3 += 3 * _studioHeader->numbones;
-				CalcRotations(pos, q, pseqdesc, panim3, f);
-
-				auto panim4 = panim;
-				if (pseqdesc->numblends > 4)
-					panim4 += 4 * _studioHeader->numbones;
-				CalcRotations(pos2, q2, pseqdesc, panim4, f);
-
-				auto panim6 = panim;
-				if (pseqdesc->numblends > 6)
-					panim6 += 6 * _studioHeader->numbones;
-				CalcRotations(pos3, q3, pseqdesc, panim6, f);
-
-				lastanim = panim;
-				if (pseqdesc->numblends > 7)
-					lastanim += 7 * _studioHeader->numbones;
-			}
-		}
+	pose.Key = key;
+	pose.PoseId = ++_nextPoseId;
+	std::copy_n(_bonetransform, _studioHeader->numbones, pose.BoneTransforms);
 
-		CalcRotations(pos4, q4, pseqdesc, lastanim, f);
+	_currentPoseId = pose.PoseId;
+}
 
-		const auto normalizedInterpolantX = interpolantX / 255.0;
-		SlerpBones(q, pos, q2, pos2, normalizedInterpolantX);
-		SlerpBones(q3, pos3, q4, pos4, normalizedInterpolantX);
+void StudioModelRenderer::CalcBones()
+{
+	_boneSetup.CalcBoneTransforms(*_renderInfo, _bonetransform);
+}
 
-		const auto normalizedInterpolantY = interpolantY / 255.0;
-		SlerpBones(q, pos, q3, pos3, normalizedInterpolantY);
-	}
-	else
+void StudioModelRenderer::SetupLighting()
+{
+	_ambientlight = 32;
+	_shadelight = 192;
+
+	for (int i = 0; i < _studioHeader->numbones; i++)
 	{
-		CalcRotations(pos, q, pseqdesc, panim, _renderInfo->Frame);
+		VectorIRotate(_lightvec, _bonetransform[i], _blightvec[i]);
+	}
+}
 
-		if (pseqdesc->numblends > 1)
-		{
-			panim += _studioHeader->numbones;
-			CalcRotations(pos2, q2, pseqdesc, panim, _renderInfo->Frame);
-			float s = _renderInfo->Blender[0] / 255.0;
+void StudioModelRenderer::SetupModel(int bodypart)
+{
+	if (bodypart > _studioHeader->numbodyparts)
+	{
+		// Con_DPrintf ("StudioModelRenderer::SetupModel: no such bodypart %d\n", bodypart);
+		bodypart = 0;
+	}
 
-			SlerpBones(q, pos, q2, pos2, s);
+	_model = _renderInfo->Model->GetModelByBodyPart(_renderInfo->Bodygroup, bodypart);
 
-			if (pseqdesc->numblends == 4)
-			{
-				panim += _studioHeader->numbones;
-				CalcRotations(pos3, q3, pseqdesc, panim, _renderInfo->Frame);
+	//Counts are validated when the model is loaded
+	auto& buffers = GetVertexBuffers();
 
-				panim += _studioHeader->numbones;
-				CalcRotations(pos4, q4, pseqdesc, panim, _renderInfo->Frame);
+	const auto vertexCount = static_cast<std::size_t>(_model->numverts);
+	const auto normalCount = static_cast<std::size_t>(_model->numnorms);
 
-				s = _renderInfo->Blender[0] / 255.0;
-				SlerpBones(q3, pos3, q4, pos4, s);
+	if (buffers.TransformedVertices.size() < vertexCount)
+	{
+		buffers.TransformedVertices.resize(vertexCount);
+	}
 
-				s = _renderInfo->Blender[1] / 255.0;
-				SlerpBones(q, pos, q3, pos3, s);
-			}
-		}
+	if (buffers.TransformedNormals.size() < normalCount)
+	{
+		buffers.TransformedNormals.resize(normalCount);
+		buffers.LightValues.resize(normalCount);
+		buffers.Chrome.resize(normalCount);
 	}
 
-	const mstudiobone_t* const pbones = _studioHeader->GetBones();
+	_xformverts = buffers.TransformedVertices.data();
+	_xformnorms = buffers.TransformedNormals.data();
+	_lightvalues = buffers.LightValues.data();
+	_chrome = buffers.Chrome.data();
+}
 
-	glm::mat3x4 bonematrix;
+void StudioModelRenderer::TransformVertices()
+{
+	auto& buffers = GetVertexBuffers();
 
-	for (int i = 0; i < _studioHeader->numbones; i++)
+	if (buffers.TransformedVerticesOwner == this && _xformvertsModel == _model && _xformvertsPoseId == _currentPoseId)
 	{
-		QuaternionMatrix(q[i], bonematrix);
+		return;
+	}
 
-		bonematrix[0][3] = pos[i][0];
-		bonematrix[1][3] = pos[i][1];
-		bonematrix[2][3] = pos[i][2];
+	buffers.TransformedVerticesOwner = this;
+	_xformvertsModel = _model;
+	_xformvertsPoseId = _currentPoseId;
 
-		if (pbones[i].parent == -1)
-		{
-			_bonetransform[i] = bonematrix;
-		}
-		else
-		{
-			R_ConcatTransforms(_bonetransform[pbones[i].parent], bonematrix, _bonetransform[i]);
-		}
-	}
+	auto pvertbone = ((const byte*)_studioHeader + _model->vertinfoindex);
+	auto pstudioverts = (const glm::vec3*)((const byte*)_studioHeader + _model->vertindex);
+
+	VectorTransformBatch(pstudioverts, pvertbone, _bonetransform, _studioHeader->numbones, _xformverts, _model->numverts);
 }
 
-void StudioModelRenderer::CalcRotations(glm::vec3* pos, glm::vec4* q, const mstudioseqdesc_t* const pseqdesc, const mstudioanim_t* panim, const float f)
+void StudioModelRenderer::UploadBoneData()
 {
-	const int frame = (int)f;
-	const float s = (f - frame);
+	std::array<glm::vec4, SkinningTexelsPerBone * MAXSTUDIOBONES> boneData;
 
-	// add in programatic controllers
-	CalcBoneAdj();
+	for (int i = 0; i < _studioHeader->numbones; ++i)
+	{
+		SetupChrome(i);
 
-	auto pbone = _studioHeader->GetBones();
+		const auto data = &boneData[i * SkinningTexelsPerBone];
 
-	for (int i = 0; i < _studioHeader->numbones; i++, pbone++, panim++)
-	{
-		CalcBoneQuaternion(frame, s, pbone, panim, q[i]);
-		CalcBonePosition(frame, s, pbone, panim, pos[i]);
+		data[0] = _bonetransform[i][0];
+		data[1] = _bonetransform[i][1];
+		data[2] = _bonetransform[i][2];
+		data[3] = glm::vec4{_blightvec[i], 0};
+		data[4] = glm::vec4{_chromeup[i], 0};
+		data[5] = glm::vec4{_chromeright[i], 0};
 	}
 
-	if (pseqdesc->motiontype & STUDIO_X)
-		pos[pseqdesc->motionbone][0] = 0.0;
-	if (pseqdesc->motiontype & STUDIO_Y)
-		pos[pseqdesc->motionbone][1] = 0.0;
-	if (pseqdesc->motiontype & STUDIO_Z)
-		pos[pseqdesc->motionbone][2] = 0.0;
+	//Left bound to unit 1 for the skinning shader
+	glActiveTexture(GL_TEXTURE1);
+	glCountedBindTexture(GL_TEXTURE_2D, _boneDataTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SkinningTexelsPerBone, _studioHeader->numbones, GL_RGBA, GL_FLOAT, boneData.data());
+	glActiveTexture(GL_TEXTURE0);
 }
 
-void StudioModelRenderer::CalcBoneAdj()
+void StudioModelRenderer::EvaluateInstances(ModelRenderInfo* const renderInfos, const std::size_t count)
 {
-	const auto* const pbonecontroller = _studioHeader->GetBoneControllers();
+	PROFILE_ZONE("StudioModelRenderer::EvaluateInstances");
 
-	for (int j = 0; j < _studioHeader->numbonecontrollers; j++)
-	{
-		const auto i = pbonecontroller[j].index;
+	const auto model = _renderInfo->Model;
 
-		float value;
+	const std::size_t texelsPerInstance = static_cast<std::size_t>(_studioHeader->numbones) * SkinningTexelsPerBone;
 
-		if (i <= 3)
-		{
-			// check for 360% wrapping
-			if (pbonecontroller[j].type & STUDIO_RLOOP)
-			{
-				value = _renderInfo->Controller[i] * (360.0 / 256.0) + pbonecontroller[j].start;
-			}
-			else
-			{
-				value = _renderInfo->Controller[i] / 255.0;
-				if (value < 0) value = 0;
-				if (value > 1.0) value = 1.0;
-				value = (1.0 - value) * pbonecontroller[j].start + value * pbonecontroller[j].end;
-			}
-			// Con_DPrintf( "%d %d %f : %f\n", m_controller[j], m_prevcontroller[j], value, dadt );
-		}
-		else
-		{
-			value = _renderInfo->Mouth / 64.0;
-			if (value > 1.0) value = 1.0;
-			value = (1.0 - value) * pbonecontroller[j].start + value * pbonecontroller[j].end;
-			// Con_DPrintf("%d %f\n", mouthopen, value );
-		}
-		switch (pbonecontroller[j].type & STUDIO_TYPES)
+	_instanceData.resize(count * texelsPerInstance);
+
+	//The animation cache is not thread safe, so everything the instances need is decoded here and passed to the workers
+	_instanceAnimations.assign(_studioHeader->numseq, nullptr);
+
+	std::vector<bool> usedSequences(_studioHeader->numseq, false);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto& renderInfo = renderInfos[i];
+
+		if (renderInfo.Sequence < 0 || renderInfo.Sequence >= _studioHeader->numseq)
 		{
-		case STUDIO_XR:
-		case STUDIO_YR:
-		case STUDIO_ZR:
-			_adj[j] = value * (PI<double> / 180.0);
-			break;
-		case STUDIO_X:
-		case STUDIO_Y:
-		case STUDIO_Z:
-			_adj[j] = value;
-			break;
+			renderInfo.Sequence = 0;
 		}
+
+		usedSequences[renderInfo.Sequence] = true;
 	}
-}
 
-void StudioModelRenderer::CalcBoneQuaternion(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim, glm::vec4& q)
-{
-	glm::vec3			angle1, angle2;
+	//Sequence groups other than the main one can evict each other while in use, so they can only be shared by threads if there is one
+	int sequenceGroup = 0;
+	bool canUseThreads = true;
 
-	for (int j = 0; j < 3; j++)
+	for (int i = 0; i < _studioHeader->numseq; ++i)
 	{
-		if (panim->offset[j + 3] == 0)
+		if (!usedSequences[i])
 		{
-			angle2[j] = angle1[j] = pbone->value[j + 3]; // default;
+			continue;
 		}
-		else
+
+		model->GetAnimationCache()->Get(*model, i);
+
+		const int group = _studioHeader->GetSequence(i)->seqgroup;
+
+		if (group != 0)
 		{
-			auto panimvalue = (const mstudioanimvalue_t*)((const byte*)panim + panim->offset[j + 3]);
-			auto k = frame;
-			while (panimvalue->num.total <= k)
+			if (sequenceGroup != 0 && sequenceGroup != group)
 			{
-				k -= panimvalue->num.total;
-				panimvalue += panimvalue->num.valid + 1;
+				canUseThreads = false;
 			}
-			// Bah, missing blend!
-			if (panimvalue->num.valid > k)
-			{
-				angle1[j] = panimvalue[k + 1].value;
 
-				if (panimvalue->num.valid > k + 1)
-				{
-					angle2[j] = panimvalue[k + 2].value;
-				}
-				else
-				{
-					if (panimvalue->num.total > k + 1)
-						angle2[j] = angle1[j];
-					else
-						angle2[j] = panimvalue[panimvalue->num.valid + 2].value;
-				}
-			}
-			else
-			{
-				angle1[j] = panimvalue[panimvalue->num.valid].value;
-				if (panimvalue->num.total > k + 1)
-				{
-					angle2[j] = angle1[j];
-				}
-				else
-				{
-					angle2[j] = panimvalue[panimvalue->num.valid + 2].value;
-				}
-			}
-			angle1[j] = pbone->value[j + 3] + angle1[j] * pbone->scale[j + 3];
-			angle2[j] = pbone->value[j + 3] + angle2[j] * pbone->scale[j + 3];
+			sequenceGroup = group;
 		}
+	}
 
-		if (pbone->bonecontroller[j + 3] != -1)
+	//Decoding a sequence can evict one decoded earlier, those instances use the run-length encoded data instead
+	for (int i = 0; i < _studioHeader->numseq; ++i)
+	{
+		if (usedSequences[i])
 		{
-			angle1[j] += _adj[pbone->bonecontroller[j + 3]];
-			angle2[j] += _adj[pbone->bonecontroller[j + 3]];
+			_instanceAnimations[i] = model->GetAnimationCache()->Find(i);
 		}
 	}
 
-	if (!VectorCompare(angle1, angle2))
+	const auto evaluate = [&, this](BoneSetup& boneSetup, std::size_t begin, std::size_t end)
 	{
-		glm::vec4 q1, q2;
+		glm::mat3x4 boneTransforms[MAXSTUDIOBONES];
+
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const auto& renderInfo = renderInfos[_instanceOrder[i]];
+
+			boneSetup.CalcBoneTransforms(renderInfo, _instanceAnimations[renderInfo.Sequence], boneTransforms);
+			WriteInstanceData(renderInfo, boneTransforms, &_instanceData[i * texelsPerInstance]);
+		}
+	};
+
+	std::size_t rangeCount = 1;
 
-		AngleQuaternion(angle1, q1);
-		AngleQuaternion(angle2, q2);
-		QuaternionSlerp(q1, q2, s, q);
+	if (_jobSystem && canUseThreads)
+	{
+		//The calling thread evaluates a range too
+		rangeCount = std::clamp<std::size_t>(count / MinInstancesPerThread, 1, _jobSystem->GetThreadCount() + 1);
 	}
-	else
+
+	while (_instanceBoneSetups.size() < rangeCount)
 	{
-		AngleQuaternion(angle1, q);
+		_instanceBoneSetups.emplace_back(std::make_unique<BoneSetup>());
 	}
-}
 
-void StudioModelRenderer::CalcBonePosition(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim, glm::vec3& pos)
-{
-	for (int j = 0; j < 3; j++)
+	const std::size_t instancesPerRange = (count + rangeCount - 1) / rangeCount;
+
+	const auto evaluateRanges = [&](std::size_t begin, std::size_t end)
 	{
-		pos[j] = pbone->value[j]; // default;
-		if (panim->offset[j] != 0)
+		for (std::size_t range = begin; range < end; ++range)
 		{
-			auto panimvalue = (mstudioanimvalue_t*)((byte*)panim + panim->offset[j]);
+			const std::size_t first = std::min(count, range * instancesPerRange);
 
-			auto k = frame;
-			// find span of values that includes the frame we want
-			while (panimvalue->num.total <= k)
-			{
-				k -= panimvalue->num.total;
-				panimvalue += panimvalue->num.valid + 1;
-			}
-			// if we're inside the span
-			if (panimvalue->num.valid > k)
-			{
-				// and there's more data in the span
-				if (panimvalue->num.valid > k + 1)
-				{
-					pos[j] += (panimvalue[k + 1].value * (1.0 - s) + s * panimvalue[k + 2].value) * pbone->scale[j];
-				}
-				else
-				{
-					pos[j] += panimvalue[k + 1].value * pbone->scale[j];
-				}
-			}
-			else
-			{
-				// are we at the end of the repeating values section and there's another section with data?
-				if (panimvalue->num.total <= k + 1)
-				{
-					pos[j] += (panimvalue[panimvalue->num.valid].value * (1.0 - s) + s * panimvalue[panimvalue->num.valid + 2].value) * pbone->scale[j];
-				}
-				else
-				{
-					pos[j] += panimvalue[panimvalue->num.valid].value * pbone->scale[j];
-				}
-			}
-		}
-		if (pbone->bonecontroller[j] != -1)
-		{
-			pos[j] += _adj[pbone->bonecontroller[j]];
+			evaluate(*_instanceBoneSetups[range], first, std::min(count, first + instancesPerRange));
 		}
+	};
+
+	if (rangeCount > 1)
+	{
+		_jobSystem->ParallelFor(0, rangeCount, 1, evaluateRanges);
+	}
+	else
+	{
+		evaluateRanges(0, 1);
 	}
 }
 
-void StudioModelRenderer::SlerpBones(glm::vec4* q1, glm::vec3* pos1, glm::vec4* q2, glm::vec3* pos2, float s)
+void StudioModelRenderer::WriteInstanceData(const ModelRenderInfo& renderInfo, const glm::mat3x4* boneTransforms, glm::vec4* data) const
 {
-	glm::vec4 q3;
+	//Same transform that DrawModel applies to the modelview matrix
+	glm::mat3x4 instanceTransform;
 
-	if (s < 0) s = 0;
-	else if (s > 1.0) s = 1.0;
+	AngleMatrix({renderInfo.Angles[2], renderInfo.Angles[0], renderInfo.Angles[1]}, instanceTransform);
 
-	const float s1 = 1.0 - s;
-
-	for (int i = 0; i < _studioHeader->numbones; i++)
+	for (int i = 0; i < 3; ++i)
 	{
-		QuaternionSlerp(q1[i], q2[i], s, q3);
-		q1[i] = q3;
+		for (int j = 0; j < 3; ++j)
+		{
+			instanceTransform[i][j] *= renderInfo.Scale[j];
+		}
 
-		pos1[i] = pos1[i] * s1 + pos2[i] * s;
+		instanceTransform[i][3] = renderInfo.Origin[i];
 	}
-}
 
-void StudioModelRenderer::SetupLighting()
-{
-	_ambientlight = 32;
-	_shadelight = 192;
+	glm::mat3x4 transform;
+	glm::vec3 lightvec;
+	glm::vec3 chromeUp;
+	glm::vec3 chromeRight;
 
-	for (int i = 0; i < _studioHeader->numbones; i++)
+	for (int i = 0; i < _studioHeader->numbones; ++i, data += SkinningTexelsPerBone)
 	{
-		VectorIRotate(_lightvec, _bonetransform[i], _blightvec[i]);
+		R_ConcatTransforms(instanceTransform, boneTransforms[i], transform);
+
+		//Lighting and chrome use the model space transforms, like DrawModel
+		VectorIRotate(_lightvec, boneTransforms[i], lightvec);
+		CalcChromeVectors(boneTransforms[i], chromeUp, chromeRight);
+
+		data[0] = transform[0];
+		data[1] = transform[1];
+		data[2] = transform[2];
+		data[3] = glm::vec4{lightvec, 0};
+		data[4] = glm::vec4{chromeUp, 0};
+		data[5] = glm::vec4{chromeRight, 0};
 	}
 }
 
-void StudioModelRenderer::SetupModel(int bodypart)
+unsigned int StudioModelRenderer::DrawInstances(const bool bWireframe, int firstInstance, int instanceCount, int skin)
 {
-	if (bodypart > _studioHeader->numbodyparts)
+	auto ptexture = _textureHeader->GetTextures();
+
+	auto pmesh = (mstudiomesh_t*)((byte*)_studioHeader + _model->meshindex);
+
+	auto pskinref = _textureHeader->GetSkins();
+
+	if (skin != 0 && skin < _textureHeader->numskinfamilies)
+		pskinref += (skin * _textureHeader->numskinref);
+
+	SortedMesh meshes[MAXSTUDIOMESHES]{};
+
+	for (int j = 0; j < _model->nummesh; j++)
 	{
-		// Con_DPrintf ("StudioModelRenderer::SetupModel: no such bodypart %d\n", bodypart);
-		bodypart = 0;
+		meshes[j].Mesh = &pmesh[j];
+		meshes[j].Flags = ptexture[pskinref[pmesh[j].skinref]].flags;
 	}
 
-	_model = _renderInfo->Model->GetModelByBodyPart(_renderInfo->Bodygroup, bodypart);
+	std::stable_sort(meshes, meshes + _model->nummesh, CompareSortedMeshes);
+
+	const auto& cache = _meshCache.GetSubModel(*_renderInfo->Model, *_model);
+
+	const unsigned int drawnPolys = DrawMeshes(bWireframe, cache, meshes, ptexture, pskinref, firstInstance, instanceCount);
+
+	glCountedDepthMask(GL_TRUE);
+
+	return drawnPolys;
 }
 
 unsigned int StudioModelRenderer::DrawPoints(const bool bWireframe)
 {
+	PROFILE_ZONE("StudioModelRenderer::DrawPoints");
+
 	unsigned int uiDrawnPolys = 0;
 
-	auto pvertbone = ((byte*)_studioHeader + _model->vertinfoindex);
-	auto pnormbone = ((byte*)_studioHeader + _model->norminfoindex);
 	auto ptexture = _textureHeader->GetTextures();
 
 	auto pmesh = (mstudiomesh_t*)((byte*)_studioHeader + _model->meshindex);
 
-	auto pstudioverts = (const glm::vec3*)((const byte*)_studioHeader + _model->vertindex);
-	auto pstudionorms = (const glm::vec3*)((const byte*)_studioHeader + _model->normindex);
-
 	auto pskinref = _textureHeader->GetSkins();
 
 	if (_renderInfo->Skin != 0 && _renderInfo->Skin < _textureHeader->numskinfamilies)
 		pskinref += (_renderInfo->Skin * _textureHeader->numskinref);
 
-	for (int i = 0; i < _model->numverts; i++)
+	//The skinning shader does all per-vertex work itself
+	const bool useGPUSkinning = IsGPUSkinningEnabled();
+
+	auto& cache = _meshCache.GetSubModel(*_renderInfo->Model, *_model);
+
+	//Passes that draw the same submodel in the same pose, like the mirror and wireframe overlay, reuse the uploaded data
+	//as long as nothing else has been uploaded to the buffer since
+	const bool needsUpload = !useGPUSkinning
+		&& !(cache.DynamicFrame == _frameNumber
+			&& cache.DynamicPoseId == _currentPoseId
+			&& cache.DynamicSkinRef == pskinref
+			&& cache.DynamicTransparency == _renderInfo->Transparency);
+
+	if (needsUpload)
 	{
-		VectorTransform(pstudioverts[i], _bonetransform[pvertbone[i]], _xformverts[i]);
+		TransformVertices();
+		LightVertices();
 	}
 
 	SortedMesh meshes[MAXSTUDIOMESHES]{};
@@ -1021,13 +1213,51 @@ unsigned int StudioModelRenderer::DrawPoints(const bool bWireframe)
 	// clip and draw all triangles
 	//
 
-	glm::vec3* lv = _lightvalues;
 	for (int j = 0; j < _model->nummesh; j++)
 	{
-		int flags = ptexture[pskinref[pmesh[j].skinref]].flags;
-
 		meshes[j].Mesh = &pmesh[j];
-		meshes[j].Flags = flags;
+		meshes[j].Flags = ptexture[pskinref[pmesh[j].skinref]].flags;
+	}
+
+	//Sort meshes by render modes so additive meshes are drawn after solid meshes.
+	//Masked meshes are drawn before solid meshes.
+	std::stable_sort(meshes, meshes + _model->nummesh, CompareSortedMeshes);
+
+	if (needsUpload)
+	{
+		UploadDynamicMeshData(cache, pmesh, ptexture, pskinref);
+
+		cache.DynamicFrame = _frameNumber;
+		cache.DynamicPoseId = _currentPoseId;
+		cache.DynamicSkinRef = pskinref;
+		cache.DynamicTransparency = _renderInfo->Transparency;
+	}
+
+	uiDrawnPolys += DrawMeshes(bWireframe, cache, meshes, ptexture, pskinref);
+
+	glCountedDepthMask(GL_TRUE);
+
+	return uiDrawnPolys;
+}
+
+void StudioModelRenderer::LightVertices()
+{
+	auto pnormbone = ((const byte*)_studioHeader + _model->norminfoindex);
+	auto ptexture = _textureHeader->GetTextures();
+
+	auto pmesh = (const mstudiomesh_t*)((const byte*)_studioHeader + _model->meshindex);
+
+	auto pstudionorms = (const glm::vec3*)((const byte*)_studioHeader + _model->normindex);
+
+	auto pskinref = _textureHeader->GetSkins();
+
+	if (_renderInfo->Skin != 0 && _renderInfo->Skin < _textureHeader->numskinfamilies)
+		pskinref += (_renderInfo->Skin * _textureHeader->numskinref);
+
+	glm::vec3* lv = _lightvalues;
+	for (int j = 0; j < _model->nummesh; j++)
+	{
+		const int flags = ptexture[pskinref[pmesh[j].skinref]].flags;
 
 		for (int i = 0; i < pmesh[j].numnorms; i++, ++lv, ++pstudionorms, pnormbone++)
 		{
@@ -1036,153 +1266,354 @@ unsigned int StudioModelRenderer::DrawPoints(const bool bWireframe)
 			// FIX: move this check out of the inner loop
 			if (flags & STUDIO_NF_CHROME)
 			{
-				auto& c = _chrome[reinterpret_cast<glm::vec3*>(lv) - _lightvalues];
+				auto& c = _chrome[lv - _lightvalues];
 
 				Chrome(c, *pnormbone, *pstudionorms);
 			}
 		}
 	}
+}
 
-	//Sort meshes by render modes so additive meshes are drawn after solid meshes.
-	//Masked meshes are drawn before solid meshes.
-	std::stable_sort(meshes, meshes + _model->nummesh, CompareSortedMeshes);
+void StudioModelRenderer::UploadDynamicMeshData(const CachedSubModel& cache, const mstudiomesh_t* pMeshes, const mstudiotexture_t* pTextures, const short* pSkinRef)
+{
+	const auto vertexCount = cache.Vertices.size();
 
-	uiDrawnPolys += DrawMeshes(bWireframe, meshes, ptexture, pskinref);
+	_meshPositions.resize(vertexCount);
+	_meshColors.resize(vertexCount);
+	_meshChrome.resize(vertexCount);
 
-	glDepthMask(GL_TRUE);
+	for (std::size_t j = 0; j < cache.Meshes.size(); ++j)
+	{
+		const auto& mesh = cache.Meshes[j];
+		const int flags = pTextures[pSkinRef[pMeshes[j].skinref]].flags;
 
-	return uiDrawnPolys;
+		for (int v = mesh.FirstVertex; v < mesh.FirstVertex + mesh.VertexCount; ++v)
+		{
+			const auto& vertex = cache.Vertices[v];
+
+			_meshPositions[v] = _xformverts[vertex.VertexIndex];
+
+			if (flags & STUDIO_NF_ADDITIVE)
+			{
+				_meshColors[v] = glm::vec4{1.0f, 1.0f, 1.0f, _renderInfo->Transparency};
+			}
+			else
+			{
+				_meshColors[v] = glm::vec4{_lightvalues[vertex.NormalIndex], _renderInfo->Transparency};
+			}
+
+			if (flags & STUDIO_NF_CHROME)
+			{
+				_meshChrome[v] = _chrome[vertex.NormalIndex];
+			}
+		}
+	}
+
+	const auto positionsSize = vertexCount * sizeof(glm::vec3);
+	const auto colorsSize = vertexCount * sizeof(glm::vec4);
+	const auto chromeSize = vertexCount * sizeof(glm::vec2);
+
+	glBindBuffer(GL_ARRAY_BUFFER, cache.DynamicBuffer);
+	//Orphan the previous contents so the driver doesn't have to wait for pending draws
+	glBufferData(GL_ARRAY_BUFFER, positionsSize + colorsSize + chromeSize, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, positionsSize, _meshPositions.data());
+	glBufferSubData(GL_ARRAY_BUFFER, positionsSize, colorsSize, _meshColors.data());
+	glBufferSubData(GL_ARRAY_BUFFER, positionsSize + colorsSize, chromeSize, _meshChrome.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-unsigned int StudioModelRenderer::DrawMeshes(const bool bWireframe, const SortedMesh* pMeshes, const mstudiotexture_t* pTextures, const short* pSkinRef)
+unsigned int StudioModelRenderer::DrawMeshes(const bool bWireframe, const CachedSubModel& cache,
+	const SortedMesh* pMeshes, const mstudiotexture_t* pTextures, const short* pSkinRef,
+	const int firstInstance, const int instanceCount)
 {
+	PROFILE_ZONE("StudioModelRenderer::DrawMeshes");
+
+	const bool instanced = instanceCount > 0;
+	const bool useGPUSkinning = instanced || IsGPUSkinningEnabled();
+
+	const auto& skinningShader = instanced ? _instancedSkinningShader : _skinningShader;
+
+	const glm::vec4 wireframeColor{_wireframeColor, _renderInfo->Transparency};
+
 	//Set here since it never changes. Much more efficient.
 	if (bWireframe)
 	{
-		glColor4fv(glm::value_ptr(glm::vec4{_wireframeColor, _renderInfo->Transparency}));
+		glColor4fv(glm::value_ptr(wireframeColor));
 	}
 
 	unsigned int uiDrawnPolys = 0;
 
 	//Polygons may overlap, so make sure they can blend together.
-	glDepthFunc(GL_LEQUAL);
+	glCountedDepthFunc(GL_LEQUAL);
+
+	const auto vertexCount = cache.Vertices.size();
+	const auto colorsOffset = vertexCount * sizeof(glm::vec3);
+	const auto chromeOffset = colorsOffset + (vertexCount * sizeof(glm::vec4));
+
+	const bool indexedTextures = !bWireframe && _renderInfo->Model->HasIndexedTextures();
+
+	if (useGPUSkinning)
+	{
+		glUseProgram(skinningShader.GetProgram());
+
+		glUniform1i(skinningShader.UsePalette, indexedTextures ? 1 : 0);
+		glUniform1i(skinningShader.LinearFilter, _renderInfo->Model->HasLinearTextureFiltering() ? 1 : 0);
+
+		glUniform1i(skinningShader.Wireframe, bWireframe ? 1 : 0);
+		glUniform4fv(skinningShader.WireframeColor, 1, glm::value_ptr(wireframeColor));
+		glUniform1f(skinningShader.Ambient, std::max(0.1f, (float)_ambientlight / 255.0f));
+		glUniform1f(skinningShader.Shade, _shadelight / 255.0f);
+		glUniform1f(skinningShader.Lambert, std::max(1.0f, _lambert));
+		glUniform3fv(skinningShader.LightColor, 1, glm::value_ptr(_lightcolor));
+		glUniform1f(skinningShader.Transparency, _renderInfo->Transparency);
+
+		if (instanced)
+		{
+			glUniform1i(skinningShader.FirstInstance, firstInstance);
+			glUniform1i(skinningShader.BoneCount, _studioHeader->numbones);
+			glUniformMatrix4fv(skinningShader.ModelViewProjection, 1, GL_FALSE, glm::value_ptr(_instanceViewProjection));
+		}
+
+		const auto position = static_cast<GLuint>(SkinningAttribute::Position);
+		const auto normal = static_cast<GLuint>(SkinningAttribute::Normal);
+		const auto bones = static_cast<GLuint>(SkinningAttribute::Bones);
+		const auto texCoord = static_cast<GLuint>(SkinningAttribute::TexCoord);
+
+		glBindBuffer(GL_ARRAY_BUFFER, cache.SkinningBuffer);
+
+		glEnableVertexAttribArray(position);
+		glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, sizeof(CachedSkinningVertex),
+			reinterpret_cast<const void*>(offsetof(CachedSkinningVertex, Position)));
+
+		glEnableVertexAttribArray(normal);
+		glVertexAttribPointer(normal, 3, GL_FLOAT, GL_FALSE, sizeof(CachedSkinningVertex),
+			reinterpret_cast<const void*>(offsetof(CachedSkinningVertex, Normal)));
+
+		glEnableVertexAttribArray(bones);
+		glVertexAttribPointer(bones, 2, GL_FLOAT, GL_FALSE, sizeof(CachedSkinningVertex),
+			reinterpret_cast<const void*>(offsetof(CachedSkinningVertex, Bones)));
+
+		glBindBuffer(GL_ARRAY_BUFFER, cache.TexCoordBuffer);
+
+		glEnableVertexAttribArray(texCoord);
+		glVertexAttribPointer(texCoord, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	}
+	else
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, cache.DynamicBuffer);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glVertexPointer(3, GL_FLOAT, 0, nullptr);
+
+		if (!bWireframe)
+		{
+			glEnableClientState(GL_COLOR_ARRAY);
+			glColorPointer(4, GL_FLOAT, 0, reinterpret_cast<const void*>(colorsOffset));
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+
+		if (indexedTextures)
+		{
+			glUseProgram(_paletteShader.GetProgram());
+			glUniform1i(_paletteShader.LinearFilter, _renderInfo->Model->HasLinearTextureFiltering() ? 1 : 0);
+		}
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cache.IndexBuffer);
+
+	const auto firstMesh = reinterpret_cast<const mstudiomesh_t*>(_studioHeader->GetData() + _model->meshindex);
 
 	for (int j = 0; j < _model->nummesh; j++)
 	{
 		auto pmesh = pMeshes[j].Mesh;
-		auto ptricmds = (short*)((byte*)_studioHeader + pmesh->triindex);
+		const auto& cachedMesh = cache.Meshes[pmesh - firstMesh];
 
 		const mstudiotexture_t& texture = pTextures[pSkinRef[pmesh->skinref]];
 
-		const auto s = 1.0 / (float)texture.width;
-		const auto t = 1.0 / (float)texture.height;
-
 		if (texture.flags & STUDIO_NF_ADDITIVE)
-			glDepthMask(GL_FALSE);
+			glCountedDepthMask(GL_FALSE);
 		else
-			glDepthMask(GL_TRUE);
+			glCountedDepthMask(GL_TRUE);
 
 		if (texture.flags & STUDIO_NF_ADDITIVE)
 		{
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+			glCountedEnable(GL_BLEND);
+			glCountedBlendFunc(GL_SRC_ALPHA, GL_ONE);
 		}
 		else if (_renderInfo->Transparency < 1.0f)
 		{
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			glCountedEnable(GL_BLEND);
+			glCountedBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		}
 		else
-			glDisable(GL_BLEND);
+			glCountedDisable(GL_BLEND);
 
 		if (texture.flags & STUDIO_NF_MASKED)
 		{
-			glEnable(GL_ALPHA_TEST);
+			glCountedEnable(GL_ALPHA_TEST);
 			glAlphaFunc(GL_GREATER, 0.5f);
 		}
 
 		if (!bWireframe)
 		{
-			glBindTexture(GL_TEXTURE_2D, _renderInfo->Model->GetTextureId(pSkinRef[pmesh->skinref]));
-		}
+			BindModelTexture(*_renderInfo->Model, pSkinRef[pmesh->skinref],
+				useGPUSkinning ? skinningShader.UsePalette : _paletteShader.UsePalette);
 
-		int i;
-
-		while (i = *(ptricmds++))
-		{
-			if (i < 0)
+			if (useGPUSkinning)
 			{
-				glBegin(GL_TRIANGLE_FAN);
-				i = -i;
+				glUniform1i(skinningShader.Flags, texture.flags);
+				glUniform2f(skinningShader.TextureScale, 1.0f / texture.width, 1.0f / texture.height);
 			}
 			else
 			{
-				glBegin(GL_TRIANGLE_STRIP);
-			}
-
-			uiDrawnPolys += i - 2;
+				glMatrixMode(GL_TEXTURE);
+				glLoadIdentity();
 
-			for (; i > 0; i--, ptricmds += 4)
-			{
-				if (!bWireframe)
+				if (texture.flags & STUDIO_NF_CHROME)
 				{
-					if (texture.flags & STUDIO_NF_CHROME)
-					{
-						const auto& c = _chrome[ptricmds[1]];
-
-						glTexCoord2f(c[0], c[1]);
-					}
-					else
-					{
-						glTexCoord2f(ptricmds[2] * s, ptricmds[3] * t);
-					}
+					glBindBuffer(GL_ARRAY_BUFFER, cache.DynamicBuffer);
+					glTexCoordPointer(2, GL_FLOAT, 0, reinterpret_cast<const void*>(chromeOffset));
+				}
+				else
+				{
+					//Cached texture coordinates are in texels
+					glScalef(1.0f / texture.width, 1.0f / texture.height, 1.0f);
 
-					if (texture.flags & STUDIO_NF_ADDITIVE)
-					{
-						glColor4f(1.0f, 1.0f, 1.0f, _renderInfo->Transparency);
-					}
-					else
-					{
-						const glm::vec3& lightVec = _lightvalues[ptricmds[1]];
-						glColor4f(lightVec[0], lightVec[1], lightVec[2], _renderInfo->Transparency);
-					}
+					glBindBuffer(GL_ARRAY_BUFFER, cache.TexCoordBuffer);
+					glTexCoordPointer(2, GL_FLOAT, 0, nullptr);
 				}
 
-				glVertex3fv(glm::value_ptr(_xformverts[ptricmds[0]]));
+				glMatrixMode(GL_MODELVIEW);
 			}
-			glEnd();
+		}
+
+		if (instanced)
+		{
+			glCountedDrawElementsInstanced(GL_TRIANGLES, cachedMesh.IndexCount, GL_UNSIGNED_INT,
+				reinterpret_cast<const void*>(cachedMesh.FirstIndex * sizeof(GLuint)), instanceCount);
+
+			uiDrawnPolys += cachedMesh.PolygonCount * instanceCount;
+		}
+		else
+		{
+			glCountedDrawElements(GL_TRIANGLES, cachedMesh.IndexCount, GL_UNSIGNED_INT,
+				reinterpret_cast<const void*>(cachedMesh.FirstIndex * sizeof(GLuint)));
+
+			uiDrawnPolys += cachedMesh.PolygonCount;
 		}
 
 		if (texture.flags & STUDIO_NF_MASKED)
-			glDisable(GL_ALPHA_TEST);
+			glCountedDisable(GL_ALPHA_TEST);
+	}
+
+	if (useGPUSkinning)
+	{
+		glDisableVertexAttribArray(static_cast<GLuint>(SkinningAttribute::Position));
+		glDisableVertexAttribArray(static_cast<GLuint>(SkinningAttribute::Normal));
+		glDisableVertexAttribArray(static_cast<GLuint>(SkinningAttribute::Bones));
+		glDisableVertexAttribArray(static_cast<GLuint>(SkinningAttribute::TexCoord));
+
+		glUseProgram(0);
+	}
+	else
+	{
+		if (!bWireframe)
+		{
+			glMatrixMode(GL_TEXTURE);
+			glLoadIdentity();
+			glMatrixMode(GL_MODELVIEW);
+
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			glDisableClientState(GL_COLOR_ARRAY);
+		}
+
+		glDisableClientState(GL_VERTEX_ARRAY);
+
+		if (indexedTextures)
+		{
+			glUseProgram(0);
+		}
 	}
 
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
 	return uiDrawnPolys;
 }
 
+void StudioModelRenderer::BindModelTexture(const StudioModel& model, int textureIndex, GLint usePalette)
+{
+	if (!model.IsTextureResident(textureIndex))
+	{
+		glCountedBindTexture(GL_TEXTURE_2D, _placeholderTexture);
+
+		if (model.HasIndexedTextures())
+		{
+			glUniform1i(usePalette, 0);
+		}
+
+		return;
+	}
+
+	glCountedBindTexture(GL_TEXTURE_2D, model.GetTextureId(textureIndex));
+
+	if (model.HasIndexedTextures())
+	{
+		glActiveTexture(GL_TEXTURE0 + PaletteTextureUnit);
+		glCountedBindTexture(GL_TEXTURE_2D, model.GetPaletteTextureId(textureIndex));
+		glActiveTexture(GL_TEXTURE0);
+
+		glUniform1i(usePalette, 1);
+	}
+}
+
+void StudioModelRenderer::BindTexture(const StudioModel& model, int textureIndex)
+{
+	if (model.HasIndexedTextures())
+	{
+		glUseProgram(_paletteShader.GetProgram());
+		glUniform1i(_paletteShader.LinearFilter, model.HasLinearTextureFiltering() ? 1 : 0);
+	}
+
+	BindModelTexture(model, textureIndex, _paletteShader.UsePalette);
+}
+
+void StudioModelRenderer::UnbindTexture()
+{
+	glUseProgram(0);
+
+	glActiveTexture(GL_TEXTURE0 + PaletteTextureUnit);
+	glCountedBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	glCountedBindTexture(GL_TEXTURE_2D, 0);
+}
+
 unsigned int StudioModelRenderer::DrawShadows(const bool fixZFighting, const bool wireframe)
 {
 	if (!(_studioHeader->flags & EF_NOSHADELIGHT))
 	{
+		//Shadows are projected on the CPU
+		TransformVertices();
+
 		GLint oldDepthMask;
 		glGetIntegerv(GL_DEPTH_WRITEMASK, &oldDepthMask);
 
 		if (fixZFighting)
 		{
-			glDepthMask(GL_FALSE);
+			glCountedDepthMask(GL_FALSE);
 		}
 		else
 		{
-			glDepthMask(GL_TRUE);
+			glCountedDepthMask(GL_TRUE);
 		}
 
 		const float r_blend = _renderInfo->Transparency;
 
 		const auto alpha = 0.5 * r_blend;
 
-		glDisable(GL_TEXTURE_2D);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glEnable(GL_BLEND);
+		glCountedDisable(GL_TEXTURE_2D);
+		glCountedBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glCountedEnable(GL_BLEND);
 
 		if (wireframe)
 		{
@@ -1194,18 +1625,18 @@ unsigned int StudioModelRenderer::DrawShadows(const bool fixZFighting, const boo
 			glColor4f(0.f, 0.f, 0.f, alpha);
 		}
 
-		glDepthFunc(GL_LESS);
+		glCountedDepthFunc(GL_LESS);
 
 		const auto drawnPolys = InternalDrawShadows();
 
-		glDepthFunc(GL_LEQUAL);
+		glCountedDepthFunc(GL_LEQUAL);
 
-		glEnable(GL_TEXTURE_2D);
-		glDisable(GL_BLEND);
+		glCountedEnable(GL_TEXTURE_2D);
+		glCountedDisable(GL_BLEND);
 		glColor4f(1.f, 1.f, 1.f, 1.f);
 		glShadeModel(GL_SMOOTH);
 
-		glDepthMask(static_cast<GLboolean>(oldDepthMask));
+		glCountedDepthMask(static_cast<GLboolean>(oldDepthMask));
 
 		return drawnPolys;
 	}
@@ -1235,11 +1666,11 @@ unsigned int StudioModelRenderer::InternalDrawShadows()
 			if (i < 0)
 			{
 				i = -i;
-				glBegin(GL_TRIANGLE_FAN);
+				glCountedBegin(GL_TRIANGLE_FAN);
 			}
 			else
 			{
-				glBegin(GL_TRIANGLE_STRIP);
+				glCountedBegin(GL_TRIANGLE_STRIP);
 			}
 
 			for (; i > 0; --i, triCmds += 4)
@@ -1307,31 +1738,41 @@ void StudioModelRenderer::Lighting(glm::vec3& lv, int bone, int flags, const glm
 }
 
 
-void StudioModelRenderer::Chrome(glm::vec2& chrome, int bone, const glm::vec3& normal)
+void StudioModelRenderer::SetupChrome(int bone)
 {
 	if (_chromeage[bone] != _modelsDrawnCount)
 	{
-		// calculate vectors from the viewer to the bone. This roughly adjusts for position
-		// vector pointing at bone in world reference frame
-		auto tmp = _viewerOrigin * -1.0f;
-
-		tmp[0] += _bonetransform[bone][0][3];
-		tmp[1] += _bonetransform[bone][1][3];
-		tmp[2] += _bonetransform[bone][2][3];
-
-		VectorNormalize(tmp);
-		// g_chrome t vector in world reference frame
-		auto chromeupvec = glm::cross(tmp, _viewerRight);
-		VectorNormalize(chromeupvec);
-		// g_chrome s vector in world reference frame
-		auto chromerightvec = glm::cross(tmp, chromeupvec);
-		VectorNormalize(chromerightvec);
-
-		VectorIRotate(-chromeupvec, _bonetransform[bone], _chromeup[bone]);
-		VectorIRotate(chromerightvec, _bonetransform[bone], _chromeright[bone]);
+		CalcChromeVectors(_bonetransform[bone], _chromeup[bone], _chromeright[bone]);
 
 		_chromeage[bone] = _modelsDrawnCount;
 	}
+}
+
+void StudioModelRenderer::CalcChromeVectors(const glm::mat3x4& boneTransform, glm::vec3& chromeUp, glm::vec3& chromeRight) const
+{
+	// calculate vectors from the viewer to the bone. This roughly adjusts for position
+	// vector pointing at bone in world reference frame
+	auto tmp = _viewerOrigin * -1.0f;
+
+	tmp[0] += boneTransform[0][3];
+	tmp[1] += boneTransform[1][3];
+	tmp[2] += boneTransform[2][3];
+
+	VectorNormalize(tmp);
+	// g_chrome t vector in world reference frame
+	auto chromeupvec = glm::cross(tmp, _viewerRight);
+	VectorNormalize(chromeupvec);
+	// g_chrome s vector in world reference frame
+	auto chromerightvec = glm::cross(tmp, chromeupvec);
+	VectorNormalize(chromerightvec);
+
+	VectorIRotate(-chromeupvec, boneTransform, chromeUp);
+	VectorIRotate(chromerightvec, boneTransform, chromeRight);
+}
+
+void StudioModelRenderer::Chrome(glm::vec2& chrome, int bone, const glm::vec3& normal)
+{
+	SetupChrome(bone);
 
 	// calc s coord
 	auto n = glm::dot(normal, _chromeright[bone]);
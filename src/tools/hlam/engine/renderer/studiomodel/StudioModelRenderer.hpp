@@ -1,21 +1,68 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <vector>
+
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
 #include <glm/mat3x4.hpp>
+#include <glm/mat4x4.hpp>
 
+#include "engine/renderer/studiomodel/BoneSetup.hpp"
+#include "engine/renderer/studiomodel/StudioModelMeshCache.hpp"
+#include "engine/renderer/studiomodel/StudioModelPaletteShader.hpp"
+#include "engine/renderer/studiomodel/StudioModelSkinningShader.hpp"
 #include "engine/renderer/studiomodel/StudioSorting.hpp"
 #include "engine/shared/renderer/studiomodel/IStudioModelRenderer.hpp"
 #include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
 
+class JobSystem;
+
+namespace graphics
+{
+class GPUTimer;
+}
+
 namespace studiomdl
 {
+/**
+*	@brief Everything that determines a model's bone transforms.
+*/
+struct BonePoseKey
+{
+	const StudioModel* Model;
+	int Sequence;
+	float Frame;
+	byte Blender[2];
+	byte Controller[4];
+	byte Mouth;
+
+	bool operator==(const BonePoseKey& other) const
+	{
+		return Model == other.Model
+			&& Sequence == other.Sequence
+			&& Frame == other.Frame
+			&& Blender[0] == other.Blender[0]
+			&& Blender[1] == other.Blender[1]
+			&& Controller[0] == other.Controller[0]
+			&& Controller[1] == other.Controller[1]
+			&& Controller[2] == other.Controller[2]
+			&& Controller[3] == other.Controller[3]
+			&& Mouth == other.Mouth;
+	}
+};
+
 class StudioModelRenderer final : public studiomdl::IStudioModelRenderer
 {
 public:
-	StudioModelRenderer();
+	/**
+	*	@param jobSystem If not null, used to evaluate the poses of instances in parallel.
+	*	@param gpuTimer If not null, the passes drawn by this renderer are timed with it.
+	*/
+	StudioModelRenderer(JobSystem* jobSystem, graphics::GPUTimer* gpuTimer);
 	~StudioModelRenderer();
 
 	StudioModelRenderer(const StudioModelRenderer&) = delete;
@@ -68,15 +115,51 @@ public:
 		_wireframeColor = color;
 	}
 
+	bool IsGPUSkinningEnabled() const override final
+	{
+		return _gpuSkinningEnabled && _skinningShader.IsValid();
+	}
+
+	void SetGPUSkinningEnabled(bool enabled) override final
+	{
+		_gpuSkinningEnabled = enabled;
+	}
+
+	bool SupportsIndexedTextures() const override final { return _paletteShader.IsValid(); }
+
+	void BindTexture(const StudioModel& model, int textureIndex) override final;
+
+	void UnbindTexture() override final;
+
+	unsigned int GetPoseCacheHits() const override final { return _poseCacheHits; }
+
+	unsigned int GetPoseCacheMisses() const override final { return _poseCacheMisses; }
+
 	unsigned int DrawModel(ModelRenderInfo* const renderInfo, const renderer::DrawFlags flags) override final;
 
+	unsigned int DrawModelInstances(ModelRenderInfo* const renderInfos, const std::size_t count, const renderer::DrawFlags flags) override final;
+
 	void DrawSingleBone(ModelRenderInfo& renderInfo, const int iBone) override final;
 
 	void DrawSingleAttachment(ModelRenderInfo& renderInfo, const int iAttachment) override final;
 
 	void DrawSingleHitbox(ModelRenderInfo& renderInfo, const int hitboxIndex) override final;
 
+	/**
+	*	@brief Does the CPU work of drawing a model with CPU skinning without making any OpenGL calls:
+	*	sets up the bones, then transforms and lights the vertices of every body part.
+	*	Bone transforms are reused until the next call to RunFrame like they are when drawing, vertices are always transformed again.
+	*	Used to measure CPU skinning performance.
+	*/
+	void SkinModel(ModelRenderInfo& renderInfo);
+
 private:
+	/**
+	*	@brief Binds a model texture, or the placeholder if it is not resident yet.
+	*	@param usePalette Uniform to set to whether the palette lookup should be performed
+	*/
+	void BindModelTexture(const StudioModel& model, int textureIndex, GLint usePalette);
+
 	void DrawBones();
 
 	void DrawAttachments();
@@ -87,13 +170,11 @@ private:
 
 	void DrawNormals();
 
+	/**
+	*	@brief Sets up _bonetransform for the current render info, reusing the result of an earlier call this frame if possible
+	*/
 	void SetUpBones();
-	void CalcRotations(glm::vec3* pos, glm::vec4* q, const mstudioseqdesc_t* const pseqdesc, const mstudioanim_t* panim, const float f);
-
-	void CalcBoneAdj();
-	void CalcBoneQuaternion(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim, glm::vec4& q);
-	void CalcBonePosition(const int frame, const float s, const mstudiobone_t* const pbone, const mstudioanim_t* const panim, glm::vec3& pos);
-	void SlerpBones(glm::vec4* q1, glm::vec3* pos1, glm::vec4* q2, glm::vec3* pos2, float s);
+	void CalcBones();
 
 	/**
 	*	@brief set some global variables based on entity position
@@ -101,24 +182,74 @@ private:
 	void SetupLighting();
 
 	/**
-	*	@brief based on the body part, figure out which mesh it should be using
+	*	@brief based on the body part, figure out which mesh it should be using.
+	*	Makes sure the per-vertex buffers are large enough for it.
 	*/
 	void SetupModel(int bodypart);
 
+	/**
+	*	@brief Transforms the current submodel's vertices into _xformverts. Does nothing if they are already up to date for the current pose.
+	*/
+	void TransformVertices();
+
+	/**
+	*	@brief Calculates the light values and chrome texture coordinates of the current submodel's normals.
+	*/
+	void LightVertices();
+
+	/**
+	*	@brief Uploads bone transforms and per-bone lighting and chrome vectors for use by the skinning shader
+	*/
+	void UploadBoneData();
+
+	/**
+	*	@brief Calculates the bone data of all instances into _instanceData, in the order given by _instanceOrder.
+	*	Instances are spread over multiple threads if their sequences allow it.
+	*/
+	void EvaluateInstances(ModelRenderInfo* const renderInfos, const std::size_t count);
+
+	/**
+	*	@brief Writes the bone data of a single instance, laid out like the data written by UploadBoneData.
+	*	The instance's own transform is included in the bone transforms. Safe to call from multiple threads.
+	*/
+	void WriteInstanceData(const ModelRenderInfo& renderInfo, const glm::mat3x4* boneTransforms, glm::vec4* data) const;
+
+	/**
+	*	@brief Draws the current submodel for a range of instances in the current instance data batch that all use the same skin.
+	*/
+	unsigned int DrawInstances(const bool bWireframe, int firstInstance, int instanceCount, int skin);
+
 	unsigned int DrawPoints(const bool bWireframe);
 
-	unsigned int DrawMeshes(const bool bWireframe, const SortedMesh* pMeshes, const mstudiotexture_t* pTextures, const short* pSkinRef);
+	/**
+	*	@brief Streams this frame's positions, colors and chrome texture coordinates into the submodel's dynamic buffer
+	*/
+	void UploadDynamicMeshData(const CachedSubModel& cache, const mstudiomesh_t* pMeshes, const mstudiotexture_t* pTextures, const short* pSkinRef);
+
+	/**
+	*	@param instanceCount If not 0, the meshes are drawn this many times with the instanced skinning shader,
+	*		starting at firstInstance in the instance data texture
+	*/
+	unsigned int DrawMeshes(const bool bWireframe, const CachedSubModel& cache,
+		const SortedMesh* pMeshes, const mstudiotexture_t* pTextures, const short* pSkinRef,
+		const int firstInstance = 0, const int instanceCount = 0);
 
 	unsigned int DrawShadows(const bool fixZFighting, const bool wireframe);
 
 	unsigned int InternalDrawShadows();
 
 	void Lighting(glm::vec3& lv, int bone, int flags, const glm::vec3& normal);
+	void SetupChrome(int bone);
+
+	/**
+	*	@brief Calculates the chrome vectors for a bone in the bone's reference frame.
+	*/
+	void CalcChromeVectors(const glm::mat3x4& boneTransform, glm::vec3& chromeUp, glm::vec3& chromeRight) const;
 	void Chrome(glm::vec2& chrome, int bone, const glm::vec3& normal);
 
 private:
-	//TODO: need to validate model on load to ensure it does not exceed this limit
-	static constexpr int MaxVertices = 0xFFFF;
+	JobSystem* const _jobSystem;
+	graphics::GPUTimer* const _gpuTimer;
 
 	/**
 	*	Total number of models drawn by this renderer since the last time it was initialized.
@@ -137,14 +268,13 @@ private:
 	*/
 	unsigned int _drawnPolygonsCount = 0;
 
-	glm::vec3		_xformverts[MaxVertices];		// transformed vertices
-	glm::vec3		_xformnorms[MaxVertices];
-	glm::vec3		_lightvalues[MaxVertices];	// light surface normals
+	//Per-vertex buffers, sized for the current submodel by SetupModel
+	glm::vec3*		_xformverts = nullptr;		// transformed vertices
+	glm::vec3*		_xformnorms = nullptr;
+	glm::vec3*		_lightvalues = nullptr;	// light surface normals
 
 	glm::mat3x4		_bonetransform[MAXSTUDIOBONES];	// bone transformation matrix
 
-	float			_adj[MAXSTUDIOCONTROLLERS];		//This used to be a vec4, but it really needs to be this.
-
 	int				_ambientlight;						// ambient world light
 	float			_shadelight;						// direct world light
 
@@ -152,7 +282,7 @@ private:
 	glm::vec3		_lightcolor{255, 255, 255};
 	glm::vec3		_blightvec[MAXSTUDIOBONES];		// light vectors in bone reference frames
 
-	glm::vec2		_chrome[MaxVertices];			// texture coords for surface normals
+	glm::vec2*		_chrome = nullptr;			// texture coords for surface normals
 	unsigned int	_chromeage[MAXSTUDIOBONES];		// last time chrome vectors were updated
 	glm::vec3		_chromeup[MAXSTUDIOBONES];		// chrome vector "up" in bone reference frames
 	glm::vec3		_chromeright[MAXSTUDIOBONES];	// chrome vector "right" in bone reference frames
@@ -162,5 +292,83 @@ private:
 	float			_lambert = 1.5f;					// modifier for pseudo-hemispherical lighting
 
 	glm::vec3 _wireframeColor{255, 0, 0};
+
+	BoneSetup _boneSetup;
+
+	StudioModelMeshCache _meshCache;
+
+	bool _gpuSkinningEnabled = false;
+	StudioModelSkinningShader _skinningShader;
+	GLuint _boneDataTexture = 0;
+
+	StudioModelPaletteShader _paletteShader;
+
+	//Drawn in place of textures that have not been uploaded yet
+	GLuint _placeholderTexture = 0;
+
+	//Staging memory for the dynamic mesh buffer
+	std::vector<glm::vec3> _meshPositions;
+	std::vector<glm::vec4> _meshColors;
+	std::vector<glm::vec2> _meshChrome;
+
+	struct CachedBonePose
+	{
+		BonePoseKey Key;
+		unsigned int PoseId;
+		glm::mat3x4 BoneTransforms[MAXSTUDIOBONES];
+	};
+
+	/**
+	*	Poses calculated since the last call to RunFrame. Only the first _cachedPoseCount entries are valid,
+	*	the rest are kept around to avoid reallocating every frame.
+	*/
+	std::vector<std::unique_ptr<CachedBonePose>> _cachedPoses;
+	std::size_t _cachedPoseCount = 0;
+
+	unsigned int _poseCacheHits = 0;
+	unsigned int _poseCacheMisses = 0;
+
+	/**
+	*	Identifies the pose currently stored in _bonetransform. Unique for every pose calculated since the last call to RunFrame.
+	*/
+	unsigned int _currentPoseId = 0;
+	unsigned int _nextPoseId = 0;
+
+	/**
+	*	Submodel and pose that _xformverts was last calculated for.
+	*/
+	const mstudiomodel_t* _xformvertsModel = nullptr;
+	unsigned int _xformvertsPoseId = 0;
+
+	/**
+	*	Incremented by RunFrame. Pose ids are only unique within a frame, so uploaded mesh data is only reused within the same frame.
+	*/
+	unsigned int _frameNumber = 1;
+
+	StudioModelSkinningShader _instancedSkinningShader;
+
+	//Texture buffer containing the bone data of all instances drawn by one batch
+	GLuint _instanceDataBuffer = 0;
+	GLuint _instanceDataTexture = 0;
+	GLint _maxInstanceDataTexels = 0;
+
+	glm::mat4 _instanceViewProjection{1.f};
+
+	/**
+	*	Indices of the instances being drawn, sorted by skin.
+	*/
+	std::vector<std::size_t> _instanceOrder;
+
+	std::vector<glm::vec4> _instanceData;
+
+	/**
+	*	One per range of instances evaluated in parallel.
+	*/
+	std::vector<std::unique_ptr<BoneSetup>> _instanceBoneSetups;
+
+	/**
+	*	Decoded animation data for each sequence used by the instances being drawn, indexed by sequence.
+	*/
+	std::vector<const DecodedAnimation*> _instanceAnimations;
 };
 }
@@ -0,0 +1,268 @@
+#include "core/shared/Logging.hpp"
+
+#include "engine/renderer/studiomodel/ShaderUtils.hpp"
+#include "engine/renderer/studiomodel/StudioModelPaletteShader.hpp"
+#include "engine/renderer/studiomodel/StudioModelSkinningShader.hpp"
+
+namespace studiomdl
+{
+//Bone data for a single model is stored in a 2D texture, one row per bone
+static const char* const SkinningVertexShaderHeader = R"(#version 130
+
+uniform sampler2D BoneData;
+
+vec4 GetBoneData(int bone, int row)
+{
+	return texelFetch(BoneData, ivec2(row, bone), 0);
+}
+
+vec4 TransformToClipSpace(vec4 position)
+{
+	return gl_ModelViewProjectionMatrix * position;
+}
+)";
+
+//Bone data for all instances is stored in a texture buffer, 6 texels per bone like SkinningTexelsPerBone.
+//Bone transforms include the instance's own transform, so only the view and projection are applied here.
+static const char* const InstancedSkinningVertexShaderHeader = R"(#version 140
+
+uniform samplerBuffer BoneData;
+uniform int BoneCount;
+uniform int FirstInstance;
+uniform mat4 ModelViewProjection;
+
+vec4 GetBoneData(int bone, int row)
+{
+	return texelFetch(BoneData, (((FirstInstance + gl_InstanceID) * BoneCount) + bone) * 6 + row);
+}
+
+vec4 TransformToClipSpace(vec4 position)
+{
+	return ModelViewProjection * position;
+}
+)";
+
+//Preceded by one of the headers above
+//Must stay in sync with StudioModelRenderer::Lighting and StudioModelRenderer::Chrome
+static const char* const SkinningVertexShader = R"(
+const int STUDIO_NF_FLATSHADE = 0x0001;
+const int STUDIO_NF_CHROME = 0x0002;
+const int STUDIO_NF_FULLBRIGHT = 0x0004;
+const int STUDIO_NF_ADDITIVE = 0x0020;
+
+uniform int Flags;
+uniform vec2 TextureScale;
+
+uniform float Ambient;
+uniform float Shade;
+uniform float Lambert;
+uniform vec3 LightColor;
+uniform float Transparency;
+
+uniform bool Wireframe;
+uniform vec4 WireframeColor;
+
+in vec3 Position;
+in vec3 Normal;
+in vec2 Bones;
+in vec2 TexCoord;
+
+out vec4 VertexColor;
+out vec2 VertexTexCoord;
+
+void main()
+{
+	int vertexBone = int(Bones.x);
+	int normalBone = int(Bones.y);
+
+	vec4 position = vec4(Position, 1.0);
+
+	gl_Position = TransformToClipSpace(vec4(
+		dot(GetBoneData(vertexBone, 0), position),
+		dot(GetBoneData(vertexBone, 1), position),
+		dot(GetBoneData(vertexBone, 2), position),
+		1.0));
+
+	if (Wireframe)
+	{
+		VertexColor = WireframeColor;
+		VertexTexCoord = vec2(0.0);
+		return;
+	}
+
+	vec3 lv;
+
+	if ((Flags & STUDIO_NF_FULLBRIGHT) != 0)
+	{
+		lv = vec3(1.0);
+	}
+	else
+	{
+		vec3 illum = vec3(Ambient);
+
+		if ((Flags & STUDIO_NF_FLATSHADE) != 0)
+		{
+			illum += 0.8 * Shade;
+		}
+		else
+		{
+			float lightcos = min(dot(Normal, GetBoneData(normalBone, 3).xyz), 1.0);
+
+			illum += Shade;
+
+			// do modified hemispherical lighting
+			lightcos = (lightcos + (Lambert - 1.0)) / Lambert;
+
+			if (lightcos > 0.0)
+			{
+				illum -= lightcos * Shade;
+			}
+
+			illum = max(illum, 0.0);
+		}
+
+		float maxIllum = max(illum.x, max(illum.y, illum.z));
+
+		if (maxIllum > 1.0)
+		{
+			illum *= 1.0 / maxIllum;
+		}
+
+		lv = illum * LightColor;
+	}
+
+	if ((Flags & STUDIO_NF_ADDITIVE) != 0)
+	{
+		VertexColor = vec4(1.0, 1.0, 1.0, Transparency);
+	}
+	else
+	{
+		//Fixed function clamps vertex colors
+		VertexColor = vec4(clamp(lv, 0.0, 1.0), Transparency);
+	}
+
+	if ((Flags & STUDIO_NF_CHROME) != 0)
+	{
+		VertexTexCoord = vec2(
+			(dot(Normal, GetBoneData(normalBone, 5).xyz) + 1.0) * 0.5,
+			(dot(Normal, GetBoneData(normalBone, 4).xyz) + 1.0) * 0.5);
+	}
+	else
+	{
+		VertexTexCoord = TexCoord * TextureScale;
+	}
+}
+)";
+
+//Fixed function outputs are not available in version 140
+static const char* const InstancedSkinningFragmentShaderHeader = R"(#version 140
+
+out vec4 FragColor;
+)";
+
+//Preceded by a version directive and the palette lookup source
+static const char* const SkinningFragmentShader = R"(
+uniform bool Wireframe;
+
+in vec4 VertexColor;
+in vec2 VertexTexCoord;
+
+void main()
+{
+	if (Wireframe)
+	{
+		FragColor = VertexColor;
+	}
+	else
+	{
+		FragColor = SampleTexture(VertexTexCoord) * VertexColor;
+	}
+}
+)";
+
+bool StudioModelSkinningShader::Create(bool instanced)
+{
+	Destroy();
+
+	if (!instanced && !GLEW_VERSION_3_0)
+	{
+		Warning("StudioModelSkinningShader: OpenGL 3.0 is required for GPU skinning\n");
+		return false;
+	}
+
+	if (instanced && !GLEW_VERSION_3_1)
+	{
+		Warning("StudioModelSkinningShader: OpenGL 3.1 is required for instanced GPU skinning\n");
+		return false;
+	}
+
+	const GLuint vertexShader = CompileShader(GL_VERTEX_SHADER,
+		{instanced ? InstancedSkinningVertexShaderHeader : SkinningVertexShaderHeader, SkinningVertexShader},
+		"StudioModelSkinningShader");
+	const GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER,
+		{instanced ? InstancedSkinningFragmentShaderHeader : "#version 130\n#define FragColor gl_FragColor\n",
+			PaletteLookupShaderSource, SkinningFragmentShader},
+		"StudioModelSkinningShader");
+
+	if (vertexShader == 0 || fragmentShader == 0)
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return false;
+	}
+
+	const GLuint program = glCreateProgram();
+
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+
+	glBindAttribLocation(program, static_cast<GLuint>(SkinningAttribute::Position), "Position");
+	glBindAttribLocation(program, static_cast<GLuint>(SkinningAttribute::Normal), "Normal");
+	glBindAttribLocation(program, static_cast<GLuint>(SkinningAttribute::Bones), "Bones");
+	glBindAttribLocation(program, static_cast<GLuint>(SkinningAttribute::TexCoord), "TexCoord");
+
+	//Flagged for deletion, freed along with the program
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	if (!LinkProgram(program, "StudioModelSkinningShader"))
+	{
+		return false;
+	}
+
+	_program = program;
+
+	Flags = glGetUniformLocation(_program, "Flags");
+	TextureScale = glGetUniformLocation(_program, "TextureScale");
+	Ambient = glGetUniformLocation(_program, "Ambient");
+	Shade = glGetUniformLocation(_program, "Shade");
+	Lambert = glGetUniformLocation(_program, "Lambert");
+	LightColor = glGetUniformLocation(_program, "LightColor");
+	Transparency = glGetUniformLocation(_program, "Transparency");
+	Wireframe = glGetUniformLocation(_program, "Wireframe");
+	WireframeColor = glGetUniformLocation(_program, "WireframeColor");
+	UsePalette = glGetUniformLocation(_program, "UsePalette");
+	LinearFilter = glGetUniformLocation(_program, "LinearFilter");
+	BoneCount = glGetUniformLocation(_program, "BoneCount");
+	FirstInstance = glGetUniformLocation(_program, "FirstInstance");
+	ModelViewProjection = glGetUniformLocation(_program, "ModelViewProjection");
+
+	//Samplers never change
+	glUseProgram(_program);
+	glUniform1i(glGetUniformLocation(_program, "Texture"), 0);
+	glUniform1i(glGetUniformLocation(_program, "BoneData"), 1);
+	glUniform1i(glGetUniformLocation(_program, "Palette"), PaletteTextureUnit);
+	glUseProgram(0);
+
+	return true;
+}
+
+void StudioModelSkinningShader::Destroy()
+{
+	if (_program != 0)
+	{
+		glDeleteProgram(_program);
+		_program = 0;
+	}
+}
+}
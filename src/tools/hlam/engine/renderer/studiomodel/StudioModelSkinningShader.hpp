@@ -0,0 +1,71 @@
+#pragma once
+
+#include "graphics/OpenGL.hpp"
+
+namespace studiomdl
+{
+/**
+*	@brief Vertex attribute locations used by the skinning shader.
+*/
+enum class SkinningAttribute : GLuint
+{
+	Position = 0,
+	Normal,
+	Bones,
+	TexCoord
+};
+
+/**
+*	@brief Texels stored per bone in the bone data texture.
+*	Rows 0-2 are the bone transform, followed by the light vector, chrome up and chrome right vectors in bone space.
+*/
+constexpr int SkinningTexelsPerBone = 6;
+
+/**
+*	@brief GLSL program that performs vertex skinning, lighting and chrome texture coordinate generation.
+*	Produces the same results as the fixed function path in StudioModelRenderer.
+*	The instanced variant reads the bone data of each instance from a texture buffer instead of a 2D texture.
+*/
+class StudioModelSkinningShader final
+{
+public:
+	StudioModelSkinningShader() = default;
+	~StudioModelSkinningShader() = default;
+
+	StudioModelSkinningShader(const StudioModelSkinningShader&) = delete;
+	StudioModelSkinningShader& operator=(const StudioModelSkinningShader&) = delete;
+
+	/**
+	*	@brief Compiles and links the program.
+	*	@param instanced Whether to create the variant used to draw many instances of a model with one draw call
+	*	@return Whether the program is ready for use. Errors are logged.
+	*/
+	bool Create(bool instanced = false);
+
+	void Destroy();
+
+	bool IsValid() const { return _program != 0; }
+
+	GLuint GetProgram() const { return _program; }
+
+	GLint Flags = -1;
+	GLint TextureScale = -1;
+	GLint Ambient = -1;
+	GLint Shade = -1;
+	GLint Lambert = -1;
+	GLint LightColor = -1;
+	GLint Transparency = -1;
+	GLint Wireframe = -1;
+	GLint WireframeColor = -1;
+	GLint UsePalette = -1;
+	GLint LinearFilter = -1;
+
+	//Only used by the instanced variant
+	GLint BoneCount = -1;
+	GLint FirstInstance = -1;
+	GLint ModelViewProjection = -1;
+
+private:
+	GLuint _program = 0;
+};
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 #include <glm/vec3.hpp>
 
 #include "core/shared/Const.hpp"
@@ -95,6 +97,41 @@ public:
 
 	virtual void SetWireframeColor(const glm::vec3& color) = 0;
 
+	/**
+	*	@return Whether vertex skinning, lighting and chrome are evaluated on the GPU.
+	*	This can be false even if it was enabled if the GPU does not support it.
+	*/
+	virtual bool IsGPUSkinningEnabled() const = 0;
+
+	/**
+	*	Sets whether to evaluate vertex skinning, lighting and chrome on the GPU.
+	*/
+	virtual void SetGPUSkinningEnabled(bool enabled) = 0;
+
+	/**
+	*	@return Whether models can use indexed textures that are drawn with a palette lookup on the GPU.
+	*/
+	virtual bool SupportsIndexedTextures() const = 0;
+
+	/**
+	*	Binds a model texture for drawing outside of DrawModel, setting up the palette lookup if needed.
+	*	A placeholder is bound if the texture is not resident yet.
+	*	Must be followed by a call to UnbindTexture.
+	*/
+	virtual void BindTexture(const StudioModel& model, int textureIndex) = 0;
+
+	virtual void UnbindTexture() = 0;
+
+	/**
+	*	@return The number of times bone transforms were reused since the last call to RunFrame.
+	*/
+	virtual unsigned int GetPoseCacheHits() const = 0;
+
+	/**
+	*	@return The number of times bone transforms were calculated since the last call to RunFrame.
+	*/
+	virtual unsigned int GetPoseCacheMisses() const = 0;
+
 	/**
 	*	Draws the given model.
 	*	@param renderInfo Render info that describes the model.
@@ -103,6 +140,17 @@ public:
 	*/
 	virtual unsigned int DrawModel(ModelRenderInfo* const renderInfo, const renderer::DrawFlags flags = renderer::DrawFlag::NONE) = 0;
 
+	/**
+	*	Draws many instances of the same model. All instances must use the same model and bodygroup.
+	*	Poses are evaluated in parallel and the meshes are drawn with hardware instancing if possible,
+	*	otherwise each instance is drawn with DrawModel.
+	*	@param renderInfos Array of count render infos that describe the instances.
+	*	@param flags Flags. Only NODRAW and WIREFRAME_OVERLAY can be used with hardware instancing.
+	*	@return Number of polygons that were drawn.
+	*/
+	virtual unsigned int DrawModelInstances(ModelRenderInfo* const renderInfos, const std::size_t count,
+		const renderer::DrawFlags flags = renderer::DrawFlag::NONE) = 0;
+
 	/*
 	*	Tool only operations.
 	*/
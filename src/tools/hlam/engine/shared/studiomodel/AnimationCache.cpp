@@ -0,0 +1,236 @@
+#include "engine/shared/studiomodel/AnimationCache.hpp"
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+namespace studiomdl
+{
+namespace
+{
+//These match the lookups done by the engine's CalcBoneQuaternion and CalcBonePosition exactly,
+//including reading the first value of the next span when interpolating past the end of a span
+DecodedAnimValue ReadRotationValue(const mstudioanimvalue_t* panimvalue, const int k)
+{
+	DecodedAnimValue value{};
+
+	// Bah, missing blend!
+	if (panimvalue->num.valid > k)
+	{
+		value.Value1 = panimvalue[k + 1].value;
+
+		if (panimvalue->num.valid > k + 1)
+		{
+			value.Value2 = panimvalue[k + 2].value;
+		}
+		else
+		{
+			if (panimvalue->num.total > k + 1)
+				value.Value2 = value.Value1;
+			else
+				value.Value2 = panimvalue[panimvalue->num.valid + 2].value;
+		}
+	}
+	else
+	{
+		value.Value1 = panimvalue[panimvalue->num.valid].value;
+
+		if (panimvalue->num.total > k + 1)
+		{
+			value.Value2 = value.Value1;
+		}
+		else
+		{
+			value.Value2 = panimvalue[panimvalue->num.valid + 2].value;
+		}
+	}
+
+	value.Interpolate = true;
+
+	return value;
+}
+
+DecodedAnimValue ReadPositionValue(const mstudioanimvalue_t* panimvalue, const int k)
+{
+	DecodedAnimValue value{};
+
+	// if we're inside the span
+	if (panimvalue->num.valid > k)
+	{
+		value.Value1 = panimvalue[k + 1].value;
+
+		// and there's more data in the span
+		if (panimvalue->num.valid > k + 1)
+		{
+			value.Value2 = panimvalue[k + 2].value;
+			value.Interpolate = true;
+		}
+		else
+		{
+			value.Value2 = value.Value1;
+			value.Interpolate = false;
+		}
+	}
+	else
+	{
+		value.Value1 = panimvalue[panimvalue->num.valid].value;
+
+		// are we at the end of the repeating values section and there's another section with data?
+		if (panimvalue->num.total <= k + 1)
+		{
+			value.Value2 = panimvalue[panimvalue->num.valid + 2].value;
+			value.Interpolate = true;
+		}
+		else
+		{
+			value.Value2 = value.Value1;
+			value.Interpolate = false;
+		}
+	}
+
+	return value;
+}
+
+// find span of values that includes the frame we want
+void FindSpan(const mstudioanimvalue_t*& panimvalue, int& k)
+{
+	while (panimvalue->num.total <= k)
+	{
+		k -= panimvalue->num.total;
+		panimvalue += panimvalue->num.valid + 1;
+	}
+}
+}
+
+DecodedAnimValue DecodeRotationValue(const mstudioanimvalue_t* panimvalue, int frame)
+{
+	FindSpan(panimvalue, frame);
+	return ReadRotationValue(panimvalue, frame);
+}
+
+DecodedAnimValue DecodePositionValue(const mstudioanimvalue_t* panimvalue, int frame)
+{
+	FindSpan(panimvalue, frame);
+	return ReadPositionValue(panimvalue, frame);
+}
+
+DecodedAnimation::DecodedAnimation(const StudioModel& model, const mstudioseqdesc_t& sequence)
+	: _frameCount(sequence.numframes)
+	, _blendCount(sequence.numblends)
+	, _boneCount(model.GetStudioHeader()->numbones)
+	, _sequenceGroup(sequence.seqgroup)
+	, _animIndex(sequence.animindex)
+{
+	_channelOffsets.resize(static_cast<std::size_t>(_blendCount) * _boneCount * AnimChannelCount, -1);
+
+	//GetAnim doesn't modify the sequence
+	const mstudioanim_t* panim = model.GetAnim(const_cast<mstudioseqdesc_t*>(&sequence));
+
+	for (int blend = 0; blend < _blendCount; ++blend)
+	{
+		for (int bone = 0; bone < _boneCount; ++bone, ++panim)
+		{
+			for (int channel = 0; channel < AnimChannelCount; ++channel)
+			{
+				if (panim->offset[channel] == 0)
+				{
+					continue;
+				}
+
+				_channelOffsets[(((blend * _boneCount) + bone) * AnimChannelCount) + channel] = static_cast<int>(_values.size());
+
+				auto panimvalue = reinterpret_cast<const mstudioanimvalue_t*>(reinterpret_cast<const byte*>(panim) + panim->offset[channel]);
+
+				//Walk the spans once instead of once per frame
+				int k = 0;
+
+				for (int frame = 0; frame < _frameCount; ++frame, ++k)
+				{
+					FindSpan(panimvalue, k);
+
+					_values.push_back(channel < 3 ? ReadPositionValue(panimvalue, k) : ReadRotationValue(panimvalue, k));
+				}
+			}
+		}
+	}
+}
+
+const DecodedAnimation* AnimationCache::Get(const StudioModel& model, int sequenceIndex)
+{
+	const auto header = model.GetStudioHeader();
+
+	if (sequenceIndex < 0 || sequenceIndex >= header->numseq)
+	{
+		return nullptr;
+	}
+
+	const auto sequence = header->GetSequence(sequenceIndex);
+
+	if (auto it = _entries.find(sequenceIndex); it != _entries.end())
+	{
+		if (it->second.Animation->IsUpToDate(*sequence, header->numbones))
+		{
+			_lru.splice(_lru.begin(), _lru, it->second.LRUPosition);
+			return it->second.Animation.get();
+		}
+
+		Remove(it);
+	}
+
+	//Check before decoding so sequences that will never fit aren't decoded every frame
+	const std::size_t expectedSize =
+		static_cast<std::size_t>(sequence->numblends) * header->numbones * AnimChannelCount * sequence->numframes * sizeof(DecodedAnimValue);
+
+	if (expectedSize > _memoryBudget)
+	{
+		return nullptr;
+	}
+
+	//Loads the sequence group if needed
+	if (!model.GetAnim(sequence))
+	{
+		return nullptr;
+	}
+
+	auto animation = std::make_unique<DecodedAnimation>(model, *sequence);
+
+	const auto result = animation.get();
+
+	_memoryUsage += animation->GetMemoryUsage();
+
+	_lru.push_front(sequenceIndex);
+	_entries.emplace(sequenceIndex, Entry{std::move(animation), _lru.begin()});
+
+	EvictToBudget(sequenceIndex);
+
+	return result;
+}
+
+const DecodedAnimation* AnimationCache::Find(int sequenceIndex) const
+{
+	if (auto it = _entries.find(sequenceIndex); it != _entries.end())
+	{
+		return it->second.Animation.get();
+	}
+
+	return nullptr;
+}
+
+void AnimationCache::SetMemoryBudget(std::size_t budget)
+{
+	_memoryBudget = budget;
+	EvictToBudget(-1);
+}
+
+void AnimationCache::Remove(std::unordered_map<int, Entry>::iterator it)
+{
+	_memoryUsage -= it->second.Animation->GetMemoryUsage();
+	_lru.erase(it->second.LRUPosition);
+	_entries.erase(it);
+}
+
+void AnimationCache::EvictToBudget(int sequenceToKeep)
+{
+	while (_memoryUsage > _memoryBudget && !_lru.empty() && _lru.back() != sequenceToKeep)
+	{
+		Remove(_entries.find(_lru.back()));
+	}
+}
+}
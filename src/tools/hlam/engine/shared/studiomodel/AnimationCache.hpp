@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
+
+namespace studiomdl
+{
+class StudioModel;
+
+/**
+*	@brief Raw animation values needed to sample a single channel at a single frame.
+*/
+struct DecodedAnimValue
+{
+	/**
+	*	@brief Value at the frame.
+	*/
+	short Value1;
+
+	/**
+	*	@brief Value to interpolate towards.
+	*/
+	short Value2;
+
+	/**
+	*	@brief Whether to interpolate between the two values. Only used by position channels.
+	*/
+	bool Interpolate;
+};
+
+/**
+*	@brief Number of channels per bone: X, Y, Z, XR, YR, ZR.
+*/
+constexpr int AnimChannelCount = 6;
+
+/**
+*	@brief Reads the values for a rotation channel at the given frame from run-length encoded animation data.
+*	This walks the data from the start so it is linear in the frame number.
+*/
+DecodedAnimValue DecodeRotationValue(const mstudioanimvalue_t* panimvalue, int frame);
+
+/**
+*	@brief Reads the values for a position channel at the given frame from run-length encoded animation data.
+*	This walks the data from the start so it is linear in the frame number.
+*/
+DecodedAnimValue DecodePositionValue(const mstudioanimvalue_t* panimvalue, int frame);
+
+/**
+*	@brief All of a sequence's animation data decoded to allow constant time lookup by frame.
+*/
+class DecodedAnimation final
+{
+public:
+	DecodedAnimation(const StudioModel& model, const mstudioseqdesc_t& sequence);
+	~DecodedAnimation() = default;
+
+	DecodedAnimation(const DecodedAnimation&) = delete;
+	DecodedAnimation& operator=(const DecodedAnimation&) = delete;
+
+	int GetFrameCount() const { return _frameCount; }
+
+	/**
+	*	@brief Gets the values for a channel, indexed by frame, or nullptr if the channel is not animated.
+	*/
+	const DecodedAnimValue* GetChannel(int blend, int bone, int channel) const
+	{
+		const auto offset = _channelOffsets[(((blend * _boneCount) + bone) * AnimChannelCount) + channel];
+
+		return offset != -1 ? &_values[offset] : nullptr;
+	}
+
+	std::size_t GetMemoryUsage() const
+	{
+		return (_channelOffsets.size() * sizeof(int)) + (_values.size() * sizeof(DecodedAnimValue));
+	}
+
+	/**
+	*	@brief Whether this data was decoded from the sequence in its current state.
+	*/
+	bool IsUpToDate(const mstudioseqdesc_t& sequence, int boneCount) const
+	{
+		return _frameCount == sequence.numframes
+			&& _blendCount == sequence.numblends
+			&& _boneCount == boneCount
+			&& _sequenceGroup == sequence.seqgroup
+			&& _animIndex == sequence.animindex;
+	}
+
+private:
+	const int _frameCount;
+	const int _blendCount;
+	const int _boneCount;
+	const int _sequenceGroup;
+	const int _animIndex;
+
+	std::vector<int> _channelOffsets;
+	std::vector<DecodedAnimValue> _values;
+};
+
+/**
+*	@brief Lazily decodes sequence animation data and keeps it around within a memory budget.
+*	The least recently used sequences are evicted first.
+*	Animation values are never edited after load. Changes to a sequence's frame count, blends or animation offset
+*	are detected by DecodedAnimation::IsUpToDate, so entries never have to be discarded explicitly.
+*/
+class AnimationCache final
+{
+public:
+	static constexpr std::size_t DefaultMemoryBudget = 64 * 1024 * 1024;
+
+	AnimationCache() = default;
+	~AnimationCache() = default;
+
+	AnimationCache(const AnimationCache&) = delete;
+	AnimationCache& operator=(const AnimationCache&) = delete;
+
+	/**
+	*	@brief Gets the decoded animation data for a sequence, decoding it if needed.
+	*	@return The decoded data, or nullptr if the sequence does not fit in the memory budget or its sequence group could not be loaded.
+	*		The pointer remains valid until the next call to a non-const member.
+	*/
+	const DecodedAnimation* Get(const StudioModel& model, int sequenceIndex);
+
+	/**
+	*	@brief Gets the decoded animation data for a sequence if it is in the cache, without decoding or affecting eviction order.
+	*	Does not check whether the data is up to date, call Get first.
+	*/
+	const DecodedAnimation* Find(int sequenceIndex) const;
+
+	std::size_t GetMemoryBudget() const { return _memoryBudget; }
+
+	void SetMemoryBudget(std::size_t budget);
+
+	std::size_t GetMemoryUsage() const { return _memoryUsage; }
+
+private:
+	struct Entry
+	{
+		std::unique_ptr<DecodedAnimation> Animation;
+		std::list<int>::iterator LRUPosition;
+	};
+
+	void Remove(std::unordered_map<int, Entry>::iterator it);
+
+	void EvictToBudget(int sequenceToKeep);
+
+private:
+	std::size_t _memoryBudget = DefaultMemoryBudget;
+	std::size_t _memoryUsage = 0;
+
+	std::unordered_map<int, Entry> _entries;
+
+	/**
+	*	@brief Sequence indices, most recently used first.
+	*/
+	std::list<int> _lru;
+};
+}
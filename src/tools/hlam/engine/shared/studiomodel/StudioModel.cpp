@@ -1,14 +1,20 @@
 #include <algorithm>
 #include <cassert>
 #include <cctype>
+#include <cstdlib>
 #include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <functional>
 #include <iomanip>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
 
+#include "core/shared/JobSystem.hpp"
 #include "core/shared/Platform.hpp"
+#include "core/shared/Profiler.hpp"
 #include "core/shared/Logging.hpp"
 
 #include "utility/IOUtils.hpp"
@@ -22,6 +28,8 @@
 
 namespace studiomdl
 {
+static const std::string SequenceGroupResourceType{"Studio model sequence group"};
+
 namespace
 {
 //Dol differs only in texture storage
@@ -91,23 +99,253 @@ void ConvertDolToMdl(byte* pBuffer, const mstudiotexture_t& texture)
 	//Some data will be left dangling after the palette and before the next texture/end of file. Nothing will reference it though
 	//in the SL version this will not be a problem since the file isn't loaded in one chunk
 }
+
+/**
+*	@brief Checks that count elements starting at offset lie within the file.
+*/
+bool IsInFile(const studiohdr_t& header, int offset, int count, std::size_t elementSize)
+{
+	if (offset < 0 || count < 0 || offset > header.length)
+	{
+		return false;
+	}
+
+	return static_cast<std::size_t>(count) <= (static_cast<std::size_t>(header.length - offset) / elementSize);
+}
+
+/**
+*	@brief Checks that all vertex, normal and bone indices used by the meshes are valid,
+*	so the renderer can use them without checking and size its buffers from the vertex and normal counts.
+*	@exception assets::AssetInvalidFormat If the mesh data is invalid
+*/
+void ValidateMeshes(const studiohdr_t& header, const std::string& fileName)
+{
+	const auto fail = [&](const std::string& message)
+	{
+		throw assets::AssetInvalidFormat(std::string{"File \""} + fileName + "\": " + message);
+	};
+
+	if (header.numbones < 0 || header.numbones > MAXSTUDIOBONES)
+	{
+		fail("Model has " + std::to_string(header.numbones) + " bones, the maximum is " + std::to_string(MAXSTUDIOBONES));
+	}
+
+	if (!IsInFile(header, header.bodypartindex, header.numbodyparts, sizeof(mstudiobodyparts_t)))
+	{
+		fail("Body part data is invalid");
+	}
+
+	const auto end = reinterpret_cast<const short*>(header.GetData() + header.length);
+
+	for (int i = 0; i < header.numbodyparts; ++i)
+	{
+		const auto& bodyPart = *header.GetBodypart(i);
+
+		if (!IsInFile(header, bodyPart.modelindex, bodyPart.nummodels, sizeof(mstudiomodel_t)))
+		{
+			fail("Body part " + std::to_string(i) + " has invalid submodel data");
+		}
+
+		const auto models = reinterpret_cast<const mstudiomodel_t*>(header.GetData() + bodyPart.modelindex);
+
+		for (int j = 0; j < bodyPart.nummodels; ++j)
+		{
+			const auto& model = models[j];
+
+			const std::string modelName{"Body part " + std::to_string(i) + " submodel " + std::to_string(j)};
+
+			if (!IsInFile(header, model.vertinfoindex, model.numverts, sizeof(byte))
+				|| !IsInFile(header, model.vertindex, model.numverts, sizeof(glm::vec3))
+				|| !IsInFile(header, model.norminfoindex, model.numnorms, sizeof(byte))
+				|| !IsInFile(header, model.normindex, model.numnorms, sizeof(glm::vec3))
+				|| !IsInFile(header, model.meshindex, model.nummesh, sizeof(mstudiomesh_t)))
+			{
+				fail(modelName + " has invalid vertex data");
+			}
+
+			if (model.nummesh > MAXSTUDIOMESHES)
+			{
+				fail(modelName + " has " + std::to_string(model.nummesh) + " meshes, the maximum is " + std::to_string(MAXSTUDIOMESHES));
+			}
+
+			const auto vertexBones = header.GetData() + model.vertinfoindex;
+			const auto normalBones = header.GetData() + model.norminfoindex;
+
+			if (std::any_of(vertexBones, vertexBones + model.numverts, [&](byte bone) { return bone >= header.numbones; })
+				|| std::any_of(normalBones, normalBones + model.numnorms, [&](byte bone) { return bone >= header.numbones; }))
+			{
+				fail(modelName + " references a bone that does not exist");
+			}
+
+			const auto meshes = reinterpret_cast<const mstudiomesh_t*>(header.GetData() + model.meshindex);
+
+			int normalCount = 0;
+
+			for (int k = 0; k < model.nummesh; ++k)
+			{
+				const auto& mesh = meshes[k];
+
+				//The renderer lights each mesh's normals in order, so together they must fit in the submodel's normals
+				normalCount += std::max(0, mesh.numnorms);
+
+				if (mesh.numnorms < 0 || normalCount > model.numnorms)
+				{
+					fail(modelName + " mesh " + std::to_string(k) + " has invalid normal data");
+				}
+
+				if (!IsInFile(header, mesh.triindex, 1, sizeof(short)))
+				{
+					fail(modelName + " mesh " + std::to_string(k) + " has invalid triangle data");
+				}
+
+				for (auto commands = reinterpret_cast<const short*>(header.GetData() + mesh.triindex); ;)
+				{
+					if (commands >= end)
+					{
+						fail(modelName + " mesh " + std::to_string(k) + " has invalid triangle data");
+					}
+
+					const int count = std::abs(*commands++);
+
+					if (count == 0)
+					{
+						break;
+					}
+
+					if ((end - commands) / 4 < count)
+					{
+						fail(modelName + " mesh " + std::to_string(k) + " has invalid triangle data");
+					}
+
+					for (int vertex = 0; vertex < count; ++vertex, commands += 4)
+					{
+						if (commands[0] < 0 || commands[0] >= model.numverts || commands[1] < 0 || commands[1] >= model.numnorms)
+						{
+							fail(modelName + " mesh " + std::to_string(k) + " references a vertex that does not exist");
+						}
+					}
+				}
+			}
+		}
+	}
+}
 }
 
 StudioModel::StudioModel(std::string&& fileName, studio_ptr<studiohdr_t>&& studioHeader, studio_ptr<studiohdr_t>&& textureHeader,
-	std::vector<studio_ptr<studioseqhdr_t>>&& sequenceHeaders, bool isDol)
+	std::vector<std::filesystem::path>&& sequenceGroupFileNames, bool isDol, bool useMemoryMapping,
+	std::optional<assets::FileIdentity>&& textureFileIdentity)
 	: _fileName(std::move(fileName))
 	, _studioHeader(std::move(studioHeader))
 	, _textureHeader(std::move(textureHeader))
-	, _sequenceHeaders(std::move(sequenceHeaders))
+	, _textureFileIdentity(std::move(textureFileIdentity))
 	, _isDol(isDol)
+	, _useMemoryMapping(useMemoryMapping)
 {
 	assert(_studioHeader);
+
+	_sequenceGroups.resize(sequenceGroupFileNames.size());
+
+	for (std::size_t i = 0; i < sequenceGroupFileNames.size(); ++i)
+	{
+		_sequenceGroups[i].FileName = std::move(sequenceGroupFileNames[i]);
+	}
+}
+
+StudioModel::~StudioModel() = default;
+
+/**
+*	@brief Copies data that is mapped from a file into memory allocated with new[].
+*/
+template<typename T>
+static studio_ptr<T> CopyMappedData(const MappedFile& mapping)
+{
+	auto copy = std::make_unique<byte[]>(mapping.GetSize());
+
+	std::memcpy(copy.get(), mapping.GetData(), mapping.GetSize());
+
+	return studio_ptr<T>{reinterpret_cast<T*>(copy.release())};
 }
 
-StudioModel::~StudioModel()
+/**
+*	@return Whether the header was mapped from a file.
+*/
+template<typename T>
+static bool DetachHeader(studio_ptr<T>& header)
 {
-	glDeleteTextures(_textures.size(), _textures.data());
-	_textures.clear();
+	if (!header || !header.get_deleter().Mapping)
+	{
+		return false;
+	}
+
+	//The model points to the copy before the mapping is released
+	header = CopyMappedData<T>(*header.get_deleter().Mapping);
+
+	return true;
+}
+
+template<typename T>
+static bool DetachHeader(std::shared_ptr<T>& header)
+{
+	const auto deleter = std::get_deleter<StudioDataDeleter>(header);
+
+	if (!deleter || !deleter->Mapping)
+	{
+		return false;
+	}
+
+	//Other models that share the data keep using the mapping until they are detached or unloaded themselves
+	header = CopyMappedData<T>(*deleter->Mapping);
+
+	return true;
+}
+
+void StudioModel::DetachFromFiles()
+{
+	bool detached = false;
+
+	detached = DetachHeader(_studioHeader) || detached;
+	detached = DetachHeader(_textureHeader) || detached;
+
+	std::unique_lock lock{_sequenceGroupsMutex};
+
+	//Finish background loads first, they could be reading a file that is about to be overwritten
+	std::vector<JobHandle> prefetchJobs;
+
+	for (const auto& group : _sequenceGroups)
+	{
+		if (group.Prefetch)
+		{
+			prefetchJobs.push_back(group.Prefetch->Job);
+		}
+	}
+
+	if (!prefetchJobs.empty())
+	{
+		lock.unlock();
+
+		for (const auto& job : prefetchJobs)
+		{
+			_jobSystem->Wait(job);
+		}
+
+		lock.lock();
+	}
+
+	for (auto& group : _sequenceGroups)
+	{
+		if (group.Prefetch && JobSystem::IsFinished(group.Prefetch->Job))
+		{
+			FinishPrefetch(group);
+		}
+
+		detached = DetachHeader(group.Header) || detached;
+	}
+
+	//Caches keyed by the address of the mesh data have to be rebuilt
+	if (detached)
+	{
+		InvalidateMeshes();
+	}
 }
 
 mstudioanim_t* StudioModel::GetAnim(mstudioseqdesc_t* pseqdesc) const
@@ -119,7 +357,19 @@ mstudioanim_t* StudioModel::GetAnim(mstudioseqdesc_t* pseqdesc) const
 		return (mstudioanim_t*)((byte*)_studioHeader.get() + pseqgroup->unused2 + pseqdesc->animindex);
 	}
 
-	return (mstudioanim_t*)((byte*)_sequenceHeaders[pseqdesc->seqgroup - 1].get() + pseqdesc->animindex);
+	if (pseqdesc->seqgroup < 0 || static_cast<std::size_t>(pseqdesc->seqgroup) > _sequenceGroups.size())
+	{
+		return nullptr;
+	}
+
+	const auto header = LoadSequenceGroup(pseqdesc->seqgroup - 1);
+
+	if (!header)
+	{
+		return nullptr;
+	}
+
+	return (mstudioanim_t*)((byte*)header + pseqdesc->animindex);
 }
 
 mstudiomodel_t* StudioModel::GetModelByBodyPart(const int iBody, const int iBodyPart) const
@@ -161,120 +411,52 @@ bool StudioModel::CalculateBodygroup(const int iGroup, const int iValue, int& iI
 	return true;
 }
 
-GLuint StudioModel::GetTextureId(const int iIndex) const
+void StudioModel::PrepareTextures(const graphics::TextureLoader& textureLoader, JobSystem* jobSystem)
 {
-	if (iIndex < 0 || iIndex >= _textures.size())
-	{
-		return GL_INVALID_TEXTURE_ID;
-	}
+	PROFILE_ZONE("StudioModel::PrepareTextures");
 
-	return _textures[iIndex];
-}
+	_preparedTextures.clear();
+	_preparedTexturesPowerOf2 = textureLoader.ShouldResizeToPowerOf2();
 
-void StudioModel::CreateTextures(graphics::TextureLoader& textureLoader)
-{
 	const auto textureHeader = GetTextureHeader();
 
 	if (textureHeader->textureindex > 0)
 	{
-		byte* pIn = reinterpret_cast<byte*>(textureHeader);
-
-		for (int i = 0; i < textureHeader->numtextures; ++i)
-		{
-			GLuint name;
-
-			glBindTexture(GL_TEXTURE_2D, 0);
-			glGenTextures(1, &name);
+		const byte* pIn = reinterpret_cast<const byte*>(textureHeader);
 
-			const auto& texture = *textureHeader->GetTexture(i);
+		_preparedTextures.resize(textureHeader->numtextures);
 
-			if (_isDol)
+		const auto convert = [&](std::size_t begin, std::size_t end)
+		{
+			for (std::size_t i = begin; i < end; ++i)
 			{
-				ConvertDolToMdl(pIn, texture);
-			}
+				const auto& texture = *textureHeader->GetTexture(i);
 
-			textureLoader.UploadIndexed8(
-				name,
-				texture.width, texture.height,
-				pIn + texture.index,
-				pIn + texture.index + (texture.width * texture.height),
-				(texture.flags & STUDIO_NF_NOMIPS) != 0,
-				(texture.flags & STUDIO_NF_MASKED) != 0);
+				_preparedTextures[i] = textureLoader.ConvertIndexed8(
+					texture.width, texture.height,
+					pIn + texture.index,
+					pIn + texture.index + (texture.width * texture.height),
+					(texture.flags & STUDIO_NF_MASKED) != 0);
+			}
+		};
 
-			_textures.emplace_back(name);
+		if (jobSystem)
+		{
+			//Textures vary a lot in size so each one is converted separately to balance the load
+			jobSystem->ParallelFor(0, _preparedTextures.size(), 1, convert);
+		}
+		else
+		{
+			convert(0, _preparedTextures.size());
 		}
-	}
-}
-
-void StudioModel::ReplaceTexture(graphics::TextureLoader& textureLoader, mstudiotexture_t* ptexture, const byte* data, const byte* pal, GLuint textureId)
-{
-	textureLoader.UploadIndexed8(
-		textureId,
-		ptexture->width, ptexture->height,
-		data,
-		pal,
-		(ptexture->flags & STUDIO_NF_NOMIPS) != 0,
-		(ptexture->flags & STUDIO_NF_MASKED) != 0);
-}
-
-void StudioModel::ReuploadTexture(graphics::TextureLoader& textureLoader, mstudiotexture_t* ptexture)
-{
-	assert(ptexture);
-
-	auto header = GetTextureHeader();
-
-	const int index = ptexture - header->GetTextures();
-
-	if (index < 0 || index >= header->numtextures)
-	{
-		Error("StudioModel::ReuploadTexture: Invalid texture!");
-		return;
-	}
-
-	ReplaceTexture(textureLoader, ptexture,
-		header->GetData() + ptexture->index, header->GetData() + ptexture->index + ptexture->width * ptexture->height, _textures[index]);
-}
-
-void StudioModel::UpdateFilters(graphics::TextureLoader& textureLoader)
-{
-	if (_textures.empty())
-	{
-		//No textures loaded yet, do nothing
-		return;
-	}
-
-	const auto textureHeader{GetTextureHeader()};
-
-	for (int i = 0; i < textureHeader->numtextures; ++i)
-	{
-		glBindTexture(GL_TEXTURE_2D, _textures[i]);
-		textureLoader.SetFilters(_textures[i], (textureHeader->GetTexture(i)->flags & STUDIO_NF_NOMIPS) != 0);
-	}
-}
-
-void StudioModel::ReuploadTextures(graphics::TextureLoader& textureLoader)
-{
-	if (_textures.empty())
-	{
-		//No textures loaded yet, do nothing
-		return;
-	}
-
-	auto header = GetTextureHeader();
-
-	for (int i = 0; i < header->numtextures; ++i)
-	{
-		const auto ptexture = header->GetTexture(i);
-
-		ReplaceTexture(textureLoader, ptexture,
-			header->GetData() + ptexture->index, header->GetData() + ptexture->index + ptexture->width * ptexture->height, _textures[i]);
 	}
 }
 
 namespace
 {
 template<typename T>
-studio_ptr<T> LoadStudioHeader(const std::filesystem::path& fileName, const bool bAllowSeqGroup, const bool externalTextures)
+studio_ptr<T> LoadStudioHeader(const std::filesystem::path& fileName, const bool bAllowSeqGroup, const bool externalTextures,
+	const bool useMemoryMapping)
 {
 	const std::string utf8FileName{fileName.u8string()};
 
@@ -311,18 +493,38 @@ studio_ptr<T> LoadStudioHeader(const std::filesystem::path& fileName, const bool
 	const size_t size = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	auto buffer = std::make_unique<byte[]>(size);
+	std::unique_ptr<byte[]> buffer;
+	StudioDataDeleter deleter;
 
-	auto header = reinterpret_cast<T*>(buffer.get());
+	T* header = nullptr;
 
-	const size_t readCount = fread(header, size, 1, file);
-	fclose(file);
+	if (useMemoryMapping)
+	{
+		deleter.Mapping = MappedFile::Map(file, size);
 
-	if (readCount != 1)
+		if (deleter.Mapping)
+		{
+			header = reinterpret_cast<T*>(deleter.Mapping->GetData());
+		}
+	}
+
+	if (!header)
 	{
-		throw assets::AssetInvalidFormat(std::string{"Error reading file \""} + utf8FileName + "\"");
+		buffer = std::make_unique<byte[]>(size);
+
+		header = reinterpret_cast<T*>(buffer.get());
+
+		const size_t readCount = fread(header, size, 1, file);
+
+		if (readCount != 1)
+		{
+			fclose(file);
+			throw assets::AssetInvalidFormat(std::string{"Error reading file \""} + utf8FileName + "\"");
+		}
 	}
 
+	fclose(file);
+
 	if (strncmp(reinterpret_cast<const char*>(&header->id), STUDIOMDL_HDR_ID, 4) &&
 		strncmp(reinterpret_cast<const char*>(&header->id), STUDIOMDL_SEQ_ID, 4))
 	{
@@ -349,7 +551,7 @@ studio_ptr<T> LoadStudioHeader(const std::filesystem::path& fileName, const bool
 
 	buffer.release();
 
-	return studio_ptr<T>(header);
+	return studio_ptr<T>(header, std::move(deleter));
 }
 }
 
@@ -383,8 +585,237 @@ bool IsStudioModel(const std::string& fileName)
 	return isStudioModel;
 }
 
-std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName)
+/**
+*	@brief Loads a sequence group file, or gets it from another model that loaded the same file.
+*/
+static std::shared_ptr<studioseqhdr_t> LoadSharedSequenceGroup(const std::filesystem::path& fileName, bool useMemoryMapping)
 {
+	const auto identity = assets::FileIdentity::Get(fileName);
+
+	if (!identity)
+	{
+		return LoadStudioHeader<studioseqhdr_t>(fileName, true, false, useMemoryMapping);
+	}
+
+	auto& cache = assets::ResourceCache::GetInstance();
+
+	if (auto header = cache.Find<studioseqhdr_t>(SequenceGroupResourceType, *identity); header)
+	{
+		return header;
+	}
+
+	std::shared_ptr<studioseqhdr_t> header = LoadStudioHeader<studioseqhdr_t>(fileName, true, false, useMemoryMapping);
+
+	return cache.Add(SequenceGroupResourceType, *identity, {}, header, header->length);
+}
+
+studioseqhdr_t* StudioModel::GetSeqGroupHeader(const size_t i) const
+{
+	std::lock_guard lock{_sequenceGroupsMutex};
+	return _sequenceGroups[i].Header.get();
+}
+
+studioseqhdr_t* StudioModel::LoadSequenceGroup(std::size_t index) const
+{
+	std::unique_lock lock{_sequenceGroupsMutex};
+
+	auto& group = _sequenceGroups[index];
+
+	group.LastUsed = ++_sequenceGroupUseCount;
+
+	//Don't hold the lock while waiting for a background load so other groups can still be used
+	if (group.Prefetch && !JobSystem::IsFinished(group.Prefetch->Job))
+	{
+		const auto job = group.Prefetch->Job;
+
+		lock.unlock();
+		_jobSystem->Wait(job);
+		lock.lock();
+	}
+
+	//Another thread may have taken the prefetched result while the lock was released
+	if (group.Header)
+	{
+		return group.Header.get();
+	}
+
+	if (!group.Error.empty())
+	{
+		return nullptr;
+	}
+
+	if (group.Prefetch)
+	{
+		FinishPrefetch(group);
+
+		if (!group.Header)
+		{
+			return nullptr;
+		}
+	}
+	else
+	{
+		//Read the file without holding the lock so other groups can still be used
+		const auto fileName = group.FileName;
+
+		lock.unlock();
+
+		std::shared_ptr<studioseqhdr_t> header;
+		std::string error;
+
+		try
+		{
+			header = LoadSharedSequenceGroup(fileName, _useMemoryMapping);
+		}
+		catch (const assets::AssetException& e)
+		{
+			error = e.what();
+		}
+
+		lock.lock();
+
+		//Another thread may have loaded the group in the meantime
+		if (group.Header)
+		{
+			return group.Header.get();
+		}
+
+		if (!group.Error.empty())
+		{
+			return nullptr;
+		}
+
+		if (!error.empty())
+		{
+			group.Error = std::move(error);
+			Error("StudioModel::GetAnim: Could not load sequence group %d: %s\n", static_cast<int>(index + 1), group.Error.c_str());
+			return nullptr;
+		}
+
+		group.Header = std::move(header);
+
+		//A neighbouring group may have started prefetching this one while the lock was released
+		group.Prefetch.reset();
+	}
+
+	EvictSequenceGroups(index);
+
+	//Sequences in the same group tend to be stored next to each other, so neighbouring groups are likely to be used next
+	if (index > 0)
+	{
+		PrefetchSequenceGroup(index - 1);
+	}
+
+	PrefetchSequenceGroup(index + 1);
+
+	return group.Header.get();
+}
+
+void StudioModel::PrefetchSequenceGroup(std::size_t index) const
+{
+	if (!_jobSystem || index >= _sequenceGroups.size() || _maxResidentSequenceGroups <= 1)
+	{
+		return;
+	}
+
+	auto& group = _sequenceGroups[index];
+
+	if (group.Header || group.Prefetch || !group.Error.empty())
+	{
+		return;
+	}
+
+	auto prefetch = std::make_shared<SequenceGroupPrefetch>();
+
+	group.LastUsed = _sequenceGroupUseCount;
+	group.Prefetch = prefetch;
+
+	//The state owns the job, so the job only keeps a weak reference to it.
+	//Loads that the model has discarded before they started are skipped.
+	prefetch->Job = _jobSystem->Schedule([weakPrefetch = std::weak_ptr{prefetch}, fileName = group.FileName, useMemoryMapping = _useMemoryMapping]
+		{
+			const auto prefetch = weakPrefetch.lock();
+
+			if (!prefetch)
+			{
+				return;
+			}
+
+			try
+			{
+				prefetch->Header = LoadSharedSequenceGroup(fileName, useMemoryMapping);
+			}
+			catch (const assets::AssetException& e)
+			{
+				prefetch->Error = e.what();
+			}
+		});
+}
+
+void StudioModel::FinishPrefetch(SequenceGroup& group) const
+{
+	assert(JobSystem::IsFinished(group.Prefetch->Job));
+
+	const auto prefetch = std::move(group.Prefetch);
+
+	group.Header = std::move(prefetch->Header);
+
+	if (!prefetch->Error.empty())
+	{
+		group.Error = std::move(prefetch->Error);
+		Error("StudioModel::GetAnim: Could not load sequence group \"%s\": %s\n", group.FileName.u8string().c_str(), group.Error.c_str());
+	}
+}
+
+void StudioModel::EvictSequenceGroups(std::size_t indexToKeep) const
+{
+	while (true)
+	{
+		int residentCount = 0;
+		SequenceGroup* leastRecentlyUsed = nullptr;
+
+		for (std::size_t i = 0; i < _sequenceGroups.size(); ++i)
+		{
+			auto& group = _sequenceGroups[i];
+
+			if (!group.Header && !group.Prefetch)
+			{
+				continue;
+			}
+
+			++residentCount;
+
+			//Loads that are still in progress are left alone, evicting them would mean waiting for them to finish
+			if (group.Prefetch && !JobSystem::IsFinished(group.Prefetch->Job))
+			{
+				continue;
+			}
+
+			if (i != indexToKeep && (!leastRecentlyUsed || group.LastUsed < leastRecentlyUsed->LastUsed))
+			{
+				leastRecentlyUsed = &group;
+			}
+		}
+
+		if (residentCount <= _maxResidentSequenceGroups || !leastRecentlyUsed)
+		{
+			break;
+		}
+
+		leastRecentlyUsed->Prefetch.reset();
+		leastRecentlyUsed->Header.reset();
+	}
+}
+
+std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName, bool useMemoryMapping, const std::atomic<bool>* cancelled)
+{
+	PROFILE_ZONE("LoadStudioModel");
+
+	const auto isCancelled = [cancelled]
+	{
+		return cancelled && *cancelled;
+	};
+
 	const std::filesystem::path completeFileName{std::filesystem::u8path(fileName)};
 
 	std::filesystem::path baseFileName{completeFileName};
@@ -394,7 +825,7 @@ std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName)
 	const auto isDol = completeFileName.extension() == ".dol";
 
 	//Load the model
-	auto mainHeader = LoadStudioHeader<studiohdr_t>(completeFileName, false, false);
+	auto mainHeader = LoadStudioHeader<studiohdr_t>(completeFileName, false, false, useMemoryMapping);
 
 	if (mainHeader->name[0] == '\0')
 	{
@@ -409,8 +840,18 @@ std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName)
 		throw StudioModelIsNotMainHeader(message);
 	}
 
+	ValidateMeshes(*mainHeader, fileName);
+
+	if (isCancelled())
+	{
+		return {};
+	}
+
 	studio_ptr<studiohdr_t> textureHeader;
 
+	//Identifies the texture data so other models loaded from the same file can share the textures
+	std::optional<assets::FileIdentity> textureFileIdentity;
+
 	// preload textures
 	if (mainHeader->numtextures == 0)
 	{
@@ -420,15 +861,25 @@ std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName)
 
 		texturename += extension;
 
-		textureHeader = LoadStudioHeader<studiohdr_t>(texturename, true, true);
+		textureFileIdentity = assets::FileIdentity::Get(texturename);
+		textureHeader = LoadStudioHeader<studiohdr_t>(texturename, true, true, useMemoryMapping);
+	}
+	else
+	{
+		textureFileIdentity = assets::FileIdentity::Get(completeFileName);
+	}
+
+	if (isCancelled())
+	{
+		return {};
 	}
 
-	std::vector<studio_ptr<studioseqhdr_t>> sequenceHeaders;
+	//Sequence groups are loaded when they are first used
+	std::vector<std::filesystem::path> sequenceGroupFileNames;
 
-	// preload animations
 	if (mainHeader->numseqgroups > 1)
 	{
-		sequenceHeaders.reserve(mainHeader->numseqgroups - 1);
+		sequenceGroupFileNames.reserve(mainHeader->numseqgroups - 1);
 
 		std::stringstream seqgroupname;
 
@@ -442,16 +893,126 @@ std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName)
 				std::setfill('0') << std::setw(2) << i <<
 				std::setw(0) << suffix;
 
-			sequenceHeaders.emplace_back(LoadStudioHeader<studioseqhdr_t>(seqgroupname.str(), true, false));
+			sequenceGroupFileNames.emplace_back(std::filesystem::u8path(seqgroupname.str()));
+		}
+	}
+
+	//Convert once on load so textures can be prepared and uploaded as regular model textures
+	if (isDol)
+	{
+		const auto textureData = textureHeader ? textureHeader.get() : mainHeader.get();
+
+		if (textureData->textureindex > 0)
+		{
+			for (int i = 0; i < textureData->numtextures; ++i)
+			{
+				ConvertDolToMdl(reinterpret_cast<byte*>(textureData), *textureData->GetTexture(i));
+			}
 		}
 	}
 
 	return std::make_unique<StudioModel>(fileName, std::move(mainHeader), std::move(textureHeader),
-		std::move(sequenceHeaders), isDol);
+		std::move(sequenceGroupFileNames), isDol, useMemoryMapping, std::move(textureFileIdentity));
+}
+
+namespace
+{
+/**
+*	@brief Writes a file to a temporary file next to it, then renames the temporary file over it once writing has succeeded.
+*	Other models may have the file mapped into memory. Replacing the file leaves their mapping referencing the old contents,
+*	whereas writing to it in place would change the data underneath them or make them crash if the file shrinks.
+*	@param write Writes the contents to the file it is given. Returns whether writing succeeded.
+*/
+void ReplaceFile(const std::filesystem::path& fileName, const char* description, const std::function<bool(FILE*)>& write)
+{
+	std::filesystem::path temporaryFileName{fileName};
+
+	temporaryFileName += ".tmp";
+
+	FILE* file = utf8_fopen(temporaryFileName.u8string().c_str(), "wb");
+
+	if (!file)
+	{
+		throw assets::AssetException(std::string{"Could not open "} + description + " file for writing");
+	}
+
+	bool success = write(file);
+
+	success = (fclose(file) == 0) && success;
+
+	std::error_code e;
+
+	if (!success)
+	{
+		std::filesystem::remove(temporaryFileName, e);
+		throw assets::AssetException(std::string{"Error while writing to "} + description + " file");
+	}
+
+	std::filesystem::rename(temporaryFileName, fileName, e);
+
+	if (e)
+	{
+		std::filesystem::remove(temporaryFileName, e);
+		throw assets::AssetException(std::string{"Could not replace "} + description + " file \"" + fileName.u8string() + "\"");
+	}
+}
+
+void WriteStudioFile(const std::filesystem::path& fileName, const char* description, const void* data, int length)
+{
+	ReplaceFile(fileName, description, [&](FILE* file)
+		{
+			return fwrite(data, sizeof(byte), length, file) == static_cast<std::size_t>(length);
+		});
+}
+
+void CopySequenceGroupFile(const std::filesystem::path& source, const std::filesystem::path& destination)
+{
+	std::error_code e;
+
+	//Saving over the original file, which already has the right contents
+	if (std::filesystem::equivalent(source, destination, e))
+	{
+		return;
+	}
+
+	FILE* inputFile = utf8_fopen(source.u8string().c_str(), "rb");
+
+	if (!inputFile)
+	{
+		throw assets::AssetException(std::string{"Could not open sequence file \""} + source.u8string() + "\" for reading");
+	}
+
+	try
+	{
+		ReplaceFile(destination, "sequence", [&](FILE* outputFile)
+			{
+				std::vector<byte> buffer(64 * 1024);
+
+				while (const auto readCount = fread(buffer.data(), sizeof(byte), buffer.size(), inputFile))
+				{
+					if (fwrite(buffer.data(), sizeof(byte), readCount, outputFile) != readCount)
+					{
+						return false;
+					}
+				}
+
+				return !ferror(inputFile);
+			});
+	}
+	catch (...)
+	{
+		fclose(inputFile);
+		throw;
+	}
+
+	fclose(inputFile);
+}
 }
 
 void SaveStudioModel(const char* const pszFilename, StudioModel& model, bool correctSequenceGroupFileNames)
 {
+	PROFILE_ZONE("SaveStudioModel");
+
 	if (!pszFilename)
 	{
 		throw assets::AssetException("Null filename provided");
@@ -462,6 +1023,9 @@ void SaveStudioModel(const char* const pszFilename, StudioModel& model, bool cor
 		throw assets::AssetException("Empty filename provided");
 	}
 
+	//The files being written to may be the ones the model is mapped from
+	model.DetachFromFiles();
+
 	studiohdr_t* const pStudioHdr = model.GetStudioHeader();
 
 	if (correctSequenceGroupFileNames)
@@ -530,24 +1094,10 @@ void SaveStudioModel(const char* const pszFilename, StudioModel& model, bool cor
 		}
 	}
 
-	FILE* file = utf8_fopen(pszFilename, "wb");
-
-	if (!file)
-	{
-		throw assets::AssetException("Could not open main file for writing");
-	}
-
-	bool success = fwrite(pStudioHdr, sizeof(byte), pStudioHdr->length, file) == pStudioHdr->length;
-
-	fclose(file);
-
-	if (!success)
-	{
-		throw assets::AssetException("Error while writing to main file");
-	}
-
 	const std::filesystem::path fileName{std::filesystem::u8path(pszFilename)};
 
+	WriteStudioFile(fileName, "main", pStudioHdr, pStudioHdr->length);
+
 	auto baseFileName{fileName};
 
 	baseFileName.replace_extension();
@@ -561,20 +1111,7 @@ void SaveStudioModel(const char* const pszFilename, StudioModel& model, bool cor
 
 		texturename += "T.mdl";
 
-		file = utf8_fopen(texturename.u8string().c_str(), "wb");
-
-		if (!file)
-		{
-			throw assets::AssetException("Could not open texture file for writing");
-		}
-
-		success = fwrite(pTextureHdr, sizeof(byte), pTextureHdr->length, file) == pTextureHdr->length;
-		fclose(file);
-
-		if (!success)
-		{
-			throw assets::AssetException("Error while writing to texture file");
-		}
+		WriteStudioFile(texturename, "texture", pTextureHdr, pTextureHdr->length);
 	}
 
 	// write seq groups
@@ -590,22 +1127,18 @@ void SaveStudioModel(const char* const pszFilename, StudioModel& model, bool cor
 				std::setfill('0') << std::setw(2) << i <<
 				std::setw(0) << ".mdl";
 
-			file = utf8_fopen(seqgroupname.str().c_str(), "wb");
-
-			if (!file)
-			{
-				throw assets::AssetException("Could not open sequence file for writing");
-			}
-
 			const auto pAnimHdr = model.GetSeqGroupHeader(i - 1);
 
-			success = fwrite(pAnimHdr, sizeof(byte), pAnimHdr->length, file) == pAnimHdr->length;
-			fclose(file);
+			const auto seqGroupFileName = std::filesystem::u8path(seqgroupname.str());
 
-			if (!success)
+			//Groups that were never loaded are unchanged, so the original file is copied
+			if (!pAnimHdr)
 			{
-				throw assets::AssetException("Error while writing to sequence file");
+				CopySequenceGroupFile(model.GetSeqGroupFileName(i - 1), seqGroupFileName);
+				continue;
 			}
+
+			WriteStudioFile(seqGroupFileName, "sequence", pAnimHdr, pAnimHdr->length);
 		}
 	}
 }
@@ -729,6 +1262,8 @@ void ApplyScaleMeshesData(StudioModel& studioModel, const ScaleMeshesData& data)
 		sequence->bbmin = data.SequenceBBoxes[i].first;
 		sequence->bbmax = data.SequenceBBoxes[i].second;
 	}
+
+	studioModel.InvalidateMeshes();
 }
 
 std::pair<std::vector<ScaleBonesBoneData>, std::vector<ScaleBonesBoneData>> CalculateScaledBonesData(const StudioModel& studioModel, const float scale)
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -9,21 +16,21 @@
 #include <glm/vec3.hpp>
 
 #include "assets/AssetIO.hpp"
+#include "assets/ResourceCache.hpp"
 
 #include "core/shared/Const.hpp"
+#include "core/shared/JobSystem.hpp"
 
+#include "utility/MappedFile.hpp"
 #include "utility/mathlib.hpp"
 #include "utility/Color.hpp"
 
 #include "graphics/OpenGL.hpp"
+#include "graphics/TextureLoader.hpp"
 
+#include "engine/shared/studiomodel/AnimationCache.hpp"
 #include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
 
-namespace graphics
-{
-class TextureLoader;
-}
-
 namespace studiomdl
 {
 /**
@@ -35,16 +42,37 @@ public:
 	using assets::AssetException::AssetException;
 };
 
+/**
+*	@brief Frees studio model data. Data is either allocated with new[] or is a mapped file.
+*/
 struct StudioDataDeleter
 {
+	/**
+	*	If not null, the data is a view of this file. Changes to the data are private to this process.
+	*/
+	mutable std::unique_ptr<MappedFile> Mapping;
+
 	void operator()(studiohdr_t* pointer) const
 	{
-		delete[] pointer;
+		Free(reinterpret_cast<byte*>(pointer));
 	}
 
 	void operator()(studioseqhdr_t* pointer) const
 	{
-		delete[] pointer;
+		Free(reinterpret_cast<byte*>(pointer));
+	}
+
+private:
+	void Free(byte* pointer) const
+	{
+		if (Mapping)
+		{
+			Mapping.reset();
+		}
+		else
+		{
+			delete[] pointer;
+		}
 	}
 };
 
@@ -53,16 +81,52 @@ using studio_ptr = std::unique_ptr<T, StudioDataDeleter>;
 
 class StudioModel;
 
+/**
+*	@brief OpenGL textures created from a model's texture data.
+*	Models loaded from the same unmodified file with the same texture settings share one set.
+*/
+struct StudioModelTextureSet
+{
+	StudioModelTextureSet() = default;
+	~StudioModelTextureSet();
+
+	StudioModelTextureSet(const StudioModelTextureSet&) = delete;
+	StudioModelTextureSet& operator=(const StudioModelTextureSet&) = delete;
+
+	std::vector<GLuint> Textures;
+
+	/**
+	*	Palettes of indexed textures. Empty if textures were converted to RGBA.
+	*/
+	std::vector<GLuint> PaletteTextures;
+	bool LinearFiltering = true;
+
+	std::vector<bool> Resident;
+	std::deque<int> Pending;
+
+	/**
+	*	Textures converted by PrepareTextures, kept until all pending textures have been uploaded.
+	*/
+	std::vector<graphics::RGBAImage> PreparedTextures;
+};
+
 bool IsStudioModel(const std::string& fileName);
 
 /**
 *	Loads a studio model
 *	@param fileName Name of the model to load. This is the entire path, including the extension
+*	@param useMemoryMapping Whether to map the files into memory instead of reading them.
+*		Avoids copying the data but prevents the files from being overwritten while the model is loaded.
+*		Falls back to reading the files if they can't be mapped.
+*	@param cancelled If not null, checked after each file is loaded. Loading stops once it has been set.
+*	Sequence group files are not loaded until they are needed, see StudioModel::GetAnim.
+*	@return The model, or null if the load was cancelled
 *	@exception assets::AssetNotFound If a file could not be found
 *	@exception assets::AssetInvalidFormat If a file has an invalid format
 *	@exception assets::AssetVersionDiffers If a file has the wrong studio version
 */
-std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName);
+std::unique_ptr<StudioModel> LoadStudioModel(const char* const fileName, bool useMemoryMapping = false,
+	const std::atomic<bool>* cancelled = nullptr);
 
 /**
 *	Saves a studio model.
@@ -79,14 +143,23 @@ void SaveStudioModel(const char* const fileName, StudioModel& model, bool correc
 class StudioModel final
 {
 protected:
-	friend std::unique_ptr<StudioModel> LoadStudioModel(const char* const pszFilename);
+	friend std::unique_ptr<StudioModel> LoadStudioModel(const char* const pszFilename, bool useMemoryMapping,
+		const std::atomic<bool>* cancelled);
 
 public:
 	static const size_t MAX_SEQGROUPS = 32;
 
+	static constexpr int DefaultMaxResidentSequenceGroups = 8;
+
 public:
+	/**
+	*	@param sequenceGroupFileNames Names of the sequence group files, excluding the main file
+	*	@param textureFileIdentity Identity of the file the textures were loaded from, used to share them with other models.
+	*		If empty the textures are never shared.
+	*/
 	StudioModel(std::string&& fileName, studio_ptr<studiohdr_t>&& studioHeader, studio_ptr<studiohdr_t>&& textureHeader,
-		std::vector<studio_ptr<studioseqhdr_t>>&& sequenceHeaders, bool isDol);
+		std::vector<std::filesystem::path>&& sequenceGroupFileNames, bool isDol, bool useMemoryMapping,
+		std::optional<assets::FileIdentity>&& textureFileIdentity = {});
 	~StudioModel();
 
 	StudioModel(const StudioModel&) = delete;
@@ -113,10 +186,62 @@ public:
 		return _studioHeader.get();
 	}
 
-	studioseqhdr_t* GetSeqGroupHeader(const size_t i) const { return _sequenceHeaders[i].get(); }
+	/**
+	*	@brief Gets a sequence group's header if it is currently loaded. Does not load it.
+	*	@param i Index of the group, excluding the main file
+	*/
+	studioseqhdr_t* GetSeqGroupHeader(const size_t i) const;
+
+	/**
+	*	@brief Gets the name of the file a sequence group is loaded from
+	*	@param i Index of the group, excluding the main file
+	*/
+	const std::filesystem::path& GetSeqGroupFileName(const size_t i) const { return _sequenceGroups[i].FileName; }
+
+	int GetMaxResidentSequenceGroups() const { return _maxResidentSequenceGroups; }
+
+	/**
+	*	@brief Sets the number of sequence group files to keep loaded.
+	*	The least recently used groups are unloaded when a group is loaded while at this limit.
+	*	Groups being prefetched in the background are counted as well, but are only unloaded once their load has finished.
+	*/
+	void SetMaxResidentSequenceGroups(int value)
+	{
+		_maxResidentSequenceGroups = std::max(1, value);
+	}
+
+	JobSystem* GetJobSystem() const { return _jobSystem; }
+
+	/**
+	*	@brief Sets the job system used to load neighbouring sequence groups in the background.
+	*	Sequence groups are only loaded when they are used if no job system is set.
+	*	The job system must outlive the model's use of sequence groups.
+	*/
+	void SetJobSystem(JobSystem* jobSystem)
+	{
+		_jobSystem = jobSystem;
+	}
+
+	/**
+	*	@brief Stops referencing files the model data was mapped from so they can be overwritten.
+	*	Mapped data is copied into memory owned by the model, so pointers into the model data have to be retrieved again.
+	*	The meshes are invalidated if any data was copied.
+	*/
+	void DetachFromFiles();
 
+	/**
+	*	@brief Gets a sequence's animation data. Loads the sequence group file if needed and prefetches its neighbours in the background.
+	*	The data remains valid until a sequence in another group is requested.
+	*	@return The animation data, or nullptr if the sequence group could not be loaded. The error is logged the first time.
+	*/
 	mstudioanim_t* GetAnim(mstudioseqdesc_t* pseqdesc) const;
 
+	/**
+	*	@brief Cache of decoded sequence animation data.
+	*	Must be invalidated after modifying a sequence's animation data in place.
+	*/
+	AnimationCache* GetAnimationCache() const { return _animationCache.get(); }
+
 	mstudiomodel_t* GetModelByBodyPart(const int iBody, const int iBodyPart) const;
 
 	int GetBodyValueForGroup(int compositeValue, int group) const;
@@ -125,9 +250,61 @@ public:
 
 	GLuint GetTextureId(const int iIndex) const;
 
+	/**
+	*	@brief Whether the textures were created as palette index textures with a separate palette texture.
+	*	If so, GetTextureId returns the index texture and the renderer must perform the palette lookup.
+	*/
+	bool HasIndexedTextures() const { return _textureSet && !_textureSet->PaletteTextures.empty(); }
+
+	/**
+	*	@brief Gets the palette texture for an indexed texture.
+	*	@return The palette texture, or GL_INVALID_TEXTURE_ID if the textures are not indexed.
+	*/
+	GLuint GetPaletteTextureId(const int iIndex) const;
+
+	/**
+	*	@brief Whether indexed textures should be filtered linearly when sampled.
+	*/
+	bool HasLinearTextureFiltering() const { return !_textureSet || _textureSet->LinearFiltering; }
+
+	/**
+	*	@brief Converts the textures to RGBA ahead of time so CreateTextures only has to upload them.
+	*	Does not use OpenGL so this can be called on a worker thread, before the model is used anywhere else.
+	*	Not needed if the textures will be created as indexed textures.
+	*	@param jobSystem If not null, textures are converted in parallel using this job system.
+	*/
+	void PrepareTextures(const graphics::TextureLoader& textureLoader, JobSystem* jobSystem = nullptr);
+
+	/**
+	*	@brief Creates the textures. Their data is not uploaded until UploadPendingTextures is called,
+	*	so the model can be drawn right away with placeholders for textures that are not resident yet.
+	*	If another model loaded from the same file already created them with the same settings, its textures are used instead.
+	*/
 	void CreateTextures(graphics::TextureLoader& textureLoader);
 
-	void ReplaceTexture(graphics::TextureLoader& textureLoader, mstudiotexture_t* ptexture, const byte* data, const byte* pal, GLuint textureId);
+	/**
+	*	@brief Whether a texture's data has been uploaded. If not, a placeholder should be drawn instead.
+	*/
+	bool IsTextureResident(const int iIndex) const;
+
+	bool HasPendingTextures() const { return _textureSet && !_textureSet->Pending.empty(); }
+
+	/**
+	*	@brief Uploads textures created by CreateTextures that are not resident yet.
+	*	@param maxBytes Number of bytes to upload before stopping. At least one texture is always uploaded
+	*/
+	void UploadPendingTextures(graphics::TextureLoader& textureLoader, std::size_t maxBytes);
+
+	/**
+	*	@brief Uploads new data for a texture. Textures shared with other models are copied first.
+	*/
+	void ReplaceTexture(graphics::TextureLoader& textureLoader, mstudiotexture_t* ptexture, const byte* data, const byte* pal);
+
+	/**
+	*	@brief Replaces the palette a texture is drawn with without changing the texture's data.
+	*	With indexed textures only the palette is uploaded, otherwise the entire texture is converted and reuploaded.
+	*/
+	void ReplacePalette(graphics::TextureLoader& textureLoader, int index, const byte* pal);
 
 	/**
 	*	Reuploads a texture. Useful for making changes made to the texture's pixel, palette or flag data show up in the model itself.
@@ -140,6 +317,25 @@ public:
 
 	void ReuploadTextures(graphics::TextureLoader& textureLoader);
 
+	/**
+	*	@brief Revision number of the uploaded textures. Changes whenever texture data, palettes or filters are uploaded
+	*	so views that draw the model know to redraw.
+	*/
+	unsigned int GetTexturesRevision() const { return _texturesRevision; }
+
+	/**
+	*	@brief Revision number of the mesh data. Changes whenever vertex data is modified so cached copies of it can be rebuilt.
+	*/
+	unsigned int GetMeshesRevision() const { return _meshesRevision; }
+
+	/**
+	*	@brief Must be called after modifying vertex, normal or triangle data.
+	*/
+	void InvalidateMeshes()
+	{
+		++_meshesRevision;
+	}
+
 	std::vector<int> GetRootBoneIndices()
 	{
 		std::vector<int> bones;
@@ -163,11 +359,92 @@ private:
 	studio_ptr<studiohdr_t> _studioHeader;
 	studio_ptr<studiohdr_t> _textureHeader;
 
-	std::vector<studio_ptr<studioseqhdr_t>> _sequenceHeaders;
+	/**
+	*	@brief Sequence group load running on the job system.
+	*	Dropping the last reference to it cancels the load if it hasn't started yet.
+	*/
+	struct SequenceGroupPrefetch
+	{
+		JobHandle Job;
+
+		//Set by the job before it finishes
+		std::shared_ptr<studioseqhdr_t> Header;
+		std::string Error;
+	};
+
+	struct SequenceGroup
+	{
+		std::filesystem::path FileName;
+
+		/**
+		*	Sequence group data is never modified, so it is shared with other models that loaded the same file
+		*/
+		std::shared_ptr<studioseqhdr_t> Header;
+
+		/**
+		*	Background load started by a neighbouring group
+		*/
+		std::shared_ptr<SequenceGroupPrefetch> Prefetch;
+
+		/**
+		*	If not empty the file could not be loaded and won't be retried
+		*/
+		std::string Error;
+
+		unsigned int LastUsed = 0;
+	};
+
+	studioseqhdr_t* LoadSequenceGroup(std::size_t index) const;
+
+	void PrefetchSequenceGroup(std::size_t index) const;
+
+	/**
+	*	@brief Takes the result of a finished prefetch. Must be called with _sequenceGroupsMutex held.
+	*/
+	void FinishPrefetch(SequenceGroup& group) const;
+
+	void EvictSequenceGroups(std::size_t indexToKeep) const;
+
+	std::shared_ptr<StudioModelTextureSet> CreateTextureSet(graphics::TextureLoader& textureLoader);
+
+	void UploadTexture(graphics::TextureLoader& textureLoader, int index);
+
+	/**
+	*	@brief Must be called before modifying the textures so the changes don't show up in other models.
+	*/
+	void MakeTexturesUnique(graphics::TextureLoader& textureLoader);
+
+	//Sequence groups are loaded on demand by const accessors
+	mutable std::mutex _sequenceGroupsMutex;
+	mutable std::vector<SequenceGroup> _sequenceGroups;
+	mutable unsigned int _sequenceGroupUseCount = 0;
+
+	int _maxResidentSequenceGroups = DefaultMaxResidentSequenceGroups;
+
+	JobSystem* _jobSystem = nullptr;
+
+	std::shared_ptr<StudioModelTextureSet> _textureSet;
+
+	/**
+	*	Cleared once the textures have been modified, after which they are no longer shared.
+	*/
+	std::optional<assets::FileIdentity> _textureFileIdentity;
+	std::string _textureSetVariant;
+
+	/**
+	*	Textures converted by PrepareTextures. Only used if the loader that uploads them resizes the same way.
+	*	Moved into the texture set by CreateTextures.
+	*/
+	std::vector<graphics::RGBAImage> _preparedTextures;
+	bool _preparedTexturesPowerOf2 = false;
+
+	const std::unique_ptr<AnimationCache> _animationCache = std::make_unique<AnimationCache>();
 
-	std::vector<GLuint> _textures;
+	unsigned int _meshesRevision = 0;
+	unsigned int _texturesRevision = 0;
 
 	bool _isDol;
+	bool _useMemoryMapping;
 };
 
 struct ScaleMeshesData
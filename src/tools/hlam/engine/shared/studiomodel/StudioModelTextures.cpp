@@ -0,0 +1,417 @@
+#include <cassert>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "core/shared/Logging.hpp"
+#include "core/shared/Profiler.hpp"
+
+#include "graphics/Palette.hpp"
+#include "graphics/TextureLoader.hpp"
+
+#include "engine/shared/studiomodel/StudioModel.hpp"
+
+namespace studiomdl
+{
+static const std::string TexturesResourceType{"Studio model textures"};
+
+StudioModelTextureSet::~StudioModelTextureSet()
+{
+	//Models that failed to load or whose load was cancelled are destroyed without an OpenGL context
+	if (!Textures.empty())
+	{
+		glDeleteTextures(Textures.size(), Textures.data());
+		Textures.clear();
+	}
+
+	if (!PaletteTextures.empty())
+	{
+		glDeleteTextures(PaletteTextures.size(), PaletteTextures.data());
+		PaletteTextures.clear();
+	}
+}
+
+GLuint StudioModel::GetTextureId(const int iIndex) const
+{
+	if (!_textureSet || iIndex < 0 || static_cast<std::size_t>(iIndex) >= _textureSet->Textures.size())
+	{
+		return GL_INVALID_TEXTURE_ID;
+	}
+
+	return _textureSet->Textures[iIndex];
+}
+
+GLuint StudioModel::GetPaletteTextureId(const int iIndex) const
+{
+	if (!_textureSet || iIndex < 0 || static_cast<std::size_t>(iIndex) >= _textureSet->PaletteTextures.size())
+	{
+		return GL_INVALID_TEXTURE_ID;
+	}
+
+	return _textureSet->PaletteTextures[iIndex];
+}
+
+/**
+*	@brief Textures created with different settings can't be shared.
+*/
+static std::string GetTextureSetVariant(const graphics::TextureLoader& textureLoader)
+{
+	std::ostringstream stream;
+
+	//Index textures always use point filtering, only the way the renderer filters them differs
+	if (textureLoader.ShouldCreateIndexedTextures())
+	{
+		stream << "Indexed " << static_cast<int>(textureLoader.GetMagFilter());
+	}
+	else
+	{
+		stream << "RGBA " << textureLoader.ShouldResizeToPowerOf2()
+			<< ' ' << static_cast<int>(textureLoader.GetMinFilter())
+			<< ' ' << static_cast<int>(textureLoader.GetMagFilter())
+			<< ' ' << static_cast<int>(textureLoader.GetMipmapFilter());
+	}
+
+	return stream.str();
+}
+
+void StudioModel::CreateTextures(graphics::TextureLoader& textureLoader)
+{
+	PROFILE_ZONE("StudioModel::CreateTextures");
+
+	auto& cache = assets::ResourceCache::GetInstance();
+
+	_textureSetVariant = GetTextureSetVariant(textureLoader);
+
+	++_texturesRevision;
+
+	if (_textureFileIdentity)
+	{
+		if (auto textureSet = cache.Find<StudioModelTextureSet>(TexturesResourceType, *_textureFileIdentity, _textureSetVariant); textureSet)
+		{
+			_textureSet = std::move(textureSet);
+			_preparedTextures.clear();
+			_preparedTextures.shrink_to_fit();
+			return;
+		}
+	}
+
+	_textureSet = CreateTextureSet(textureLoader);
+
+	if (_textureFileIdentity)
+	{
+		const auto textureHeader = GetTextureHeader();
+
+		const bool isIndexed = !_textureSet->PaletteTextures.empty();
+
+		std::size_t bytes = 0;
+
+		for (std::size_t i = 0; i < _textureSet->Textures.size(); ++i)
+		{
+			const auto& texture = *textureHeader->GetTexture(i);
+
+			bytes += isIndexed ? (texture.width * texture.height) + (PALETTE_ENTRIES * 4) : texture.width * texture.height * 4;
+		}
+
+		_textureSet = cache.Add(TexturesResourceType, *_textureFileIdentity, _textureSetVariant, _textureSet, bytes);
+	}
+}
+
+std::shared_ptr<StudioModelTextureSet> StudioModel::CreateTextureSet(graphics::TextureLoader& textureLoader)
+{
+	const auto textureHeader = GetTextureHeader();
+
+	auto textureSet = std::make_shared<StudioModelTextureSet>();
+
+	textureSet->LinearFiltering = textureLoader.GetMagFilter() == graphics::TextureFilter::Linear;
+
+	const bool createIndexedTextures = textureLoader.ShouldCreateIndexedTextures();
+
+	const bool usePreparedTextures = !createIndexedTextures
+		&& _preparedTextures.size() == static_cast<std::size_t>(textureHeader->numtextures)
+		&& _preparedTexturesPowerOf2 == textureLoader.ShouldResizeToPowerOf2();
+
+	if (usePreparedTextures)
+	{
+		textureSet->PreparedTextures = std::move(_preparedTextures);
+	}
+
+	_preparedTextures.clear();
+	_preparedTextures.shrink_to_fit();
+
+	if (textureHeader->textureindex > 0 && textureHeader->numtextures > 0)
+	{
+		textureSet->Textures.resize(textureHeader->numtextures);
+		glGenTextures(textureSet->Textures.size(), textureSet->Textures.data());
+
+		if (createIndexedTextures)
+		{
+			textureSet->PaletteTextures.resize(textureHeader->numtextures);
+			glGenTextures(textureSet->PaletteTextures.size(), textureSet->PaletteTextures.data());
+		}
+
+		textureSet->Resident.assign(textureHeader->numtextures, false);
+
+		for (int i = 0; i < textureHeader->numtextures; ++i)
+		{
+			textureSet->Pending.push_back(i);
+		}
+	}
+
+	return textureSet;
+}
+
+bool StudioModel::IsTextureResident(const int iIndex) const
+{
+	if (!_textureSet || iIndex < 0 || static_cast<std::size_t>(iIndex) >= _textureSet->Resident.size())
+	{
+		return false;
+	}
+
+	return _textureSet->Resident[iIndex];
+}
+
+void StudioModel::UploadPendingTextures(graphics::TextureLoader& textureLoader, std::size_t maxBytes)
+{
+	PROFILE_ZONE("StudioModel::UploadPendingTextures");
+
+	if (!_textureSet)
+	{
+		return;
+	}
+
+	const auto textureHeader = GetTextureHeader();
+
+	auto& pending = _textureSet->Pending;
+
+	std::size_t uploadedBytes = 0;
+
+	while (!pending.empty() && uploadedBytes < maxBytes)
+	{
+		const int index = pending.front();
+		pending.pop_front();
+
+		//Textures can be replaced before their turn comes up
+		if (_textureSet->Resident[index])
+		{
+			continue;
+		}
+
+		UploadTexture(textureLoader, index);
+
+		const auto& texture = *textureHeader->GetTexture(index);
+
+		uploadedBytes += texture.width * texture.height * (HasIndexedTextures() ? 1 : 4);
+	}
+
+	if (pending.empty())
+	{
+		_textureSet->PreparedTextures.clear();
+		_textureSet->PreparedTextures.shrink_to_fit();
+	}
+}
+
+void StudioModel::UploadTexture(graphics::TextureLoader& textureLoader, int index)
+{
+	const auto textureHeader = GetTextureHeader();
+
+	const byte* const pIn = textureHeader->GetData();
+
+	const auto& texture = *textureHeader->GetTexture(index);
+
+	auto& textureSet = *_textureSet;
+
+	if (HasIndexedTextures())
+	{
+		textureLoader.UploadIndices(textureSet.Textures[index], texture.width, texture.height, pIn + texture.index);
+		textureLoader.UploadPalette(textureSet.PaletteTextures[index], pIn + texture.index + (texture.width * texture.height),
+			(texture.flags & STUDIO_NF_MASKED) != 0);
+	}
+	else if (!textureSet.PreparedTextures.empty())
+	{
+		textureLoader.UploadImage(textureSet.Textures[index], textureSet.PreparedTextures[index], (texture.flags & STUDIO_NF_NOMIPS) != 0);
+
+		//Free memory as soon as possible
+		textureSet.PreparedTextures[index] = {};
+	}
+	else
+	{
+		textureLoader.UploadIndexed8(
+			textureSet.Textures[index],
+			texture.width, texture.height,
+			pIn + texture.index,
+			pIn + texture.index + (texture.width * texture.height),
+			(texture.flags & STUDIO_NF_NOMIPS) != 0,
+			(texture.flags & STUDIO_NF_MASKED) != 0);
+	}
+
+	textureSet.Resident[index] = true;
+
+	++_texturesRevision;
+}
+
+void StudioModel::MakeTexturesUnique(graphics::TextureLoader& textureLoader)
+{
+	if (!_textureFileIdentity || !_textureSet)
+	{
+		return;
+	}
+
+	if (_textureSet.use_count() == 1)
+	{
+		//Nobody else uses these textures, they only have to be hidden from models loaded later
+		assets::ResourceCache::GetInstance().Remove(TexturesResourceType, *_textureFileIdentity, _textureSetVariant, _textureSet.get());
+	}
+	else
+	{
+		_textureSet = CreateTextureSet(textureLoader);
+
+		//Upload everything right away so the copy doesn't show placeholders
+		UploadPendingTextures(textureLoader, std::numeric_limits<std::size_t>::max());
+	}
+
+	_textureFileIdentity.reset();
+}
+
+void StudioModel::ReplaceTexture(graphics::TextureLoader& textureLoader, mstudiotexture_t* ptexture, const byte* data, const byte* pal)
+{
+	MakeTexturesUnique(textureLoader);
+
+	const int index = ptexture - GetTextureHeader()->GetTextures();
+
+	assert(_textureSet && index >= 0 && static_cast<std::size_t>(index) < _textureSet->Resident.size());
+
+	const GLuint textureId = _textureSet->Textures[index];
+
+	if (HasIndexedTextures())
+	{
+		textureLoader.UploadIndices(textureId, ptexture->width, ptexture->height, data);
+		textureLoader.UploadPalette(_textureSet->PaletteTextures[index], pal, (ptexture->flags & STUDIO_NF_MASKED) != 0);
+	}
+	else
+	{
+		textureLoader.UploadIndexed8(
+			textureId,
+			ptexture->width, ptexture->height,
+			data,
+			pal,
+			(ptexture->flags & STUDIO_NF_NOMIPS) != 0,
+			(ptexture->flags & STUDIO_NF_MASKED) != 0);
+	}
+
+	//A pending texture no longer needs to be uploaded
+	_textureSet->Resident[index] = true;
+
+	++_texturesRevision;
+}
+
+void StudioModel::ReplacePalette(graphics::TextureLoader& textureLoader, int index, const byte* pal)
+{
+	auto header = GetTextureHeader();
+
+	if (!_textureSet || index < 0 || index >= header->numtextures || static_cast<std::size_t>(index) >= _textureSet->Textures.size())
+	{
+		Error("StudioModel::ReplacePalette: Invalid texture!");
+		return;
+	}
+
+	const auto ptexture = header->GetTexture(index);
+
+	if (HasIndexedTextures())
+	{
+		MakeTexturesUnique(textureLoader);
+
+		//The pending upload would overwrite the new palette
+		if (!_textureSet->Resident[index])
+		{
+			UploadTexture(textureLoader, index);
+		}
+
+		textureLoader.UploadPalette(_textureSet->PaletteTextures[index], pal, (ptexture->flags & STUDIO_NF_MASKED) != 0);
+
+		++_texturesRevision;
+	}
+	else
+	{
+		ReplaceTexture(textureLoader, ptexture, header->GetData() + ptexture->index, pal);
+	}
+}
+
+void StudioModel::ReuploadTexture(graphics::TextureLoader& textureLoader, mstudiotexture_t* ptexture)
+{
+	assert(ptexture);
+
+	auto header = GetTextureHeader();
+
+	const int index = ptexture - header->GetTextures();
+
+	if (!_textureSet || index < 0 || index >= header->numtextures)
+	{
+		Error("StudioModel::ReuploadTexture: Invalid texture!");
+		return;
+	}
+
+	ReplaceTexture(textureLoader, ptexture,
+		header->GetData() + ptexture->index, header->GetData() + ptexture->index + ptexture->width * ptexture->height);
+}
+
+void StudioModel::UpdateFilters(graphics::TextureLoader& textureLoader)
+{
+	if (!_textureSet)
+	{
+		//No textures loaded yet, do nothing
+		return;
+	}
+
+	if (_textureFileIdentity)
+	{
+		//Shared textures can't be changed, switch to textures created with the new settings instead
+		CreateTextures(textureLoader);
+		UploadPendingTextures(textureLoader, std::numeric_limits<std::size_t>::max());
+		return;
+	}
+
+	_textureSet->LinearFiltering = textureLoader.GetMagFilter() == graphics::TextureFilter::Linear;
+
+	++_texturesRevision;
+
+	if (HasIndexedTextures())
+	{
+		//Index textures always use point filtering, the renderer filters after the palette lookup
+		return;
+	}
+
+	const auto textureHeader{GetTextureHeader()};
+
+	for (int i = 0; i < textureHeader->numtextures; ++i)
+	{
+		glBindTexture(GL_TEXTURE_2D, _textureSet->Textures[i]);
+		textureLoader.SetFilters(_textureSet->Textures[i], (textureHeader->GetTexture(i)->flags & STUDIO_NF_NOMIPS) != 0);
+	}
+}
+
+void StudioModel::ReuploadTextures(graphics::TextureLoader& textureLoader)
+{
+	if (!_textureSet)
+	{
+		//No textures loaded yet, do nothing
+		return;
+	}
+
+	if (_textureFileIdentity)
+	{
+		CreateTextures(textureLoader);
+		UploadPendingTextures(textureLoader, std::numeric_limits<std::size_t>::max());
+		return;
+	}
+
+	auto header = GetTextureHeader();
+
+	for (int i = 0; i < header->numtextures; ++i)
+	{
+		const auto ptexture = header->GetTexture(i);
+
+		ReplaceTexture(textureLoader, ptexture,
+			header->GetData() + ptexture->index, header->GetData() + ptexture->index + ptexture->width * ptexture->height);
+	}
+}
+}
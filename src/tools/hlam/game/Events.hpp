@@ -14,3 +14,11 @@ enum Event
 	SCRIPT_EVENT_SOUND_VOICE	= 1008,		// Play named wave file (on CHAN_VOICE)
 	SCRIPT_CLIENT_EVENT_SOUND	= 5004,		// Play named wave file (at a given location)
 };
+
+/**
+*	@brief Whether an event plays the sound named by its options.
+*/
+inline bool IsSoundEvent(int event)
+{
+	return event == SCRIPT_EVENT_SOUND || event == SCRIPT_EVENT_SOUND_VOICE || event == SCRIPT_CLIENT_EVENT_SOUND;
+}
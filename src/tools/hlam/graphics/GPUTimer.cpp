@@ -0,0 +1,175 @@
+#include "graphics/GPUTimer.hpp"
+
+namespace graphics
+{
+const char* RenderPassToString(RenderPass pass)
+{
+	switch (pass)
+	{
+	case RenderPass::Mirror: return "Mirror";
+	case RenderPass::Main: return "Main";
+	case RenderPass::WireframeOverlay: return "Wireframe Overlay";
+	case RenderPass::Shadows: return "Shadows";
+	case RenderPass::DebugOverlays: return "Debug Overlays";
+	case RenderPass::Floor: return "Floor";
+	case RenderPass::Other: return "Other";
+	default: return "Unknown";
+	}
+}
+
+void GPUTimer::Initialize()
+{
+	Shutdown();
+
+	_supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+}
+
+void GPUTimer::Shutdown()
+{
+	for (auto& frame : _frames)
+	{
+		if (!frame.Queries.empty())
+		{
+			glDeleteQueries(static_cast<GLsizei>(frame.Queries.size()), frame.Queries.data());
+		}
+
+		frame = {};
+	}
+
+	_supported = false;
+	_inFrame = false;
+	_passStack.clear();
+	_frameTime = -1;
+	_passTimes.fill(0);
+}
+
+void GPUTimer::BeginFrame()
+{
+	if (!_supported)
+	{
+		return;
+	}
+
+	auto& frame = _frames[_currentFrame];
+
+	//This frame's queries were issued two frames ago, so they have usually finished by now
+	if (frame.Pending)
+	{
+		ReadResults(frame);
+
+		if (frame.Pending)
+		{
+			//Skip timing this frame rather than waiting for the results
+			return;
+		}
+	}
+
+	_inFrame = true;
+	_passStack.clear();
+
+	frame.TimestampsCount = 0;
+	WriteTimestamp(frame, true);
+}
+
+void GPUTimer::EndFrame()
+{
+	if (_inFrame)
+	{
+		auto& frame = _frames[_currentFrame];
+
+		_passStack.clear();
+		WriteTimestamp(frame, true);
+
+		frame.Pending = true;
+		_inFrame = false;
+	}
+
+	_currentFrame = (_currentFrame + 1) % 2;
+}
+
+void GPUTimer::BeginPass(RenderPass pass)
+{
+	if (_inFrame)
+	{
+		WriteTimestamp(_frames[_currentFrame], false);
+	}
+
+	_passStack.push_back(pass);
+}
+
+void GPUTimer::EndPass()
+{
+	if (_inFrame)
+	{
+		WriteTimestamp(_frames[_currentFrame], false);
+	}
+
+	if (!_passStack.empty())
+	{
+		_passStack.pop_back();
+	}
+}
+
+void GPUTimer::WriteTimestamp(Frame& frame, bool force)
+{
+	//The last timestamp is reserved for the end of the frame
+	if (!force && (frame.TimestampsCount + 1) >= MaxTimestampsPerFrame)
+	{
+		return;
+	}
+
+	if (frame.TimestampsCount >= frame.Queries.size())
+	{
+		const std::size_t oldSize = frame.Queries.size();
+
+		frame.Queries.resize(oldSize + 16);
+		frame.Passes.resize(frame.Queries.size());
+
+		glGenQueries(16, frame.Queries.data() + oldSize);
+	}
+
+	glQueryCounter(frame.Queries[frame.TimestampsCount], GL_TIMESTAMP);
+	frame.Passes[frame.TimestampsCount] = _passStack.empty() ? RenderPass::Other : _passStack.back();
+
+	++frame.TimestampsCount;
+}
+
+void GPUTimer::ReadResults(Frame& frame)
+{
+	if (frame.TimestampsCount < 2)
+	{
+		frame.Pending = false;
+		return;
+	}
+
+	//Queries finish in order, so if the last one is available all of them are
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(frame.Queries[frame.TimestampsCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (!available)
+	{
+		return;
+	}
+
+	_passTimes.fill(0);
+
+	GLuint64 previous = 0;
+	glGetQueryObjectui64v(frame.Queries[0], GL_QUERY_RESULT, &previous);
+
+	const GLuint64 first = previous;
+
+	for (std::size_t i = 1; i < frame.TimestampsCount; ++i)
+	{
+		GLuint64 timestamp = 0;
+		glGetQueryObjectui64v(frame.Queries[i], GL_QUERY_RESULT, &timestamp);
+
+		_passTimes[static_cast<std::size_t>(frame.Passes[i])] += (timestamp - previous) / 1000000.f;
+
+		previous = timestamp;
+	}
+
+	_frameTime = (previous - first) / 1000000.f;
+
+	frame.Pending = false;
+}
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace graphics
+{
+enum class RenderPass
+{
+	Mirror = 0,
+	Main,
+	WireframeOverlay,
+	Shadows,
+	DebugOverlays,
+	Floor,
+
+	/**
+	*	Time not spent in any of the other passes.
+	*/
+	Other,
+
+	Count
+};
+
+const char* RenderPassToString(RenderPass pass);
+
+/**
+*	@brief Measures how much GPU time each render pass takes.
+*	Timestamps are written when passes begin and end. The time between two timestamps is attributed to the innermost pass,
+*	so nested passes are not counted twice.
+*	Results are read back a frame later so rendering never waits for the GPU. If they aren't ready by then the frame is skipped.
+*/
+class GPUTimer final
+{
+public:
+	/**
+	*	@brief Maximum number of timestamps per frame. Passes beyond this in a frame are attributed to the enclosing pass.
+	*/
+	static constexpr std::size_t MaxTimestampsPerFrame = 512;
+
+	GPUTimer() = default;
+	~GPUTimer() = default;
+
+	GPUTimer(const GPUTimer&) = delete;
+	GPUTimer& operator=(const GPUTimer&) = delete;
+
+	/**
+	*	@brief Creates the queries if timer queries are supported. Requires a current OpenGL context.
+	*/
+	void Initialize();
+
+	void Shutdown();
+
+	bool IsSupported() const { return _supported; }
+
+	void BeginFrame();
+
+	void EndFrame();
+
+	void BeginPass(RenderPass pass);
+
+	void EndPass();
+
+	/**
+	*	@brief Gets the GPU time of the last measured frame in milliseconds, or -1 if not available.
+	*/
+	float GetFrameTime() const { return _frameTime; }
+
+	/**
+	*	@brief Gets the GPU time spent in a pass during the last measured frame in milliseconds.
+	*/
+	float GetPassTime(RenderPass pass) const { return _passTimes[static_cast<std::size_t>(pass)]; }
+
+private:
+	struct Frame
+	{
+		std::vector<GLuint> Queries;
+
+		/**
+		*	Pass that was active between the previous timestamp and this one.
+		*/
+		std::vector<RenderPass> Passes;
+
+		std::size_t TimestampsCount = 0;
+		bool Pending = false;
+	};
+
+	void WriteTimestamp(Frame& frame, bool force);
+
+	void ReadResults(Frame& frame);
+
+private:
+	bool _supported = false;
+	bool _inFrame = false;
+
+	//Double buffered so the previous frame's results can be read without waiting for the GPU
+	Frame _frames[2];
+	int _currentFrame = 0;
+
+	std::vector<RenderPass> _passStack;
+
+	float _frameTime = -1;
+	std::array<float, static_cast<std::size_t>(RenderPass::Count)> _passTimes{};
+};
+
+/**
+*	@brief Times the rest of the enclosing scope as a render pass. Does nothing if the timer is null.
+*/
+class GPUPassScope final
+{
+public:
+	GPUPassScope(GPUTimer* timer, RenderPass pass)
+		: _timer(timer)
+	{
+		if (_timer)
+		{
+			_timer->BeginPass(pass);
+		}
+	}
+
+	~GPUPassScope()
+	{
+		if (_timer)
+		{
+			_timer->EndPass();
+		}
+	}
+
+	GPUPassScope(const GPUPassScope&) = delete;
+	GPUPassScope& operator=(const GPUPassScope&) = delete;
+
+private:
+	GPUTimer* const _timer;
+};
+}
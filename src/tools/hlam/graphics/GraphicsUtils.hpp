@@ -52,13 +52,6 @@ void SetProjection( const float flFOV, const int iWidth, const int iHeight );
 */
 void DrawBox( const glm::vec3* const v );
 
-/**
-*	@brief Tests if the given filename is a remap name, and returns the remap ranges if so
-*/
-bool TryGetRemapColors(std::string_view fileName, int& low, int& mid, int& high);
-
-void PaletteHueReplace(byte* palette, int newHue, int start, int end);
-
 /*
 *	Sets up OpenGL for the specified render mode.
 *	@param renderMode Render mode to set up. Must be valid.
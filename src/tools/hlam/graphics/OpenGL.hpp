@@ -12,3 +12,97 @@ void glDeleteTexture(GLuint& textureId);
 const char* glErrorToString(const GLenum error);
 
 const char* glFrameBufferStatusToString(const GLenum status);
+
+/**
+*	Counts of OpenGL calls that affect rendering performance.
+*	Only calls made through the glCounted* wrappers are counted. Only used on the thread that renders.
+*/
+struct GLCallCounts
+{
+	unsigned int DrawCalls = 0;
+	unsigned int TextureBinds = 0;
+
+	/**
+	*	Blend and depth state changes.
+	*/
+	unsigned int StateChanges = 0;
+};
+
+inline GLCallCounts g_GLCallCounts;
+
+inline void glCountedBindTexture( GLenum target, GLuint texture )
+{
+	++g_GLCallCounts.TextureBinds;
+	glBindTexture( target, texture );
+}
+
+/**
+*	Each immediate mode batch is counted as a draw call.
+*/
+inline void glCountedBegin( GLenum mode )
+{
+	++g_GLCallCounts.DrawCalls;
+	glBegin( mode );
+}
+
+inline void glCountedDrawArrays( GLenum mode, GLint first, GLsizei count )
+{
+	++g_GLCallCounts.DrawCalls;
+	glDrawArrays( mode, first, count );
+}
+
+inline void glCountedDrawElements( GLenum mode, GLsizei count, GLenum type, const void* indices )
+{
+	++g_GLCallCounts.DrawCalls;
+	glDrawElements( mode, count, type, indices );
+}
+
+inline void glCountedDrawElementsInstanced( GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instanceCount )
+{
+	++g_GLCallCounts.DrawCalls;
+	glDrawElementsInstanced( mode, count, type, indices, instanceCount );
+}
+
+/**
+*	Only blend and depth test changes are counted.
+*/
+inline void glCountedEnable( GLenum cap )
+{
+	if( cap == GL_BLEND || cap == GL_DEPTH_TEST )
+	{
+		++g_GLCallCounts.StateChanges;
+	}
+
+	glEnable( cap );
+}
+
+/**
+*	Only blend and depth test changes are counted.
+*/
+inline void glCountedDisable( GLenum cap )
+{
+	if( cap == GL_BLEND || cap == GL_DEPTH_TEST )
+	{
+		++g_GLCallCounts.StateChanges;
+	}
+
+	glDisable( cap );
+}
+
+inline void glCountedBlendFunc( GLenum sfactor, GLenum dfactor )
+{
+	++g_GLCallCounts.StateChanges;
+	glBlendFunc( sfactor, dfactor );
+}
+
+inline void glCountedDepthFunc( GLenum func )
+{
+	++g_GLCallCounts.StateChanges;
+	glDepthFunc( func );
+}
+
+inline void glCountedDepthMask( GLboolean flag )
+{
+	++g_GLCallCounts.StateChanges;
+	glDepthMask( flag );
+}
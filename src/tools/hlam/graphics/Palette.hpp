@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <string_view>
+
+#include "core/shared/Const.hpp"
+
 /*
 *	Definitions for 24 bit 256 color palettes.
 */
@@ -23,3 +28,13 @@ const size_t PALETTE_SIZE = PALETTE_ENTRIES * PALETTE_CHANNELS;
 *	The index in a palette where the alpha color is stored. Used for transparent textures.
 */
 const size_t PALETTE_ALPHA_INDEX = 255 * PALETTE_CHANNELS;
+
+namespace graphics
+{
+/**
+*	@brief Tests if the given filename is a remap name, and returns the remap ranges if so
+*/
+bool TryGetRemapColors(std::string_view fileName, int& low, int& mid, int& high);
+
+void PaletteHueReplace(byte* palette, int newHue, int start, int end);
+}
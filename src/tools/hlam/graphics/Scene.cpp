@@ -1,5 +1,10 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <random>
+#include <type_traits>
 #include <utility>
 
 #include <GL/glew.h>
@@ -10,6 +15,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/transform.hpp>
 
+#include "core/shared/Profiler.hpp"
 #include "core/shared/WorldTime.hpp"
 
 #include "engine/renderer/sprite/SpriteRenderer.hpp"
@@ -20,6 +26,7 @@
 #include "game/entity/BaseEntityList.hpp"
 #include "game/entity/EntityManager.hpp"
 
+#include "graphics/GPUTimer.hpp"
 #include "graphics/GraphicsUtils.hpp"
 #include "graphics/IGraphicsContext.hpp"
 #include "graphics/Scene.hpp"
@@ -40,10 +47,42 @@ static const int GUIDELINES_OFFSET = GUIDELINES_LINE_LENGTH + (GUIDELINES_POINT_
 
 static const int GUIDELINES_EDGE_WIDTH = 4;
 
-Scene::Scene(TextureLoader* textureLoader, soundsystem::ISoundSystem* soundSystem, WorldTime* worldTime)
+//Amount of texture data uploaded after each frame while a model's textures are streamed in
+static const std::size_t TEXTURE_UPLOAD_BYTES_PER_FRAME = 4 * 1024 * 1024;
+
+/**
+*	@brief Incrementally computes a FNV-1a hash of values.
+*	Values with padding bytes should be added one member at a time, since padding can have any value.
+*/
+class StateHasher
+{
+public:
+	template<typename T>
+	StateHasher& Add(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+
+		const auto bytes = reinterpret_cast<const unsigned char*>(&value);
+
+		for (std::size_t i = 0; i < sizeof(T); ++i)
+		{
+			_hash = (_hash ^ bytes[i]) * 1099511628211ULL;
+		}
+
+		return *this;
+	}
+
+	std::size_t GetHash() const { return static_cast<std::size_t>(_hash); }
+
+private:
+	unsigned long long _hash = 14695981039346656037ULL;
+};
+
+Scene::Scene(TextureLoader* textureLoader, soundsystem::ISoundSystem* soundSystem, WorldTime* worldTime, JobSystem* jobSystem)
 	: _textureLoader(textureLoader)
+	, _gpuTimer(std::make_unique<graphics::GPUTimer>())
 	, _spriteRenderer(std::make_unique<sprite::SpriteRenderer>(worldTime))
-	, _studioModelRenderer(std::make_unique<studiomdl::StudioModelRenderer>())
+	, _studioModelRenderer(std::make_unique<studiomdl::StudioModelRenderer>(jobSystem, _gpuTimer.get()))
 	, _worldTime(worldTime)
 	//Use the default list class for now
 	, _entityManager(std::make_unique<EntityManager>(std::make_unique<BaseEntityList>(), _worldTime))
@@ -95,6 +134,128 @@ void Scene::SetWireframeColor(const glm::vec3& value)
 	_studioModelRenderer->SetWireframeColor(value);
 }
 
+bool Scene::IsGPUSkinningEnabled() const
+{
+	return _studioModelRenderer->IsGPUSkinningEnabled();
+}
+
+void Scene::SetGPUSkinningEnabled(bool value)
+{
+	_studioModelRenderer->SetGPUSkinningEnabled(value);
+}
+
+unsigned int Scene::GetPoseCacheHits() const
+{
+	return _studioModelRenderer->GetPoseCacheHits();
+}
+
+unsigned int Scene::GetPoseCacheMisses() const
+{
+	return _studioModelRenderer->GetPoseCacheMisses();
+}
+
+void Scene::SetCrowdSize(int size)
+{
+	size = std::clamp(size, 0, MaxCrowdSize);
+
+	MarkDirty();
+
+	for (auto entity : _crowd)
+	{
+		_entityContext->EntityList->Remove(entity);
+	}
+
+	_crowd.clear();
+
+	if (!_entity || size == 0)
+	{
+		return;
+	}
+
+	const auto model = _entity->GetModel();
+	const auto header = model->GetStudioHeader();
+	const auto textureHeader = model->GetTextureHeader();
+
+	if (header->numseq == 0)
+	{
+		return;
+	}
+
+	//Sequences in the main file don't require loading sequence groups, which also lets the crowd be evaluated on multiple threads
+	std::vector<int> sequences;
+
+	for (int i = 0; i < header->numseq; ++i)
+	{
+		if (header->GetSequence(i)->seqgroup == 0)
+		{
+			sequences.push_back(i);
+		}
+	}
+
+	if (sequences.empty())
+	{
+		for (int i = 0; i < header->numseq; ++i)
+		{
+			sequences.push_back(i);
+		}
+	}
+
+	//Space entities out so they don't overlap
+	const auto firstSequence = header->GetSequence(0);
+	const glm::vec3 size3d = firstSequence->bbmax - firstSequence->bbmin;
+
+	float spacing = std::max(size3d.x, size3d.y) * 1.5f;
+
+	if (spacing <= 0)
+	{
+		spacing = 64;
+	}
+
+	//Square grid centered on the entity, which occupies the center cell
+	const int gridSize = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(size + 1))));
+	const int gridCenter = gridSize / 2;
+
+	std::mt19937 random{static_cast<std::mt19937::result_type>(size)};
+
+	std::uniform_int_distribution<std::size_t> sequenceDistribution{0, sequences.size() - 1};
+	std::uniform_int_distribution<int> skinDistribution{0, std::max(0, textureHeader->numskinfamilies - 1)};
+
+	_crowd.reserve(size);
+
+	for (int cell = 0; cell < gridSize * gridSize && static_cast<int>(_crowd.size()) < size; ++cell)
+	{
+		const int x = (cell % gridSize) - gridCenter;
+		const int y = (cell / gridSize) - gridCenter;
+
+		if (x == 0 && y == 0)
+		{
+			continue;
+		}
+
+		const glm::vec3 origin = _entity->GetOrigin() + glm::vec3{x * spacing, y * spacing, 0};
+
+		auto entity = static_cast<HLMVStudioModelEntity*>(_entityContext->EntityManager->Create("studiomodel", _entityContext.get(),
+			origin, _entity->GetAngles(), false));
+
+		if (!entity)
+		{
+			break;
+		}
+
+		entity->SetModel(model);
+		entity->Spawn();
+
+		entity->SetSequence(sequences[sequenceDistribution(random)]);
+
+		std::uniform_real_distribution<float> frameDistribution{0, static_cast<float>(std::max(0, entity->GetNumFrames() - 1))};
+
+		entity->SetFrame(frameDistribution(random));
+		entity->SetSkin(skinDistribution(random));
+
+		_crowd.push_back(entity);
+	}
+}
+
 void Scene::AlignOnGround()
 {
 	auto entity = GetEntity();
@@ -144,13 +305,18 @@ void Scene::Initialize()
 		//TODO: handle error
 	}
 
+	//Lets palette changes upload only the palette instead of the entire texture
+	_textureLoader->SetCreateIndexedTextures(_studioModelRenderer->SupportsIndexedTextures());
+
 	if (nullptr != _entity)
 	{
-		//TODO: should be replaced with an on-demand resource uploading stage in Draw()
+		//Texture data is uploaded by Draw
 		_entity->GetModel()->CreateTextures(*_textureLoader);
 	}
 
 	glGenTextures(1, &UVMeshTexture);
+
+	_gpuTimer->Initialize();
 }
 
 void Scene::Shutdown()
@@ -165,16 +331,38 @@ void Scene::Shutdown()
 	glDeleteTexture(UVMeshTexture);
 	UVMeshTexture = 0;
 
+	_gpuTimer->Shutdown();
+
+	_textureLoader->ReleaseUploadBuffer();
+
 	_studioModelRenderer->Shutdown();
 }
 
 void Scene::Tick()
 {
+	PROFILE_ZONE("Scene::Tick");
+
 	_entityManager->RunFrame();
 }
 
+bool Scene::IsDirty() const
+{
+	return _dirty || _drawnStateHash != ComputeStateHash();
+}
+
 void Scene::Draw()
 {
+	PROFILE_ZONE("Scene::Draw");
+
+	const auto frameStart = std::chrono::steady_clock::now();
+
+	_dirty = false;
+	_drawnStateHash = ComputeStateHash();
+
+	g_GLCallCounts = {};
+
+	_gpuTimer->BeginFrame();
+
 	glClearColor(BackgroundColor.r, BackgroundColor.g, BackgroundColor.b, 1.0f);
 
 	if (MirrorOnGround)
@@ -192,6 +380,8 @@ void Scene::Draw()
 
 	_drawnPolygonsCount = 0;
 
+	_studioModelRenderer->RunFrame();
+
 	if (ShowTexture)
 	{
 		DrawTexture(TextureXOffset, TextureYOffset, _windowWidth, _windowHeight, _entity, TextureIndex, TextureScale, ShowUVMap, OverlayUVMap);
@@ -206,6 +396,8 @@ void Scene::Draw()
 
 	if (ShowCrosshair)
 	{
+		GPUPassScope pass{_gpuTimer.get(), RenderPass::DebugOverlays};
+
 		glMatrixMode(GL_PROJECTION);
 		glLoadIdentity();
 
@@ -256,6 +448,8 @@ void Scene::Draw()
 
 	if (ShowGuidelines)
 	{
+		GPUPassScope pass{_gpuTimer.get(), RenderPass::DebugOverlays};
+
 		glMatrixMode(GL_PROJECTION);
 		glLoadIdentity();
 
@@ -316,6 +510,131 @@ void Scene::Draw()
 
 		glPopMatrix();
 	}
+
+	if (nullptr != _entity)
+	{
+		auto model = _entity->GetModel();
+
+		//Uploading after the frame has been drawn lets the model show up right away, with placeholders
+		if (model->HasPendingTextures())
+		{
+			model->UploadPendingTextures(*_textureLoader, TEXTURE_UPLOAD_BYTES_PER_FRAME);
+
+			//Keep drawing until all textures are resident
+			_dirty = true;
+		}
+	}
+
+	//The crowd is not part of the state hash, so keep drawing while it animates
+	if (!_crowd.empty())
+	{
+		_dirty = true;
+	}
+
+	_gpuTimer->EndFrame();
+
+	_glCallCounts = g_GLCallCounts;
+
+	_cpuFrameTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+	auto& profiler = Profiler::GetInstance();
+
+	profiler.RecordCounter("Draw Calls", _glCallCounts.DrawCalls);
+	profiler.RecordCounter("Texture Binds", _glCallCounts.TextureBinds);
+	profiler.RecordCounter("State Changes", _glCallCounts.StateChanges);
+	profiler.RecordCounter("CPU Frame Time (ms)", _cpuFrameTime);
+
+	if (_gpuTimer->IsSupported())
+	{
+		profiler.RecordCounter("GPU Frame Time (ms)", _gpuTimer->GetFrameTime());
+	}
+}
+
+std::size_t Scene::ComputeStateHash() const
+{
+	StateHasher hasher;
+
+	hasher
+		.Add(CurrentRenderMode)
+		.Add(ShowHitboxes)
+		.Add(ShowBones)
+		.Add(ShowAttachments)
+		.Add(ShowEyePosition)
+		.Add(EnableBackfaceCulling)
+		.Add(ShowGround)
+		.Add(MirrorOnGround)
+		.Add(ShowBackground)
+		.Add(ShowWireframeOverlay)
+		.Add(DrawShadows)
+		.Add(FixShadowZFighting)
+		.Add(ShowAxes)
+		.Add(ShowNormals)
+		.Add(ShowCrosshair)
+		.Add(ShowGuidelines)
+		.Add(ShowPlayerHitbox)
+		.Add(FloorLength)
+		.Add(EnableFloorTextureTiling)
+		.Add(FloorTextureLength)
+		.Add(GroundTexture)
+		.Add(BackgroundTexture)
+		.Add(DrawSingleBoneIndex)
+		.Add(DrawSingleAttachmentIndex)
+		.Add(DrawSingleHitboxIndex)
+		.Add(ShowTexture)
+		.Add(TextureIndex)
+		.Add(TextureXOffset)
+		.Add(TextureYOffset)
+		.Add(TextureScale)
+		.Add(ShowUVMap)
+		.Add(OverlayUVMap)
+		.Add(CameraIsFirstPerson)
+		.Add(GroundColor)
+		.Add(BackgroundColor)
+		.Add(CrosshairColor)
+		.Add(_windowWidth)
+		.Add(_windowHeight)
+		.Add(GetLightColor())
+		.Add(GetWireframeColor())
+		.Add(IsGPUSkinningEnabled());
+
+	hasher
+		.Add(_currentCamera)
+		.Add(_currentCamera->GetOrigin())
+		.Add(_currentCamera->GetPitch())
+		.Add(_currentCamera->GetYaw())
+		.Add(_currentCamera->GetViewMatrix())
+		.Add(_currentCamera->GetFieldOfView());
+
+	hasher.Add(_entity);
+
+	if (_entity)
+	{
+		const auto renderInfo = _entity->GetRenderInfo();
+
+		hasher
+			.Add(renderInfo.Origin)
+			.Add(renderInfo.Angles)
+			.Add(renderInfo.Scale)
+			.Add(renderInfo.Model)
+			.Add(renderInfo.Transparency)
+			.Add(renderInfo.Sequence)
+			.Add(renderInfo.Frame)
+			.Add(renderInfo.Bodygroup)
+			.Add(renderInfo.Skin)
+			.Add(renderInfo.Blender)
+			.Add(renderInfo.Controller)
+			.Add(renderInfo.Mouth);
+
+		//Edits to the model's data and textures don't change anything above
+		if (renderInfo.Model)
+		{
+			hasher
+				.Add(renderInfo.Model->GetMeshesRevision())
+				.Add(renderInfo.Model->GetTexturesRevision());
+		}
+	}
+
+	return hasher.GetHash();
 }
 
 void Scene::ApplyCameraToScene()
@@ -358,6 +677,8 @@ void Scene::DrawModel()
 
 	if (ShowAxes)
 	{
+		GPUPassScope pass{_gpuTimer.get(), RenderPass::DebugOverlays};
+
 		glDisable(GL_TEXTURE_2D);
 		glEnable(GL_DEPTH_TEST);
 
@@ -395,6 +716,8 @@ void Scene::DrawModel()
 		// setup stencil buffer and draw mirror
 		if (MirrorOnGround)
 		{
+			GPUPassScope pass{_gpuTimer.get(), RenderPass::Mirror};
+
 			graphics::DrawMirroredModel(*_studioModelRenderer, _entity,
 				CurrentRenderMode,
 				ShowWireframeOverlay,
@@ -462,7 +785,15 @@ void Scene::DrawModel()
 			flags |= renderer::DrawFlag::DRAW_NORMALS;
 		}
 
-		_entity->Draw(flags);
+		{
+			GPUPassScope pass{_gpuTimer.get(), RenderPass::Main};
+
+			_entity->Draw(flags);
+
+			DrawCrowd(flags & renderer::DrawFlag::WIREFRAME_OVERLAY);
+		}
+
+		GPUPassScope pass{_gpuTimer.get(), RenderPass::DebugOverlays};
 
 		auto renderInfo = _entity->GetRenderInfo();
 
@@ -530,6 +861,8 @@ void Scene::DrawModel()
 		_floorTextureOffset.x = std::fmod(_floorTextureOffset.x, floorTextureLength);
 		_floorTextureOffset.y = std::fmod(_floorTextureOffset.y, floorTextureLength);
 
+		GPUPassScope pass{_gpuTimer.get(), RenderPass::Floor};
+
 		graphics::DrawFloor(FloorLength, floorTextureLength, _floorTextureOffset, GroundTexture, GroundColor, MirrorOnGround);
 	}
 
@@ -537,6 +870,8 @@ void Scene::DrawModel()
 
 	if (ShowPlayerHitbox)
 	{
+		GPUPassScope pass{_gpuTimer.get(), RenderPass::DebugOverlays};
+
 		//Draw a transparent green box to display the player hitbox
 		glDisable(GL_TEXTURE_2D);
 		glDisable(GL_CULL_FACE);
@@ -597,6 +932,32 @@ void Scene::DrawModel()
 	glPopMatrix();
 }
 
+void Scene::DrawCrowd(renderer::DrawFlags flags)
+{
+	if (_crowd.empty())
+	{
+		return;
+	}
+
+	_crowdRenderInfos.clear();
+
+	const auto entityRenderInfo = _entity->GetRenderInfo();
+
+	for (auto entity : _crowd)
+	{
+		auto renderInfo = entity->GetRenderInfo();
+
+		//Follow changes made to the entity, instances must use the same bodygroup
+		renderInfo.Scale = entityRenderInfo.Scale;
+		renderInfo.Transparency = entityRenderInfo.Transparency;
+		renderInfo.Bodygroup = entityRenderInfo.Bodygroup;
+
+		_crowdRenderInfos.push_back(renderInfo);
+	}
+
+	_studioModelRenderer->DrawModelInstances(_crowdRenderInfos.data(), _crowdRenderInfos.size(), flags);
+}
+
 void Scene::DrawTexture(const int xOffset, const int yOffset, const int width, const int height, StudioModelEntity* entity,
 	const int textureIndex, const float textureScale, const bool showUVMap, const bool overlayUVMap)
 {
@@ -650,7 +1011,7 @@ void Scene::DrawTexture(const int xOffset, const int yOffset, const int width, c
 
 		glEnable(GL_TEXTURE_2D);
 		glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-		glBindTexture(GL_TEXTURE_2D, model->GetTextureId(textureIndex));
+		_studioModelRenderer->BindTexture(*model, textureIndex);
 
 		glBegin(GL_TRIANGLE_STRIP);
 
@@ -668,7 +1029,7 @@ void Scene::DrawTexture(const int xOffset, const int yOffset, const int width, c
 
 		glEnd();
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		_studioModelRenderer->UnbindTexture();
 
 		if (texture.flags & STUDIO_NF_MASKED)
 		{
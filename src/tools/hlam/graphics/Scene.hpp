@@ -1,19 +1,26 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 #include <GL/glew.h>
 
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include "engine/shared/renderer/DrawConstants.hpp"
+#include "engine/shared/renderer/studiomodel/ModelRenderInfo.hpp"
 #include "engine/shared/studiomodel/StudioModelFileFormat.hpp"
 
 #include "graphics/Camera.hpp"
 #include "graphics/Constants.hpp"
+#include "graphics/GPUTimer.hpp"
+#include "graphics/OpenGL.hpp"
 
 class EntityManager;
 class HLMVStudioModelEntity;
+class JobSystem;
 class StudioModelEntity;
 class WorldTime;
 struct EntityContext;
@@ -44,7 +51,12 @@ class TextureLoader;
 class Scene
 {
 public:
-	Scene(graphics::TextureLoader* textureLoader, soundsystem::ISoundSystem* soundSystem, WorldTime* worldTime);
+	/**
+	*	@brief Maximum number of additional instances of the model that can be drawn around the entity.
+	*/
+	static constexpr int MaxCrowdSize = 1024;
+
+	Scene(graphics::TextureLoader* textureLoader, soundsystem::ISoundSystem* soundSystem, WorldTime* worldTime, JobSystem* jobSystem);
 	~Scene();
 	Scene(const Scene&) = delete;
 	Scene& operator=(const Scene&) = delete;
@@ -82,15 +94,64 @@ public:
 
 	void SetWireframeColor(const glm::vec3& value);
 
+	bool IsGPUSkinningEnabled() const;
+
+	void SetGPUSkinningEnabled(bool value);
+
 	unsigned int GetDrawnPolygonsCount() const { return _drawnPolygonsCount; }
 
+	unsigned int GetPoseCacheHits() const;
+
+	unsigned int GetPoseCacheMisses() const;
+
 	HLMVStudioModelEntity* GetEntity() { return _entity; }
 
 	void SetEntity(HLMVStudioModelEntity* entity)
 	{
+		SetCrowdSize(0);
 		_entity = entity;
 	}
 
+	int GetCrowdSize() const { return static_cast<int>(_crowd.size()); }
+
+	/**
+	*	@brief Spawns copies of the entity in a grid around it to stress test the renderer.
+	*	Each copy plays a random sequence starting at a random frame, and uses a random skin.
+	*	The same size always produces the same crowd.
+	*	@param size Number of copies, clamped to [0, MaxCrowdSize]
+	*/
+	void SetCrowdSize(int size);
+
+	/**
+	*	@brief Gets the number of entities drawn by the scene, including the crowd.
+	*/
+	unsigned int GetEntityCount() const { return (_entity ? 1 : 0) + static_cast<unsigned int>(_crowd.size()); }
+
+	unsigned int GetDrawCallsCount() const { return _glCallCounts.DrawCalls; }
+
+	/**
+	*	@brief Gets the number of draw calls, texture binds and state changes made by the renderers in the last frame.
+	*/
+	const GLCallCounts& GetGLCallCounts() const { return _glCallCounts; }
+
+	/**
+	*	@brief Gets the time it took to issue the commands for the last frame, in milliseconds.
+	*/
+	float GetCPUFrameTime() const { return _cpuFrameTime; }
+
+	/**
+	*	@brief Gets the time the GPU spent drawing a recent frame, in milliseconds.
+	*	Queries are read back a frame late to avoid stalling, so this lags behind by a frame.
+	*	@return The time, or a negative value if timer queries aren't supported.
+	*/
+	float GetGPUFrameTime() const { return _gpuTimer->GetFrameTime(); }
+
+	/**
+	*	@brief Gets the time the GPU spent in a render pass during a recent frame, in milliseconds.
+	*	Lags behind by a frame, same as GetGPUFrameTime.
+	*/
+	float GetGPUPassTime(RenderPass pass) const { return _gpuTimer->GetPassTime(pass); }
+
 	void AlignOnGround();
 
 	void Initialize();
@@ -99,15 +160,37 @@ public:
 
 	void Tick();
 
+	/**
+	*	@brief Marks the scene as needing to be redrawn.
+	*	Only needed for changes that IsDirty can't detect, like edits to the model data.
+	*/
+	void MarkDirty()
+	{
+		_dirty = true;
+	}
+
+	/**
+	*	@brief Returns whether anything that affects the scene's appearance changed since it was last drawn.
+	*	Changes to the public settings, the camera, the entity and the model's mesh and texture revisions are detected automatically.
+	*/
+	bool IsDirty() const;
+
 	void Draw();
 
 private:
+	/**
+	*	@brief Computes a hash of all state that affects the scene's appearance.
+	*/
+	std::size_t ComputeStateHash() const;
+
 	void ApplyCameraToScene();
 
 	void SetupRenderMode(RenderMode renderMode = RenderMode::INVALID);
 
 	void DrawModel();
 
+	void DrawCrowd(renderer::DrawFlags flags);
+
 	void DrawTexture(const int xOffset, const int yOffset, const int width, const int height, StudioModelEntity* entity,
 		const int textureIndex, const float textureScale, const bool showUVMap, const bool overlayUVMap);
 
@@ -171,6 +254,8 @@ private:
 
 	std::unique_ptr<IGraphicsContext> _graphicsContext;
 
+	//Must be created before the renderers that use it
+	const std::unique_ptr<GPUTimer> _gpuTimer;
 	const std::unique_ptr<sprite::ISpriteRenderer> _spriteRenderer;
 	const std::unique_ptr<studiomdl::IStudioModelRenderer> _studioModelRenderer;
 
@@ -188,8 +273,18 @@ private:
 
 	unsigned int _drawnPolygonsCount = 0;
 
+	bool _dirty{true};
+	std::size_t _drawnStateHash{0};
+
 	HLMVStudioModelEntity* _entity{};
 
+	std::vector<HLMVStudioModelEntity*> _crowd;
+	std::vector<studiomdl::ModelRenderInfo> _crowdRenderInfos;
+
+	GLCallCounts _glCallCounts;
+
+	float _cpuFrameTime = 0;
+
 	int _floorSequence{-1};
 	float _previousFloorFrame{0};
 
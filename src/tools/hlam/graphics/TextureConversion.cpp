@@ -0,0 +1,138 @@
+#include <cstring>
+#include <initializer_list>
+
+#include "graphics/TextureConversion.hpp"
+#include "graphics/TextureConversionKernels.hpp"
+
+namespace graphics
+{
+namespace textureconversion
+{
+void ScalarExpandIndexed8(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		std::memcpy(rgbaPixels + (i * 4), &rgbaPalette[pixels[i]], 4);
+	}
+}
+
+void ScalarBoxFilterRowRGBA8888(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const auto pix1 = &rows[0][columns[0][i] * 4];
+		const auto pix2 = &rows[0][columns[1][i] * 4];
+		const auto pix3 = &rows[1][columns[0][i] * 4];
+		const auto pix4 = &rows[1][columns[1][i] * 4];
+
+		byte* const pixel = &rgbaPixels[i * 4];
+
+		for (int p = 0; p < 4; ++p)
+		{
+			pixel[p] = (pix1[p] + pix2[p] + pix3[p] + pix4[p]) / 4;
+		}
+
+		//If any of the sampled pixels are transparent the destination pixel is also transparent
+		if (masked && pixel[3] != 0xFF)
+		{
+			pixel[3] = 0x00;
+		}
+	}
+}
+
+const Kernels ScalarKernels
+{
+	&ScalarExpandIndexed8,
+	&ScalarBoxFilterRowRGBA8888
+};
+
+static bool IsSupported(TextureConversionImplementation implementation)
+{
+	switch (implementation)
+	{
+	case TextureConversionImplementation::Scalar: return true;
+	case TextureConversionImplementation::SSE2: return IsSSE2Supported();
+	case TextureConversionImplementation::AVX2: return IsAVX2Supported();
+	default: return false;
+	}
+}
+
+static const Kernels& GetKernels(TextureConversionImplementation implementation)
+{
+	switch (implementation)
+	{
+#if HLAM_SIMD_X86
+	case TextureConversionImplementation::SSE2: return SSE2Kernels;
+	case TextureConversionImplementation::AVX2: return AVX2Kernels;
+#endif
+	default: return ScalarKernels;
+	}
+}
+
+static TextureConversionImplementation SelectBestImplementation()
+{
+	for (auto implementation : {TextureConversionImplementation::AVX2, TextureConversionImplementation::SSE2})
+	{
+		if (IsSupported(implementation))
+		{
+			return implementation;
+		}
+	}
+
+	return TextureConversionImplementation::Scalar;
+}
+
+struct State
+{
+	TextureConversionImplementation Implementation = SelectBestImplementation();
+	const Kernels* CurrentKernels = &GetKernels(Implementation);
+};
+
+static State& GetState()
+{
+	static State state;
+	return state;
+}
+}
+
+TextureConversionImplementation GetTextureConversionImplementation()
+{
+	return textureconversion::GetState().Implementation;
+}
+
+bool SetTextureConversionImplementation(TextureConversionImplementation implementation)
+{
+	if (!textureconversion::IsSupported(implementation))
+	{
+		return false;
+	}
+
+	auto& state = textureconversion::GetState();
+
+	state.Implementation = implementation;
+	state.CurrentKernels = &textureconversion::GetKernels(implementation);
+
+	return true;
+}
+
+const char* TextureConversionImplementationToString(TextureConversionImplementation implementation)
+{
+	switch (implementation)
+	{
+	case TextureConversionImplementation::Scalar: return "Scalar";
+	case TextureConversionImplementation::SSE2: return "SSE2";
+	case TextureConversionImplementation::AVX2: return "AVX2";
+	default: return "Unknown";
+	}
+}
+
+void ExpandIndexed8(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count)
+{
+	textureconversion::GetState().CurrentKernels->ExpandIndexed8(pixels, rgbaPalette, rgbaPixels, count);
+}
+
+void BoxFilterRowRGBA8888(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count)
+{
+	textureconversion::GetState().CurrentKernels->BoxFilterRowRGBA8888(rows, columns, masked, rgbaPixels, count);
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/shared/Const.hpp"
+
+/**
+*	@file
+*
+*	Kernels used by TextureLoader to convert and resize images.
+*	SSE2 and AVX2 implementations are selected at runtime based on what the CPU supports.
+*	All implementations produce identical results.
+*/
+
+namespace graphics
+{
+enum class TextureConversionImplementation
+{
+	Scalar = 0,
+	SSE2,
+	AVX2
+};
+
+/**
+*	@brief Gets the implementation used by the conversion functions.
+*/
+TextureConversionImplementation GetTextureConversionImplementation();
+
+/**
+*	@brief Overrides the implementation used by the conversion functions. Not thread safe, intended for testing and benchmarks.
+*	@return Whether the implementation is supported by this CPU. If not, the current implementation is left unchanged.
+*/
+bool SetTextureConversionImplementation(TextureConversionImplementation implementation);
+
+const char* TextureConversionImplementationToString(TextureConversionImplementation implementation);
+
+/**
+*	@brief Converts indexed pixels to RGBA.
+*	@param rgbaPalette 256 RGBA colors, stored in memory order
+*	@param rgbaPixels Destination, must have room for count * 4 bytes
+*/
+void ExpandIndexed8(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count);
+
+/**
+*	@brief Produces one row of a resized image by averaging 4 source pixels for each destination pixel.
+*	Destination pixel i is the average of the pixels at columns[0][i] and columns[1][i] in both source rows.
+*	@param rows The 2 source rows to sample
+*	@param columns The 2 source columns to sample for each destination pixel
+*	@param masked If true, destination pixels are fully transparent unless all sampled pixels are opaque
+*/
+void BoxFilterRowRGBA8888(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count);
+}
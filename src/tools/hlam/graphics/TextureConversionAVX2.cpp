@@ -0,0 +1,104 @@
+#include "graphics/TextureConversionKernels.hpp"
+
+#if HLAM_SIMD_X86
+
+#include <immintrin.h>
+
+/**
+*	@file
+*
+*	AVX2 texture conversion kernels. Palette lookups and pixel sampling use gathers.
+*/
+
+namespace graphics::textureconversion
+{
+namespace
+{
+HLAM_TARGET_AVX2 inline __m256i GatherPixels(const byte* row, const int* columns)
+{
+	return _mm256_i32gather_epi32(reinterpret_cast<const int*>(row),
+		_mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns)), 4);
+}
+
+/**
+*	@brief Averages 4 sets of pixels per channel, truncating the result the same way integer division does.
+*	Unpacking and packing both operate per 128 bit lane so pixels stay in order.
+*/
+HLAM_TARGET_AVX2 inline __m256i Average(__m256i a, __m256i b, __m256i c, __m256i d)
+{
+	const __m256i zero = _mm256_setzero_si256();
+
+	const __m256i low = _mm256_add_epi16(
+		_mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)), _mm256_unpacklo_epi8(c, zero)),
+		_mm256_unpacklo_epi8(d, zero));
+
+	const __m256i high = _mm256_add_epi16(
+		_mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)), _mm256_unpackhi_epi8(c, zero)),
+		_mm256_unpackhi_epi8(d, zero));
+
+	return _mm256_packus_epi16(_mm256_srli_epi16(low, 2), _mm256_srli_epi16(high, 2));
+}
+
+/**
+*	@brief Makes pixels whose alpha is not 255 fully transparent.
+*/
+HLAM_TARGET_AVX2 inline __m256i MaskAlpha(__m256i pixels)
+{
+	//Alpha is the last byte of each pixel
+	const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+	const __m256i opaque = _mm256_and_si256(_mm256_cmpeq_epi8(pixels, alphaMask), alphaMask);
+
+	return _mm256_or_si256(_mm256_andnot_si256(alphaMask, pixels), opaque);
+}
+
+HLAM_TARGET_AVX2 void AVX2ExpandIndexed8(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count)
+{
+	const auto palette = reinterpret_cast<const int*>(rgbaPalette);
+
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + i)));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgbaPixels + (i * 4)), _mm256_i32gather_epi32(palette, indices, 4));
+	}
+
+	ScalarExpandIndexed8(pixels + i, rgbaPalette, rgbaPixels + (i * 4), count - i);
+}
+
+HLAM_TARGET_AVX2 void AVX2BoxFilterRowRGBA8888(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count)
+{
+	std::size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i result = Average(
+			GatherPixels(rows[0], columns[0] + i),
+			GatherPixels(rows[0], columns[1] + i),
+			GatherPixels(rows[1], columns[0] + i),
+			GatherPixels(rows[1], columns[1] + i));
+
+		if (masked)
+		{
+			result = MaskAlpha(result);
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgbaPixels + (i * 4)), result);
+	}
+
+	const int* const remainingColumns[2]{columns[0] + i, columns[1] + i};
+
+	ScalarBoxFilterRowRGBA8888(rows, remainingColumns, masked, rgbaPixels + (i * 4), count - i);
+}
+}
+
+const Kernels AVX2Kernels
+{
+	&AVX2ExpandIndexed8,
+	&AVX2BoxFilterRowRGBA8888
+};
+}
+
+#endif
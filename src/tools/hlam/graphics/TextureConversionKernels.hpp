@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/shared/Const.hpp"
+
+#include "utility/SIMD.hpp"
+
+/**
+*	@file
+*
+*	Internal to the TextureConversion implementation.
+*/
+
+namespace graphics::textureconversion
+{
+struct Kernels
+{
+	void (*ExpandIndexed8)(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count);
+
+	void (*BoxFilterRowRGBA8888)(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count);
+};
+
+extern const Kernels ScalarKernels;
+
+//Shared with the SIMD kernels to process the remaining pixels
+void ScalarExpandIndexed8(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count);
+void ScalarBoxFilterRowRGBA8888(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count);
+
+#if HLAM_SIMD_X86
+extern const Kernels SSE2Kernels;
+extern const Kernels AVX2Kernels;
+#endif
+}
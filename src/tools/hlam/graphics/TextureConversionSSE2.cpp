@@ -0,0 +1,114 @@
+#include "graphics/TextureConversionKernels.hpp"
+
+#if HLAM_SIMD_X86
+
+#include <cstring>
+
+#include <emmintrin.h>
+
+/**
+*	@file
+*
+*	SSE2 texture conversion kernels. SSE2 has no gather or 256 entry table lookup,
+*	so palette lookups are done one pixel at a time and only the stores are vectorized.
+*/
+
+namespace graphics::textureconversion
+{
+namespace
+{
+inline int LoadPixel(const byte* row, int column)
+{
+	int value;
+	std::memcpy(&value, row + (column * 4), sizeof(value));
+	return value;
+}
+
+HLAM_TARGET_SSE2 inline __m128i LoadPixels(const byte* row, const int* columns)
+{
+	return _mm_setr_epi32(
+		LoadPixel(row, columns[0]), LoadPixel(row, columns[1]), LoadPixel(row, columns[2]), LoadPixel(row, columns[3]));
+}
+
+/**
+*	@brief Averages 4 sets of pixels per channel, truncating the result the same way integer division does.
+*/
+HLAM_TARGET_SSE2 inline __m128i Average(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	const __m128i low = _mm_add_epi16(
+		_mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)), _mm_unpacklo_epi8(c, zero)),
+		_mm_unpacklo_epi8(d, zero));
+
+	const __m128i high = _mm_add_epi16(
+		_mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)), _mm_unpackhi_epi8(c, zero)),
+		_mm_unpackhi_epi8(d, zero));
+
+	return _mm_packus_epi16(_mm_srli_epi16(low, 2), _mm_srli_epi16(high, 2));
+}
+
+/**
+*	@brief Makes pixels whose alpha is not 255 fully transparent.
+*/
+HLAM_TARGET_SSE2 inline __m128i MaskAlpha(__m128i pixels)
+{
+	//Alpha is the last byte of each pixel
+	const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+	const __m128i opaque = _mm_and_si128(_mm_cmpeq_epi8(pixels, alphaMask), alphaMask);
+
+	return _mm_or_si128(_mm_andnot_si128(alphaMask, pixels), opaque);
+}
+
+HLAM_TARGET_SSE2 void SSE2ExpandIndexed8(const byte* pixels, const std::uint32_t* rgbaPalette, byte* rgbaPixels, std::size_t count)
+{
+	const auto palette = reinterpret_cast<const int*>(rgbaPalette);
+
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i result = _mm_setr_epi32(
+			palette[pixels[i]], palette[pixels[i + 1]], palette[pixels[i + 2]], palette[pixels[i + 3]]);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(rgbaPixels + (i * 4)), result);
+	}
+
+	ScalarExpandIndexed8(pixels + i, rgbaPalette, rgbaPixels + (i * 4), count - i);
+}
+
+HLAM_TARGET_SSE2 void SSE2BoxFilterRowRGBA8888(const byte* const* rows, const int* const* columns, bool masked, byte* rgbaPixels, std::size_t count)
+{
+	std::size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i result = Average(
+			LoadPixels(rows[0], columns[0] + i),
+			LoadPixels(rows[0], columns[1] + i),
+			LoadPixels(rows[1], columns[0] + i),
+			LoadPixels(rows[1], columns[1] + i));
+
+		if (masked)
+		{
+			result = MaskAlpha(result);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(rgbaPixels + (i * 4)), result);
+	}
+
+	const int* const remainingColumns[2]{columns[0] + i, columns[1] + i};
+
+	ScalarBoxFilterRowRGBA8888(rows, remainingColumns, masked, rgbaPixels + (i * 4), count - i);
+}
+}
+
+const Kernels SSE2Kernels
+{
+	&SSE2ExpandIndexed8,
+	&SSE2BoxFilterRowRGBA8888
+};
+}
+
+#endif
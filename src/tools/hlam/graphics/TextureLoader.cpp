@@ -1,7 +1,9 @@
+#include <cstdint>
 #include <cstring>
 #include <vector>
 
 #include "graphics/Palette.hpp"
+#include "graphics/TextureConversion.hpp"
 #include "graphics/TextureLoader.hpp"
 
 namespace graphics
@@ -74,147 +76,126 @@ void TextureLoader::SetTextureFilters(TextureFilter minFilter, TextureFilter mag
 	}
 }
 
-void TextureLoader::UploadRGBA8888(GLuint texture, int width, int height, const byte* rgbaPixels, bool generateMipmaps, bool masked)
+RGBAImage TextureLoader::ConvertIndexed8(int width, int height, const byte* pixels, const byte* palette, bool masked) const
 {
-	const auto [newWidth, newHeight] = AdjustImageDimensions(width, height);
+	RGBAImage image{width, height};
 
-	std::vector<byte> pixels;
+	ExpandIndexed8(width, height, pixels, palette, masked, image.Pixels);
 
-	if (newWidth != width || newHeight != height)
+	if (ConversionBuffers buffers; ResizeRGBA8888(width, height, image.Pixels.data(), masked, buffers))
 	{
-		std::vector<int> col1, col2;
-		std::vector<int> row1, row2;
-		
-		col1.resize(newWidth);
-		col2.resize(newWidth);
-
-		row1.resize(newHeight);
-		row2.resize(newHeight);
+		return std::move(buffers.Resized);
+	}
 
-		for (int i = 0; i < newWidth; ++i)
-		{
-			col1[i] = (int)((i + 0.25) * (width / (float)newWidth));
-			col2[i] = (int)((i + 0.75) * (width / (float)newWidth));
-		}
+	return image;
+}
 
-		for (int i = 0; i < newHeight; ++i)
-		{
-			row1[i] = (int)((i + 0.25) * (height / (float)newHeight)) * width;
-			row2[i] = (int)((i + 0.75) * (height / (float)newHeight)) * width;
-		}
+std::pair<int, int> TextureLoader::AdjustImageDimensions(int width, int height) const
+{
+	if (!ShouldResizeToPowerOf2())
+	{
+		return {width, height};
+	}
 
-		pixels.resize(newWidth * newHeight * 4);
+	int newWidth, newHeight;
 
-		for (int i = 0; i < newHeight; ++i)
-		{
-			for (int j = 0; j < newWidth; ++j)
-			{
-				const auto pix1 = &rgbaPixels[(row1[i] + col1[j]) * 4];
-				const auto pix2 = &rgbaPixels[(row1[i] + col2[j]) * 4];
-				const auto pix3 = &rgbaPixels[(row2[i] + col1[j]) * 4];
-				const auto pix4 = &rgbaPixels[(row2[i] + col2[j]) * 4];
-
-				byte* const pixel = &pixels[((newWidth * i) + j) * 4];
-
-				for (int p = 0; p < 4; ++p)
-				{
-					pixel[p] = (pix1[p] + pix2[p] + pix3[p] + pix4[p]) / 4;
-				}
-
-				//If any of the sampled pixels are transparent the destination pixel is also transparent
-				if (masked && pixel[3] != 0xFF)
-				{
-					pixel[3] = 0x00;
-				}
-			}
-		}
+	for (newWidth = 1; newWidth > 0 && newWidth < width; newWidth <<= 1)
+	{
+	}
 
-		rgbaPixels = pixels.data();
+	for (newHeight = 1; newHeight > 0 && newHeight < height; newHeight <<= 1)
+	{
 	}
 
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, newWidth, newHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgbaPixels);
-	SetFilters(texture, generateMipmaps);
+	//If the initial dimensions exceed the largest power of 2 then it should be clamped to that value
+	if (newWidth < 0)
+	{
+		newWidth = 1 << 31;
+	}
 
-	if (generateMipmaps)
+	if (newHeight < 0)
 	{
-		glGenerateMipmap(GL_TEXTURE_2D);
+		newHeight = 1 << 31;
 	}
+
+	return {newWidth, newHeight};
 }
 
-void TextureLoader::UploadIndexed8(GLuint texture, int width, int height, const byte* pixels, const byte* palette, bool generateMipmaps, bool masked)
+void TextureLoader::ExpandIndexed8(int width, int height, const byte* pixels, const byte* palette, bool masked, std::vector<byte>& rgbaPixels) const
 {
 	//TODO: total size can be too large
-	byte localPalette[PALETTE_SIZE];
+	alignas(32) std::uint32_t rgbaPalette[PALETTE_ENTRIES];
 
-	memcpy(localPalette, palette, sizeof(localPalette));
+	for (std::size_t i = 0; i < PALETTE_ENTRIES; ++i)
+	{
+		const byte color[4]{palette[i * 3], palette[(i * 3) + 1], palette[(i * 3) + 2], 0xFF};
+		std::memcpy(&rgbaPalette[i], color, sizeof(color));
+	}
 
-	//Sets the mask color to black. This helps limit the bleedover effect caused by resizing and filtering
+	//For masked textures the last color in the table is the transparent color
+	//Pixels with that color are set to transparent black. Black helps limit the bleedover effect caused by resizing and filtering
 	if (masked)
 	{
-		localPalette[255 * 3 + 0] = localPalette[255 * 3 + 1] = localPalette[255 * 3 + 2] = 0;
+		rgbaPalette[255] = 0;
 	}
 
-	std::vector<byte> rgbaPixels;
-
 	rgbaPixels.resize(width * height * 4);
 
-	for (int i = 0; i < (width * height); ++i)
-	{
-		for (int c = 0; c < 3; ++c)
-		{
-			rgbaPixels[(i * 4) + c] = localPalette[(pixels[i] * 3) + c];
-		}
-
-		//For masked textures the last color in the table is the transparent color
-		//Pixels with that color have their alpha value set to 0 to appear transparent
-		if (masked && pixels[i] == 255)
-		{
-			rgbaPixels[(i * 4) + 3] = 0x00;
-		}
-		else
-		{
-			rgbaPixels[(i * 4) + 3] = 0xFF;
-		}
-	}
-
-	UploadRGBA8888(texture, width, height, rgbaPixels.data(), generateMipmaps, masked);
+	graphics::ExpandIndexed8(pixels, rgbaPalette, rgbaPixels.data(), width * height);
 }
 
-void TextureLoader::SetFilters(GLuint texture, bool hasMipmaps)
+bool TextureLoader::ResizeRGBA8888(int width, int height, const byte* rgbaPixels, bool masked, ConversionBuffers& buffers) const
 {
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, hasMipmaps ? _glMinFilter : _glMagFilter);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _glMagFilter);
-}
+	const auto [newWidth, newHeight] = AdjustImageDimensions(width, height);
 
-std::pair<int, int> TextureLoader::AdjustImageDimensions(int width, int height) const
-{
-	if (!ShouldResizeToPowerOf2())
+	if (newWidth == width && newHeight == height)
 	{
-		return {width, height};
+		return false;
 	}
 
-	int newWidth, newHeight;
+	auto& columns = buffers.Columns;
+	auto& rows = buffers.Rows;
 
-	for (newWidth = 1; newWidth > 0 && newWidth < width; newWidth <<= 1)
-	{
-	}
+	columns[0].resize(newWidth);
+	columns[1].resize(newWidth);
 
-	for (newHeight = 1; newHeight > 0 && newHeight < height; newHeight <<= 1)
+	rows[0].resize(newHeight);
+	rows[1].resize(newHeight);
+
+	for (int i = 0; i < newWidth; ++i)
 	{
+		columns[0][i] = (int)((i + 0.25) * (width / (float)newWidth));
+		columns[1][i] = (int)((i + 0.75) * (width / (float)newWidth));
 	}
 
-	//If the initial dimensions exceed the largest power of 2 then it should be clamped to that value
-	if (newWidth < 0)
+	for (int i = 0; i < newHeight; ++i)
 	{
-		newWidth = 1 << 31;
+		rows[0][i] = (int)((i + 0.25) * (height / (float)newHeight));
+		rows[1][i] = (int)((i + 0.75) * (height / (float)newHeight));
 	}
 
-	if (newHeight < 0)
+	RGBAImage& resized = buffers.Resized;
+
+	resized.Width = newWidth;
+	resized.Height = newHeight;
+
+	std::vector<byte>& pixels = resized.Pixels;
+
+	pixels.resize(newWidth * newHeight * 4);
+
+	const int* const columnData[2]{columns[0].data(), columns[1].data()};
+
+	for (int i = 0; i < newHeight; ++i)
 	{
-		newHeight = 1 << 31;
+		const byte* const sourceRows[2]
+		{
+			rgbaPixels + (rows[0][i] * width * 4),
+			rgbaPixels + (rows[1][i] * width * 4)
+		};
+
+		BoxFilterRowRGBA8888(sourceRows, columnData, masked, &pixels[newWidth * i * 4], newWidth);
 	}
 
-	return {newWidth, newHeight};
+	return true;
 }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <utility>
+#include <vector>
 
 #include <GL/glew.h>
 
@@ -27,6 +29,16 @@ enum class MipmapFilter
 	Last = Linear
 };
 
+/**
+*	@brief 32 bit RGBA image that is ready to be uploaded
+*/
+struct RGBAImage
+{
+	int Width = 0;
+	int Height = 0;
+	std::vector<byte> Pixels;
+};
+
 class TextureLoader final
 {
 public:
@@ -48,15 +60,84 @@ public:
 		_resizeToPowerOf2 = value;
 	}
 
+	/**
+	*	@brief Whether indexed images should be uploaded as an index texture and a palette texture
+	*	instead of being converted to RGBA. Requires a shader that performs the palette lookup.
+	*/
+	bool ShouldCreateIndexedTextures() const { return _createIndexedTextures; }
+
+	void SetCreateIndexedTextures(bool value)
+	{
+		_createIndexedTextures = value;
+	}
+
 	void UploadRGBA8888(GLuint texture, int width, int height, const byte* rgbaPixels, bool generateMipmaps, bool masked);
 
 	void UploadIndexed8(GLuint texture, int width, int height, const byte* pixels, const byte* palette, bool generateMipmaps, bool masked);
 
+	/**
+	*	@brief Converts an indexed image to RGBA and resizes it the same way UploadIndexed8 does.
+	*	Does not use OpenGL so it can be called on any thread, provided the loader's settings are not changed at the same time.
+	*/
+	RGBAImage ConvertIndexed8(int width, int height, const byte* pixels, const byte* palette, bool masked) const;
+
+	/**
+	*	@brief Uploads an image created by ConvertIndexed8 using the same settings.
+	*/
+	void UploadImage(GLuint texture, const RGBAImage& image, bool generateMipmaps);
+
+	/**
+	*	@brief Uploads the palette indices of an indexed image as a single channel texture.
+	*	The texture is not resized and always uses point filtering, filtering is performed after the palette lookup.
+	*/
+	void UploadIndices(GLuint texture, int width, int height, const byte* pixels);
+
+	/**
+	*	@brief Uploads a palette as a 256x1 RGBA texture for use with a texture created by UploadIndices.
+	*	@param masked If true the last color is transparent
+	*/
+	void UploadPalette(GLuint texture, const byte* palette, bool masked);
+
 	void SetFilters(GLuint texture, bool hasMipmaps);
 
+	/**
+	*	@brief Deletes the buffer used to stream pixel data to the GPU. Must be called while the context that uploaded textures is current.
+	*/
+	void ReleaseUploadBuffer();
+
 private:
+	/**
+	*	@brief Memory used while converting images. Kept between uploads so uploading does not allocate every time.
+	*/
+	struct ConversionBuffers
+	{
+		std::vector<byte> Pixels;
+		RGBAImage Resized;
+		std::vector<int> Columns[2];
+		std::vector<int> Rows[2];
+	};
+
 	std::pair<int, int> AdjustImageDimensions(int width, int height) const;
 
+	void ExpandIndexed8(int width, int height, const byte* pixels, const byte* palette, bool masked, std::vector<byte>& rgbaPixels) const;
+
+	/**
+	*	@brief Resizes an image if needed
+	*	@return Whether the image was resized into buffers.Resized. If not, buffers are left unchanged
+	*/
+	bool ResizeRGBA8888(int width, int height, const byte* rgbaPixels, bool masked, ConversionBuffers& buffers) const;
+
+	void Upload(GLuint texture, int width, int height, const byte* rgbaPixels, bool generateMipmaps);
+
+	/**
+	*	@brief Copies pixel data into the pixel unpack buffer if supported so the texture upload does not block.
+	*	Must be followed by EndUpload after the data has been passed to OpenGL.
+	*	@return Pointer to pass to glTexImage2D
+	*/
+	const void* BeginUpload(const void* pixels, std::size_t size);
+
+	void EndUpload();
+
 private:
 	TextureFilter _minFilter{TextureFilter::Linear};
 	TextureFilter _magFilter{TextureFilter::Linear};
@@ -66,5 +147,10 @@ private:
 	GLint _glMagFilter;
 
 	bool _resizeToPowerOf2{true};
+	bool _createIndexedTextures{false};
+
+	ConversionBuffers _buffers;
+
+	GLuint _uploadBuffer = 0;
 };
 }
@@ -0,0 +1,132 @@
+#include <cstddef>
+#include <cstring>
+
+#include "graphics/Palette.hpp"
+#include "graphics/TextureLoader.hpp"
+
+namespace graphics
+{
+void TextureLoader::UploadRGBA8888(GLuint texture, int width, int height, const byte* rgbaPixels, bool generateMipmaps, bool masked)
+{
+	if (ResizeRGBA8888(width, height, rgbaPixels, masked, _buffers))
+	{
+		UploadImage(texture, _buffers.Resized, generateMipmaps);
+	}
+	else
+	{
+		Upload(texture, width, height, rgbaPixels, generateMipmaps);
+	}
+}
+
+void TextureLoader::UploadIndexed8(GLuint texture, int width, int height, const byte* pixels, const byte* palette, bool generateMipmaps, bool masked)
+{
+	ExpandIndexed8(width, height, pixels, palette, masked, _buffers.Pixels);
+
+	UploadRGBA8888(texture, width, height, _buffers.Pixels.data(), generateMipmaps, masked);
+}
+
+void TextureLoader::UploadImage(GLuint texture, const RGBAImage& image, bool generateMipmaps)
+{
+	Upload(texture, image.Width, image.Height, image.Pixels.data(), generateMipmaps);
+}
+
+void TextureLoader::UploadIndices(GLuint texture, int width, int height, const byte* pixels)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	//Rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE,
+		BeginUpload(pixels, static_cast<std::size_t>(width) * height));
+	EndUpload();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void TextureLoader::UploadPalette(GLuint texture, const byte* palette, bool masked)
+{
+	byte rgbaPalette[PALETTE_ENTRIES * 4];
+
+	for (std::size_t i = 0; i < PALETTE_ENTRIES; ++i)
+	{
+		for (std::size_t c = 0; c < PALETTE_CHANNELS; ++c)
+		{
+			rgbaPalette[(i * 4) + c] = palette[(i * PALETTE_CHANNELS) + c];
+		}
+
+		rgbaPalette[(i * 4) + 3] = 0xFF;
+	}
+
+	//Matches ConvertIndexed8: the mask color is transparent black
+	if (masked)
+	{
+		std::memset(&rgbaPalette[255 * 4], 0, 4);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(PALETTE_ENTRIES), 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgbaPalette);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void TextureLoader::SetFilters(GLuint texture, bool hasMipmaps)
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, hasMipmaps ? _glMinFilter : _glMagFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _glMagFilter);
+}
+
+void TextureLoader::Upload(GLuint texture, int width, int height, const byte* rgbaPixels, bool generateMipmaps)
+{
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+		BeginUpload(rgbaPixels, static_cast<std::size_t>(width) * height * 4));
+	EndUpload();
+	SetFilters(texture, generateMipmaps);
+
+	if (generateMipmaps)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+}
+
+const void* TextureLoader::BeginUpload(const void* pixels, std::size_t size)
+{
+	if (!GLEW_VERSION_2_1)
+	{
+		return pixels;
+	}
+
+	if (_uploadBuffer == 0)
+	{
+		glGenBuffers(1, &_uploadBuffer);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadBuffer);
+
+	//Orphan the previous contents so the driver can keep transferring them while the new data is copied
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, pixels);
+
+	//Offset into the buffer
+	return nullptr;
+}
+
+void TextureLoader::EndUpload()
+{
+	if (_uploadBuffer != 0)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+}
+
+void TextureLoader::ReleaseUploadBuffer()
+{
+	if (_uploadBuffer != 0)
+	{
+		glDeleteBuffers(1, &_uploadBuffer);
+		_uploadBuffer = 0;
+	}
+}
+}
@@ -17,6 +17,8 @@ public:
 
 	void PlaySound(std::string_view, float, int) override {}
 
+	PrecacheResult PrecacheSound(std::string_view) override { return PrecacheResult::LoadFailed; }
+
 	void StopAllSounds() override {}
 };
 }
@@ -17,6 +17,21 @@ class IFileSystem;
 
 namespace soundsystem
 {
+enum class PrecacheResult
+{
+	Loaded,
+
+	/**
+	*	The file does not exist
+	*/
+	NotFound,
+
+	/**
+	*	The file exists but could not be read or decoded
+	*/
+	LoadFailed
+};
+
 /**
 *	A sound system that can be used to play back sounds. Sounds are non-looping.
 */
@@ -54,6 +69,13 @@ public:
 	*/
 	virtual void PlaySound(std::string_view fileName, float volume, int pitch) = 0;
 
+	/**
+	*	@brief Loads a sound ahead of time so it plays without delay the first time it is played.
+	*	Precaching does not count towards the cache's hit and miss statistics.
+	*	@param fileName Sound filename, as passed to PlaySound.
+	*/
+	virtual PrecacheResult PrecacheSound(std::string_view fileName) = 0;
+
 	/**
 	*	Stops all sounds that are currently playing.
 	*/
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <utility>
+
+#include "vorbis/vorbisfile.h"
+
+#include "core/shared/Logging.hpp"
+
+#include "soundsystem/OggVorbisStream.hpp"
+
+#include "utility/ByteSwap.hpp"
+
+namespace soundsystem
+{
+void OggVorbisFileDeleter::operator()(OggVorbis_File* file) const
+{
+	ov_clear(file);
+	delete file;
+}
+
+OggVorbisFilePtr OpenOggVorbisFile(const std::string& fileName)
+{
+	auto file = std::make_unique<OggVorbis_File>();
+
+	//The file is cleaned up by ov_fopen if it fails
+	if (ov_fopen(fileName.c_str(), file.get()) != 0)
+	{
+		return {};
+	}
+
+	return OggVorbisFilePtr{file.release()};
+}
+
+std::int64_t GetOggVorbisDecodedSize(OggVorbis_File& file)
+{
+	const auto pcmTotal = ov_pcm_total(&file, -1);
+
+	if (pcmTotal < 0)
+	{
+		return -1;
+	}
+
+	return pcmTotal * ov_info(&file, -1)->channels * 2;
+}
+
+long DecodeOggVorbis(OggVorbis_File& file, std::uint8_t* data, std::size_t size)
+{
+	const int bigEndian = ByteSwap<>::IsLittleEndian() ? 0 : 1;
+
+	std::size_t offset = 0;
+	int bitStream = 0;
+
+	while (offset < size)
+	{
+		const long result = ov_read(&file, reinterpret_cast<char*>(data + offset),
+			static_cast<int>(std::min<std::size_t>(size - offset, 4096)), bigEndian, 2, 1, &bitStream);
+
+		//Interruptions in the data are skipped, decoding continues after them
+		if (result == OV_HOLE)
+		{
+			continue;
+		}
+
+		if (result < 0)
+		{
+			return result;
+		}
+
+		if (result == 0)
+		{
+			break;
+		}
+
+		offset += static_cast<std::size_t>(result);
+	}
+
+	return static_cast<long>(offset);
+}
+
+OggVorbisStream::OggVorbisStream(std::string fileName, OggVorbisFilePtr&& file)
+	: _fileName(std::move(fileName))
+	, _file(std::move(file))
+{
+	const auto info = ov_info(_file.get(), -1);
+
+	_format = info->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+	_sampleRate = static_cast<ALsizei>(info->rate);
+
+	alGenBuffers(static_cast<ALsizei>(_buffers.size()), _buffers.data());
+
+	_freeBuffers.assign(_buffers.begin(), _buffers.end());
+}
+
+OggVorbisStream::~OggVorbisStream()
+{
+	{
+		std::lock_guard lock{_mutex};
+		_stopping = true;
+	}
+
+	_condition.notify_all();
+
+	if (_decodeThread.joinable())
+	{
+		_decodeThread.join();
+	}
+
+	//The source has been stopped and its buffers unqueued by now
+	alDeleteBuffers(static_cast<ALsizei>(_buffers.size()), _buffers.data());
+}
+
+bool OggVorbisStream::Start(ALuint source)
+{
+	std::vector<std::uint8_t> chunk;
+
+	const long result = DecodeChunk(chunk);
+
+	if (result <= 0)
+	{
+		Error("OggVorbisStream::Start: Error while reading file \"%s\" (%ld)\n", _fileName.c_str(), result);
+		return false;
+	}
+
+	const bool endOfStream = result < static_cast<long>(ChunkSize);
+
+	_decodedChunks.push_back(std::move(chunk));
+	_endOfStream = endOfStream;
+
+	QueueDecodedChunks(source);
+
+	//Sounds that fit in a single chunk don't need to be decoded any further
+	if (!endOfStream)
+	{
+		_decodeThread = std::thread(&OggVorbisStream::DecodeMain, this);
+	}
+
+	return true;
+}
+
+bool OggVorbisStream::Update(ALuint source)
+{
+	ALint processed = 0;
+	alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+
+	for (; processed > 0; --processed)
+	{
+		ALuint buffer = 0;
+		alSourceUnqueueBuffers(source, 1, &buffer);
+		_freeBuffers.push_back(buffer);
+	}
+
+	QueueDecodedChunks(source);
+
+	bool isDecoding;
+	long error;
+
+	{
+		std::lock_guard lock{_mutex};
+		isDecoding = !_endOfStream || !_decodedChunks.empty();
+		error = _error;
+	}
+
+	if (error < 0 && !_errorReported)
+	{
+		_errorReported = true;
+		Error("OggVorbisStream::Update: Error while reading file \"%s\" (%ld)\n", _fileName.c_str(), error);
+	}
+
+	ALint state = AL_STOPPED;
+	alGetSourcei(source, AL_SOURCE_STATE, &state);
+
+	if (state == AL_PLAYING)
+	{
+		return true;
+	}
+
+	ALint queued = 0;
+	alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+
+	if (queued > 0)
+	{
+		//The source ran out of buffers before the decoder caught up, continue where it stopped
+		alSourcePlay(source);
+		return true;
+	}
+
+	return isDecoding;
+}
+
+void OggVorbisStream::DecodeMain()
+{
+	while (true)
+	{
+		{
+			std::unique_lock lock{_mutex};
+
+			//Stay at most one chunk per buffer ahead of playback
+			_condition.wait(lock, [this] { return _stopping || _decodedChunks.size() < BufferCount; });
+
+			if (_stopping)
+			{
+				return;
+			}
+		}
+
+		std::vector<std::uint8_t> chunk;
+
+		const long result = DecodeChunk(chunk);
+
+		std::lock_guard lock{_mutex};
+
+		if (!chunk.empty())
+		{
+			_decodedChunks.push_back(std::move(chunk));
+		}
+
+		if (result < static_cast<long>(ChunkSize))
+		{
+			_endOfStream = true;
+			_error = std::min(result, 0L);
+			return;
+		}
+	}
+}
+
+long OggVorbisStream::DecodeChunk(std::vector<std::uint8_t>& chunk)
+{
+	chunk.resize(ChunkSize);
+
+	const long result = DecodeOggVorbis(*_file, chunk.data(), chunk.size());
+
+	chunk.resize(static_cast<std::size_t>(std::max(result, 0L)));
+
+	return result;
+}
+
+void OggVorbisStream::QueueDecodedChunks(ALuint source)
+{
+	std::unique_lock lock{_mutex};
+
+	while (!_freeBuffers.empty() && !_decodedChunks.empty())
+	{
+		const auto chunk = std::move(_decodedChunks.front());
+		_decodedChunks.pop_front();
+
+		lock.unlock();
+		_condition.notify_one();
+
+		const ALuint buffer = _freeBuffers.back();
+		_freeBuffers.pop_back();
+
+		alBufferData(buffer, _format, chunk.data(), static_cast<ALsizei>(chunk.size()), _sampleRate);
+		alSourceQueueBuffers(source, 1, &buffer);
+
+		lock.lock();
+	}
+}
+}
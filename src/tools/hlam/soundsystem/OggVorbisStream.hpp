@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <al.h>
+
+struct OggVorbis_File;
+
+namespace soundsystem
+{
+struct OggVorbisFileDeleter
+{
+	void operator()(OggVorbis_File* file) const;
+};
+
+using OggVorbisFilePtr = std::unique_ptr<OggVorbis_File, OggVorbisFileDeleter>;
+
+/**
+*	@brief Opens an Ogg Vorbis file for decoding.
+*	@return The file, or null if it could not be opened.
+*/
+OggVorbisFilePtr OpenOggVorbisFile(const std::string& fileName);
+
+/**
+*	@brief Gets the size of the file's samples once decoded to 16 bit, or -1 if the size is unknown.
+*/
+std::int64_t GetOggVorbisDecodedSize(OggVorbis_File& file);
+
+/**
+*	@brief Decodes up to size bytes of 16 bit samples in native byte order.
+*	@return Number of bytes decoded, 0 at the end of the stream or a negative error code.
+*/
+long DecodeOggVorbis(OggVorbis_File& file, std::uint8_t* data, std::size_t size);
+
+/**
+*	@brief Plays an Ogg Vorbis file through a small ring of OpenAL buffers queued on a source.
+*	A background thread decodes the file in chunks a few buffers ahead of playback,
+*	so playback starts as soon as the first chunk is decoded and the file is never fully in memory.
+*	All member functions must be called on the thread that owns the OpenAL context.
+*/
+class OggVorbisStream final
+{
+public:
+	static constexpr std::size_t BufferCount = 4;
+
+	/**
+	*	Size of each decoded chunk. About a third of a second of 44.1 KHz stereo audio.
+	*/
+	static constexpr std::size_t ChunkSize = 64 * 1024;
+
+	/**
+	*	@brief Takes ownership of file. The file must not be used by the caller afterwards.
+	*/
+	OggVorbisStream(std::string fileName, OggVorbisFilePtr&& file);
+	~OggVorbisStream();
+
+	OggVorbisStream(const OggVorbisStream&) = delete;
+	OggVorbisStream& operator=(const OggVorbisStream&) = delete;
+
+	/**
+	*	@brief Decodes the first chunk, queues it on source and starts decoding the rest in the background.
+	*	The source must not have a buffer attached to it. The caller starts playback.
+	*	@return Whether the first chunk could be queued.
+	*/
+	bool Start(ALuint source);
+
+	/**
+	*	@brief Requeues buffers that have finished playing with newly decoded chunks.
+	*	Restarts playback if the source ran out of buffers before the decoder could catch up.
+	*	@return Whether the stream is still playing.
+	*/
+	bool Update(ALuint source);
+
+private:
+	void DecodeMain();
+
+	/**
+	*	@brief Decodes the next chunk. Fewer than ChunkSize bytes are decoded only at the end of the stream.
+	*	@return Number of bytes decoded or a negative error code.
+	*/
+	long DecodeChunk(std::vector<std::uint8_t>& chunk);
+
+	/**
+	*	@brief Queues decoded chunks on the buffers that are not queued on the source.
+	*/
+	void QueueDecodedChunks(ALuint source);
+
+private:
+	const std::string _fileName;
+	const OggVorbisFilePtr _file;
+
+	ALenum _format = AL_NONE;
+	ALsizei _sampleRate = 0;
+
+	std::array<ALuint, BufferCount> _buffers{};
+	std::vector<ALuint> _freeBuffers;
+
+	std::thread _decodeThread;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+
+	//Accessed by both threads while holding _mutex
+	std::deque<std::vector<std::uint8_t>> _decodedChunks;
+	bool _endOfStream = false;
+	long _error = 0;
+	bool _stopping = false;
+
+	bool _errorReported = false;
+};
+}
@@ -0,0 +1,82 @@
+#include "soundsystem/SoundBufferCache.hpp"
+
+namespace soundsystem
+{
+std::shared_ptr<SoundBuffer> SoundBufferCache::Find(const assets::FileIdentity& file, bool recordStats)
+{
+	if (auto it = _entries.find(file.Path); it != _entries.end())
+	{
+		const auto& entry = it->second;
+
+		if (entry.File.Size == file.Size && entry.File.ModifiedTime == file.ModifiedTime)
+		{
+			if (recordStats)
+			{
+				++_stats.Hits;
+			}
+
+			_lru.splice(_lru.begin(), _lru, entry.LRUPosition);
+			return entry.Buffer;
+		}
+
+		//The file has changed since it was decoded
+		Remove(it);
+	}
+
+	if (recordStats)
+	{
+		++_stats.Misses;
+	}
+
+	return {};
+}
+
+void SoundBufferCache::Add(const assets::FileIdentity& file, const std::shared_ptr<SoundBuffer>& buffer)
+{
+	if (!buffer || buffer->Bytes > _memoryBudget)
+	{
+		return;
+	}
+
+	if (auto it = _entries.find(file.Path); it != _entries.end())
+	{
+		Remove(it);
+	}
+
+	_memoryUsage += buffer->Bytes;
+
+	_lru.push_front(file.Path);
+	_entries.emplace(file.Path, Entry{file, buffer, _lru.begin()});
+
+	EvictToBudget(file.Path);
+}
+
+void SoundBufferCache::Clear()
+{
+	_entries.clear();
+	_lru.clear();
+	_memoryUsage = 0;
+}
+
+void SoundBufferCache::SetMemoryBudget(std::size_t budget)
+{
+	_memoryBudget = budget;
+	EvictToBudget({});
+}
+
+void SoundBufferCache::Remove(std::unordered_map<std::string, Entry>::iterator it)
+{
+	_memoryUsage -= it->second.Buffer->Bytes;
+	_lru.erase(it->second.LRUPosition);
+	_entries.erase(it);
+}
+
+void SoundBufferCache::EvictToBudget(const std::string& pathToKeep)
+{
+	while (_memoryUsage > _memoryBudget && !_lru.empty() && _lru.back() != pathToKeep)
+	{
+		++_stats.Evictions;
+		Remove(_entries.find(_lru.back()));
+	}
+}
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <al.h>
+
+#include "assets/ResourceCache.hpp"
+
+namespace soundsystem
+{
+/**
+*	@brief OpenAL buffer holding a decoded sound.
+*	Shared between the cache and the sources playing it, so evicting a sound that is still playing does not cut it off.
+*/
+struct SoundBuffer final
+{
+	SoundBuffer()
+	{
+		alGenBuffers(1, &Buffer);
+	}
+
+	~SoundBuffer()
+	{
+		alDeleteBuffers(1, &Buffer);
+	}
+
+	SoundBuffer(const SoundBuffer&) = delete;
+	SoundBuffer& operator=(const SoundBuffer&) = delete;
+
+	ALuint Buffer = 0;
+
+	/**
+	*	Size of the decoded data.
+	*/
+	std::size_t Bytes = 0;
+};
+
+struct SoundBufferCacheStats
+{
+	std::size_t Hits = 0;
+	std::size_t Misses = 0;
+	std::size_t Evictions = 0;
+};
+
+/**
+*	@brief Keeps decoded sounds around within a memory budget so sounds that are played repeatedly are only decoded once.
+*	Sounds are identified by file, so changes to a file on disk are picked up the next time it is played.
+*	The least recently played sounds are evicted first.
+*	Must be cleared before the OpenAL context is destroyed.
+*/
+class SoundBufferCache final
+{
+public:
+	static constexpr std::size_t DefaultMemoryBudget = 32 * 1024 * 1024;
+
+	SoundBufferCache() = default;
+	~SoundBufferCache() = default;
+
+	SoundBufferCache(const SoundBufferCache&) = delete;
+	SoundBufferCache& operator=(const SoundBufferCache&) = delete;
+
+	/**
+	*	@brief Gets the buffer for a file if it is in the cache and the file has not changed since it was added.
+	*	@param recordStats Whether the lookup counts as a hit or miss. Lookups made ahead of playback should not be counted.
+	*/
+	std::shared_ptr<SoundBuffer> Find(const assets::FileIdentity& file, bool recordStats = true);
+
+	/**
+	*	@brief Adds a buffer, evicting other buffers if needed. Buffers larger than the budget are not added.
+	*/
+	void Add(const assets::FileIdentity& file, const std::shared_ptr<SoundBuffer>& buffer);
+
+	/**
+	*	@brief Releases all buffers. Buffers that are still playing are freed once they finish.
+	*/
+	void Clear();
+
+	std::size_t GetMemoryBudget() const { return _memoryBudget; }
+
+	void SetMemoryBudget(std::size_t budget);
+
+	std::size_t GetMemoryUsage() const { return _memoryUsage; }
+
+	const SoundBufferCacheStats& GetStats() const { return _stats; }
+
+private:
+	struct Entry
+	{
+		assets::FileIdentity File;
+		std::shared_ptr<SoundBuffer> Buffer;
+		std::list<std::string>::iterator LRUPosition;
+	};
+
+	void Remove(std::unordered_map<std::string, Entry>::iterator it);
+
+	void EvictToBudget(const std::string& pathToKeep);
+
+private:
+	std::size_t _memoryBudget = DefaultMemoryBudget;
+	std::size_t _memoryUsage = 0;
+
+	SoundBufferCacheStats _stats;
+
+	/**
+	*	@brief Keyed by file path. The entry's identity is checked to detect modified files.
+	*/
+	std::unordered_map<std::string, Entry> _entries;
+
+	/**
+	*	@brief File paths, most recently used first.
+	*/
+	std::list<std::string> _lru;
+};
+}
@@ -2,18 +2,21 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <filesystem>
 #include <sstream>
 #include <vector>
 
-#include "AudioFile/AudioFile.h"
-
 #include "vorbis/vorbisfile.h"
 
+#include "assets/ResourceCache.hpp"
+
 #include "filesystem/IFileSystem.hpp"
 
 #include "core/shared/Logging.hpp"
 
+#include "soundsystem/OggVorbisStream.hpp"
 #include "soundsystem/SoundSystem.hpp"
+#include "soundsystem/WaveFile.hpp"
 
 namespace soundsystem
 {
@@ -36,168 +39,81 @@ bool _CheckALErrors(const char* file, int line)
 
 #define CheckALErrors() _CheckALErrors(__FILE__, __LINE__)
 
-static ALenum BufferFormat(const AudioFile<double>& file)
+static ALenum BufferFormat(const PCMFormat& format)
 {
-	switch (file.getBitDepth())
+	switch (format.BitsPerSample)
 	{
-	case 8: return file.isStereo() ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
-	case 16: return file.isStereo() ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+	case 8: return format.Channels == 2 ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
+	case 16: return format.Channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
 	default: return AL_INVALID;
 	}
 }
 
-struct DataConverter8Bit
-{
-	using Type = std::int8_t;
-
-	static Type Convert(double value)
-	{
-		value = (value + 1.) / 2.;
-		return static_cast<uint8_t> (value * 255.);
-	}
-};
-
-struct DataConverter16Bit
-{
-	using Type = std::int16_t;
-
-	static Type Convert(double value)
-	{
-		value = std::clamp(value, -1., 1.);
-		return static_cast<int16_t> (value * 32767.);
-	}
-};
-
-template<typename T>
-void ConvertToAL(const AudioFile<double>& file, std::vector<std::uint8_t>& data)
-{
-	std::size_t byteIndex = 0;
-
-	for (int i = 0; i < file.getNumSamplesPerChannel(); ++i)
-	{
-		for (int channel = 0; channel < file.getNumChannels(); ++channel)
-		{
-			auto& dest = *reinterpret_cast<typename T::Type*>(&data[byteIndex]);
-
-			auto value = file.samples[channel][i];
-
-			dest = T::Convert(value);
-
-			byteIndex += sizeof(typename T::Type);
-		}
-	}
-}
-
-std::unique_ptr<SoundSystem::Sound> TryLoadWaveFile(const std::string& fileName)
+std::shared_ptr<SoundBuffer> TryLoadWaveFile(const std::string& fileName)
 {
-	AudioFile<double> file;
+	const auto wave = LoadWaveFile(fileName);
 
-	if (!file.load(fileName))
+	if (!wave)
 	{
 		return {};
 	}
 
-	if (file.getBitDepth() != 8 && file.getBitDepth() != 16)
-	{
-		return {};
-	}
-
-	std::vector<std::uint8_t> data;
-
-	data.resize(file.getNumChannels() * file.getNumSamplesPerChannel() * (file.getBitDepth() / 8));
-
-	switch (file.getBitDepth())
-	{
-	case 8:
-		ConvertToAL<DataConverter8Bit>(file, data);
-		break;
-
-	case 16:
-		ConvertToAL<DataConverter16Bit>(file, data);
-		break;
-
-	default: return {};
-	}
-
-	const auto format = BufferFormat(file);
-
-	auto sound = std::make_unique<SoundSystem::Sound>();
+	auto buffer = std::make_shared<SoundBuffer>();
 
-	alBufferData(sound->buffer, format, data.data(), data.size(), file.getSampleRate());
+	alBufferData(buffer->Buffer, BufferFormat(wave->Format), wave->Samples, static_cast<ALsizei>(wave->Size), wave->Format.SampleRate);
 
 	if (CheckALErrors())
 	{
 		return {};
 	}
 
-	return sound;
-}
+	buffer->Bytes = wave->Size;
 
-struct OggVorbisCleanup
-{
-	void operator()(OggVorbis_File* pointer) const
-	{
-		ov_clear(pointer);
-	}
-};
+	return buffer;
+}
 
-std::unique_ptr<SoundSystem::Sound> TryLoadOggVorbis(const std::string& fileName)
+std::shared_ptr<SoundBuffer> TryLoadOggVorbis(const std::string& fileName, OggVorbis_File& file)
 {
-	OggVorbis_File vorbisData{};
-
-	auto result = ov_fopen(fileName.c_str(), &vorbisData);
-
-	if (result)
-	{
-		return {};
-	}
-
-	const std::unique_ptr<OggVorbis_File, OggVorbisCleanup> cleanup(&vorbisData);
-
-	const auto info = ov_info(&vorbisData, -1);
+	const auto info = ov_info(&file, -1);
 
 	const ALenum format = info->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
 
-	const auto pcmTotal = ov_pcm_total(&vorbisData, -1);
-
-	const ogg_int64_t sizeInBytes = pcmTotal * info->channels * 2;
+	const auto sizeInBytes = GetOggVorbisDecodedSize(file);
 
 	std::vector<std::uint8_t> data;
 
-	if (sizeInBytes > data.max_size())
+	if (sizeInBytes < 0 || static_cast<std::uint64_t>(sizeInBytes) > data.max_size())
 	{
-		Error("CSoundSystem::TryLoadOggVorbis: File \"%s\" is too large to read (%dll > %u)\n", fileName.c_str(), sizeInBytes, data.max_size());
+		Error("CSoundSystem::TryLoadOggVorbis: File \"%s\" is too large to read (%lld > %zu)\n",
+			fileName.c_str(), static_cast<long long>(sizeInBytes), data.max_size());
 		return {};
 	}
 
 	data.resize(static_cast<std::size_t>(sizeInBytes));
 
-	long size = 0;
-	int bitStream = 0;
-
-	for (std::size_t offset = 0;
-		(size = ov_read(&vorbisData, (char*)data.data() + offset, 4096, 0, 2, 1, &bitStream)) > 0;
-		offset += size)
-	{
-	}
+	const long size = DecodeOggVorbis(file, data.data(), data.size());
 
 	//An error occurred while reading
 	if (size < 0)
 	{
-		Error("CSoundSystem::TryLoadOggVorbis: Error while reading file \"%s\" (%dl)\n", fileName.c_str(), size);
+		Error("CSoundSystem::TryLoadOggVorbis: Error while reading file \"%s\" (%ld)\n", fileName.c_str(), size);
 		return {};
 	}
 
-	auto sound = std::make_unique<SoundSystem::Sound>();
+	data.resize(static_cast<std::size_t>(size));
 
-	alBufferData(sound->buffer, format, data.data(), data.size(), info->rate);
+	auto buffer = std::make_shared<SoundBuffer>();
+
+	alBufferData(buffer->Buffer, format, data.data(), static_cast<ALsizei>(data.size()), info->rate);
 
 	if (CheckALErrors())
 	{
 		return {};
 	}
 
-	return sound;
+	buffer->Bytes = data.size();
+
+	return buffer;
 }
 
 SoundSystem::SoundSystem() = default;
@@ -226,6 +142,24 @@ bool SoundSystem::Initialize(filesystem::IFileSystem* filesystem)
 		alcMakeContextCurrent(_context);
 
 		CheckALErrors();
+
+		std::array<ALuint, MAX_SOUNDS> sources{};
+
+		alGenSources(static_cast<ALsizei>(sources.size()), sources.data());
+
+		//Sounds can't be played without sources, but everything else still works
+		if (CheckALErrors())
+		{
+			Error("SoundSystem::Initialize: Could not create %zu sources\n", sources.size());
+		}
+		else
+		{
+			for (size_t i = 0; i < MAX_SOUNDS; ++i)
+			{
+				_sounds[i].source = sources[i];
+				FreeSound(_sounds[i]);
+			}
+		}
 	}
 
 	return true;
@@ -235,6 +169,30 @@ void SoundSystem::Shutdown()
 {
 	StopAllSounds();
 
+	if (const auto& stats = _bufferCache.GetStats(); stats.Hits > 0 || stats.Misses > 0)
+	{
+		Message("Sound buffer cache: %zu hits, %zu misses, %zu evictions\n", stats.Hits, stats.Misses, stats.Evictions);
+	}
+
+	//All sources are in the free list now, unless none could be created
+	if (_freeSounds)
+	{
+		std::array<ALuint, MAX_SOUNDS> sources{};
+
+		for (size_t i = 0; i < MAX_SOUNDS; ++i)
+		{
+			sources[i] = _sounds[i].source;
+			_sounds[i] = {};
+		}
+
+		alDeleteSources(static_cast<ALsizei>(sources.size()), sources.data());
+
+		_freeSounds = nullptr;
+	}
+
+	//Buffers must be deleted while the context still exists
+	_bufferCache.Clear();
+
 	if (_context)
 	{
 		alcMakeContextCurrent(nullptr);
@@ -251,26 +209,33 @@ void SoundSystem::Shutdown()
 
 void SoundSystem::RunFrame()
 {
-	size_t uiIndex = 0;
-
-	ALint isPlaying;
+	ALint state;
 
-	for (auto& sound : _sounds)
+	//Only sounds that are playing are checked
+	for (auto sound = _newestSound; sound;)
 	{
-		++uiIndex;
+		const auto next = sound->next;
+
+		bool isPlaying;
 
-		if (!sound)
+		if (sound->stream)
 		{
-			continue;
+			//Streams keep playing until the whole file has been played, even if the source ran out of buffers
+			isPlaying = sound->stream->Update(sound->source);
+		}
+		else
+		{
+			alGetSourcei(sound->source, AL_SOURCE_STATE, &state);
+			isPlaying = state == AL_PLAYING;
 		}
 
-		alGetSourcei(sound->source, AL_SOURCE_STATE, &isPlaying);
-
-		if (isPlaying != AL_PLAYING)
+		if (!isPlaying)
 		{
-			sound.reset();
-			_soundsLRU.erase(std::find(_soundsLRU.begin(), _soundsLRU.end(), uiIndex - 1));
+			UnlinkPlayingSound(*sound);
+			FreeSound(*sound);
 		}
+
+		sound = next;
 	}
 }
 
@@ -286,22 +251,10 @@ void SoundSystem::PlaySound(std::string_view fileName, float volume, int pitch)
 		return;
 	}
 
-	if (fileName[0] == '*')
-	{
-		fileName = fileName.substr(1);
-	}
-
-	std::ostringstream stream;
-
-	stream << "sound/" << fileName;
-
-	const auto actualFileName{stream.str()};
-
-	const auto fullFileName{_fileSystem->GetRelativePath(actualFileName)};
+	const auto fullFileName = FindSoundFile(fileName);
 
 	if (fullFileName.empty())
 	{
-		Warning("CSoundSystem::PlaySound: Unable to find sound file '%s'\n", actualFileName.c_str());
 		return;
 	}
 
@@ -313,58 +266,86 @@ void SoundSystem::PlaySound(std::string_view fileName, float volume, int pitch)
 	volume = std::clamp(volume, 0.0f, 1.0f);
 	pitch = std::clamp(pitch, 0, 255);
 
-	std::unique_ptr<Sound> sound = TryLoadWaveFile(fullFileName);
+	std::shared_ptr<SoundBuffer> buffer;
+	OggVorbisFilePtr streamFile;
 
-	if (!sound)
+	if (!LoadSound(fullFileName, buffer, streamFile, false))
 	{
-		sound = TryLoadOggVorbis(fullFileName);
+		return;
 	}
 
-	if (!sound)
+	std::unique_ptr<OggVorbisStream> oggStream;
+
+	if (streamFile)
 	{
-		return;
+		oggStream = std::make_unique<OggVorbisStream>(fullFileName, std::move(streamFile));
 	}
 
-	alSourcei(sound->source, AL_BUFFER, sound->buffer);
+	const auto sound = GetSoundForPlayback();
 
-	if (CheckALErrors())
+	if (!sound)
 	{
 		return;
 	}
 
-	alSourcePlay(sound->source);
+	if (oggStream)
+	{
+		if (!oggStream->Start(sound->source))
+		{
+			FreeSound(*sound);
+			return;
+		}
 
-	if (CheckALErrors())
+		sound->stream = std::move(oggStream);
+	}
+	else
 	{
-		return;
+		sound->buffer = std::move(buffer);
+
+		alSourcei(sound->source, AL_BUFFER, sound->buffer->Buffer);
 	}
 
+	const auto pitchMultiplier = pitch / (static_cast<float>(PITCH_NORM));
+
 	alSourcef(sound->source, AL_GAIN, volume);
+	alSourcef(sound->source, AL_PITCH, pitchMultiplier);
 
 	if (CheckALErrors())
 	{
+		FreeSound(*sound);
 		return;
 	}
 
-	const auto pitchMultiplier = pitch / (static_cast<float>(PITCH_NORM));
+	alSourcePlay(sound->source);
 
 	if (CheckALErrors())
 	{
+		FreeSound(*sound);
 		return;
 	}
 
-	alSourcef(sound->source, AL_PITCH, pitchMultiplier);
+	LinkPlayingSound(*sound);
+}
 
-	if (CheckALErrors())
+PrecacheResult SoundSystem::PrecacheSound(std::string_view fileName)
+{
+	if (fileName.empty() || !_context)
 	{
-		return;
+		return PrecacheResult::NotFound;
 	}
 
-	const size_t uiIndex = GetSoundForPlayback();
+	const auto fullFileName = FindSoundFile(fileName);
 
-	_sounds[uiIndex] = std::move(sound);
+	if (fullFileName.empty())
+	{
+		return PrecacheResult::NotFound;
+	}
+
+	std::shared_ptr<SoundBuffer> buffer;
+	OggVorbisFilePtr streamFile;
 
-	_soundsLRU.push_front(uiIndex);
+	//Streamed sounds start playing right away, so they only need to be found
+	return LoadSound(fullFileName, buffer, streamFile, true) ? PrecacheResult::Loaded : PrecacheResult::LoadFailed;
 }
 
 void SoundSystem::StopAllSounds()
@@ -374,45 +355,154 @@ void SoundSystem::StopAllSounds()
 		return;
 	}
 
-	for (auto& sound : _sounds)
+	while (_newestSound)
 	{
-		if (!sound)
-		{
-			continue;
-		}
+		const auto sound = _newestSound;
+		UnlinkPlayingSound(*sound);
+		FreeSound(*sound);
+	}
+}
 
-		sound.reset();
+std::string SoundSystem::FindSoundFile(std::string_view fileName) const
+{
+	if (fileName[0] == '*')
+	{
+		fileName = fileName.substr(1);
 	}
 
-	_soundsLRU.clear();
+	std::ostringstream stream;
+
+	stream << "sound/" << fileName;
+
+	const auto actualFileName{stream.str()};
+
+	auto fullFileName{_fileSystem->GetRelativePath(actualFileName)};
+
+	if (fullFileName.empty())
+	{
+		Warning("CSoundSystem::FindSoundFile: Unable to find sound file '%s'\n", actualFileName.c_str());
+	}
+
+	return fullFileName;
 }
 
-size_t SoundSystem::GetSoundForPlayback()
+bool SoundSystem::LoadSound(const std::string& fullFileName, std::shared_ptr<SoundBuffer>& buffer, OggVorbisFilePtr& streamFile,
+	bool isPrecache)
 {
-	for (size_t uiIndex = 0; uiIndex < MAX_SOUNDS; ++uiIndex)
+	//Sounds that can't be identified can still be played, they just aren't cached
+	const auto fileIdentity = assets::FileIdentity::Get(std::filesystem::u8path(fullFileName));
+
+	if (fileIdentity)
 	{
-		if (!_sounds[uiIndex])
+		buffer = _bufferCache.Find(*fileIdentity, !isPrecache);
+
+		if (buffer)
+		{
+			return true;
+		}
+	}
+
+	buffer = TryLoadWaveFile(fullFileName);
+
+	if (!buffer)
+	{
+		auto file = OpenOggVorbisFile(fullFileName);
+
+		if (!file)
+		{
+			return false;
+		}
+
+		const auto decodedSize = GetOggVorbisDecodedSize(*file);
+
+		//Long sounds are streamed so they start playing right away and aren't fully decoded in memory
+		if (decodedSize < 0 || static_cast<std::uint64_t>(decodedSize) > MIN_STREAMING_SIZE)
+		{
+			streamFile = std::move(file);
+			return true;
+		}
+
+		buffer = TryLoadOggVorbis(fullFileName, *file);
+
+		if (!buffer)
 		{
-			return uiIndex;
+			return false;
 		}
 	}
 
-	//Shouldn't happen; LRU is only empty if no sounds are playing.
-	if (_soundsLRU.empty())
+	if (fileIdentity)
 	{
-		return 0;
+		_bufferCache.Add(*fileIdentity, buffer);
 	}
 
-	//get from LRU.
-	const size_t uiIndex = _soundsLRU.back();
+	return true;
+}
+
+SoundSystem::Sound* SoundSystem::GetSoundForPlayback()
+{
+	if (const auto sound = _freeSounds; sound)
+	{
+		_freeSounds = sound->next;
+		sound->next = nullptr;
+		return sound;
+	}
 
-	_soundsLRU.pop_back();
+	//Shouldn't happen; both lists are only empty if no sources could be created.
+	if (!_oldestSound)
+	{
+		return nullptr;
+	}
+
+	//Take the least recently played sound
+	const auto sound = _oldestSound;
+
+	UnlinkPlayingSound(*sound);
+	FreeSound(*sound);
+
+	_freeSounds = sound->next;
+	sound->next = nullptr;
+
+	return sound;
+}
+
+void SoundSystem::LinkPlayingSound(Sound& sound)
+{
+	sound.previous = nullptr;
+	sound.next = _newestSound;
+
+	if (_newestSound)
+	{
+		_newestSound->previous = &sound;
+	}
+	else
+	{
+		_oldestSound = &sound;
+	}
+
+	_newestSound = &sound;
+}
+
+void SoundSystem::UnlinkPlayingSound(Sound& sound)
+{
+	(sound.previous ? sound.previous->next : _newestSound) = sound.next;
+	(sound.next ? sound.next->previous : _oldestSound) = sound.previous;
+
+	sound.previous = nullptr;
+	sound.next = nullptr;
+}
+
+void SoundSystem::FreeSound(Sound& sound)
+{
+	alSourceStop(sound.source);
 
-	auto& sound = _sounds[uiIndex];
+	//Also unqueues all of a stream's buffers
+	alSourcei(sound.source, AL_BUFFER, 0);
 
-	//Reset the sound data. Must be done after the above actions so it doesn't try to access null pointers.
-	_sounds[uiIndex].reset();
+	sound.buffer.reset();
+	sound.stream.reset();
 
-	return uiIndex;
+	sound.previous = nullptr;
+	sound.next = _freeSounds;
+	_freeSounds = &sound;
 }
 }
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <array>
-#include <list>
 #include <memory>
+#include <string>
 
 #include <al.h>
 #include <alc.h>
 
+#include "soundsystem/OggVorbisStream.hpp"
+#include "soundsystem/SoundBufferCache.hpp"
 #include "soundsystem/SoundConstants.hpp"
 
 #include "soundsystem/ISoundSystem.hpp"
@@ -30,23 +32,24 @@ public:
 	//Maximum number of sounds to play simultaneously.
 	static const size_t MAX_SOUNDS = 16;
 
+	//Ogg Vorbis sounds that are larger than this once decoded are streamed instead of cached.
+	static const size_t MIN_STREAMING_SIZE = 1024 * 1024;
+
 public:
+	/**
+	*	@brief One of the preallocated sources and what it is playing.
+	*/
 	struct Sound
 	{
-		Sound()
-		{
-			alGenBuffers(1, &buffer);
-			alGenSources(1, &source);
-		}
-
-		~Sound()
-		{
-			alDeleteSources(1, &source);
-			alDeleteBuffers(1, &buffer);
-		}
-
-		ALuint buffer = 0;
 		ALuint source = 0;
+
+		//Only one of these is set while the sound is playing
+		std::shared_ptr<SoundBuffer> buffer;
+		std::unique_ptr<OggVorbisStream> stream;
+
+		//Links in the list of playing sounds, or in the free list
+		Sound* previous = nullptr;
+		Sound* next = nullptr;
 	};
 
 public:
@@ -65,10 +68,45 @@ public:
 public:
 	void PlaySound(std::string_view fileName, float volume, int pitch) override final;
 
+	PrecacheResult PrecacheSound(std::string_view fileName) override final;
+
 	void StopAllSounds() override final;
 
+	const SoundBufferCache& GetBufferCache() const { return _bufferCache; }
+
 private:
-	size_t GetSoundForPlayback();
+	/**
+	*	@brief Gets the path to a sound file from its name relative to the game's sound directory.
+	*	@return The path, or an empty string if the file could not be found.
+	*/
+	std::string FindSoundFile(std::string_view fileName) const;
+
+	/**
+	*	@brief Gets a file's buffer from the cache, or loads it and adds it to the cache.
+	*	Ogg Vorbis files that are too large to cache are opened for streaming instead.
+	*	@param[out] streamFile Set instead of buffer if the file should be streamed.
+	*	@param isPrecache Whether the sound is being precached instead of played, which is kept out of the cache statistics.
+	*	@return Whether the file could be loaded.
+	*/
+	bool LoadSound(const std::string& fullFileName, std::shared_ptr<SoundBuffer>& buffer, OggVorbisFilePtr& streamFile, bool isPrecache);
+
+	/**
+	*	@brief Gets a sound that is not playing, stopping the least recently played sound if all sounds are playing.
+	*	The sound is not in any list. Returns null if no sources could be created.
+	*/
+	Sound* GetSoundForPlayback();
+
+	/**
+	*	@brief Adds a sound to the front of the list of playing sounds.
+	*/
+	void LinkPlayingSound(Sound& sound);
+
+	void UnlinkPlayingSound(Sound& sound);
+
+	/**
+	*	@brief Stops a sound that is not in any list, releases what it was playing and adds it to the free list.
+	*/
+	void FreeSound(Sound& sound);
 
 private:
 	filesystem::IFileSystem* _fileSystem{};
@@ -76,9 +114,16 @@ private:
 	ALCdevice* _device{};
 	ALCcontext* _context{};
 
-	std::array<std::unique_ptr<Sound>, MAX_SOUNDS> _sounds;
+	SoundBufferCache _bufferCache;
+
+	//Sources are created once on startup and reused
+	std::array<Sound, MAX_SOUNDS> _sounds;
+
+	//Playing sounds, most recently played first
+	Sound* _newestSound{};
+	Sound* _oldestSound{};
 
-	std::list<size_t> _soundsLRU;
+	Sound* _freeSounds{};
 };
 }
 
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "AudioFile/AudioFile.h"
+
+#include "soundsystem/WaveFile.hpp"
+
+#include "utility/ByteSwap.hpp"
+#include "utility/IOUtils.hpp"
+
+namespace soundsystem
+{
+namespace
+{
+constexpr std::uint16_t WaveFormatPCM = 0x0001;
+constexpr std::uint16_t WaveFormatExtensible = 0xFFFE;
+
+std::uint16_t ReadUInt16(const std::uint8_t* data)
+{
+	return static_cast<std::uint16_t>(data[0] | (data[1] << 8));
+}
+
+std::uint32_t ReadUInt32(const std::uint8_t* data)
+{
+	return static_cast<std::uint32_t>(data[0])
+		| (static_cast<std::uint32_t>(data[1]) << 8)
+		| (static_cast<std::uint32_t>(data[2]) << 16)
+		| (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+struct DataConverter8Bit
+{
+	using Type = std::uint8_t;
+
+	static Type Convert(double value)
+	{
+		value = (std::clamp(value, -1., 1.) + 1.) / 2.;
+		return static_cast<Type>(value * 255.);
+	}
+};
+
+struct DataConverter16Bit
+{
+	using Type = std::int16_t;
+
+	static Type Convert(double value)
+	{
+		value = std::clamp(value, -1., 1.);
+		return static_cast<Type>(value * 32767.);
+	}
+};
+
+template<typename T>
+void ConvertToAL(const AudioFile<double>& file, std::vector<std::uint8_t>& data)
+{
+	std::size_t byteIndex = 0;
+
+	for (int i = 0; i < file.getNumSamplesPerChannel(); ++i)
+	{
+		for (int channel = 0; channel < file.getNumChannels(); ++channel)
+		{
+			const typename T::Type value = T::Convert(file.samples[channel][i]);
+
+			std::memcpy(&data[byteIndex], &value, sizeof(value));
+
+			byteIndex += sizeof(value);
+		}
+	}
+}
+}
+
+bool ParseWaveData(const std::uint8_t* data, std::size_t size, PCMFormat& format, const std::uint8_t*& samples, std::size_t& samplesSize)
+{
+	if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+	{
+		return false;
+	}
+
+	bool hasFormat = false;
+	std::uint16_t blockAlign = 0;
+
+	//The RIFF size is wrong in some game files, so chunks are read until the end of the file instead
+	for (std::size_t offset = 12; (offset + 8) <= size;)
+	{
+		const std::uint8_t* const chunk = data + offset;
+		const std::size_t chunkSize = ReadUInt32(chunk + 4);
+		const std::size_t available = size - (offset + 8);
+		const std::uint8_t* const body = chunk + 8;
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0)
+		{
+			if (chunkSize < 16 || available < 16)
+			{
+				return false;
+			}
+
+			std::uint16_t encoding = ReadUInt16(body);
+
+			//Extensible files store the actual encoding at the start of the sub format GUID
+			if (encoding == WaveFormatExtensible && chunkSize >= 40 && available >= 40)
+			{
+				encoding = ReadUInt16(body + 24);
+			}
+
+			if (encoding != WaveFormatPCM)
+			{
+				return false;
+			}
+
+			format.Channels = ReadUInt16(body + 2);
+			format.SampleRate = static_cast<int>(ReadUInt32(body + 4));
+			blockAlign = ReadUInt16(body + 12);
+			format.BitsPerSample = ReadUInt16(body + 14);
+
+			if ((format.Channels != 1 && format.Channels != 2)
+				|| (format.BitsPerSample != 8 && format.BitsPerSample != 16)
+				|| format.SampleRate <= 0
+				|| blockAlign != (format.Channels * format.BitsPerSample / 8))
+			{
+				return false;
+			}
+
+			hasFormat = true;
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0)
+		{
+			if (!hasFormat)
+			{
+				return false;
+			}
+
+			//Truncated files are common, play whatever is there
+			samples = body;
+			samplesSize = std::min(chunkSize, available);
+			samplesSize -= samplesSize % blockAlign;
+
+			return true;
+		}
+
+		if (chunkSize > available)
+		{
+			break;
+		}
+
+		//Chunks are padded to an even size
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	return false;
+}
+
+std::optional<WaveData> LoadWaveFile(const std::string& fileName)
+{
+	FILE* file = utf8_fopen(fileName.c_str(), "rb");
+
+	if (!file)
+	{
+		return {};
+	}
+
+	fseek(file, 0, SEEK_END);
+	const long fileSize = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (fileSize <= 0)
+	{
+		fclose(file);
+		return {};
+	}
+
+	const std::size_t size = static_cast<std::size_t>(fileSize);
+
+	WaveData wave;
+
+	const std::uint8_t* data = nullptr;
+
+	//Mapping avoids copying the file, OpenAL copies the samples out of the mapping
+	wave.Mapping = MappedFile::Map(file, size);
+
+	if (wave.Mapping)
+	{
+		data = static_cast<const std::uint8_t*>(wave.Mapping->GetData());
+	}
+	else
+	{
+		wave.Storage.resize(size);
+
+		if (fread(wave.Storage.data(), size, 1, file) != 1)
+		{
+			fclose(file);
+			return {};
+		}
+
+		data = wave.Storage.data();
+	}
+
+	fclose(file);
+
+	if (!ParseWaveData(data, size, wave.Format, wave.Samples, wave.Size))
+	{
+		//Only try AudioFile on files it might support, other sound formats are handled by the caller
+		if (size >= 4 && (std::memcmp(data, "RIFF", 4) == 0 || std::memcmp(data, "FORM", 4) == 0))
+		{
+			return LoadWaveFileWithAudioFile(fileName);
+		}
+
+		return {};
+	}
+
+	if (wave.Format.BitsPerSample == 16 && !ByteSwap<>::IsLittleEndian())
+	{
+		std::vector<std::uint8_t> swapped(wave.Size);
+
+		for (std::size_t i = 0; i < wave.Size; i += 2)
+		{
+			swapped[i] = wave.Samples[i + 1];
+			swapped[i + 1] = wave.Samples[i];
+		}
+
+		wave.Mapping.reset();
+		wave.Storage = std::move(swapped);
+		wave.Samples = wave.Storage.data();
+	}
+
+	return wave;
+}
+
+std::optional<WaveData> LoadWaveFileWithAudioFile(const std::string& fileName)
+{
+	AudioFile<double> file;
+
+	if (!file.load(fileName))
+	{
+		return {};
+	}
+
+	if (file.getNumChannels() != 1 && file.getNumChannels() != 2)
+	{
+		return {};
+	}
+
+	WaveData wave;
+
+	wave.Format.Channels = file.getNumChannels();
+	wave.Format.SampleRate = static_cast<int>(file.getSampleRate());
+
+	//Anything other than 8 bit is converted to 16 bit, the most OpenAL supports
+	wave.Format.BitsPerSample = file.getBitDepth() == 8 ? 8 : 16;
+
+	wave.Storage.resize(
+		static_cast<std::size_t>(file.getNumChannels()) * file.getNumSamplesPerChannel() * (wave.Format.BitsPerSample / 8));
+
+	if (wave.Format.BitsPerSample == 8)
+	{
+		ConvertToAL<DataConverter8Bit>(file, wave.Storage);
+	}
+	else
+	{
+		ConvertToAL<DataConverter16Bit>(file, wave.Storage);
+	}
+
+	wave.Samples = wave.Storage.data();
+	wave.Size = wave.Storage.size();
+
+	return wave;
+}
+}
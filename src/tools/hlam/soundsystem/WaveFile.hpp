@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "utility/MappedFile.hpp"
+
+namespace soundsystem
+{
+/**
+*	@brief Format of integer PCM samples as OpenAL accepts them.
+*/
+struct PCMFormat
+{
+	int Channels = 0;
+	int SampleRate = 0;
+
+	/**
+	*	8 bit samples are unsigned, 16 bit samples are signed and in native byte order.
+	*/
+	int BitsPerSample = 0;
+};
+
+/**
+*	@brief Integer PCM samples loaded from a wave file.
+*	Samples point into the mapped file if the file's data could be used as-is, otherwise into Storage.
+*/
+struct WaveData
+{
+	PCMFormat Format;
+
+	const std::uint8_t* Samples = nullptr;
+	std::size_t Size = 0;
+
+	std::unique_ptr<MappedFile> Mapping;
+	std::vector<std::uint8_t> Storage;
+};
+
+/**
+*	@brief Parses a RIFF WAVE file stored in memory that contains 8 or 16 bit integer PCM samples with 1 or 2 channels.
+*	A data chunk that claims to be larger than the file is truncated to the data that is present.
+*	@param[out] samples Points to the sample data in the file. 16 bit samples are little endian.
+*	@return Whether the data is a valid wave file in a supported format.
+*/
+bool ParseWaveData(const std::uint8_t* data, std::size_t size, PCMFormat& format, const std::uint8_t*& samples, std::size_t& samplesSize);
+
+/**
+*	@brief Loads a wave file. 8 and 16 bit integer PCM files are used directly,
+*	other encodings are decoded with AudioFile and converted to 16 bit samples.
+*	@return The samples, or an empty optional if the file could not be loaded.
+*/
+std::optional<WaveData> LoadWaveFile(const std::string& fileName);
+
+/**
+*	@brief Loads a wave file by decoding it with AudioFile and converting it to 8 or 16 bit samples.
+*	Handles every encoding AudioFile supports, but is much slower than reading integer PCM directly.
+*/
+std::optional<WaveData> LoadWaveFileWithAudioFile(const std::string& fileName);
+}
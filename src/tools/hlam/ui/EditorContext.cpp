@@ -7,6 +7,8 @@
 #include <QOffscreenSurface>
 #include <QOpenGLContext>
 
+#include "core/shared/JobSystem.hpp"
+#include "core/shared/Profiler.hpp"
 #include "core/shared/WorldTime.hpp"
 
 #include "filesystem/FileSystem.hpp"
@@ -51,23 +53,37 @@ EditorContext::EditorContext(
 		? std::unique_ptr<soundsystem::ISoundSystem>(std::make_unique<soundsystem::SoundSystem>())
 		: std::make_unique<soundsystem::DummySoundSystem>())
 	, _worldTime(std::make_unique<WorldTime>())
+	, _jobSystem(std::make_unique<JobSystem>())
 	, _assetProviderRegistry(std::move(assetProviderRegistry))
 {
 	_settings->setParent(this);
 
 	_timer->setTimerType(Qt::TimerType::PreciseTimer);
 
+	Profiler::GetInstance().SetThreadName("Main");
+
 	if (!_soundSystem->Initialize(_fileSystem.get()))
 	{
 		throw std::runtime_error("Failed to initialize sound system");
 	}
 
+	_jobSystem->SetMainThreadWakeCallback([this]
+		{
+			//Called from worker threads, queue the callbacks to run on the thread this object lives on
+			QMetaObject::invokeMethod(this, [this]
+				{
+					_jobSystem->RunMainThreadCallbacks();
+				}, Qt::QueuedConnection);
+		});
+
 	connect(_timer, &QTimer::timeout, this, &EditorContext::OnTimerTick);
 	connect(_generalSettings.get(), &settings::GeneralSettings::TickRateChanged, this, &EditorContext::OnTickRateChanged);
 }
 
 EditorContext::~EditorContext()
 {
+	//Jobs may still be using anything owned by this object
+	_jobSystem->Shutdown();
 	_soundSystem->Shutdown();
 }
 
@@ -106,8 +122,21 @@ void EditorContext::StartTimer()
 	_timer->start(1000 / _generalSettings->GetTickRate());
 }
 
+void EditorContext::SetProfilerOverlayVisible(bool visible)
+{
+	if (_profilerOverlayVisible != visible)
+	{
+		_profilerOverlayVisible = visible;
+		emit ProfilerOverlayVisibilityChanged(_profilerOverlayVisible);
+	}
+}
+
 void EditorContext::OnTimerTick()
 {
+	Profiler::GetInstance().MarkFrame();
+
+	PROFILE_ZONE("EditorContext::Tick");
+
 	const auto timeMillis{std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count()};
 
 	const double currentTime = timeMillis / 1000.0;
@@ -131,6 +160,8 @@ void EditorContext::OnTimerTick()
 
 	_worldTime->TimeChanged(currentTime);
 
+	_soundSystem->RunFrame();
+
 	emit Tick();
 }
 
@@ -12,6 +12,7 @@
 class QOffscreenSurface;
 class QOpenGLContext;
 
+class JobSystem;
 class WorldTime;
 
 namespace filesystem
@@ -85,6 +86,8 @@ public:
 
 	WorldTime* GetWorldTime() const { return _worldTime.get(); }
 
+	JobSystem* GetJobSystem() const { return _jobSystem.get(); }
+
 	assets::IAssetProviderRegistry* GetAssetProviderRegistry() const { return _assetProviderRegistry.get(); }
 
 	QOpenGLContext* GetOffscreenContext() const { return _offscreenContext; }
@@ -97,12 +100,18 @@ public:
 
 	void StartTimer();
 
+	bool IsProfilerOverlayVisible() const { return _profilerOverlayVisible; }
+
+	void SetProfilerOverlayVisible(bool visible);
+
 signals:
 	/**
 	*	@brief Emitted every time a frame tick occurs
 	*/
 	void Tick();
 
+	void ProfilerOverlayVisibilityChanged(bool visible);
+
 private slots:
 	void OnTimerTick();
 
@@ -123,10 +132,13 @@ private:
 	const std::unique_ptr<filesystem::IFileSystem> _fileSystem;
 	const std::unique_ptr<soundsystem::ISoundSystem> _soundSystem;
 	const std::unique_ptr<WorldTime> _worldTime;
+	const std::unique_ptr<JobSystem> _jobSystem;
 
 	const std::unique_ptr<assets::IAssetProviderRegistry> _assetProviderRegistry;
 
 	QOpenGLContext* _offscreenContext{};
 	QOffscreenSurface* _offscreenSurface{};
+
+	bool _profilerOverlayVisible = false;
 };
 }
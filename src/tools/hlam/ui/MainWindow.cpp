@@ -1,5 +1,8 @@
 #include <algorithm>
 #include <cassert>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
 #include <string_view>
 #include <utility>
 #include <vector>
@@ -11,9 +14,13 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QStatusBar>
 
 #include "assets/AssetIO.hpp"
 
+#include "core/shared/JobSystem.hpp"
+#include "core/shared/Profiler.hpp"
+
 #include "filesystem/IFileSystem.hpp"
 #include "filesystem/FileSystemConstants.hpp"
 
@@ -36,6 +43,55 @@ namespace ui
 constexpr std::string_view TabWidgetAssetProperty{"TabWidgetAssetProperty"};
 const QString AssetPathName{QStringLiteral("AssetPath")};
 
+/**
+*	@brief How much history is saved in profiler traces.
+*/
+constexpr long long ProfilerTraceSeconds = 10;
+
+using AssetLoadedCallback = std::function<void(const std::shared_ptr<assets::LoadedAsset>& loadedAsset, const QString& error)>;
+
+/**
+*	@brief Loads an asset on a worker thread and passes the result to a callback on the main thread
+*/
+static JobHandle ScheduleAssetLoad(JobSystem* jobSystem, assets::AssetLoadFunction&& load,
+	const std::shared_ptr<std::atomic<bool>>& cancelled, AssetLoadedCallback&& callback)
+{
+	return jobSystem->Schedule([jobSystem, load = std::move(load), cancelled, callback = std::move(callback)]
+		{
+			std::shared_ptr<assets::LoadedAsset> loadedAsset;
+			QString error;
+
+			if (*cancelled)
+			{
+				return;
+			}
+
+			try
+			{
+				loadedAsset = load(*cancelled);
+			}
+			catch (const std::exception& e)
+			{
+				error = e.what();
+			}
+
+			//Loads stop early once cancelled, there is nothing to pass back
+			if (*cancelled)
+			{
+				return;
+			}
+
+			//Callbacks that have not run yet are discarded when the job system shuts down
+			jobSystem->RunOnMainThread([callback, cancelled, loadedAsset, error]
+				{
+					if (!*cancelled)
+					{
+						callback(loadedAsset, error);
+					}
+				});
+		});
+}
+
 MainWindow::MainWindow(EditorContext* editorContext)
 	: QMainWindow()
 	, _editorContext(editorContext)
@@ -115,6 +171,9 @@ MainWindow::MainWindow(EditorContext* editorContext)
 	connect(_ui.ActionExit, &QAction::triggered, this, &MainWindow::OnExit);
 
 	connect(_ui.ActionFullscreen, &QAction::triggered, this, &MainWindow::OnGoFullscreen);
+	connect(_ui.ActionShowProfilerOverlay, &QAction::toggled, _editorContext, &EditorContext::SetProfilerOverlayVisible);
+
+	connect(_ui.ActionSaveProfilerTrace, &QAction::triggered, this, &MainWindow::OnSaveProfilerTrace);
 
 	connect(_ui.ActionOptions, &QAction::triggered, this, &MainWindow::OnOpenOptionsDialog);
 	connect(_ui.ActionAbout, &QAction::triggered, this, &MainWindow::OnShowAbout);
@@ -166,21 +225,72 @@ MainWindow::MainWindow(EditorContext* editorContext)
 
 	_fileFilter += "All Files (*.*)";
 
+	{
+		_loadProgressBar = new QProgressBar(this);
+		_loadProgressBar->setFormat("Loading %v of %m");
+
+		_cancelLoadsButton = new QPushButton("Cancel", this);
+
+		connect(_cancelLoadsButton, &QPushButton::clicked, this, &MainWindow::OnCancelAssetLoads);
+
+		statusBar()->addPermanentWidget(_loadProgressBar);
+		statusBar()->addPermanentWidget(_cancelLoadsButton);
+
+		//Only shown while assets are loading
+		statusBar()->hide();
+	}
+
 	_editorContext->StartTimer();
 }
 
 MainWindow::~MainWindow()
 {
+	//Loads still in progress reference this window
+	*_loadsCancelled = true;
+
+	for (const auto& job : _loadJobs)
+	{
+		_editorContext->GetJobSystem()->Wait(job);
+	}
+
 	_editorContext->GetTimer()->stop();
 }
 
-bool MainWindow::TryLoadAsset(QString fileName)
+void MainWindow::TryLoadAsset(QString fileName, bool removeFromRecentFilesOnFailure)
 {
 	fileName = QDir::cleanPath(fileName);
 
+	auto load = _editorContext->GetAssetProviderRegistry()->BeginLoad(fileName);
+
+	_loadJobs.erase(std::remove_if(_loadJobs.begin(), _loadJobs.end(), &JobSystem::IsFinished), _loadJobs.end());
+
+	_loadJobs.push_back(ScheduleAssetLoad(_editorContext->GetJobSystem(), std::move(load), _loadsCancelled,
+		[this, fileName, removeFromRecentFilesOnFailure](const auto& loadedAsset, const auto& error)
+		{
+			OnAssetLoaded(fileName, loadedAsset, error, removeFromRecentFilesOnFailure);
+		}));
+
+	++_pendingLoadCount;
+	++_totalLoadCount;
+
+	UpdateLoadProgress();
+}
+
+void MainWindow::OnAssetLoaded(const QString& fileName, const std::shared_ptr<assets::LoadedAsset>& loadedAsset, const QString& error,
+	bool removeFromRecentFilesOnFailure)
+{
+	--_pendingLoadCount;
+
+	UpdateLoadProgress();
+
 	try
 	{
-		auto asset = _editorContext->GetAssetProviderRegistry()->Load(_editorContext, fileName);
+		if (!error.isEmpty())
+		{
+			throw ::assets::AssetException(error.toStdString());
+		}
+
+		auto asset = loadedAsset ? loadedAsset->CreateAsset(_editorContext) : nullptr;
 
 		if (nullptr != asset)
 		{
@@ -205,7 +315,7 @@ bool MainWindow::TryLoadAsset(QString fileName)
 
 			_editorContext->GetRecentFiles()->Add(fileName);
 
-			return true;
+			return;
 		}
 		else
 		{
@@ -217,7 +327,25 @@ bool MainWindow::TryLoadAsset(QString fileName)
 		QMessageBox::critical(this, "Error loading asset", QString{"Error loading asset:\n%1"}.arg(e.what()));
 	}
 
-	return false;
+	if (removeFromRecentFilesOnFailure)
+	{
+		_editorContext->GetRecentFiles()->Remove(fileName);
+	}
+}
+
+void MainWindow::UpdateLoadProgress()
+{
+	if (_pendingLoadCount == 0)
+	{
+		_totalLoadCount = 0;
+		statusBar()->hide();
+		return;
+	}
+
+	_loadProgressBar->setRange(0, _totalLoadCount);
+	_loadProgressBar->setValue(_totalLoadCount - _pendingLoadCount);
+
+	statusBar()->show();
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent* event)
@@ -480,10 +608,7 @@ void MainWindow::OnOpenRecentFile()
 
 	const QString fileName{action->text()};
 
-	if (!TryLoadAsset(fileName))
-	{
-		_editorContext->GetRecentFiles()->Remove(fileName);
-	}
+	TryLoadAsset(fileName, true);
 }
 
 void MainWindow::OnExit()
@@ -514,6 +639,28 @@ void MainWindow::OnFileSelected(const QString& fileName)
 	TryLoadAsset(fileName);
 }
 
+void MainWindow::OnSaveProfilerTrace()
+{
+	const QString fileName{QFileDialog::getSaveFileName(this, "Save Profiler Trace", "trace.json", "Chrome Trace Files (*.json)")};
+
+	if (fileName.isEmpty())
+	{
+		return;
+	}
+
+	std::ofstream stream{fileName.toStdString()};
+
+	if (!stream)
+	{
+		QMessageBox::critical(this, "Error saving profiler trace", QString{"Could not open \"%1\" for writing"}.arg(fileName));
+		return;
+	}
+
+	auto& profiler = Profiler::GetInstance();
+
+	profiler.WriteChromeTrace(stream, profiler.GetTime() - ProfilerTraceSeconds * 1'000'000'000LL);
+}
+
 void MainWindow::OnOpenOptionsDialog()
 {
 	options::OptionsDialog dialog{_editorContext, this};
@@ -596,6 +743,17 @@ void MainWindow::OnActiveConfigurationChanged(std::pair<settings::GameEnvironmen
 	}
 }
 
+void MainWindow::OnCancelAssetLoads()
+{
+	//Loads that have already started stop at the next stage and are discarded
+	*_loadsCancelled = true;
+	_loadsCancelled = std::make_shared<std::atomic<bool>>(false);
+
+	_pendingLoadCount = 0;
+
+	UpdateLoadProgress();
+}
+
 void MainWindow::OnGameConfigurationDirectoryChanged()
 {
 	SetupFileSystem(_editorContext->GetGameConfigurations()->GetActiveConfiguration());
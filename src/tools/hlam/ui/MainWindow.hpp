@@ -1,14 +1,20 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <QMainWindow>
 #include <QPointer>
+#include <QProgressBar>
+#include <QPushButton>
 #include <QString>
 #include <QTabWidget>
 #include <QUndoGroup>
 
+#include "core/shared/JobSystem.hpp"
+
 #include "ui_MainWindow.h"
 
 namespace ui
@@ -20,6 +26,7 @@ class FullscreenWidget;
 namespace assets
 {
 class Asset;
+class LoadedAsset;
 }
 
 namespace settings
@@ -36,7 +43,12 @@ public:
 	MainWindow(EditorContext* editorContext);
 	~MainWindow();
 
-	bool TryLoadAsset(QString fileName);
+	/**
+	*	@brief Loads an asset in the background and opens it in a new tab once it has loaded.
+	*	Errors are reported to the user.
+	*	@param removeFromRecentFilesOnFailure Whether to remove the file from the recent files list if it fails to load
+	*/
+	void TryLoadAsset(QString fileName, bool removeFromRecentFilesOnFailure = false);
 
 protected:
 	void dragEnterEvent(QDragEnterEvent* event) override;
@@ -58,6 +70,11 @@ private:
 
 	void SetupFileSystem(std::pair<settings::GameEnvironment*, settings::GameConfiguration*> activeConfiguration);
 
+	void OnAssetLoaded(const QString& fileName, const std::shared_ptr<assets::LoadedAsset>& loadedAsset, const QString& error,
+		bool removeFromRecentFilesOnFailure);
+
+	void UpdateLoadProgress();
+
 private slots:
 	void OnOpenLoadAssetDialog();
 
@@ -83,6 +100,8 @@ private slots:
 
 	void OnFileSelected(const QString& fileName);
 
+	void OnSaveProfilerTrace();
+
 	void OnOpenOptionsDialog();
 
 	void OnShowAbout();
@@ -92,6 +111,8 @@ private slots:
 
 	void OnGameConfigurationDirectoryChanged();
 
+	void OnCancelAssetLoads();
+
 private:
 	Ui_MainWindow _ui;
 
@@ -108,5 +129,21 @@ private:
 	std::unique_ptr<FullscreenWidget> _fullscreenWidget;
 
 	QPointer<QDockWidget> _fileListDock;
+
+	/**
+	*	Loads that may still be running, waited on when this window is destroyed since they reference it.
+	*/
+	std::vector<JobHandle> _loadJobs;
+
+	/**
+	*	Shared with pending loads. Replaced when loads are cancelled so new loads are unaffected.
+	*/
+	std::shared_ptr<std::atomic<bool>> _loadsCancelled = std::make_shared<std::atomic<bool>>(false);
+
+	int _pendingLoadCount = 0;
+	int _totalLoadCount = 0;
+
+	QProgressBar* _loadProgressBar;
+	QPushButton* _cancelLoadsButton;
 };
 }
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QRect>
+
+#include "core/shared/Profiler.hpp"
+
+#include "ui/ProfilerOverlay.hpp"
+
+namespace ui
+{
+constexpr std::int64_t NanosecondsPerSecond = 1'000'000'000;
+constexpr std::int64_t NanosecondsPerMillisecond = 1'000'000;
+
+/**
+*	@brief How often the statistics are refreshed, so the numbers stay readable.
+*/
+constexpr std::int64_t UpdateInterval = NanosecondsPerSecond / 4;
+
+constexpr std::size_t MaxZonesShown = 24;
+
+constexpr int GraphHeight = 64;
+
+void ProfilerOverlay::Paint(QPainter& painter, const QRect& rect)
+{
+	const std::int64_t now = Profiler::GetInstance().GetTime();
+
+	if (_lastUpdateTime < 0 || (now - _lastUpdateTime) >= UpdateInterval)
+	{
+		_lastUpdateTime = now;
+		UpdateStats();
+	}
+
+	const QFont font{QFontDatabase::systemFont(QFontDatabase::FixedFont)};
+	const QFontMetrics metrics{font};
+
+	const int lineHeight = metrics.height();
+	const int margin = lineHeight / 2;
+	const int nameWidth = metrics.horizontalAdvance(QString(32, QChar{'0'}));
+	const int columnWidth = metrics.horizontalAdvance(QString(10, QChar{'0'}));
+
+	const std::size_t zonesShown = std::min(_zones.size(), MaxZonesShown);
+
+	const int width = std::max(nameWidth + (columnWidth * 3), static_cast<int>(Profiler::MaxFrameTimes)) + (margin * 2);
+	const int height = (static_cast<int>(zonesShown + 1) * lineHeight) + GraphHeight + (margin * 3);
+
+	const QRect background{rect.topLeft(), QSize{std::min(width, rect.width()), std::min(height, rect.height())}};
+
+	painter.save();
+
+	painter.setClipRect(background);
+	painter.fillRect(background, QColor{0, 0, 0, 160});
+
+	painter.setFont(font);
+	painter.setPen(Qt::white);
+
+	int x = background.left() + margin;
+	int y = background.top() + margin + metrics.ascent();
+
+	const auto drawRow = [&](const QString& name, const QString& average, const QString& max, const QString& calls)
+	{
+		painter.drawText(x, y, name);
+		painter.drawText(x + nameWidth, y, average);
+		painter.drawText(x + nameWidth + columnWidth, y, max);
+		painter.drawText(x + nameWidth + (columnWidth * 2), y, calls);
+		y += lineHeight;
+	};
+
+	drawRow("Zone", "ms/frame", "max ms", "calls");
+
+	const double framesCount = static_cast<double>(_framesCount);
+
+	for (std::size_t i = 0; i < zonesShown; ++i)
+	{
+		const auto& zone = _zones[i];
+
+		drawRow(
+			QString(static_cast<int>(zone.Depth) * 2, QChar{' '}) + zone.Name,
+			QString::number(zone.TotalTime / framesCount / NanosecondsPerMillisecond, 'f', 3),
+			QString::number(static_cast<double>(zone.MaxTime) / NanosecondsPerMillisecond, 'f', 3),
+			QString::number(zone.Calls / framesCount, 'f', 1));
+	}
+
+	//Frame time graph, newest frame on the right
+	const QRect graph{x, y - metrics.ascent() + margin, static_cast<int>(Profiler::MaxFrameTimes), GraphHeight};
+
+	float maxFrameTime = 1000.f / 30.f;
+
+	for (const float frameTime : _frameTimes)
+	{
+		maxFrameTime = std::max(maxFrameTime, frameTime);
+	}
+
+	const auto toGraphY = [&](float frameTime)
+	{
+		return graph.bottom() - static_cast<int>((frameTime / maxFrameTime) * (graph.height() - 1));
+	};
+
+	painter.setPen(QColor{0, 192, 0});
+
+	const int firstX = graph.right() - static_cast<int>(_frameTimes.size()) + 1;
+
+	for (std::size_t i = 0; i < _frameTimes.size(); ++i)
+	{
+		const int frameX = firstX + static_cast<int>(i);
+		painter.drawLine(frameX, graph.bottom(), frameX, toGraphY(_frameTimes[i]));
+	}
+
+	//Reference lines for 60 and 30 frames per second
+	painter.setPen(QColor{255, 255, 0, 160});
+
+	for (const float reference : {1000.f / 60.f, 1000.f / 30.f})
+	{
+		const int referenceY = toGraphY(reference);
+		painter.drawLine(graph.left(), referenceY, graph.right(), referenceY);
+	}
+
+	painter.restore();
+}
+
+void ProfilerOverlay::UpdateStats()
+{
+	auto& profiler = Profiler::GetInstance();
+
+	_frameTimes = profiler.GetFrameTimes();
+
+	//Count the frames that make up the last second
+	{
+		float time = 0;
+		_framesCount = 0;
+
+		for (auto it = _frameTimes.rbegin(); it != _frameTimes.rend() && time < 1000.f; ++it)
+		{
+			time += *it;
+			++_framesCount;
+		}
+
+		_framesCount = std::max<std::size_t>(_framesCount, 1);
+	}
+
+	//Zones with the same name are combined regardless of the thread they ran on
+	std::unordered_map<std::string_view, ZoneStats> zones;
+
+	for (const auto& thread : profiler.GetEvents(profiler.GetTime() - NanosecondsPerSecond))
+	{
+		for (const auto& event : thread.Events)
+		{
+			auto [it, inserted] = zones.try_emplace(event.Name);
+
+			auto& zone = it->second;
+
+			const std::int64_t duration = event.End - event.Start;
+
+			if (inserted)
+			{
+				zone.Name = QString::fromUtf8(event.Name);
+				zone.Depth = event.Depth;
+			}
+
+			zone.Depth = std::min(zone.Depth, event.Depth);
+			zone.TotalTime += duration;
+			zone.MaxTime = std::max(zone.MaxTime, duration);
+			++zone.Calls;
+		}
+	}
+
+	_zones.clear();
+	_zones.reserve(zones.size());
+
+	for (auto& zone : zones)
+	{
+		_zones.push_back(std::move(zone.second));
+	}
+
+	std::sort(_zones.begin(), _zones.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.TotalTime > rhs.TotalTime;
+		});
+}
+}
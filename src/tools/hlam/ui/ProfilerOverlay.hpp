@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+
+class QPainter;
+class QRect;
+
+namespace ui
+{
+/**
+*	@brief Draws a breakdown of the profiler zones recorded in the last second and a graph of recent frame times
+*/
+class ProfilerOverlay final
+{
+public:
+	/**
+	*	@brief Draws the overlay in the top left corner of rect. Statistics are refreshed a few times per second.
+	*/
+	void Paint(QPainter& painter, const QRect& rect);
+
+private:
+	struct ZoneStats
+	{
+		QString Name;
+		std::uint32_t Depth = 0;
+		std::int64_t TotalTime = 0;
+		std::int64_t MaxTime = 0;
+		std::size_t Calls = 0;
+	};
+
+	void UpdateStats();
+
+private:
+	std::int64_t _lastUpdateTime = -1;
+
+	std::vector<ZoneStats> _zones;
+	std::size_t _framesCount = 1;
+	std::vector<float> _frameTimes;
+};
+}
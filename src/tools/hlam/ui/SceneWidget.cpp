@@ -1,6 +1,7 @@
 #include <cassert>
 
 #include <QApplication>
+#include <QPainter>
 #include <QWheelEvent>
 #include <QWidget>
 
@@ -17,8 +18,6 @@ SceneWidget::SceneWidget(graphics::Scene* scene, QWidget* parent)
 	assert(nullptr != _scene);
 
 	_container->setFocusPolicy(Qt::FocusPolicy::WheelFocus);
-
-	connect(this, &SceneWidget::frameSwapped, this, qOverload<>(&SceneWidget::update));
 }
 
 SceneWidget::~SceneWidget()
@@ -30,6 +29,23 @@ SceneWidget::~SceneWidget()
 	doneCurrent();
 }
 
+void SceneWidget::UpdateIfDirty()
+{
+	if (_scene->IsDirty() || _showProfilerOverlay)
+	{
+		update();
+	}
+}
+
+void SceneWidget::SetShowProfilerOverlay(bool show)
+{
+	if (_showProfilerOverlay != show)
+	{
+		_showProfilerOverlay = show;
+		update();
+	}
+}
+
 void SceneWidget::wheelEvent(QWheelEvent* event)
 {
 	//Ugly hack: when this window has focus it eats all wheel events even when the mouse is not over it.
@@ -39,6 +55,7 @@ void SceneWidget::wheelEvent(QWheelEvent* event)
 	if (_container->rect().contains(event->position().toPoint()))
 	{
 		emit WheelEvent(event);
+		UpdateIfDirty();
 	}
 	else
 	{
@@ -77,6 +94,13 @@ void SceneWidget::paintGL()
 		//TODO: this is temporary until window sized resources can be decoupled from the scene class
 		_scene->UpdateWindowSize(static_cast<unsigned int>(size.width()), static_cast<unsigned int>(size.height()));
 		_scene->Draw();
+
+		if (_showProfilerOverlay)
+		{
+			//Painting resets the OpenGL state it changes when the painter ends
+			QPainter painter{this};
+			_profilerOverlay.Paint(painter, QRect{QPoint{}, size});
+		}
 	}
 }
 }
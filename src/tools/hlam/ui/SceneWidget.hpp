@@ -8,6 +8,8 @@
 
 #include "graphics/IGraphicsContext.hpp"
 
+#include "ui/ProfilerOverlay.hpp"
+
 namespace graphics
 {
 class Scene;
@@ -39,6 +41,8 @@ private:
 
 /**
 *	@brief Renders a scene to an OpenGL window
+*	The scene is only redrawn when it has changed. Redraws are requested through QWindow::requestUpdate,
+*	which coalesces requests and limits them to the display refresh rate.
 *	TODO: rework this so it isn't tied directly to OpenGL (allow D3D or Vulkan backends)
 */
 class SceneWidget final : public QOpenGLWindow
@@ -53,6 +57,15 @@ public:
 
 	graphics::Scene* GetScene() { return _scene; }
 
+public slots:
+	/**
+	*	@brief Schedules a redraw if the scene has changed since it was last drawn
+	*	While the profiler overlay is shown a redraw is always scheduled to keep it up to date
+	*/
+	void UpdateIfDirty();
+
+	void SetShowProfilerOverlay(bool show);
+
 signals:
 	void CreateDeviceResources();
 
@@ -64,16 +77,19 @@ protected:
 	void mousePressEvent(QMouseEvent* event) override final
 	{
 		emit MouseEvent(event);
+		UpdateIfDirty();
 	}
 
 	void mouseReleaseEvent(QMouseEvent* event) override final
 	{
 		emit MouseEvent(event);
+		UpdateIfDirty();
 	}
 
 	void mouseMoveEvent(QMouseEvent* event) override final
 	{
 		emit MouseEvent(event);
+		UpdateIfDirty();
 	}
 
 	void wheelEvent(QWheelEvent* event) override final;
@@ -85,5 +101,8 @@ protected:
 private:
 	QWidget* const _container;
 	graphics::Scene* const _scene;
+
+	bool _showProfilerOverlay = false;
+	ProfilerOverlay _profilerOverlay;
 };
 }
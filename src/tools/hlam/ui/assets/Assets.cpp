@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <stdexcept>
+#include <utility>
 
 #include "assets/AssetIO.hpp"
 #include "ui/assets/Assets.hpp"
@@ -30,16 +31,28 @@ void AssetProviderRegistry::AddProvider(std::unique_ptr<AssetProvider>&& provide
 	_providers.emplace(provider->GetAssetType(), std::move(provider));
 }
 
-std::unique_ptr<Asset> AssetProviderRegistry::Load(EditorContext* editorContext, const QString& fileName) const
+AssetLoadFunction AssetProviderRegistry::BeginLoad(const QString& fileName) const
 {
+	std::vector<std::pair<const AssetProvider*, AssetLoadFunction>> loaders;
+
+	loaders.reserve(_providers.size());
+
 	for (const auto& provider : _providers)
 	{
-		if (provider.second->CanLoad(fileName))
+		loaders.emplace_back(provider.second.get(), provider.second->BeginLoad(fileName));
+	}
+
+	return [loaders = std::move(loaders), fileName](const std::atomic<bool>& cancelled) -> std::unique_ptr<LoadedAsset>
+	{
+		for (const auto& loader : loaders)
 		{
-			return provider.second->Load(editorContext, fileName);
+			if (loader.first->CanLoad(fileName))
+			{
+				return loader.second(cancelled);
+			}
 		}
-	}
 
-	throw ::assets::AssetException("File type not supported");
+		throw ::assets::AssetException("File type not supported");
+	};
 }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -90,6 +92,28 @@ private:
 	bool _isActive{false};
 };
 
+/**
+*	@brief Asset data loaded on a worker thread
+*/
+class LoadedAsset
+{
+public:
+	virtual ~LoadedAsset() {}
+
+	/**
+	*	@brief Creates the asset from the loaded data. Called on the main thread.
+	*/
+	virtual std::unique_ptr<Asset> CreateAsset(EditorContext* editorContext) = 0;
+};
+
+/**
+*	@brief Loads asset data. Runs on a worker thread so it must not access the editor context, settings or OpenGL.
+*	The cancelled flag can be set by the main thread at any time, it should be checked between stages of the load.
+*	@return The loaded asset, or null if the load was cancelled
+*	@exception ::assets::AssetException If the asset could not be loaded
+*/
+using AssetLoadFunction = std::function<std::unique_ptr<LoadedAsset>(const std::atomic<bool>& cancelled)>;
+
 /**
 *	@brief Provides a means of loading and saving assets
 */
@@ -112,10 +136,17 @@ public:
 	*/
 	virtual QMenu* CreateToolMenu(EditorContext* editorContext) = 0;
 
+	/**
+	*	@brief Called on a worker thread, must not depend on any mutable state.
+	*/
 	virtual bool CanLoad(const QString& fileName) const = 0;
 
+	/**
+	*	@brief Called on the main thread to capture the state needed to load the asset.
+	*	@return Function that loads the asset
+	*/
 	//TODO: pass a filesystem object to resolve additional file locations with
-	virtual std::unique_ptr<Asset> Load(EditorContext* editorContext, const QString& fileName) const = 0;
+	virtual AssetLoadFunction BeginLoad(const QString& fileName) const = 0;
 };
 
 /**
@@ -130,7 +161,11 @@ public:
 
 	virtual void AddProvider(std::unique_ptr<AssetProvider>&& provider) = 0;
 
-	virtual std::unique_ptr<Asset> Load(EditorContext* editorContext, const QString& fileName) const = 0;
+	/**
+	*	@brief Called on the main thread to capture the state needed to load an asset.
+	*	@return Function that finds a provider that can load the file and loads it
+	*/
+	virtual AssetLoadFunction BeginLoad(const QString& fileName) const = 0;
 };
 
 class AssetProviderRegistry final : public IAssetProviderRegistry
@@ -145,7 +180,7 @@ public:
 
 	void AddProvider(std::unique_ptr<AssetProvider>&& provider) override;
 
-	std::unique_ptr<Asset> Load(EditorContext* editorContext, const QString& fileName) const override;
+	AssetLoadFunction BeginLoad(const QString& fileName) const override;
 
 private:
 	std::unordered_map<entt::id_type, std::unique_ptr<AssetProvider>> _providers;
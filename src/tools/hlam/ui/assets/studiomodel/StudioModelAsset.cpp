@@ -13,6 +13,9 @@
 
 #include <GL/glew.h>
 
+#include "core/shared/JobSystem.hpp"
+
+#include "engine/renderer/studiomodel/StudioModelPaletteShader.hpp"
 #include "engine/shared/studiomodel/DumpModelInfo.hpp"
 #include "entity/HLMVStudioModelEntity.hpp"
 #include "game/entity/BaseEntity.hpp"
@@ -82,13 +85,15 @@ StudioModelAsset::StudioModelAsset(QString&& fileName,
 	, _provider(provider)
 	, _studioModel(std::move(studioModel))
 	, _textureLoader(std::make_unique<graphics::TextureLoader>())
-	, _scene(std::make_unique<graphics::Scene>(_textureLoader.get(), editorContext->GetSoundSystem(), editorContext->GetWorldTime()))
+	, _scene(std::make_unique<graphics::Scene>(_textureLoader.get(), editorContext->GetSoundSystem(), editorContext->GetWorldTime(),
+		editorContext->GetJobSystem()))
 {
 	PushInputSink(this);
 
 	UpdateColors();
 
 	_scene->FloorLength = _provider->GetStudioModelSettings()->GetFloorLength();
+	_scene->SetGPUSkinningEnabled(_provider->GetStudioModelSettings()->ShouldUseGPUSkinning());
 
 	auto entity = static_cast<HLMVStudioModelEntity*>(_scene->GetEntityContext()->EntityManager->Create("studiomodel", _scene->GetEntityContext(),
 		glm::vec3(), glm::vec3(), false));
@@ -130,6 +135,12 @@ StudioModelAsset::StudioModelAsset(QString&& fileName,
 	connect(_editorContext, &EditorContext::Tick, this, &StudioModelAsset::OnTick);
 	connect(_editorContext->GetColorSettings(), &settings::ColorSettings::ColorsChanged, this, &StudioModelAsset::UpdateColors);
 	connect(_provider->GetStudioModelSettings(), &settings::StudioModelSettings::FloorLengthChanged, this, &StudioModelAsset::OnFloorLengthChanged);
+	connect(_provider->GetStudioModelSettings(), &settings::StudioModelSettings::GPUSkinningChanged, this, &StudioModelAsset::OnGPUSkinningChanged);
+
+	//The scene can't detect changes to the model data by itself
+	connect(this, &StudioModelAsset::ModelChanged, this, &StudioModelAsset::OnSceneContentsChanged);
+	connect(this, &StudioModelAsset::IsActiveChanged, this, &StudioModelAsset::OnSceneContentsChanged);
+	connect(GetUndoStack(), &QUndoStack::indexChanged, this, &StudioModelAsset::OnSceneContentsChanged);
 }
 
 StudioModelAsset::~StudioModelAsset()
@@ -188,7 +199,10 @@ void StudioModelAsset::SetupFullscreenWidget(FullscreenWidget* fullscreenWidget)
 
 	fullscreenWidget->setCentralWidget(sceneWidget->GetContainer());
 
-	//sceneWidget->connect(this, &StudioModelAsset::Draw, sceneWidget, &SceneWidget::requestUpdate);
+	sceneWidget->connect(this, &StudioModelAsset::Tick, sceneWidget, &SceneWidget::UpdateIfDirty);
+
+	sceneWidget->SetShowProfilerOverlay(_editorContext->IsProfilerOverlayVisible());
+	sceneWidget->connect(_editorContext, &EditorContext::ProfilerOverlayVisibilityChanged, sceneWidget, &SceneWidget::SetShowProfilerOverlay);
 	sceneWidget->connect(sceneWidget, &SceneWidget::MouseEvent, this, &StudioModelAsset::OnSceneWidgetMouseEvent);
 
 	//Filter key events on the scene widget so we can capture exit even if it has focus
@@ -273,12 +287,22 @@ void StudioModelAsset::ChangeCamera(bool next)
 void StudioModelAsset::OnTick()
 {
 	//TODO: update asset-local world time
-	//TODO: pause all updates while not active
+	//Hidden assets don't need to animate or redraw. Entities limit how far they advance after a pause
+	if (!IsActive())
+	{
+		return;
+	}
+
 	_scene->Tick();
 
 	emit Tick();
 }
 
+void StudioModelAsset::OnSceneContentsChanged()
+{
+	_scene->MarkDirty();
+}
+
 void StudioModelAsset::OnMouseEvent(QMouseEvent* event)
 {
 	if (_cameraOperator)
@@ -332,6 +356,11 @@ void StudioModelAsset::OnFloorLengthChanged(int length)
 	_scene->FloorLength = length;
 }
 
+void StudioModelAsset::OnGPUSkinningChanged(bool value)
+{
+	_scene->SetGPUSkinningEnabled(value);
+}
+
 void StudioModelAsset::OnPreviousCamera()
 {
 	ChangeCamera(false);
@@ -557,10 +586,73 @@ bool StudioModelAssetProvider::CanLoad(const QString& fileName) const
 	return studiomdl::IsStudioModel(fileName.toStdString());
 }
 
-std::unique_ptr<Asset> StudioModelAssetProvider::Load(EditorContext* editorContext, const QString& fileName) const
+namespace
+{
+class LoadedStudioModel final : public LoadedAsset
+{
+public:
+	LoadedStudioModel(QString&& fileName, const StudioModelAssetProvider* provider, std::unique_ptr<studiomdl::StudioModel>&& studioModel)
+		: _fileName(std::move(fileName))
+		, _provider(provider)
+		, _studioModel(std::move(studioModel))
+	{
+	}
+
+	std::unique_ptr<Asset> CreateAsset(EditorContext* editorContext) override
+	{
+		return std::make_unique<StudioModelAsset>(std::move(_fileName), editorContext, _provider, std::move(_studioModel));
+	}
+
+private:
+	QString _fileName;
+	const StudioModelAssetProvider* const _provider;
+	std::unique_ptr<studiomdl::StudioModel> _studioModel;
+};
+}
+
+AssetLoadFunction StudioModelAssetProvider::BeginLoad(const QString& fileName) const
 {
-	auto studioModel = studiomdl::LoadStudioModel(fileName.toStdString().c_str());
+	//Settings can only be accessed on the main thread
+	const bool useMemoryMapping = _studioModelSettings->ShouldMemoryMapModels();
+	const bool powerOf2Textures = _studioModelSettings->ShouldResizeTexturesToPowerOf2();
+	const int maxResidentSequenceGroups = _studioModelSettings->GetMaxResidentSequenceGroups();
+
+	//Indexed textures are uploaded as-is, so there is nothing to convert
+	const bool prepareTextures = !studiomdl::IsPaletteLookupSupported();
+
+	return [this, fileName, useMemoryMapping, powerOf2Textures, maxResidentSequenceGroups, prepareTextures](
+		const std::atomic<bool>& cancelled) -> std::unique_ptr<LoadedAsset>
+	{
+		auto studioModel = studiomdl::LoadStudioModel(fileName.toStdString().c_str(), useMemoryMapping, &cancelled);
+
+		//Converting the textures is the most expensive part, don't start it if the load is no longer needed
+		if (!studioModel || cancelled)
+		{
+			return {};
+		}
+
+		studioModel->SetMaxResidentSequenceGroups(maxResidentSequenceGroups);
+
+		//Loads run as jobs, neighbouring sequence groups are loaded in the background on the same workers
+		studioModel->SetJobSystem(JobSystem::GetCurrent());
+
+		if (prepareTextures)
+		{
+			//Convert textures here so the main thread only has to upload them
+			graphics::TextureLoader textureLoader;
+
+			textureLoader.SetResizeToPowerOf2(powerOf2Textures);
+
+			//The conversion can be split up over the same workers
+			studioModel->PrepareTextures(textureLoader, studioModel->GetJobSystem());
+
+			if (cancelled)
+			{
+				return {};
+			}
+		}
 
-	return std::make_unique<StudioModelAsset>(QString{fileName}, editorContext, this, std::move(studioModel));
+		return std::make_unique<LoadedStudioModel>(QString{fileName}, this, std::move(studioModel));
+	};
 }
 }
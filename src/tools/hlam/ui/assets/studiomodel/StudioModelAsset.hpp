@@ -59,7 +59,7 @@ public:
 
 	bool CanLoad(const QString& fileName) const override;
 
-	std::unique_ptr<Asset> Load(EditorContext* editorContext, const QString& fileName) const override;
+	AssetLoadFunction BeginLoad(const QString& fileName) const override;
 
 	settings::StudioModelSettings* GetStudioModelSettings() const { return _studioModelSettings.get(); }
 
@@ -150,6 +150,8 @@ signals:
 private slots:
 	void OnTick();
 
+	void OnSceneContentsChanged();
+
 	void OnSceneWidgetMouseEvent(QMouseEvent* event);
 
 	void OnSceneWidgetWheelEvent(QWheelEvent* event);
@@ -158,6 +160,8 @@ private slots:
 
 	void OnFloorLengthChanged(int length);
 
+	void OnGPUSkinningChanged(bool value);
+
 	void OnPreviousCamera();
 	void OnNextCamera();
 
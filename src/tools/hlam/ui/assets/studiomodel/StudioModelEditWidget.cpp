@@ -103,7 +103,10 @@ StudioModelEditWidget::StudioModelEditWidget(
 		_controlAreaWidget->setLayout(controlAreaLayout);
 	}
 
-	//connect(asset, &StudioModelAsset::Draw, _sceneWidget, &SceneWidget::requestUpdate);
+	connect(asset, &StudioModelAsset::Tick, _sceneWidget, &SceneWidget::UpdateIfDirty);
+
+	_sceneWidget->SetShowProfilerOverlay(editorContext->IsProfilerOverlayVisible());
+	connect(editorContext, &EditorContext::ProfilerOverlayVisibilityChanged, _sceneWidget, &SceneWidget::SetShowProfilerOverlay);
 
 	connect(_dockPanels, &QTabWidget::currentChanged, this, &StudioModelEditWidget::OnTabChanged);
 
@@ -235,7 +235,7 @@ void ImportTextureCommand::Apply(int index, const ImportTextureData& oldValue, c
 	memcpy(header->GetData() + texture->index, newValue.Pixels.get(), newValue.Width * newValue.Height);
 	memcpy(header->GetData() + texture->index + (newValue.Width * newValue.Height), newValue.Palette, PALETTE_SIZE);
 
-	model->ReplaceTexture(*_asset->GetTextureLoader(), texture, newValue.Pixels.get(), newValue.Palette, model->GetTextureId(index));
+	model->ReplaceTexture(*_asset->GetTextureLoader(), texture, newValue.Pixels.get(), newValue.Palette);
 }
 
 void ChangeEventCommand::Apply(int index, const mstudioevent_t& oldValue, const mstudioevent_t& newValue)
@@ -2,6 +2,8 @@
 
 #include "entity/HLMVStudioModelEntity.hpp"
 
+#include "graphics/GPUTimer.hpp"
+
 #include "ui/assets/studiomodel/StudioModelAsset.hpp"
 #include "ui/assets/studiomodel/dockpanels/InfoBar.hpp"
 
@@ -39,5 +41,65 @@ void InfoBar::OnDraw()
 		_oldDrawnPolygonsCount = drawnPolygonsCount;
 		_ui.DrawnPolygonsCountLabel->setText(QString::number(drawnPolygonsCount));
 	}
+
+	const unsigned int poseCacheHits = _asset->GetScene()->GetPoseCacheHits();
+	const unsigned int poseCacheMisses = _asset->GetScene()->GetPoseCacheMisses();
+
+	if (_oldPoseCacheHits != poseCacheHits || _oldPoseCacheMisses != poseCacheMisses)
+	{
+		_oldPoseCacheHits = poseCacheHits;
+		_oldPoseCacheMisses = poseCacheMisses;
+		_ui.PoseCacheLabel->setText(QString{"%1/%2"}.arg(poseCacheHits).arg(poseCacheMisses));
+	}
+
+	const auto scene = _asset->GetScene();
+
+	if (_oldEntityCount != scene->GetEntityCount())
+	{
+		_oldEntityCount = scene->GetEntityCount();
+		_ui.EntitiesLabel->setText(QString::number(_oldEntityCount));
+	}
+
+	const auto& callCounts = scene->GetGLCallCounts();
+
+	if (_oldGLCallCounts.DrawCalls != callCounts.DrawCalls
+		|| _oldGLCallCounts.TextureBinds != callCounts.TextureBinds
+		|| _oldGLCallCounts.StateChanges != callCounts.StateChanges)
+	{
+		_oldGLCallCounts = callCounts;
+		_ui.DrawCallsLabel->setText(QString{"%1/%2/%3"}
+			.arg(callCounts.DrawCalls).arg(callCounts.TextureBinds).arg(callCounts.StateChanges));
+	}
+
+	//Frame times change every frame, so they are updated a few times per second to keep them readable
+	if (_lastFrameTimeUpdate == 0 || ((currentTick - _lastFrameTimeUpdate) >= 250))
+	{
+		_lastFrameTimeUpdate = currentTick;
+
+		const float gpuFrameTime = scene->GetGPUFrameTime();
+
+		_ui.FrameTimeLabel->setText(QString{"%1/%2"}
+			.arg(scene->GetCPUFrameTime(), 0, 'f', 2)
+			.arg(gpuFrameTime >= 0 ? QString::number(gpuFrameTime, 'f', 2) : QString{"N/A"}));
+
+		QString passTimes;
+
+		if (gpuFrameTime >= 0)
+		{
+			for (int i = 0; i < static_cast<int>(graphics::RenderPass::Count); ++i)
+			{
+				const auto pass = static_cast<graphics::RenderPass>(i);
+
+				if (!passTimes.isEmpty())
+				{
+					passTimes += '\n';
+				}
+
+				passTimes += QString{"%1: %2 ms"}.arg(graphics::RenderPassToString(pass)).arg(scene->GetGPUPassTime(pass), 0, 'f', 3);
+			}
+		}
+
+		_ui.FrameTimeLabel->setToolTip(passTimes);
+	}
 }
 }
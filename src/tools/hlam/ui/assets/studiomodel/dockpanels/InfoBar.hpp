@@ -6,6 +6,8 @@
 
 #include "core/shared/Utility.hpp"
 
+#include "graphics/OpenGL.hpp"
+
 namespace ui::assets::studiomodel
 {
 class StudioModelAsset;
@@ -29,5 +31,13 @@ private:
 	unsigned int _currentFPS{0};
 
 	unsigned int _oldDrawnPolygonsCount{0};
+
+	unsigned int _oldPoseCacheHits{0};
+	unsigned int _oldPoseCacheMisses{0};
+
+	unsigned int _oldEntityCount{0};
+	GLCallCounts _oldGLCallCounts;
+
+	long long _lastFrameTimeUpdate{0};
 };
 }
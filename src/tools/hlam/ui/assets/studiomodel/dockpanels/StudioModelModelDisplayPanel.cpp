@@ -13,6 +13,9 @@ StudioModelModelDisplayPanel::StudioModelModelDisplayPanel(StudioModelAsset* ass
 
 	_ui.GroundTextureSize->setValue(_asset->GetScene()->FloorTextureLength);
 
+	_ui.CrowdSize->setMaximum(graphics::Scene::MaxCrowdSize);
+	_ui.CrowdSize->setValue(_asset->GetScene()->GetCrowdSize());
+
 	connect(_ui.RenderModeComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &StudioModelModelDisplayPanel::OnRenderModeChanged);
 
 	connect(_ui.OpacitySlider, &QSlider::valueChanged, this, &StudioModelModelDisplayPanel::OnOpacityChanged);
@@ -43,6 +46,7 @@ StudioModelModelDisplayPanel::StudioModelModelDisplayPanel(StudioModelAsset* ass
 
 	connect(_ui.CenterModelOnWorldOrigin, &QPushButton::clicked, this, &StudioModelModelDisplayPanel::OnCenterModelOnWorldOrigin);
 	connect(_ui.AlignOnGround, &QPushButton::clicked, this, &StudioModelModelDisplayPanel::OnAlignOnGround);
+	connect(_ui.CrowdSize, qOverload<int>(&QSpinBox::valueChanged), this, &StudioModelModelDisplayPanel::OnCrowdSizeChanged);
 
 	connect(_ui.EnableGroundTextureTiling, &QGroupBox::toggled, this, &StudioModelModelDisplayPanel::OnEnableGroundTextureTilingChanged);
 	connect(_ui.GroundTextureSize, qOverload<int>(&QSpinBox::valueChanged), this, &StudioModelModelDisplayPanel::OnGroundTextureSizeChanged);
@@ -183,6 +187,11 @@ void StudioModelModelDisplayPanel::OnAlignOnGround()
 	_asset->GetScene()->AlignOnGround();
 }
 
+void StudioModelModelDisplayPanel::OnCrowdSizeChanged()
+{
+	_asset->GetScene()->SetCrowdSize(_ui.CrowdSize->value());
+}
+
 void StudioModelModelDisplayPanel::OnEnableGroundTextureTilingChanged()
 {
 	_asset->GetScene()->EnableFloorTextureTiling = _ui.EnableGroundTextureTiling->isChecked();
@@ -46,6 +46,8 @@ private:
 
 	void OnAlignOnGround();
 
+	void OnCrowdSizeChanged();
+
 	void OnEnableGroundTextureTilingChanged();
 	void OnGroundTextureSizeChanged();
 
@@ -1,7 +1,12 @@
+#include <cstring>
 #include <limits>
+#include <string_view>
+#include <unordered_set>
 
 #include "engine/shared/activity.hpp"
 
+#include "game/Events.hpp"
+
 #include "entity/HLMVStudioModelEntity.hpp"
 
 #include "qt/ByteLengthValidator.hpp"
@@ -85,9 +90,15 @@ void StudioModelSequencesPanel::OnModelChanged(const ModelChangeEvent& event)
 	{
 		const auto& listChange = static_cast<const ModelEventChangeEvent&>(event);
 
-		if (listChange.GetSourceIndex() == _ui.SequenceComboBox->currentIndex() && listChange.GetEventIndex() == _ui.EventsComboBox->currentIndex())
+		if (listChange.GetSourceIndex() == _ui.SequenceComboBox->currentIndex())
 		{
-			OnEventChanged(_ui.EventsComboBox->currentIndex());
+			if (listChange.GetEventIndex() == _ui.EventsComboBox->currentIndex())
+			{
+				OnEventChanged(_ui.EventsComboBox->currentIndex());
+			}
+
+			//The event may play a different sound now
+			PrecacheSequenceSounds();
 		}
 		break;
 	}
@@ -110,6 +121,67 @@ void StudioModelSequencesPanel::UpdateBlendValue(int blender, BlendUpdateSource
 	entity->SetBlending(blender, spinner->value());
 }
 
+void StudioModelSequencesPanel::PrecacheSequenceSounds()
+{
+	const auto soundSystem = _asset->GetScene()->GetEntityContext()->SoundSystem;
+
+	if (!_ui.PlaySound->isChecked() || !soundSystem->IsSoundAvailable())
+	{
+		_ui.SoundStatusLabel->clear();
+		return;
+	}
+
+	const auto entity = _asset->GetScene()->GetEntity();
+	const auto header = entity->GetModel()->GetStudioHeader();
+	const auto sequence = header->GetSequence(entity->GetSequence());
+	const auto events = reinterpret_cast<const mstudioevent_t*>(header->GetData() + sequence->eventindex);
+
+	std::unordered_set<std::string_view> fileNames;
+
+	int missingCount = 0;
+	int failedCount = 0;
+
+	for (int i = 0; i < sequence->numevents; ++i)
+	{
+		const auto& event = events[i];
+
+		if (!IsSoundEvent(event.event))
+		{
+			continue;
+		}
+
+		const std::string_view fileName{event.options, strnlen(event.options, sizeof(event.options))};
+
+		if (!fileNames.insert(fileName).second)
+		{
+			continue;
+		}
+
+		switch (soundSystem->PrecacheSound(fileName))
+		{
+		case soundsystem::PrecacheResult::Loaded:
+			break;
+
+		case soundsystem::PrecacheResult::NotFound:
+			++missingCount;
+			break;
+
+		case soundsystem::PrecacheResult::LoadFailed:
+			++failedCount;
+			break;
+		}
+	}
+
+	if (fileNames.empty())
+	{
+		_ui.SoundStatusLabel->clear();
+		return;
+	}
+
+	_ui.SoundStatusLabel->setText(QString{"Sounds: %1 (%2 missing, %3 failed to load)"}
+		.arg(fileNames.size()).arg(missingCount).arg(failedCount));
+}
+
 void StudioModelSequencesPanel::OnSequenceChanged(int index)
 {
 	auto entity = _asset->GetScene()->GetEntity();
@@ -242,6 +314,8 @@ void StudioModelSequencesPanel::OnSequenceChanged(int index)
 	}
 
 	_ui.EventsComboBox->setEnabled(hasEvents);
+
+	PrecacheSequenceSounds();
 }
 
 void StudioModelSequencesPanel::OnLoopingModeChanged(int index)
@@ -306,6 +380,8 @@ void StudioModelSequencesPanel::OnEventChanged(int index)
 void StudioModelSequencesPanel::OnPlaySoundChanged()
 {
 	_asset->GetScene()->GetEntity()->PlaySound = _ui.PlaySound->isChecked();
+
+	PrecacheSequenceSounds();
 }
 
 void StudioModelSequencesPanel::OnPitchFramerateAmplitudeChanged()
@@ -28,6 +28,12 @@ private:
 
 	void UpdateBlendValue(int blender, BlendUpdateSource source, QSlider* slider, QDoubleSpinBox* spinner);
 
+	/**
+	*	@brief Loads the sounds played by the current sequence's events so they play without delay,
+	*	and shows how many of them are missing.
+	*/
+	void PrecacheSequenceSounds();
+
 private slots:
 	void OnModelChanged(const ModelChangeEvent& event);
 
@@ -792,8 +792,6 @@ void StudioModelTexturesPanel::RemapTexture(int index)
 
 	const auto texture = textureHeader->GetTexture(index);
 
-	const auto textureId = entity->GetModel()->GetTextureId(index);
-
 	int low, mid, high;
 
 	if (graphics::TryGetRemapColors(texture->name, low, mid, high))
@@ -812,8 +810,10 @@ void StudioModelTexturesPanel::RemapTexture(int index)
 		auto graphicsContext = _asset->GetScene()->GetGraphicsContext();
 
 		graphicsContext->Begin();
-		entity->GetModel()->ReplaceTexture(*_asset->GetTextureLoader(), texture, reinterpret_cast<byte*>(textureHeader) + texture->index, palette, textureId);
+		entity->GetModel()->ReplacePalette(*_asset->GetTextureLoader(), index, palette);
 		graphicsContext->End();
+
+		_asset->GetScene()->MarkDirty();
 	}
 }
 
@@ -1114,6 +1114,8 @@ void StudioModelTexturesPanel::OnTextureFiltersChanged()
 	graphicsContext->Begin();
 	_asset->GetStudioModel()->UpdateFilters(*textureLoader);
 	graphicsContext->End();
+
+	_asset->GetScene()->MarkDirty();
 }
 
 void StudioModelTexturesPanel::OnPowerOf2TexturesChanged()
@@ -1125,5 +1127,7 @@ void StudioModelTexturesPanel::OnPowerOf2TexturesChanged()
 	graphicsContext->Begin();
 	_asset->GetStudioModel()->ReuploadTextures(*_asset->GetTextureLoader());
 	graphicsContext->End();
+
+	_asset->GetScene()->MarkDirty();
 }
 }
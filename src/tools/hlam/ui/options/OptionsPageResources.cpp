@@ -0,0 +1,75 @@
+#include <QTableWidgetItem>
+
+#include "assets/ResourceCache.hpp"
+
+#include "ui/options/OptionsPageGeneral.hpp"
+#include "ui/options/OptionsPageResources.hpp"
+
+namespace ui::options
+{
+const QString OptionsPageResourcesId{QStringLiteral("E.Resources")};
+
+OptionsPageResources::OptionsPageResources()
+{
+	SetCategory(QString{OptionsPageGeneralCategory});
+	SetCategoryTitle("General");
+	SetId(QString{OptionsPageResourcesId});
+	SetPageTitle("Resources");
+	SetWidgetFactory([](EditorContext*)
+		{
+			return new OptionsPageResourcesWidget();
+		});
+}
+
+OptionsPageResources::~OptionsPageResources() = default;
+
+OptionsPageResourcesWidget::OptionsPageResourcesWidget(QWidget* parent)
+	: OptionsWidget(parent)
+{
+	_ui.setupUi(this);
+
+	connect(_ui.Refresh, &QPushButton::clicked, this, &OptionsPageResourcesWidget::OnRefresh);
+
+	OnRefresh();
+}
+
+OptionsPageResourcesWidget::~OptionsPageResourcesWidget() = default;
+
+void OptionsPageResourcesWidget::ApplyChanges(QSettings& settings)
+{
+	//Nothing to apply
+}
+
+void OptionsPageResourcesWidget::OnRefresh()
+{
+	const auto resources = assets::ResourceCache::GetInstance().GetResources();
+
+	_ui.Resources->setSortingEnabled(false);
+	_ui.Resources->setRowCount(static_cast<int>(resources.size()));
+
+	std::size_t totalBytes = 0;
+
+	for (int row = 0; row < static_cast<int>(resources.size()); ++row)
+	{
+		const auto& resource = resources[row];
+
+		auto references = new QTableWidgetItem();
+		references->setData(Qt::DisplayRole, static_cast<qlonglong>(resource.UseCount));
+
+		auto size = new QTableWidgetItem();
+		size->setData(Qt::DisplayRole, static_cast<qulonglong>(resource.Bytes / 1024));
+
+		_ui.Resources->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(resource.Type)));
+		_ui.Resources->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(resource.Name)));
+		_ui.Resources->setItem(row, 2, references);
+		_ui.Resources->setItem(row, 3, size);
+
+		totalBytes += resource.Bytes;
+	}
+
+	_ui.Resources->setSortingEnabled(true);
+	_ui.Resources->resizeColumnsToContents();
+
+	_ui.Total->setText(QString{"%1 resources, %2 KiB"}.arg(resources.size()).arg(totalBytes / 1024));
+}
+}
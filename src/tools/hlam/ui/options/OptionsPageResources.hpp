@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QSettings>
+#include <QWidget>
+
+#include "ui_OptionsPageResources.h"
+
+#include "ui/options/OptionsPage.hpp"
+
+namespace ui
+{
+class EditorContext;
+
+namespace options
+{
+/**
+*	@brief Shows the resources shared between assets. Intended for debugging, has no settings.
+*/
+class OptionsPageResources : public OptionsPage
+{
+public:
+	OptionsPageResources();
+	~OptionsPageResources();
+};
+
+class OptionsPageResourcesWidget final : public OptionsWidget
+{
+public:
+	OptionsPageResourcesWidget(QWidget* parent = nullptr);
+	~OptionsPageResourcesWidget();
+
+	void ApplyChanges(QSettings& settings) override;
+
+private slots:
+	void OnRefresh();
+
+private:
+	Ui_OptionsPageResources _ui;
+};
+}
+}
@@ -35,6 +35,8 @@ OptionsPageStudioModelWidget::OptionsPageStudioModelWidget(EditorContext* editor
 
 	_ui.AutodetectViewmodels->setChecked(_studioModelSettings->ShouldAutodetectViewmodels());
 	_ui.PowerOf2Textures->setChecked(_studioModelSettings->ShouldResizeTexturesToPowerOf2());
+	_ui.GPUSkinning->setChecked(_studioModelSettings->ShouldUseGPUSkinning());
+	_ui.MemoryMapModels->setChecked(_studioModelSettings->ShouldMemoryMapModels());
 
 	_ui.FloorLengthSlider->setRange(_studioModelSettings->MinimumFloorLength, _studioModelSettings->MaximumFloorLength);
 	_ui.FloorLengthSpinner->setRange(_studioModelSettings->MinimumFloorLength, _studioModelSettings->MaximumFloorLength);
@@ -42,6 +44,9 @@ OptionsPageStudioModelWidget::OptionsPageStudioModelWidget(EditorContext* editor
 	_ui.FloorLengthSlider->setValue(_studioModelSettings->GetFloorLength());
 	_ui.FloorLengthSpinner->setValue(_studioModelSettings->GetFloorLength());
 
+	_ui.MaxResidentSequenceGroups->setRange(_studioModelSettings->MinimumResidentSequenceGroups, _studioModelSettings->MaximumResidentSequenceGroups);
+	_ui.MaxResidentSequenceGroups->setValue(_studioModelSettings->GetMaxResidentSequenceGroups());
+
 	_ui.Compiler->setText(_studioModelSettings->GetStudiomdlCompilerFileName());
 	_ui.Decompiler->setText(_studioModelSettings->GetStudiomdlDecompilerFileName());
 
@@ -63,7 +68,10 @@ void OptionsPageStudioModelWidget::ApplyChanges(QSettings& settings)
 {
 	_studioModelSettings->SetAutodetectViewmodels(_ui.AutodetectViewmodels->isChecked());
 	_studioModelSettings->SetResizeTexturesToPowerOf2(_ui.PowerOf2Textures->isChecked());
+	_studioModelSettings->SetUseGPUSkinning(_ui.GPUSkinning->isChecked());
+	_studioModelSettings->SetMemoryMapModels(_ui.MemoryMapModels->isChecked());
 	_studioModelSettings->SetFloorLength(_ui.FloorLengthSlider->value());
+	_studioModelSettings->SetMaxResidentSequenceGroups(_ui.MaxResidentSequenceGroups->value());
 	_studioModelSettings->SetStudiomdlCompilerFileName(_ui.Compiler->text());
 	_studioModelSettings->SetStudiomdlDecompilerFileName(_ui.Decompiler->text());
 
@@ -17,11 +17,17 @@ class StudioModelSettings final : public QObject
 public:
 	static constexpr bool DefaultAutodetectViewmodels{true};
 	static constexpr bool DefaultPowerOf2Textures{true};
+	static constexpr bool DefaultGPUSkinning{false};
+	static constexpr bool DefaultMemoryMapModels{false};
 
 	static constexpr int MinimumFloorLength = 0;
 	static constexpr int MaximumFloorLength = 2048;
 	static constexpr int DefaultFloorLength = 100;
 
+	static constexpr int MinimumResidentSequenceGroups = 1;
+	static constexpr int MaximumResidentSequenceGroups = 32;
+	static constexpr int DefaultResidentSequenceGroups = 8;
+
 	static constexpr graphics::TextureFilter DefaultMinFilter{graphics::TextureFilter::Linear};
 	static constexpr graphics::TextureFilter DefaultMagFilter{graphics::TextureFilter::Linear};
 	static constexpr graphics::MipmapFilter DefaultMipmapFilter{graphics::MipmapFilter::None};
@@ -38,7 +44,11 @@ public:
 		settings.beginGroup("assets/studiomodel");
 		_autodetectViewModels = settings.value("AutodetectViewmodels", DefaultAutodetectViewmodels).toBool();
 		_powerOf2Textures = settings.value("PowerOf2Textures", DefaultPowerOf2Textures).toBool();
+		_gpuSkinning = settings.value("GPUSkinning", DefaultGPUSkinning).toBool();
+		_memoryMapModels = settings.value("MemoryMapModels", DefaultMemoryMapModels).toBool();
 		_floorLength = std::clamp(settings.value("FloorLength", DefaultFloorLength).toInt(), MinimumFloorLength, MaximumFloorLength);
+		_maxResidentSequenceGroups = std::clamp(settings.value("MaxResidentSequenceGroups", DefaultResidentSequenceGroups).toInt(),
+			MinimumResidentSequenceGroups, MaximumResidentSequenceGroups);
 		_studiomdlCompilerFileName = settings.value("CompilerFileName").toString();
 		_studiomdlDecompilerFileName = settings.value("DecompilerFileName").toString();
 
@@ -67,7 +77,10 @@ public:
 		settings.beginGroup("assets/studiomodel");
 		settings.setValue("AutodetectViewmodels", _autodetectViewModels);
 		settings.setValue("PowerOf2Textures", _powerOf2Textures);
+		settings.setValue("GPUSkinning", _gpuSkinning);
+		settings.setValue("MemoryMapModels", _memoryMapModels);
 		settings.setValue("FloorLength", _floorLength);
+		settings.setValue("MaxResidentSequenceGroups", _maxResidentSequenceGroups);
 		settings.setValue("CompilerFileName", _studiomdlCompilerFileName);
 		settings.setValue("DecompilerFileName", _studiomdlDecompilerFileName);
 
@@ -110,6 +123,25 @@ public:
 		_powerOf2Textures = value;
 	}
 
+	bool ShouldUseGPUSkinning() const { return _gpuSkinning; }
+
+	void SetUseGPUSkinning(bool value)
+	{
+		if (_gpuSkinning != value)
+		{
+			_gpuSkinning = value;
+
+			emit GPUSkinningChanged(_gpuSkinning);
+		}
+	}
+
+	bool ShouldMemoryMapModels() const { return _memoryMapModels; }
+
+	void SetMemoryMapModels(bool value)
+	{
+		_memoryMapModels = value;
+	}
+
 	int GetFloorLength() const { return _floorLength; }
 
 	void SetFloorLength(int value)
@@ -122,6 +154,16 @@ public:
 		}
 	}
 
+	/**
+	*	@brief Maximum number of sequence group files to keep loaded per model. Applies to models loaded afterwards.
+	*/
+	int GetMaxResidentSequenceGroups() const { return _maxResidentSequenceGroups; }
+
+	void SetMaxResidentSequenceGroups(int value)
+	{
+		_maxResidentSequenceGroups = value;
+	}
+
 	QString GetStudiomdlCompilerFileName() const { return _studiomdlCompilerFileName; }
 
 	void SetStudiomdlCompilerFileName(const QString& fileName)
@@ -139,12 +181,18 @@ public:
 signals:
 	void FloorLengthChanged(int length);
 
+	void GPUSkinningChanged(bool value);
+
 private:
 	bool _autodetectViewModels{DefaultAutodetectViewmodels};
 	bool _powerOf2Textures{DefaultPowerOf2Textures};
+	bool _gpuSkinning{DefaultGPUSkinning};
+	bool _memoryMapModels{DefaultMemoryMapModels};
 
 	int _floorLength = DefaultFloorLength;
 
+	int _maxResidentSequenceGroups = DefaultResidentSequenceGroups;
+
 	QString _studiomdlCompilerFileName;
 	QString _studiomdlDecompilerFileName;
 
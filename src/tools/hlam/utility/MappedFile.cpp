@@ -0,0 +1,64 @@
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "utility/MappedFile.hpp"
+
+MappedFile::~MappedFile()
+{
+#ifdef WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle(_mappingHandle);
+#else
+	munmap(_data, _size);
+#endif
+}
+
+std::unique_ptr<MappedFile> MappedFile::Map(FILE* file, std::size_t size)
+{
+	//Empty mappings are not allowed
+	if (!file || size == 0)
+	{
+		return {};
+	}
+
+#ifdef WIN32
+	const auto fileHandle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return {};
+	}
+
+	//The mapping object keeps the file open after the caller closes it
+	const HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+
+	if (!mappingHandle)
+	{
+		return {};
+	}
+
+	void* const data = MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, size);
+
+	if (!data)
+	{
+		CloseHandle(mappingHandle);
+		return {};
+	}
+
+	return std::unique_ptr<MappedFile>(new MappedFile(data, size, mappingHandle));
+#else
+	void* const data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+
+	if (data == MAP_FAILED)
+	{
+		return {};
+	}
+
+	return std::unique_ptr<MappedFile>(new MappedFile(data, size, nullptr));
+#endif
+}
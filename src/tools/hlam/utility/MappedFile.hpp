@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+
+/**
+*	@brief A private, copy-on-write memory mapping of a file.
+*	Changes made to the mapped memory are never written back to the file.
+*	The operating system copies pages the first time they are written to, so only modified data uses private memory.
+*	The file must not be truncated or overwritten while it is mapped, copy the data and destroy the mapping first.
+*	On Windows this is enforced by the operating system, elsewhere accessing truncated pages terminates the program.
+*/
+class MappedFile final
+{
+private:
+	MappedFile(void* data, std::size_t size, void* mappingHandle)
+		: _data(data)
+		, _size(size)
+		, _mappingHandle(mappingHandle)
+	{
+	}
+
+public:
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	*	@brief Maps the first size bytes of an open file. The file can be closed afterwards.
+	*	@return The mapping, or null if the file could not be mapped.
+	*/
+	static std::unique_ptr<MappedFile> Map(FILE* file, std::size_t size);
+
+	void* GetData() const { return _data; }
+
+	std::size_t GetSize() const { return _size; }
+
+private:
+	void* const _data;
+	const std::size_t _size;
+	void* const _mappingHandle;
+};
@@ -0,0 +1,236 @@
+#include <cmath>
+
+#include "utility/mathlib.hpp"
+#include "utility/MathBatch.hpp"
+#include "utility/MathBatchKernels.hpp"
+
+namespace mathbatch
+{
+static void ScalarVectorTransform(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t,
+	glm::vec3* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		VectorTransform(in[i], transforms[bones[i]], out[i]);
+	}
+}
+
+static void ScalarVectorRotate(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t,
+	glm::vec3* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		VectorRotate(in[i], transforms[bones[i]], out[i]);
+	}
+}
+
+static void ScalarQuaternionSlerp(glm::vec4* p, glm::vec4* q, float t, std::size_t count)
+{
+	glm::vec4 result;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		::QuaternionSlerp(p[i], q[i], t, result);
+		p[i] = result;
+	}
+}
+
+static void ScalarLerp(float* a, const float* b, float t, std::size_t count)
+{
+	const float t1 = 1.0 - t;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		a[i] = a[i] * t1 + b[i] * t;
+	}
+}
+
+static void ScalarQuaternionMatrix(const glm::vec4* quaternions, const glm::vec3* positions, glm::mat3x4* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		::QuaternionMatrix(quaternions[i], out[i]);
+
+		out[i][0][3] = positions[i][0];
+		out[i][1][3] = positions[i][1];
+		out[i][2][3] = positions[i][2];
+	}
+}
+
+static void ScalarConcatBoneTransforms(const glm::mat3x4* local, const int* parents, glm::mat3x4* out, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		if (parents[i] == -1)
+		{
+			out[i] = local[i];
+		}
+		else
+		{
+			R_ConcatTransforms(out[parents[i]], local[i], out[i]);
+		}
+	}
+}
+
+static void ScalarQuaternionNlerpSoA(float* const* p, const float* const* q, float t, std::size_t count)
+{
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const float dot = p[0][i] * q[0][i] + p[1][i] * q[1][i] + p[2][i] * q[2][i] + p[3][i] * q[3][i];
+
+		//Interpolate along the shortest path
+		const float correctedT = CorrectNlerpFraction(t, std::fabs(dot));
+		const float pScale = 1 - correctedT;
+		const float qScale = dot < 0 ? -correctedT : correctedT;
+
+		float result[4];
+
+		for (int j = 0; j < 4; ++j)
+		{
+			result[j] = p[j][i] * pScale + q[j][i] * qScale;
+		}
+
+		const float length = std::sqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2] + result[3] * result[3]);
+
+		for (int j = 0; j < 4; ++j)
+		{
+			p[j][i] = result[j] / length;
+		}
+	}
+}
+
+const Kernels ScalarKernels
+{
+	&ScalarVectorTransform,
+	&ScalarVectorRotate,
+	&ScalarQuaternionSlerp,
+	&ScalarLerp,
+	&ScalarQuaternionMatrix,
+	&ScalarConcatBoneTransforms,
+	&ScalarQuaternionNlerpSoA
+};
+
+static bool IsSupported(MathBatchImplementation implementation)
+{
+	switch (implementation)
+	{
+	case MathBatchImplementation::Scalar: return true;
+
+	case MathBatchImplementation::SSE2: return IsSSE2Supported();
+	case MathBatchImplementation::AVX2: return IsAVX2Supported();
+
+	default: return false;
+	}
+}
+
+static const Kernels& GetKernels(MathBatchImplementation implementation)
+{
+	switch (implementation)
+	{
+#if HLAM_SIMD_X86
+	case MathBatchImplementation::SSE2: return SSE2Kernels;
+	case MathBatchImplementation::AVX2: return AVX2Kernels;
+#endif
+	default: return ScalarKernels;
+	}
+}
+
+static MathBatchImplementation SelectBestImplementation()
+{
+	for (auto implementation : {MathBatchImplementation::AVX2, MathBatchImplementation::SSE2})
+	{
+		if (IsSupported(implementation))
+		{
+			return implementation;
+		}
+	}
+
+	return MathBatchImplementation::Scalar;
+}
+
+struct State
+{
+	MathBatchImplementation Implementation = SelectBestImplementation();
+	const Kernels* CurrentKernels = &GetKernels(Implementation);
+};
+
+static State& GetState()
+{
+	static State state;
+	return state;
+}
+}
+
+MathBatchImplementation GetMathBatchImplementation()
+{
+	return mathbatch::GetState().Implementation;
+}
+
+bool SetMathBatchImplementation(MathBatchImplementation implementation)
+{
+	if (!mathbatch::IsSupported(implementation))
+	{
+		return false;
+	}
+
+	auto& state = mathbatch::GetState();
+
+	state.Implementation = implementation;
+	state.CurrentKernels = &mathbatch::GetKernels(implementation);
+
+	return true;
+}
+
+const char* MathBatchImplementationToString(MathBatchImplementation implementation)
+{
+	switch (implementation)
+	{
+	case MathBatchImplementation::Scalar: return "Scalar";
+	case MathBatchImplementation::SSE2: return "SSE2";
+	case MathBatchImplementation::AVX2: return "AVX2";
+	default: return "Unknown";
+	}
+}
+
+void VectorTransformBatch(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->VectorTransform(in, bones, transforms, boneCount, out, count);
+}
+
+void VectorRotateBatch(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->VectorRotate(in, bones, transforms, boneCount, out, count);
+}
+
+void QuaternionSlerpBatch(glm::vec4* p, glm::vec4* q, float t, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->QuaternionSlerp(p, q, t, count);
+}
+
+void LerpBatch(float* a, const float* b, float t, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->Lerp(a, b, t, count);
+}
+
+void VectorLerpBatch(glm::vec3* a, const glm::vec3* b, float t, std::size_t count)
+{
+	//Each component is interpolated independently so the vectors can be treated as a flat array
+	LerpBatch(reinterpret_cast<float*>(a), reinterpret_cast<const float*>(b), t, count * 3);
+}
+
+void QuaternionNlerpBatchSoA(float* const* p, const float* const* q, float t, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->QuaternionNlerpSoA(p, q, t, count);
+}
+
+void QuaternionMatrixBatch(const glm::vec4* quaternions, const glm::vec3* positions, glm::mat3x4* out, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->QuaternionMatrix(quaternions, positions, out, count);
+}
+
+void ConcatBoneTransformsBatch(const glm::mat3x4* local, const int* parents, glm::mat3x4* out, std::size_t count)
+{
+	mathbatch::GetState().CurrentKernels->ConcatBoneTransforms(local, parents, out, count);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x4.hpp>
+
+#include "core/shared/Const.hpp"
+
+/**
+*	@file
+*
+*	Batch variants of mathlib functions that operate on contiguous arrays.
+*	SSE2 and AVX2 implementations are selected at runtime based on what the CPU supports.
+*	All implementations produce results that are bit identical to calling the mathlib function on each element.
+*/
+
+enum class MathBatchImplementation
+{
+	Scalar = 0,
+	SSE2,
+	AVX2
+};
+
+/**
+*	@brief Gets the implementation used by the batch functions.
+*/
+MathBatchImplementation GetMathBatchImplementation();
+
+/**
+*	@brief Overrides the implementation used by the batch functions. Not thread safe, intended for testing and benchmarks.
+*	@return Whether the implementation is supported by this CPU. If not, the current implementation is left unchanged.
+*/
+bool SetMathBatchImplementation(MathBatchImplementation implementation);
+
+const char* MathBatchImplementationToString(MathBatchImplementation implementation);
+
+/**
+*	@brief Performs VectorTransform(in[i], transforms[bones[i]], out[i]) for each element.
+*	@param boneCount Number of transforms. Every bone index must be smaller than this.
+*/
+void VectorTransformBatch(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count);
+
+/**
+*	@brief Performs VectorRotate(in[i], transforms[bones[i]], out[i]) for each element.
+*	@param boneCount Number of transforms. Every bone index must be smaller than this.
+*/
+void VectorRotateBatch(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count);
+
+/**
+*	@brief Performs QuaternionSlerp(p[i], q[i], t, p[i]) for each element. Like QuaternionSlerp, q may be negated.
+*/
+void QuaternionSlerpBatch(glm::vec4* p, glm::vec4* q, float t, std::size_t count);
+
+/**
+*	@brief Performs a[i] = a[i] * (1 - t) + b[i] * t for each element.
+*/
+void LerpBatch(float* a, const float* b, float t, std::size_t count);
+
+/**
+*	@brief Performs a[i] = a[i] * (1 - t) + b[i] * t for each element.
+*/
+void VectorLerpBatch(glm::vec3* a, const glm::vec3* b, float t, std::size_t count);
+
+/**
+*	@brief Performs QuaternionMatrix(quaternions[i], out[i]) for each element and stores positions[i] in the translation column.
+*/
+void QuaternionMatrixBatch(const glm::vec4* quaternions, const glm::vec3* positions, glm::mat3x4* out, std::size_t count);
+
+/**
+*	@brief Concatenates local bone transforms with their parent's transform.
+*	Each parent must come before its children, a parent index of -1 means the bone has no parent.
+*	Performs R_ConcatTransforms(out[parents[i]], local[i], out[i]) or out[i] = local[i] for each element.
+*/
+void ConcatBoneTransformsBatch(const glm::mat3x4* local, const int* parents, glm::mat3x4* out, std::size_t count);
+
+/**
+*	@brief Interpolates quaternions stored as separate X, Y, Z and W arrays and stores the result in p.
+*	Uses normalized linear interpolation along the shortest path with a correction to the fraction
+*	that keeps the result within 0.1 degrees of QuaternionSlerp. Unlike the other batch functions this does not match a mathlib function.
+*	@param p X, Y, Z and W arrays of the first set of quaternions
+*	@param q X, Y, Z and W arrays of the second set of quaternions
+*/
+void QuaternionNlerpBatchSoA(float* const* p, const float* const* q, float t, std::size_t count);
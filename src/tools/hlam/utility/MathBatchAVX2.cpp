@@ -0,0 +1,298 @@
+#include "utility/MathBatchKernels.hpp"
+
+#if HLAM_SIMD_X86
+
+#include <immintrin.h>
+
+/**
+*	@file
+*
+*	AVX2 batch kernels. Operations are performed in the same order and precision as the scalar mathlib functions
+*	so results are bit identical. FMA is deliberately not used since it rounds differently.
+*	Glm types are only accessed through pointers to avoid instantiating inline functions here.
+*/
+
+namespace mathbatch
+{
+namespace
+{
+/**
+*	@brief Converts bone transforms to columns so vectors can be transformed with broadcasts instead of dot products.
+*	Column 3 holds the translation.
+*/
+HLAM_TARGET_AVX2 void TransposeTransforms(const glm::mat3x4* transforms, std::size_t boneCount, __m128* columns)
+{
+	const auto data = reinterpret_cast<const float*>(transforms);
+
+	for (std::size_t i = 0; i < boneCount; ++i, columns += 4)
+	{
+		__m128 row0 = _mm_loadu_ps(data + (i * 12));
+		__m128 row1 = _mm_loadu_ps(data + (i * 12) + 4);
+		__m128 row2 = _mm_loadu_ps(data + (i * 12) + 8);
+		__m128 row3 = _mm_setzero_ps();
+
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+		columns[0] = row0;
+		columns[1] = row1;
+		columns[2] = row2;
+		columns[3] = row3;
+	}
+}
+
+HLAM_TARGET_AVX2 inline __m256 Combine(__m128 low, __m128 high)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+/**
+*	@brief Transforms 2 packed vectors, one in each 128 bit lane.
+*	@param first Columns of the first vector's transform
+*	@param second Columns of the second vector's transform
+*	@return The transformed vectors packed in the first 6 elements
+*/
+template<bool Translate>
+HLAM_TARGET_AVX2 inline __m256 TransformPair(const __m128* first, const __m128* second, __m256 vectors)
+{
+	const __m256 x = _mm256_permutevar8x32_ps(vectors, _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3));
+	const __m256 y = _mm256_permutevar8x32_ps(vectors, _mm256_setr_epi32(1, 1, 1, 1, 4, 4, 4, 4));
+	const __m256 z = _mm256_permutevar8x32_ps(vectors, _mm256_setr_epi32(2, 2, 2, 2, 5, 5, 5, 5));
+
+	//Same order as glm::dot followed by adding the translation
+	__m256 result = _mm256_add_ps(
+		_mm256_add_ps(_mm256_mul_ps(x, Combine(first[0], second[0])), _mm256_mul_ps(y, Combine(first[1], second[1]))),
+		_mm256_mul_ps(z, Combine(first[2], second[2])));
+
+	if constexpr (Translate)
+	{
+		result = _mm256_add_ps(result, Combine(first[3], second[3]));
+	}
+
+	return _mm256_permutevar8x32_ps(result, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+}
+
+template<bool Translate>
+HLAM_TARGET_AVX2 void TransformVectors(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	__m128 columns[MaxBones * 4];
+
+	TransposeTransforms(transforms, boneCount, columns);
+
+	const auto source = reinterpret_cast<const float*>(in);
+	const auto destination = reinterpret_cast<float*>(out);
+
+	const __m256i firstSixMask = _mm256_setr_epi32(-1, -1, -1, -1, -1, -1, 0, 0);
+
+	std::size_t i = 0;
+
+	//Full loads and stores touch the first 2 floats of the next vector, so the last pair is handled separately
+	for (; (i + 3) <= count; i += 2)
+	{
+		_mm256_storeu_ps(destination + (i * 3),
+			TransformPair<Translate>(&columns[bones[i] * 4], &columns[bones[i + 1] * 4], _mm256_loadu_ps(source + (i * 3))));
+	}
+
+	if ((i + 2) <= count)
+	{
+		_mm256_maskstore_ps(destination + (i * 3), firstSixMask,
+			TransformPair<Translate>(&columns[bones[i] * 4], &columns[bones[i + 1] * 4], _mm256_maskload_ps(source + (i * 3), firstSixMask)));
+		i += 2;
+	}
+
+	if (i < count)
+	{
+		const __m128* const column = &columns[bones[i] * 4];
+
+		__m128 result = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(source[(i * 3)]), column[0]), _mm_mul_ps(_mm_set1_ps(source[(i * 3) + 1]), column[1])),
+			_mm_mul_ps(_mm_set1_ps(source[(i * 3) + 2]), column[2]));
+
+		if constexpr (Translate)
+		{
+			result = _mm_add_ps(result, column[3]);
+		}
+
+		_mm_maskstore_ps(destination + (i * 3), _mm_setr_epi32(-1, -1, -1, 0), result);
+	}
+}
+
+HLAM_TARGET_AVX2 void AVX2VectorTransform(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	TransformVectors<true>(in, bones, transforms, boneCount, out, count);
+}
+
+HLAM_TARGET_AVX2 void AVX2VectorRotate(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	TransformVectors<false>(in, bones, transforms, boneCount, out, count);
+}
+
+HLAM_TARGET_AVX2 void AVX2Lerp(float* a, const float* b, float t, std::size_t count)
+{
+	const float t1 = 1.0 - t;
+
+	const __m256 vt = _mm256_set1_ps(t);
+	const __m256 vt1 = _mm256_set1_ps(t1);
+
+	std::size_t i = 0;
+
+	for (; (i + 8) <= count; i += 8)
+	{
+		const __m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a + i), vt1), _mm256_mul_ps(_mm256_loadu_ps(b + i), vt));
+		_mm256_storeu_ps(a + i, result);
+	}
+
+	for (; i < count; ++i)
+	{
+		a[i] = a[i] * t1 + b[i] * t;
+	}
+}
+
+HLAM_TARGET_AVX2 void AVX2QuaternionNlerpSoA(float* const* p, const float* const* q, float t, std::size_t count)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	const __m256 vt = _mm256_set1_ps(t);
+	const __m256 tMinusHalf = _mm256_set1_ps(t - 0.5f);
+	const __m256 tMinusOne = _mm256_set1_ps(t - 1);
+
+	std::size_t i = 0;
+
+	//Same operations in the same order as the scalar version, including CorrectNlerpFraction
+	for (; (i + 8) <= count; i += 8)
+	{
+		const __m256 px = _mm256_loadu_ps(p[0] + i);
+		const __m256 py = _mm256_loadu_ps(p[1] + i);
+		const __m256 pz = _mm256_loadu_ps(p[2] + i);
+		const __m256 pw = _mm256_loadu_ps(p[3] + i);
+
+		const __m256 qx = _mm256_loadu_ps(q[0] + i);
+		const __m256 qy = _mm256_loadu_ps(q[1] + i);
+		const __m256 qz = _mm256_loadu_ps(q[2] + i);
+		const __m256 qw = _mm256_loadu_ps(q[3] + i);
+
+		const __m256 dot = _mm256_add_ps(
+			_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, qx), _mm256_mul_ps(py, qy)), _mm256_mul_ps(pz, qz)), _mm256_mul_ps(pw, qw));
+		const __m256 d = _mm256_andnot_ps(signMask, dot);
+
+		const __m256 a = _mm256_add_ps(_mm256_set1_ps(1.0904f), _mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(-3.2452f),
+			_mm256_mul_ps(d, _mm256_sub_ps(_mm256_set1_ps(3.55645f), _mm256_mul_ps(d, _mm256_set1_ps(1.43519f)))))));
+		const __m256 b = _mm256_add_ps(_mm256_set1_ps(0.848013f),
+			_mm256_mul_ps(d, _mm256_add_ps(_mm256_set1_ps(-1.06021f), _mm256_mul_ps(d, _mm256_set1_ps(0.215638f)))));
+		const __m256 k = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(a, tMinusHalf), tMinusHalf), b);
+		const __m256 correctedT = _mm256_add_ps(vt, _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(vt, tMinusHalf), tMinusOne), k));
+
+		//Interpolate along the shortest path
+		const __m256 pScale = _mm256_sub_ps(one, correctedT);
+		const __m256 qScale = _mm256_xor_ps(correctedT, _mm256_and_ps(_mm256_cmp_ps(dot, zero, _CMP_LT_OQ), signMask));
+
+		const __m256 rx = _mm256_add_ps(_mm256_mul_ps(px, pScale), _mm256_mul_ps(qx, qScale));
+		const __m256 ry = _mm256_add_ps(_mm256_mul_ps(py, pScale), _mm256_mul_ps(qy, qScale));
+		const __m256 rz = _mm256_add_ps(_mm256_mul_ps(pz, pScale), _mm256_mul_ps(qz, qScale));
+		const __m256 rw = _mm256_add_ps(_mm256_mul_ps(pw, pScale), _mm256_mul_ps(qw, qScale));
+
+		const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(
+			_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry)), _mm256_mul_ps(rz, rz)), _mm256_mul_ps(rw, rw)));
+
+		_mm256_storeu_ps(p[0] + i, _mm256_div_ps(rx, length));
+		_mm256_storeu_ps(p[1] + i, _mm256_div_ps(ry, length));
+		_mm256_storeu_ps(p[2] + i, _mm256_div_ps(rz, length));
+		_mm256_storeu_ps(p[3] + i, _mm256_div_ps(rw, length));
+	}
+
+	if (i < count)
+	{
+		float* const remainderP[4] = {p[0] + i, p[1] + i, p[2] + i, p[3] + i};
+		const float* const remainderQ[4] = {q[0] + i, q[1] + i, q[2] + i, q[3] + i};
+
+		ScalarKernels.QuaternionNlerpSoA(remainderP, remainderQ, t, count - i);
+	}
+}
+
+HLAM_TARGET_AVX2 void AVX2QuaternionMatrix(const glm::vec4* quaternions, const glm::vec3* positions, glm::mat3x4* out, std::size_t count)
+{
+	const auto source = reinterpret_cast<const float*>(quaternions);
+	const auto origins = reinterpret_cast<const float*>(positions);
+	const auto destination = reinterpret_cast<float*>(out);
+
+	const __m256d one = _mm256_set1_pd(1.0);
+	const __m256d two = _mm256_set1_pd(2.0);
+
+	std::size_t i = 0;
+
+	for (; (i + 4) <= count; i += 4)
+	{
+		__m128 qx = _mm_loadu_ps(source + (i * 4));
+		__m128 qy = _mm_loadu_ps(source + (i * 4) + 4);
+		__m128 qz = _mm_loadu_ps(source + (i * 4) + 8);
+		__m128 qw = _mm_loadu_ps(source + (i * 4) + 12);
+
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		//QuaternionMatrix works in double precision
+		const __m256d x = _mm256_cvtps_pd(qx);
+		const __m256d y = _mm256_cvtps_pd(qy);
+		const __m256d z = _mm256_cvtps_pd(qz);
+		const __m256d w = _mm256_cvtps_pd(qw);
+
+		const __m256d x2 = _mm256_mul_pd(two, x);
+		const __m256d y2 = _mm256_mul_pd(two, y);
+		const __m256d z2 = _mm256_mul_pd(two, z);
+		const __m256d w2 = _mm256_mul_pd(two, w);
+
+		const __m256d rows[9] =
+		{
+			_mm256_sub_pd(_mm256_sub_pd(one, _mm256_mul_pd(y2, y)), _mm256_mul_pd(z2, z)),
+			_mm256_sub_pd(_mm256_mul_pd(x2, y), _mm256_mul_pd(w2, z)),
+			_mm256_add_pd(_mm256_mul_pd(x2, z), _mm256_mul_pd(w2, y)),
+
+			_mm256_add_pd(_mm256_mul_pd(x2, y), _mm256_mul_pd(w2, z)),
+			_mm256_sub_pd(_mm256_sub_pd(one, _mm256_mul_pd(x2, x)), _mm256_mul_pd(z2, z)),
+			_mm256_sub_pd(_mm256_mul_pd(y2, z), _mm256_mul_pd(w2, x)),
+
+			_mm256_sub_pd(_mm256_mul_pd(x2, z), _mm256_mul_pd(w2, y)),
+			_mm256_add_pd(_mm256_mul_pd(y2, z), _mm256_mul_pd(w2, x)),
+			_mm256_sub_pd(_mm256_sub_pd(one, _mm256_mul_pd(x2, x)), _mm256_mul_pd(y2, y))
+		};
+
+		for (int row = 0; row < 3; ++row)
+		{
+			__m128 c0 = _mm256_cvtpd_ps(rows[(row * 3)]);
+			__m128 c1 = _mm256_cvtpd_ps(rows[(row * 3) + 1]);
+			__m128 c2 = _mm256_cvtpd_ps(rows[(row * 3) + 2]);
+			__m128 c3 = _mm_setr_ps(
+				origins[(i * 3) + row], origins[((i + 1) * 3) + row], origins[((i + 2) * 3) + row], origins[((i + 3) * 3) + row]);
+
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+			_mm_storeu_ps(destination + (i * 12) + (row * 4), c0);
+			_mm_storeu_ps(destination + ((i + 1) * 12) + (row * 4), c1);
+			_mm_storeu_ps(destination + ((i + 2) * 12) + (row * 4), c2);
+			_mm_storeu_ps(destination + ((i + 3) * 12) + (row * 4), c3);
+		}
+	}
+
+	if (i < count)
+	{
+		ScalarKernels.QuaternionMatrix(quaternions + i, positions + i, out + i, count - i);
+	}
+}
+}
+
+const Kernels AVX2Kernels
+{
+	&AVX2VectorTransform,
+	&AVX2VectorRotate,
+	&SSE2QuaternionSlerp,
+	&AVX2Lerp,
+	&AVX2QuaternionMatrix,
+	&SSE2ConcatBoneTransforms,
+	&AVX2QuaternionNlerpSoA
+};
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat3x4.hpp>
+
+#include "core/shared/Const.hpp"
+
+#include "utility/SIMD.hpp"
+
+/**
+*	@file
+*
+*	Internal to the MathBatch implementation.
+*/
+
+namespace mathbatch
+{
+/**
+*	@brief Largest number of bones a bone index can refer to.
+*/
+constexpr std::size_t MaxBones = 256;
+
+struct Kernels
+{
+	void (*VectorTransform)(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+		glm::vec3* out, std::size_t count);
+
+	void (*VectorRotate)(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+		glm::vec3* out, std::size_t count);
+
+	void (*QuaternionSlerp)(glm::vec4* p, glm::vec4* q, float t, std::size_t count);
+
+	void (*Lerp)(float* a, const float* b, float t, std::size_t count);
+
+	void (*QuaternionMatrix)(const glm::vec4* quaternions, const glm::vec3* positions, glm::mat3x4* out, std::size_t count);
+
+	void (*ConcatBoneTransforms)(const glm::mat3x4* local, const int* parents, glm::mat3x4* out, std::size_t count);
+
+	void (*QuaternionNlerpSoA)(float* const* p, const float* const* q, float t, std::size_t count);
+};
+
+/**
+*	@brief Corrects the interpolation fraction so normalized linear interpolation closely follows spherical interpolation.
+*	@param t Interpolation fraction
+*	@param d Absolute cosine of the angle between the quaternions
+*	@see https://zeux.io/2015/07/23/approximating-slerp/
+*/
+inline float CorrectNlerpFraction(float t, float d)
+{
+	const float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	const float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	const float k = a * (t - 0.5f) * (t - 0.5f) + b;
+
+	return t + t * (t - 0.5f) * (t - 1) * k;
+}
+
+extern const Kernels ScalarKernels;
+
+#if HLAM_SIMD_X86
+extern const Kernels SSE2Kernels;
+extern const Kernels AVX2Kernels;
+
+//Shared with the AVX2 kernels where wider registers don't help
+void SSE2QuaternionSlerp(glm::vec4* p, glm::vec4* q, float t, std::size_t count);
+void SSE2ConcatBoneTransforms(const glm::mat3x4* local, const int* parents, glm::mat3x4* out, std::size_t count);
+#endif
+}
@@ -0,0 +1,385 @@
+#include "utility/MathBatchKernels.hpp"
+
+#if HLAM_SIMD_X86
+
+#include <cmath>
+
+#include <emmintrin.h>
+
+#include "utility/mathlib.hpp"
+
+/**
+*	@file
+*
+*	SSE2 batch kernels. Operations are performed in the same order and precision as the scalar mathlib functions
+*	so results are bit identical. Glm types are only accessed through pointers to avoid instantiating inline functions here.
+*/
+
+namespace mathbatch
+{
+namespace
+{
+/**
+*	@brief Adds the elements of a vector from first to last, the same way a scalar loop or a chain of additions does.
+*/
+HLAM_TARGET_SSE2 inline float SumInOrder(__m128 value)
+{
+	const float e0 = _mm_cvtss_f32(value);
+	const float e1 = _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1)));
+	const float e2 = _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 2, 2)));
+	const float e3 = _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3)));
+
+	return ((e0 + e1) + e2) + e3;
+}
+
+/**
+*	@brief Stores the first 3 elements of a vector.
+*	@param canOverwriteNext Whether the 4 bytes after the destination may be overwritten.
+*/
+HLAM_TARGET_SSE2 inline void StoreVector3(float* destination, __m128 value, bool canOverwriteNext)
+{
+	if (canOverwriteNext)
+	{
+		_mm_storeu_ps(destination, value);
+	}
+	else
+	{
+		_mm_storel_pi(reinterpret_cast<__m64*>(destination), value);
+		_mm_store_ss(destination + 2, _mm_movehl_ps(value, value));
+	}
+}
+
+/**
+*	@brief Converts bone transforms to columns so vectors can be transformed with broadcasts instead of dot products.
+*	Column 3 holds the translation.
+*/
+HLAM_TARGET_SSE2 void TransposeTransforms(const glm::mat3x4* transforms, std::size_t boneCount, __m128* columns)
+{
+	const auto data = reinterpret_cast<const float*>(transforms);
+
+	for (std::size_t i = 0; i < boneCount; ++i, columns += 4)
+	{
+		__m128 row0 = _mm_loadu_ps(data + (i * 12));
+		__m128 row1 = _mm_loadu_ps(data + (i * 12) + 4);
+		__m128 row2 = _mm_loadu_ps(data + (i * 12) + 8);
+		__m128 row3 = _mm_setzero_ps();
+
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+		columns[0] = row0;
+		columns[1] = row1;
+		columns[2] = row2;
+		columns[3] = row3;
+	}
+}
+
+template<bool Translate>
+HLAM_TARGET_SSE2 void TransformVectors(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	__m128 columns[MaxBones * 4];
+
+	TransposeTransforms(transforms, boneCount, columns);
+
+	const auto source = reinterpret_cast<const float*>(in);
+	const auto destination = reinterpret_cast<float*>(out);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const __m128* const column = &columns[bones[i] * 4];
+
+		const __m128 x = _mm_set1_ps(source[(i * 3)]);
+		const __m128 y = _mm_set1_ps(source[(i * 3) + 1]);
+		const __m128 z = _mm_set1_ps(source[(i * 3) + 2]);
+
+		//Same order as glm::dot followed by adding the translation
+		__m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, column[0]), _mm_mul_ps(y, column[1])), _mm_mul_ps(z, column[2]));
+
+		if constexpr (Translate)
+		{
+			result = _mm_add_ps(result, column[3]);
+		}
+
+		StoreVector3(destination + (i * 3), result, (i + 1) < count);
+	}
+}
+
+HLAM_TARGET_SSE2 void SSE2VectorTransform(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	TransformVectors<true>(in, bones, transforms, boneCount, out, count);
+}
+
+HLAM_TARGET_SSE2 void SSE2VectorRotate(const glm::vec3* in, const byte* bones, const glm::mat3x4* transforms, std::size_t boneCount,
+	glm::vec3* out, std::size_t count)
+{
+	TransformVectors<false>(in, bones, transforms, boneCount, out, count);
+}
+
+HLAM_TARGET_SSE2 void SSE2Lerp(float* a, const float* b, float t, std::size_t count)
+{
+	const float t1 = 1.0 - t;
+
+	const __m128 vt = _mm_set1_ps(t);
+	const __m128 vt1 = _mm_set1_ps(t1);
+
+	std::size_t i = 0;
+
+	for (; (i + 4) <= count; i += 4)
+	{
+		const __m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + i), vt1), _mm_mul_ps(_mm_loadu_ps(b + i), vt));
+		_mm_storeu_ps(a + i, result);
+	}
+
+	for (; i < count; ++i)
+	{
+		a[i] = a[i] * t1 + b[i] * t;
+	}
+}
+
+HLAM_TARGET_SSE2 void SSE2QuaternionNlerpSoA(float* const* p, const float* const* q, float t, std::size_t count)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	const __m128 vt = _mm_set1_ps(t);
+	const __m128 tMinusHalf = _mm_set1_ps(t - 0.5f);
+	const __m128 tMinusOne = _mm_set1_ps(t - 1);
+
+	std::size_t i = 0;
+
+	//Same operations in the same order as the scalar version, including CorrectNlerpFraction
+	for (; (i + 4) <= count; i += 4)
+	{
+		const __m128 px = _mm_loadu_ps(p[0] + i);
+		const __m128 py = _mm_loadu_ps(p[1] + i);
+		const __m128 pz = _mm_loadu_ps(p[2] + i);
+		const __m128 pw = _mm_loadu_ps(p[3] + i);
+
+		const __m128 qx = _mm_loadu_ps(q[0] + i);
+		const __m128 qy = _mm_loadu_ps(q[1] + i);
+		const __m128 qz = _mm_loadu_ps(q[2] + i);
+		const __m128 qw = _mm_loadu_ps(q[3] + i);
+
+		const __m128 dot = _mm_add_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, qx), _mm_mul_ps(py, qy)), _mm_mul_ps(pz, qz)), _mm_mul_ps(pw, qw));
+		const __m128 d = _mm_andnot_ps(signMask, dot);
+
+		const __m128 a = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-3.2452f),
+			_mm_mul_ps(d, _mm_sub_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(1.43519f)))))));
+		const __m128 b = _mm_add_ps(_mm_set1_ps(0.848013f),
+			_mm_mul_ps(d, _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)))));
+		const __m128 k = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(a, tMinusHalf), tMinusHalf), b);
+		const __m128 correctedT = _mm_add_ps(vt, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(vt, tMinusHalf), tMinusOne), k));
+
+		//Interpolate along the shortest path
+		const __m128 pScale = _mm_sub_ps(one, correctedT);
+		const __m128 qScale = _mm_xor_ps(correctedT, _mm_and_ps(_mm_cmplt_ps(dot, zero), signMask));
+
+		const __m128 rx = _mm_add_ps(_mm_mul_ps(px, pScale), _mm_mul_ps(qx, qScale));
+		const __m128 ry = _mm_add_ps(_mm_mul_ps(py, pScale), _mm_mul_ps(qy, qScale));
+		const __m128 rz = _mm_add_ps(_mm_mul_ps(pz, pScale), _mm_mul_ps(qz, qScale));
+		const __m128 rw = _mm_add_ps(_mm_mul_ps(pw, pScale), _mm_mul_ps(qw, qScale));
+
+		const __m128 length = _mm_sqrt_ps(_mm_add_ps(
+			_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz)), _mm_mul_ps(rw, rw)));
+
+		_mm_storeu_ps(p[0] + i, _mm_div_ps(rx, length));
+		_mm_storeu_ps(p[1] + i, _mm_div_ps(ry, length));
+		_mm_storeu_ps(p[2] + i, _mm_div_ps(rz, length));
+		_mm_storeu_ps(p[3] + i, _mm_div_ps(rw, length));
+	}
+
+	if (i < count)
+	{
+		float* const remainderP[4] = {p[0] + i, p[1] + i, p[2] + i, p[3] + i};
+		const float* const remainderQ[4] = {q[0] + i, q[1] + i, q[2] + i, q[3] + i};
+
+		ScalarKernels.QuaternionNlerpSoA(remainderP, remainderQ, t, count - i);
+	}
+}
+
+/**
+*	@brief Computes the rotation part of QuaternionMatrix in double precision for 2 quaternions at a time.
+*	@param rows 3 rows of 3 elements, each containing the values for both quaternions
+*/
+HLAM_TARGET_SSE2 void QuaternionMatrix2(__m128d x, __m128d y, __m128d z, __m128d w, __m128d* rows)
+{
+	const __m128d one = _mm_set1_pd(1.0);
+	const __m128d two = _mm_set1_pd(2.0);
+
+	const __m128d x2 = _mm_mul_pd(two, x);
+	const __m128d y2 = _mm_mul_pd(two, y);
+	const __m128d z2 = _mm_mul_pd(two, z);
+	const __m128d w2 = _mm_mul_pd(two, w);
+
+	rows[0] = _mm_sub_pd(_mm_sub_pd(one, _mm_mul_pd(y2, y)), _mm_mul_pd(z2, z));
+	rows[1] = _mm_sub_pd(_mm_mul_pd(x2, y), _mm_mul_pd(w2, z));
+	rows[2] = _mm_add_pd(_mm_mul_pd(x2, z), _mm_mul_pd(w2, y));
+
+	rows[3] = _mm_add_pd(_mm_mul_pd(x2, y), _mm_mul_pd(w2, z));
+	rows[4] = _mm_sub_pd(_mm_sub_pd(one, _mm_mul_pd(x2, x)), _mm_mul_pd(z2, z));
+	rows[5] = _mm_sub_pd(_mm_mul_pd(y2, z), _mm_mul_pd(w2, x));
+
+	rows[6] = _mm_sub_pd(_mm_mul_pd(x2, z), _mm_mul_pd(w2, y));
+	rows[7] = _mm_add_pd(_mm_mul_pd(y2, z), _mm_mul_pd(w2, x));
+	rows[8] = _mm_sub_pd(_mm_sub_pd(one, _mm_mul_pd(x2, x)), _mm_mul_pd(y2, y));
+}
+
+HLAM_TARGET_SSE2 void SSE2QuaternionMatrix(const glm::vec4* quaternions, const glm::vec3* positions, glm::mat3x4* out, std::size_t count)
+{
+	const auto source = reinterpret_cast<const float*>(quaternions);
+	const auto origins = reinterpret_cast<const float*>(positions);
+	const auto destination = reinterpret_cast<float*>(out);
+
+	std::size_t i = 0;
+
+	for (; (i + 4) <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(source + (i * 4));
+		__m128 y = _mm_loadu_ps(source + (i * 4) + 4);
+		__m128 z = _mm_loadu_ps(source + (i * 4) + 8);
+		__m128 w = _mm_loadu_ps(source + (i * 4) + 12);
+
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		__m128d low[9];
+		__m128d high[9];
+
+		QuaternionMatrix2(_mm_cvtps_pd(x), _mm_cvtps_pd(y), _mm_cvtps_pd(z), _mm_cvtps_pd(w), low);
+		QuaternionMatrix2(
+			_mm_cvtps_pd(_mm_movehl_ps(x, x)), _mm_cvtps_pd(_mm_movehl_ps(y, y)),
+			_mm_cvtps_pd(_mm_movehl_ps(z, z)), _mm_cvtps_pd(_mm_movehl_ps(w, w)), high);
+
+		for (int row = 0; row < 3; ++row)
+		{
+			__m128 c0 = _mm_movelh_ps(_mm_cvtpd_ps(low[(row * 3)]), _mm_cvtpd_ps(high[(row * 3)]));
+			__m128 c1 = _mm_movelh_ps(_mm_cvtpd_ps(low[(row * 3) + 1]), _mm_cvtpd_ps(high[(row * 3) + 1]));
+			__m128 c2 = _mm_movelh_ps(_mm_cvtpd_ps(low[(row * 3) + 2]), _mm_cvtpd_ps(high[(row * 3) + 2]));
+			__m128 c3 = _mm_setr_ps(
+				origins[(i * 3) + row], origins[((i + 1) * 3) + row], origins[((i + 2) * 3) + row], origins[((i + 3) * 3) + row]);
+
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+			_mm_storeu_ps(destination + (i * 12) + (row * 4), c0);
+			_mm_storeu_ps(destination + ((i + 1) * 12) + (row * 4), c1);
+			_mm_storeu_ps(destination + ((i + 2) * 12) + (row * 4), c2);
+			_mm_storeu_ps(destination + ((i + 3) * 12) + (row * 4), c3);
+		}
+	}
+
+	if (i < count)
+	{
+		ScalarKernels.QuaternionMatrix(quaternions + i, positions + i, out + i, count - i);
+	}
+}
+}
+
+HLAM_TARGET_SSE2 void SSE2QuaternionSlerp(glm::vec4* p, glm::vec4* q, float t, std::size_t count)
+{
+	const auto first = reinterpret_cast<float*>(p);
+	const auto second = reinterpret_cast<float*>(q);
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const __m128 vp = _mm_loadu_ps(first + (i * 4));
+		__m128 vq = _mm_loadu_ps(second + (i * 4));
+
+		// decide if one of the quaternions is backwards
+		const __m128 difference = _mm_sub_ps(vp, vq);
+		const __m128 sum = _mm_add_ps(vp, vq);
+
+		const float a = SumInOrder(_mm_mul_ps(difference, difference));
+		const float b = SumInOrder(_mm_mul_ps(sum, sum));
+
+		if (a > b)
+		{
+			vq = _mm_xor_ps(vq, signMask);
+		}
+
+		const float cosom = SumInOrder(_mm_mul_ps(vp, vq));
+
+		if ((1.0 + cosom) > 0.00000001)
+		{
+			float sclp, sclq;
+
+			if ((1.0 - cosom) > 0.00000001)
+			{
+				const float omega = acos(cosom);
+				const float sinom = sin(omega);
+				sclp = sin((1.0 - t) * omega) / sinom;
+				sclq = sin(t * omega) / sinom;
+			}
+			else
+			{
+				sclp = 1.0 - t;
+				sclq = t;
+			}
+
+			_mm_storeu_ps(first + (i * 4), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(sclp), vp), _mm_mul_ps(_mm_set1_ps(sclq), vq)));
+			_mm_storeu_ps(second + (i * 4), vq);
+		}
+		else
+		{
+			//Nearly opposite quaternions are rare, let the scalar version handle it
+			ScalarKernels.QuaternionSlerp(p + i, q + i, t, 1);
+		}
+	}
+}
+
+HLAM_TARGET_SSE2 void SSE2ConcatBoneTransforms(const glm::mat3x4* local, const int* parents, glm::mat3x4* out, std::size_t count)
+{
+	const auto source = reinterpret_cast<const float*>(local);
+	const auto destination = reinterpret_cast<float*>(out);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const float* const in2 = source + (i * 12);
+		float* const result = destination + (i * 12);
+
+		const __m128 row0 = _mm_loadu_ps(in2);
+		const __m128 row1 = _mm_loadu_ps(in2 + 4);
+		const __m128 row2 = _mm_loadu_ps(in2 + 8);
+
+		if (parents[i] == -1)
+		{
+			_mm_storeu_ps(result, row0);
+			_mm_storeu_ps(result + 4, row1);
+			_mm_storeu_ps(result + 8, row2);
+			continue;
+		}
+
+		const float* const in1 = destination + (parents[i] * 12);
+
+		for (int row = 0; row < 3; ++row)
+		{
+			const float* const parentRow = in1 + (row * 4);
+
+			__m128 value = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(parentRow[0]), row0), _mm_mul_ps(_mm_set1_ps(parentRow[1]), row1)),
+				_mm_mul_ps(_mm_set1_ps(parentRow[2]), row2));
+
+			//Only the last column includes the parent's translation. Adding negative zero leaves the other columns unchanged
+			value = _mm_add_ps(value, _mm_setr_ps(-0.0f, -0.0f, -0.0f, parentRow[3]));
+
+			_mm_storeu_ps(result + (row * 4), value);
+		}
+	}
+}
+
+const Kernels SSE2Kernels
+{
+	&SSE2VectorTransform,
+	&SSE2VectorRotate,
+	&SSE2QuaternionSlerp,
+	&SSE2Lerp,
+	&SSE2QuaternionMatrix,
+	&SSE2ConcatBoneTransforms,
+	&SSE2QuaternionNlerpSoA
+};
+}
+
+#endif
@@ -0,0 +1,45 @@
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "utility/SIMD.hpp"
+
+bool IsSSE2Supported()
+{
+#if HLAM_SIMD_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2");
+#endif
+#else
+	return false;
+#endif
+}
+
+bool IsAVX2Supported()
+{
+#if HLAM_SIMD_X86
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	//The OS has to save the AVX registers on context switches
+	const bool osSavesYMM = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+	if (!osSavesYMM)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+#else
+	return false;
+#endif
+}
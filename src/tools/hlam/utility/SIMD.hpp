@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+*	@file
+*
+*	Helpers for code that selects SIMD implementations at runtime.
+*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HLAM_SIMD_X86 1
+#else
+#define HLAM_SIMD_X86 0
+#endif
+
+#if HLAM_SIMD_X86
+//Kernels are compiled for their instruction set per function instead of per file
+//so inline functions shared with other translation units never contain instructions the CPU may not support
+#if defined(_MSC_VER)
+#define HLAM_TARGET_SSE2
+#define HLAM_TARGET_AVX2
+#else
+#define HLAM_TARGET_SSE2 __attribute__((target("sse2")))
+#define HLAM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+/**
+*	@brief Whether the CPU supports SSE2. Always false on other architectures.
+*/
+bool IsSSE2Supported();
+
+/**
+*	@brief Whether the CPU and operating system support AVX2. Always false on other architectures.
+*/
+bool IsAVX2Supported();